@@ -0,0 +1,209 @@
+#include "AllocTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#if defined(_WIN32) || defined(__linux__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+namespace {
+
+struct PhaseCounters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> freedBytes;
+    std::atomic<int64_t> peakLive;
+    std::atomic<const char*> name;
+};
+
+// Zero-initialized before any constructor runs, so allocations made by
+// static initializers are safe
+std::atomic<bool> g_enabled;
+std::atomic<int> g_current;
+std::atomic<int64_t> g_live;
+PhaseCounters g_phases[AllocTracker::kMaxPhases];
+
+size_t BlockSize(void* p) {
+#if defined(_WIN32)
+    return _msize(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+void RaisePeak(std::atomic<int64_t>& peak, int64_t live) {
+    int64_t seen = peak.load(std::memory_order_relaxed);
+    while (live > seen && !peak.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {
+    }
+}
+
+void CountAllocation(void* p) {
+    int64_t size = (int64_t)BlockSize(p);
+    PhaseCounters& phase = g_phases[g_current.load(std::memory_order_relaxed)];
+    phase.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.bytes.fetch_add((uint64_t)size, std::memory_order_relaxed);
+    RaisePeak(phase.peakLive, g_live.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void CountFree(void* p) {
+    int64_t size = (int64_t)BlockSize(p);
+    PhaseCounters& phase = g_phases[g_current.load(std::memory_order_relaxed)];
+    phase.frees.fetch_add(1, std::memory_order_relaxed);
+    phase.freedBytes.fetch_add((uint64_t)size, std::memory_order_relaxed);
+    g_live.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void* Allocate(size_t size) {
+    if (size == 0) size = 1;
+    void* p;
+    while ((p = std::malloc(size)) == nullptr) {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+    if (g_enabled.load(std::memory_order_relaxed)) CountAllocation(p);
+    return p;
+}
+
+void Release(void* p) {
+    if (!p) return;
+    if (g_enabled.load(std::memory_order_relaxed)) CountFree(p);
+    std::free(p);
+}
+
+void* AllocateOrThrow(size_t size) {
+    void* p = Allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+}
+
+void AllocTracker::Enable() {
+    g_enabled.store(false);
+    for (PhaseCounters& phase : g_phases) {
+        phase.allocations.store(0);
+        phase.bytes.store(0);
+        phase.frees.store(0);
+        phase.freedBytes.store(0);
+        phase.peakLive.store(0);
+        phase.name.store(nullptr);
+    }
+    g_live.store(0);
+    g_current.store(0);
+    g_enabled.store(true);
+}
+
+void AllocTracker::Disable() {
+    g_enabled.store(false);
+}
+
+bool AllocTracker::Enabled() {
+    return g_enabled.load();
+}
+
+void AllocTracker::EndPhase(const char* name) {
+    int current = g_current.load();
+    g_phases[current].name.store(name);
+    if (current + 1 < kMaxPhases) {
+        g_phases[current + 1].peakLive.store(g_live.load());
+        g_current.store(current + 1);
+    }
+}
+
+std::vector<AllocPhaseStats> AllocTracker::Phases() {
+    // Snapshot first: building the result allocates into the current phase
+    AllocPhaseStats snapshot[kMaxPhases];
+    const char* names[kMaxPhases];
+    int current = g_current.load();
+    for (int i = 0; i <= current; i++) {
+        const PhaseCounters& phase = g_phases[i];
+        names[i] = phase.name.load();
+        snapshot[i].allocations = phase.allocations.load();
+        snapshot[i].bytes = phase.bytes.load();
+        snapshot[i].frees = phase.frees.load();
+        snapshot[i].freedBytes = phase.freedBytes.load();
+        snapshot[i].peakLiveBytes = phase.peakLive.load();
+    }
+
+    std::vector<AllocPhaseStats> phases;
+    for (int i = 0; i <= current; i++) {
+        if (!names[i] && snapshot[i].allocations == 0 && snapshot[i].frees == 0) continue;
+        snapshot[i].name = names[i] ? names[i] : "rest";
+        phases.push_back(snapshot[i]);
+    }
+    return phases;
+}
+
+void AllocTracker::Report() {
+    std::vector<AllocPhaseStats> phases = Phases();
+    std::wcout << L"Allocations by startup phase:\n";
+    std::wcout << L"  " << std::left << std::setw(14) << L"phase" << std::right
+               << std::setw(10) << L"allocs" << std::setw(12) << L"KB"
+               << std::setw(10) << L"frees" << std::setw(14) << L"peak live KB" << L"\n";
+    AllocPhaseStats total;
+    for (const AllocPhaseStats& p : phases) {
+        std::wcout << L"  " << std::left << std::setw(14) << std::wstring(p.name.begin(), p.name.end()) << std::right
+                   << std::setw(10) << p.allocations << std::setw(12) << (p.bytes + 1023) / 1024
+                   << std::setw(10) << p.frees << std::setw(14) << p.peakLiveBytes / 1024 << L"\n";
+        total.allocations += p.allocations;
+        total.bytes += p.bytes;
+        total.frees += p.frees;
+        if (p.peakLiveBytes > total.peakLiveBytes) total.peakLiveBytes = p.peakLiveBytes;
+    }
+    std::wcout << L"  " << std::left << std::setw(14) << L"total" << std::right
+               << std::setw(10) << total.allocations << std::setw(12) << (total.bytes + 1023) / 1024
+               << std::setw(10) << total.frees << std::setw(14) << total.peakLiveBytes / 1024 << L"\n";
+}
+
+// Replacements for every global operator new/delete the program can call.
+// The array forms and nothrow variants must be replaced too, or they would
+// pair a tracked allocation with an untracked free (or the other way round).
+
+void* operator new(size_t size) {
+    return AllocateOrThrow(size);
+}
+
+void* operator new[](size_t size) {
+    return AllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    Release(p);
+}
+
+void operator delete[](void* p) noexcept {
+    Release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    Release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    Release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    Release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    Release(p);
+}
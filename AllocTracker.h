@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Heap use during one startup phase. Bytes are as sized by the heap
+// (malloc_usable_size/_msize), so they include its rounding.
+struct AllocPhaseStats {
+    std::string name;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+    uint64_t freedBytes = 0;
+    int64_t peakLiveBytes = 0;  // Highest live total while the phase ran, counted from Enable
+};
+
+// Counts heap allocations per startup phase by replacing the global
+// operator new and delete (see AllocTracker.cpp).
+//
+// Disabled by default, when each new/delete costs one relaxed atomic load
+// on top of malloc/free. Once enabled, allocations from every thread are
+// added to the current phase; StartupTiming::Mark ends the current phase
+// under the mark's name and starts the next one. Live bytes start at zero
+// at Enable, so freeing a block allocated before then lowers them.
+class AllocTracker {
+public:
+    // Phases after the last one are added to it
+    static const int kMaxPhases = 32;
+
+    // Clears all counts and starts counting into the first phase
+    static void Enable();
+    static void Disable();
+    static bool Enabled();
+
+    // Names the current phase and starts the next; name must outlive the
+    // tracker (a string literal), since recording it must not allocate
+    static void EndPhase(const char* name);
+
+    // Ended phases in order, followed by the current one (named "rest")
+    // when it has seen any allocations
+    static std::vector<AllocPhaseStats> Phases();
+
+    // Prints a table of every phase to stdout
+    static void Report();
+};
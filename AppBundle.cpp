@@ -0,0 +1,171 @@
+#include "AppBundle.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+const char* const AppBundle::kConfigName = "config";
+const char* const AppBundle::kIconName = "icon.ico";
+const char* const AppBundle::kAssetPrefix = "assets/";
+
+namespace {
+
+const char kMagic[8] = { 'W', 'W', 'B', 'U', 'N', 'D', 'L', 'E' };
+const uint32_t kVersion = 1;
+
+// magic, payload size (u64), index size (u64), index CRC32, version
+const size_t kFooterSize = 32;
+
+struct Footer {
+    uint64_t payloadSize = 0;  // File data plus index, excluding the footer
+    uint64_t indexSize = 0;
+    uint32_t indexCrc = 0;
+};
+
+void PutLe(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back((char)(value >> (i * 8)));
+}
+
+uint64_t GetLe(const uint8_t* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+bool ReadFooter(const uint8_t* data, size_t size, Footer& footer) {
+    if (size < kFooterSize) return false;
+    const uint8_t* p = data + size - kFooterSize;
+    if (memcmp(p, kMagic, 8) != 0 || GetLe(p + 28, 4) != kVersion) return false;
+    footer.payloadSize = GetLe(p + 8, 8);
+    footer.indexSize = GetLe(p + 16, 8);
+    footer.indexCrc = (uint32_t)GetLe(p + 24, 4);
+    return footer.payloadSize <= size - kFooterSize && footer.indexSize <= footer.payloadSize;
+}
+
+}
+
+size_t AppBundle::ImageSize(const uint8_t* data, size_t size) {
+    Footer footer;
+    if (!ReadFooter(data, size, footer)) {
+        return size;
+    }
+    return size - kFooterSize - (size_t)footer.payloadSize;
+}
+
+bool AppBundle::Build(const std::wstring& executable, const std::wstring& out,
+    const std::vector<BundleFile>& files) {
+    std::string image;
+    if (!FileUtil::Read(executable, image)) {
+        return false;
+    }
+    // Rebuilding from a bundled app replaces its payload
+    image.resize(ImageSize((const uint8_t*)image.data(), image.size()));
+
+    std::string payload, index;
+    Varint::Put(index, files.size());
+    for (const BundleFile& f : files) {
+        Varint::PutString(index, f.name);
+        Varint::Put(index, payload.size());
+        Varint::Put(index, f.data.size());
+        Varint::Put(index, Checksums::Crc32(0, (const uint8_t*)f.data.data(), f.data.size()));
+        payload += f.data;
+    }
+    payload += index;
+
+    std::string footer(kMagic, sizeof(kMagic));
+    PutLe(footer, payload.size(), 8);
+    PutLe(footer, index.size(), 8);
+    PutLe(footer, Checksums::Crc32(0, (const uint8_t*)index.data(), index.size()), 4);
+    PutLe(footer, kVersion, 4);
+
+    image += payload;
+    image += footer;
+    return FileUtil::Write(out, image.data(), image.size());
+}
+
+bool AppBundle::Open(const std::wstring& path) {
+    m_entries.clear();
+    m_payload = nullptr;
+    return m_file.Open(path) && Parse(m_file.Data(), m_file.Size());
+}
+
+bool AppBundle::OpenSelf() {
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    DWORD len = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) {
+        return false;
+    }
+    return Open(path);
+#else
+    char path[4096];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0) {
+        return false;
+    }
+    return Open(Utf8::ToWide(std::string(path, (size_t)len)));
+#endif
+}
+
+bool AppBundle::Parse(const uint8_t* data, size_t size) {
+    m_entries.clear();
+    m_payload = nullptr;
+    Footer footer;
+    if (!ReadFooter(data, size, footer)) {
+        return false;
+    }
+
+    const uint8_t* payload = data + size - kFooterSize - footer.payloadSize;
+    const uint8_t* p = payload + (footer.payloadSize - footer.indexSize);
+    const uint8_t* end = p + footer.indexSize;
+    if (Checksums::Crc32(0, p, (size_t)footer.indexSize) != footer.indexCrc) {
+        return false;
+    }
+
+    uint64_t count = 0;
+    if (!Varint::Get(p, end, count)) {
+        return false;
+    }
+    uint64_t dataSize = footer.payloadSize - footer.indexSize;
+    for (uint64_t i = 0; i < count; i++) {
+        std::string name;
+        Entry e;
+        uint64_t crc = 0;
+        if (!Varint::GetString(p, end, name) || !Varint::Get(p, end, e.offset) ||
+            !Varint::Get(p, end, e.size) || !Varint::Get(p, end, crc) ||
+            e.offset > dataSize || e.size > dataSize - e.offset) {
+            m_entries.clear();
+            return false;
+        }
+        e.crc = (uint32_t)crc;
+        m_entries[name] = e;
+    }
+    m_payload = payload;
+    return true;
+}
+
+bool AppBundle::Find(const std::string& name, const uint8_t*& data, size_t& size) const {
+    auto it = m_entries.find(name);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    data = m_payload + it->second.offset;
+    size = (size_t)it->second.size;
+    return true;
+}
+
+bool AppBundle::Verify() const {
+    for (const auto& e : m_entries) {
+        if (Checksums::Crc32(0, m_payload + e.second.offset, (size_t)e.second.size) != e.second.crc) {
+            return false;
+        }
+    }
+    return true;
+}
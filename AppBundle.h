@@ -0,0 +1,70 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One file stored in a bundle; names use '/' separators
+struct BundleFile {
+    std::string name;
+    std::string data;
+};
+
+// A payload appended to an executable, so a single file carries an app's
+// configuration, its pre-converted icon and optionally its web assets:
+//
+//   [executable][file data ...][index][footer]
+//
+// The fixed-size footer at the very end holds a magic number, the payload
+// and index sizes and the index CRC32. The index lists each file's name,
+// offset, size and CRC32 as varints. PE and ELF loaders ignore bytes past
+// the image, so the executable runs unchanged. Reading maps the file and
+// hands out pointers into the mapping; only the index is parsed.
+class AppBundle {
+public:
+    static const char* const kConfigName;   // Manifest text with one app section
+    static const char* const kIconName;     // Multi-size .ico
+    static const char* const kAssetPrefix;  // Followed by the path inside the assets folder
+
+    // Writes executable (minus any payload it already carries) followed by files
+    static bool Build(const std::wstring& executable, const std::wstring& out,
+        const std::vector<BundleFile>& files);
+
+    // Bytes of data before its payload (all of them when there is none)
+    static size_t ImageSize(const uint8_t* data, size_t size);
+
+    AppBundle() = default;
+    AppBundle(const AppBundle&) = delete;
+    AppBundle& operator=(const AppBundle&) = delete;
+
+    // Maps path and reads its payload; false when there is none
+    bool Open(const std::wstring& path);
+
+    // Open on the running executable
+    bool OpenSelf();
+
+    // Reads the payload at the end of data, which the caller keeps alive
+    bool Parse(const uint8_t* data, size_t size);
+
+    // Points data at a stored file, valid while the bundle is open.
+    // Contents are not checked; see Verify.
+    bool Find(const std::string& name, const uint8_t*& data, size_t& size) const;
+
+    // Checks every file against its CRC32
+    bool Verify() const;
+
+    size_t Count() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t crc;
+    };
+
+    MappedFile m_file;
+    const uint8_t* m_payload = nullptr;
+    std::unordered_map<std::string, Entry> m_entries;
+};
@@ -0,0 +1,72 @@
+#include "AppPaths.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlobj.h>
+#include <knownfolders.h>
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "ole32.lib")
+#endif
+
+std::wstring AppPaths::DataDirectory() {
+    std::wstring dir;
+#ifdef _WIN32
+    PWSTR base = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &base))) {
+        dir = FileUtil::Join(base, L"WebWrap");
+    }
+    CoTaskMemFree(base);
+#else
+    const char* xdg = getenv("XDG_DATA_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) {
+        dir = FileUtil::Join(Utf8::ToWide(xdg), L"webwrap");
+    } else if (home && *home) {
+        dir = FileUtil::Join(Utf8::ToWide(home), L".local/share/webwrap");
+    }
+#endif
+    if (dir.empty() || !FileUtil::MakeDirectories(dir)) {
+        return L"";
+    }
+    return dir;
+}
+
+std::wstring AppPaths::DataFile(const std::wstring& name) {
+    std::wstring dir = DataDirectory();
+    return dir.empty() ? L"" : FileUtil::Join(dir, name);
+}
+
+std::wstring AppPaths::ProfilesDirectory() {
+    std::wstring dir = DataFile(L"Profiles");
+    if (dir.empty() || !FileUtil::MakeDirectories(dir)) {
+        return L"";
+    }
+    return dir;
+}
+
+std::wstring AppPaths::ProfileDirectory(const std::wstring& profileName) {
+    std::wstring root = ProfilesDirectory();
+    if (root.empty()) {
+        return L"";
+    }
+
+    // Keep the folder recognizable but safe on every filesystem
+    std::wstring readable;
+    for (wchar_t c : profileName) {
+        if (readable.size() >= 32) break;
+        bool safe = (c < 0x80 && iswalnum(c)) || c == L'-' || c == L'_';
+        readable += safe ? c : L'_';
+    }
+
+    std::string utf8 = Utf8::FromWide(profileName);
+    uint64_t hash = Checksums::Fnv1a64(utf8.data(), utf8.size());
+    wchar_t suffix[16];
+    swprintf(suffix, 16, L"%08x", (unsigned)(hash & 0xFFFFFFFF));
+    return FileUtil::Join(root, readable + L"-" + suffix);
+}
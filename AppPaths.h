@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+// Per-user locations for WebWrap's own state (caches, stores, logs).
+// Windows: %LOCALAPPDATA%\WebWrap; elsewhere $XDG_DATA_HOME/webwrap or
+// ~/.local/share/webwrap.
+class AppPaths {
+public:
+    // Creates the directory on first use; empty if it can't be determined
+    static std::wstring DataDirectory();
+
+    // DataDirectory() joined with name, or empty
+    static std::wstring DataFile(const std::wstring& name);
+
+    // Parent of every per-app browser profile
+    static std::wstring ProfilesDirectory();
+
+    // WebView2 user-data folder for an app (or a group of apps sharing one
+    // profile): a readable name plus a hash, so names that sanitize alike
+    // still get separate folders
+    static std::wstring ProfileDirectory(const std::wstring& profileName);
+};
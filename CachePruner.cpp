@@ -0,0 +1,261 @@
+#include "CachePruner.h"
+#include "FileUtil.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cwctype>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+
+// Chromium/WebView2 cache directory names; everything below them can be
+// regenerated by the browser. Service Worker/CacheStorage and ScriptCache
+// are not: they hold origin data (Cache API entries and registered worker
+// scripts) that offline and installed web apps depend on
+const wchar_t* const kCacheDirectories[] = {
+    L"Cache", L"Code Cache", L"GPUCache", L"ShaderCache", L"GrShaderCache",
+    L"GraphiteDawnCache", L"DawnCache", L"DawnWebGPUCache", L"DawnGraphiteCache",
+};
+
+// Cache index files are small and rebuilding them throws away the whole
+// cache, so only the entries they point at are pruned
+const wchar_t* const kIndexFiles[] = {
+    L"index", L"the-real-index", L"data_0", L"data_1", L"data_2", L"data_3",
+};
+
+const wchar_t* const kMarkerFile = L".last-prune";
+
+bool EqualsIgnoreCase(const std::wstring& a, const wchar_t* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; ++i) {
+        if (towlower(a[i]) != towlower(b[i])) return false;
+    }
+    return i == a.size() && !b[i];
+}
+
+bool IsIndexFile(const std::wstring& name) {
+    for (const wchar_t* index : kIndexFiles) {
+        if (EqualsIgnoreCase(name, index)) return true;
+    }
+    return false;
+}
+
+unsigned ThreadCount(unsigned requested) {
+    if (requested) return requested;
+    unsigned cores = std::thread::hardware_concurrency();
+    return std::min(std::max(cores, 1u), 8u);
+}
+
+struct WalkItem {
+    std::wstring path;
+    bool inCache;
+};
+
+// Shared work queue: workers pop a directory, list it and push its
+// subdirectories; the walk ends when the queue is empty and nobody is busy
+class WalkQueue {
+public:
+    void Push(WalkItem item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.push_back(std::move(item));
+        m_ready.notify_one();
+    }
+
+    bool Pop(WalkItem& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return !m_items.empty() || m_busy == 0; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.back());
+        m_items.pop_back();
+        m_busy++;
+        return true;
+    }
+
+    void Done() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy == 0 && m_items.empty()) {
+            m_ready.notify_all();
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::vector<WalkItem> m_items;  // LIFO keeps the working set small
+    size_t m_busy = 0;
+};
+
+void Worker(WalkQueue& queue, DiskUsage& usage) {
+    WalkItem item;
+    std::vector<FileUtil::Entry> entries;
+    while (queue.Pop(item)) {
+        entries.clear();
+        if (FileUtil::List(item.path, entries)) {
+            usage.directories++;
+            for (const FileUtil::Entry& e : entries) {
+                std::wstring path = FileUtil::Join(item.path, e.name);
+                if (e.isDirectory) {
+                    queue.Push(WalkItem{ path, item.inCache || CachePruner::IsCacheDirectory(e.name) });
+                    continue;
+                }
+                usage.files++;
+                usage.totalBytes += e.size;
+                if (item.inCache) {
+                    usage.cacheBytes += e.size;
+                    if (!IsIndexFile(e.name)) {
+                        CacheFile f;
+                        f.path = path;
+                        f.size = e.size;
+                        f.lastUsed = std::max(e.accessTime, e.modifiedTime);
+                        usage.cacheFiles.push_back(std::move(f));
+                    }
+                }
+            }
+        }
+        queue.Done();
+    }
+}
+
+}
+
+bool CachePruner::IsCacheDirectory(const std::wstring& name) {
+    for (const wchar_t* dir : kCacheDirectories) {
+        if (EqualsIgnoreCase(name, dir)) return true;
+    }
+    return false;
+}
+
+DiskUsage CachePruner::Measure(const std::wstring& root, unsigned threads) {
+    WalkQueue queue;
+    queue.Push(WalkItem{ root, false });
+
+    // Each worker accumulates privately; results are merged at the end
+    unsigned count = ThreadCount(threads);
+    std::vector<DiskUsage> partial(count);
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < count; ++i) {
+        workers.emplace_back(Worker, std::ref(queue), std::ref(partial[i]));
+    }
+    Worker(queue, partial[0]);
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    DiskUsage usage = std::move(partial[0]);
+    for (unsigned i = 1; i < count; ++i) {
+        usage.totalBytes += partial[i].totalBytes;
+        usage.cacheBytes += partial[i].cacheBytes;
+        usage.files += partial[i].files;
+        usage.directories += partial[i].directories;
+        usage.cacheFiles.insert(usage.cacheFiles.end(),
+            std::make_move_iterator(partial[i].cacheFiles.begin()),
+            std::make_move_iterator(partial[i].cacheFiles.end()));
+    }
+    return usage;
+}
+
+PruneResult CachePruner::Prune(const std::wstring& root, uint64_t budgetBytes, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    PruneResult result;
+    result.before = Measure(root, threads);
+
+    uint64_t cacheBytes = result.before.cacheBytes;
+    if (cacheBytes > budgetBytes) {
+        std::vector<CacheFile>& files = result.before.cacheFiles;
+        std::sort(files.begin(), files.end(),
+            [](const CacheFile& a, const CacheFile& b) { return a.lastUsed < b.lastUsed; });
+        for (const CacheFile& f : files) {
+            if (cacheBytes <= budgetBytes) break;
+            if (FileUtil::Remove(f.path)) {
+                cacheBytes -= f.size;
+                result.removedBytes += f.size;
+                result.removedFiles++;
+            }
+        }
+    }
+
+    result.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool CachePruner::IsProfileInUse(const std::wstring& profileDir) {
+#ifdef _WIN32
+    // The browser process keeps the profile's lockfile open without sharing
+    std::wstring lockFile = FileUtil::Join(FileUtil::Join(profileDir, L"EBWebView"), L"lockfile");
+    HANDLE hFile = CreateFileW(lockFile.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(hFile);
+        return false;
+    }
+    return GetLastError() == ERROR_SHARING_VIOLATION;
+#else
+    // Chromium on POSIX marks a running profile with a SingletonLock symlink
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(profileDir, entries);
+    for (const FileUtil::Entry& e : entries) {
+        if (e.name == L"SingletonLock") return true;
+    }
+    return false;
+#endif
+}
+
+uint64_t CachePruner::PruneProfiles(const std::wstring& profilesRoot, uint64_t budgetBytes,
+    const std::wstring& skip) {
+    std::vector<FileUtil::Entry> profiles;
+    if (!FileUtil::List(profilesRoot, profiles)) {
+        return 0;
+    }
+
+    uint64_t removed = 0;
+    for (const FileUtil::Entry& p : profiles) {
+        std::wstring dir = FileUtil::Join(profilesRoot, p.name);
+        if (!p.isDirectory || dir == skip || IsProfileInUse(dir)) {
+            continue;
+        }
+        PruneResult r = Prune(dir, budgetBytes);
+        if (r.removedFiles) {
+            std::wcout << L"Pruned " << r.removedFiles << L" cache files (" << r.removedBytes / 1024
+                       << L" KB) from profile " << p.name << L" in " << r.elapsedMs << L" ms\n";
+        }
+        removed += r.removedBytes;
+    }
+    return removed;
+}
+
+void CachePruner::StartBackground(const std::wstring& profilesRoot, uint64_t budgetBytes,
+    const std::wstring& skip) {
+    if (profilesRoot.empty() || budgetBytes == 0) {
+        return;
+    }
+
+    // Skip if another launch pruned recently
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(profilesRoot, entries);
+    int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const FileUtil::Entry& e : entries) {
+        if (e.name == kMarkerFile && now - e.modifiedTime < kMinIntervalSeconds) {
+            return;
+        }
+    }
+    FileUtil::Write(FileUtil::Join(profilesRoot, kMarkerFile), "", 0);
+
+    std::thread([profilesRoot, budgetBytes, skip]() {
+#ifdef _WIN32
+        // Background I/O priority keeps the pass from competing with the window
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+        PruneProfiles(profilesRoot, budgetBytes, skip);
+    }).detach();
+}
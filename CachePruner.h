@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CacheFile {
+    std::wstring path;
+    uint64_t size = 0;
+    int64_t lastUsed = 0;  // max(access, modification) time, Unix seconds
+};
+
+struct DiskUsage {
+    uint64_t totalBytes = 0;
+    uint64_t cacheBytes = 0;
+    size_t files = 0;
+    size_t directories = 0;
+    std::vector<CacheFile> cacheFiles;  // Files that may be deleted
+};
+
+struct PruneResult {
+    DiskUsage before;
+    uint64_t removedBytes = 0;
+    size_t removedFiles = 0;
+    double elapsedMs = 0;
+};
+
+// Keeps browser profile caches within a size budget.
+//
+// A profile is walked by a pool of threads (one directory per work item).
+// Files below well-known cache directories (HTTP cache, code cache, GPU and
+// shader caches, service worker caches) are candidates. The least recently
+// used are deleted until the profile's cache is within budget. Cookies,
+// local storage, IndexedDB and other site data are never touched.
+class CachePruner {
+public:
+    // Parallel walk of root; threads == 0 picks one per core (at most 8)
+    static DiskUsage Measure(const std::wstring& root, unsigned threads = 0);
+
+    // Deletes least-recently-used cache files under root until its cache
+    // is at most budgetBytes
+    static PruneResult Prune(const std::wstring& root, uint64_t budgetBytes, unsigned threads = 0);
+
+    // Prunes every profile under profilesRoot except skip and profiles
+    // currently open in a browser. Returns total bytes removed.
+    static uint64_t PruneProfiles(const std::wstring& profilesRoot, uint64_t budgetBytes,
+        const std::wstring& skip);
+
+    // Runs PruneProfiles on a detached low-priority thread, at most once per
+    // kMinIntervalSeconds (tracked with a marker file in profilesRoot)
+    static void StartBackground(const std::wstring& profilesRoot, uint64_t budgetBytes,
+        const std::wstring& skip);
+
+    static bool IsCacheDirectory(const std::wstring& name);
+    static bool IsProfileInUse(const std::wstring& profileDir);
+
+    static const int64_t kMinIntervalSeconds = 24 * 60 * 60;
+};
@@ -0,0 +1,339 @@
+#include "Checksums.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WW_CHECKSUMS_X86 1
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define WW_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#define WW_TARGET_CLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#endif
+
+namespace {
+
+// Slicing-by-8 tables for the reflected polynomial 0xEDB88320
+struct CrcTables {
+    uint32_t t[8][256];
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const CrcTables& GetCrcTables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+// Operates on the pre-inverted CRC register
+uint32_t Crc32Table(uint32_t c, const uint8_t* p, size_t len) {
+    const CrcTables& tb = GetCrcTables();
+    while (len >= 8) {
+        uint32_t lo = c ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+        c = tb.t[7][lo & 0xFF] ^ tb.t[6][(lo >> 8) & 0xFF] ^
+            tb.t[5][(lo >> 16) & 0xFF] ^ tb.t[4][lo >> 24] ^
+            tb.t[3][p[4]] ^ tb.t[2][p[5]] ^ tb.t[1][p[6]] ^ tb.t[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) {
+        c = tb.t[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    }
+    return c;
+}
+
+#ifdef WW_CHECKSUMS_X86
+
+bool CpuHasClmul() {
+    static const bool has = [] {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+#else
+        unsigned int a, b, c, d;
+        if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+        return (c & bit_PCLMUL) != 0 && (c & bit_SSE4_1) != 0;
+#endif
+    }();
+    return has;
+}
+
+// Carry-less multiply folding (Intel "Fast CRC Computation Using PCLMULQDQ").
+// Operates on the pre-inverted register; requires len >= 64 and len % 16 == 0.
+WW_TARGET_CLMUL
+uint32_t Crc32Clmul(uint32_t crc, const uint8_t* buf, size_t len) {
+    alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    alignas(16) static const uint64_t k3k4[] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+    alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124ULL, 0x0000000000ULL };
+    alignas(16) static const uint64_t poly[] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    x0 = _mm_load_si128((const __m128i*)k1k2);
+    buf += 64;
+    len -= 64;
+
+    // Fold four 128-bit lanes in parallel
+    while (len >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128((const __m128i*)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Remaining 16-byte blocks
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i*)buf);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    // Fold 128 bits down to 64
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128((const __m128i*)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+#endif // WW_CHECKSUMS_X86
+
+const uint32_t kAdlerBase = 65521;
+const size_t kAdlerNmax = 5552;  // Largest n with 255n(n+1)/2 + (n+1)(BASE-1) < 2^32
+
+uint32_t Adler32Scalar(uint32_t s1, uint32_t s2, const uint8_t* p, size_t len) {
+    while (len > 0) {
+        size_t n = len < kAdlerNmax ? len : kAdlerNmax;
+        len -= n;
+        while (n--) {
+            s1 += *p++;
+            s2 += s1;
+        }
+        s1 %= kAdlerBase;
+        s2 %= kAdlerBase;
+    }
+    return (s2 << 16) | s1;
+}
+
+} // namespace
+
+uint32_t Checksums::Crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    uint32_t c = ~crc;
+#ifdef WW_CHECKSUMS_X86
+    if (len >= 64 && CpuHasClmul()) {
+        size_t chunk = len & ~(size_t)15;
+        c = Crc32Clmul(c, data, chunk);
+        data += chunk;
+        len -= chunk;
+    }
+#endif
+    return ~Crc32Table(c, data, len);
+}
+
+uint32_t Checksums::Adler32(uint32_t adler, const uint8_t* data, size_t len) {
+    uint32_t s1 = adler & 0xFFFF;
+    uint32_t s2 = adler >> 16;
+
+#ifdef WW_CHECKSUMS_X86
+    // SSE2: s1 via SAD against zero, weighted s2 term via madd with 16..1
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wLo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i wHi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+
+    while (len >= 16) {
+        size_t n = (len < kAdlerNmax ? len : kAdlerNmax) & ~(size_t)15;
+        len -= n;
+
+        uint64_t blocks = n / 16;
+        __m128i vs1 = zero;   // Sum of bytes in this run
+        __m128i vps = zero;   // Prefix sums of vs1 (one per block)
+        __m128i vs2 = zero;   // Weighted in-block sums
+        while (n > 0) {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)data);
+            vps = _mm_add_epi32(vps, vs1);
+            vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(bytes, zero));
+            vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), wLo));
+            vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), wHi));
+            data += 16;
+            n -= 16;
+        }
+
+        alignas(16) uint32_t a[4], b[4], c[4];
+        _mm_store_si128((__m128i*)a, vs1);
+        _mm_store_si128((__m128i*)b, vps);
+        _mm_store_si128((__m128i*)c, vs2);
+        uint64_t sum1 = (uint64_t)a[0] + a[2];
+        uint64_t prefix = (uint64_t)b[0] + b[2];
+        uint64_t weighted = (uint64_t)c[0] + c[1] + c[2] + c[3];
+
+        uint64_t t2 = (uint64_t)s2 + (uint64_t)s1 * blocks * 16 + prefix * 16 + weighted;
+        s1 = (uint32_t)(((uint64_t)s1 + sum1) % kAdlerBase);
+        s2 = (uint32_t)(t2 % kAdlerBase);
+    }
+#endif
+
+    return Adler32Scalar(s1, s2, data, len);
+}
+
+uint64_t Checksums::Fnv1a64(const void* data, size_t len, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t h = seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+namespace {
+
+const uint64_t kXxPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kXxPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kXxPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kXxPrime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t kXxPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little-endian loads; memcpy compiles to a plain (unaligned) load
+inline uint64_t Load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint32_t Load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t XxRound(uint64_t acc, uint64_t input) {
+    acc += input * kXxPrime2;
+    return Rotl64(acc, 31) * kXxPrime1;
+}
+
+inline uint64_t XxMerge(uint64_t acc, uint64_t value) {
+    acc ^= XxRound(0, value);
+    return acc * kXxPrime1 + kXxPrime4;
+}
+
+} // namespace
+
+uint64_t Checksums::Xxh64(const void* data, size_t len, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        // Four independent lanes keep the multipliers busy
+        uint64_t v1 = seed + kXxPrime1 + kXxPrime2;
+        uint64_t v2 = seed + kXxPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kXxPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = XxRound(v1, Load64(p));
+            v2 = XxRound(v2, Load64(p + 8));
+            v3 = XxRound(v3, Load64(p + 16));
+            v4 = XxRound(v4, Load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+        h = XxMerge(h, v1);
+        h = XxMerge(h, v2);
+        h = XxMerge(h, v3);
+        h = XxMerge(h, v4);
+    } else {
+        h = seed + kXxPrime5;
+    }
+    h += (uint64_t)len;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= XxRound(0, Load64(p));
+        h = Rotl64(h, 27) * kXxPrime1 + kXxPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)Load32(p) * kXxPrime1;
+        h = Rotl64(h, 23) * kXxPrime2 + kXxPrime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * kXxPrime5;
+        h = Rotl64(h, 11) * kXxPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kXxPrime2;
+    h ^= h >> 29;
+    h *= kXxPrime3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// CRC32 (PNG/zlib polynomial), Adler32, FNV-1a and XXH64 checksums.
+// CRC32 and Adler32 dispatch to SIMD kernels when the CPU supports them and fall back
+// to portable table/scalar code otherwise.
+class Checksums {
+public:
+    // Running CRC32: pass 0 for the first call, then the previous result.
+    static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+    // Running Adler32: pass 1 for the first call, then the previous result.
+    static uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t len);
+
+    // 64-bit FNV-1a, used for cheap content fingerprints (not cryptographic)
+    static uint64_t Fnv1a64(const void* data, size_t len, uint64_t seed = 0xcbf29ce484222325ULL);
+
+    // 64-bit xxHash (XXH64), for fingerprints of large inputs: it consumes
+    // 32 bytes per step, where FNV-1a takes one (not cryptographic)
+    static uint64_t Xxh64(const void* data, size_t len, uint64_t seed = 0);
+};
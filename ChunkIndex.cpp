@@ -0,0 +1,181 @@
+#include "ChunkIndex.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = { 'W', 'W', 'C', 'I' };
+const uint64_t kFormatVersion = 1;
+
+void PutU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back((char)(v >> (8 * i)));
+}
+
+bool GetU64(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    if (end - p < 8) return false;
+    v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    p += 8;
+    return true;
+}
+
+// Relative paths of every file below dir, prefix included
+bool ListFiles(const std::wstring& dir, const std::string& prefix, std::vector<std::string>& paths) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) {
+        return false;
+    }
+    for (const FileUtil::Entry& e : entries) {
+        std::string name = prefix + Utf8::FromWide(e.name);
+        if (e.isDirectory) {
+            if (!ListFiles(FileUtil::Join(dir, e.name), name + "/", paths)) return false;
+        } else {
+            paths.push_back(name);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+uint64_t TreeIndex::TotalBytes() const {
+    uint64_t total = 0;
+    for (const IndexedFile& f : files) total += f.size;
+    return total;
+}
+
+uint64_t TreeIndex::Hash() const {
+    std::string summary;
+    for (const IndexedFile& f : files) {
+        Varint::PutString(summary, f.path);
+        Varint::Put(summary, f.size);
+        PutU64(summary, f.hash);
+    }
+    return Checksums::Xxh64(summary.data(), summary.size());
+}
+
+bool ChunkIndex::Build(const std::wstring& root, TreeIndex& index, std::vector<std::string>* contents) {
+    index = TreeIndex();
+    if (contents) contents->clear();
+
+    std::vector<std::string> paths;
+    if (!ListFiles(root, "", paths)) {
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::string data;
+    std::vector<Chunk> chunks;
+    for (const std::string& path : paths) {
+        if (!FileUtil::Read(FileUtil::Join(root, Utf8::ToWide(path)), data)) {
+            return false;
+        }
+        IndexedFile file;
+        file.path = path;
+        file.size = data.size();
+        file.hash = Checksums::Xxh64(data.data(), data.size());
+        chunks.clear();
+        Chunker::Split((const uint8_t*)data.data(), data.size(), chunks);
+        file.chunks.reserve(chunks.size());
+        for (const Chunk& c : chunks) {
+            IndexedChunk ic;
+            ic.hash = c.hash;
+            ic.length = (uint32_t)c.length;
+            file.chunks.push_back(ic);
+        }
+        index.files.push_back(std::move(file));
+        if (contents) contents->push_back(std::move(data));
+    }
+    return true;
+}
+
+void ChunkIndex::Serialize(const TreeIndex& index, std::string& out) {
+    out.assign(kMagic, 4);
+    Varint::Put(out, kFormatVersion);
+    Varint::Put(out, index.chunkerVersion);
+    Varint::Put(out, index.files.size());
+    for (const IndexedFile& f : index.files) {
+        Varint::PutString(out, f.path);
+        Varint::Put(out, f.size);
+        PutU64(out, f.hash);
+        Varint::Put(out, f.chunks.size());
+        for (const IndexedChunk& c : f.chunks) {
+            PutU64(out, c.hash);
+            Varint::Put(out, c.length);
+        }
+    }
+    uint32_t crc = Checksums::Crc32(0, (const uint8_t*)out.data(), out.size());
+    for (int i = 0; i < 4; i++) out.push_back((char)(crc >> (8 * i)));
+}
+
+bool ChunkIndex::IsIndex(const uint8_t* data, size_t len) {
+    return len >= 4 && memcmp(data, kMagic, 4) == 0;
+}
+
+bool ChunkIndex::Parse(const uint8_t* data, size_t len, TreeIndex& index) {
+    index = TreeIndex();
+    if (!IsIndex(data, len) || len < 8) {
+        return false;
+    }
+    const uint8_t* end = data + len - 4;
+    uint32_t crc = (uint32_t)end[0] | ((uint32_t)end[1] << 8) | ((uint32_t)end[2] << 16) | ((uint32_t)end[3] << 24);
+    if (Checksums::Crc32(0, data, len - 4) != crc) {
+        return false;
+    }
+
+    const uint8_t* p = data + 4;
+    uint64_t version = 0, chunkerVersion = 0, count = 0;
+    if (!Varint::Get(p, end, version) || version != kFormatVersion || !Varint::Get(p, end, chunkerVersion) ||
+        !Varint::Get(p, end, count)) {
+        return false;
+    }
+    index.chunkerVersion = (uint32_t)chunkerVersion;
+    for (uint64_t i = 0; i < count; i++) {
+        IndexedFile f;
+        uint64_t chunkCount = 0;
+        if (!Varint::GetString(p, end, f.path) || !IsSafePath(f.path) || !Varint::Get(p, end, f.size) ||
+            !GetU64(p, end, f.hash) || !Varint::Get(p, end, chunkCount) || chunkCount > (uint64_t)(end - p)) {
+            return false;
+        }
+        uint64_t total = 0;
+        f.chunks.resize((size_t)chunkCount);
+        for (IndexedChunk& c : f.chunks) {
+            uint64_t length = 0;
+            if (!GetU64(p, end, c.hash) || !Varint::Get(p, end, length) || !length || length > Chunker::kMaxSize) {
+                return false;
+            }
+            c.length = (uint32_t)length;
+            total += length;
+        }
+        if (total != f.size) {
+            return false;
+        }
+        index.files.push_back(std::move(f));
+    }
+    return p == end;
+}
+
+bool ChunkIndex::IsSafePath(const std::string& path) {
+    if (path.empty() || path.find_first_of("\\:*?\"<>|") != std::string::npos) {
+        return false;
+    }
+    size_t start = 0;
+    for (;;) {
+        size_t slash = path.find('/', start);
+        std::string segment = path.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (segment.empty() || segment == "." || segment == "..") {
+            return false;
+        }
+        for (char ch : segment) {
+            if ((unsigned char)ch < 0x20) return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+        start = slash + 1;
+    }
+}
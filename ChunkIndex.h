@@ -0,0 +1,57 @@
+#pragma once
+#include "Chunker.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct IndexedChunk {
+    uint64_t hash = 0;              // Checksums::Xxh64
+    uint32_t length = 0;
+};
+
+struct IndexedFile {
+    std::string path;               // Relative to the tree root, UTF-8, '/' separators
+    uint64_t size = 0;
+    uint64_t hash = 0;              // Checksums::Xxh64 of the whole file
+    std::vector<IndexedChunk> chunks;
+};
+
+// Chunk list of every file in a directory tree: what one version of a
+// local web app consists of
+struct TreeIndex {
+    uint32_t chunkerVersion = Chunker::kVersion;
+    std::vector<IndexedFile> files; // Sorted by path
+
+    uint64_t TotalBytes() const;
+
+    // Xxh64 over every path, size and file hash: equal indexes describe
+    // identical trees
+    uint64_t Hash() const;
+};
+
+// Builds, stores and reads TreeIndex. A saved index stands in for the old
+// version of a tree when making a patch (ww diff), so the old files
+// needn't be kept around. Empty directories are not recorded.
+//
+//   "WWCI" version chunkerVersion count
+//   { path size hash(8) chunkCount { hash(8) length } }  crc32(4)
+//
+// Counts and sizes are varints; the trailing CRC32 covers everything before it.
+class ChunkIndex {
+public:
+    // Reads and chunks every file below root. contents, when given,
+    // receives each file's bytes, in the order of index.files.
+    static bool Build(const std::wstring& root, TreeIndex& index, std::vector<std::string>* contents = nullptr);
+
+    static void Serialize(const TreeIndex& index, std::string& out);
+    static bool Parse(const uint8_t* data, size_t len, TreeIndex& index);
+
+    // Whether data starts like a saved index
+    static bool IsIndex(const uint8_t* data, size_t len);
+
+    // Whether a path from an index or patch can be joined under a root:
+    // relative, '/' separated, with no empty, "." or ".." segment and
+    // none of the characters Windows treats specially (\ : * ? " < > |)
+    static bool IsSafePath(const std::string& path);
+};
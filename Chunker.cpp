@@ -0,0 +1,71 @@
+#include "Chunker.h"
+#include "Checksums.h"
+
+namespace {
+
+// One random 64-bit value per byte value, from a fixed seed: the table
+// is part of the chunk format (see Chunker::kVersion)
+struct GearTable {
+    uint64_t values[256];
+
+    GearTable() {
+        uint64_t state = 0x5745425752415043ULL;  // "WEBWRAPC"
+        for (uint64_t& v : values) {
+            // splitmix64
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            v = z ^ (z >> 31);
+        }
+    }
+};
+
+const GearTable& Gear() {
+    static const GearTable table;
+    return table;
+}
+
+// The gear hash shifts left by one per byte, so its top bits depend on the
+// most bytes (up to 64). 15 and 11 bits: one cut per 32 KB and 2 KB on
+// random data, around the 8 KB average.
+const uint64_t kMaskSmall = ~0ULL << (64 - 15);
+const uint64_t kMaskLarge = ~0ULL << (64 - 11);
+
+} // namespace
+
+size_t Chunker::Cut(const uint8_t* data, size_t len) {
+    if (len <= kMinSize) {
+        return len;
+    }
+    const uint64_t* gear = Gear().values;
+    size_t normal = len < kAvgSize ? len : kAvgSize;
+    size_t end = len < kMaxSize ? len : kMaxSize;
+
+    uint64_t hash = 0;
+    size_t i = kMinSize;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & kMaskSmall)) {
+            return i + 1;
+        }
+    }
+    for (; i < end; i++) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & kMaskLarge)) {
+            return i + 1;
+        }
+    }
+    return end;
+}
+
+void Chunker::Split(const uint8_t* data, size_t len, std::vector<Chunk>& chunks) {
+    size_t offset = 0;
+    while (offset < len) {
+        Chunk c;
+        c.offset = offset;
+        c.length = Cut(data + offset, len - offset);
+        c.hash = Checksums::Xxh64(data + offset, c.length);
+        chunks.push_back(c);
+        offset += c.length;
+    }
+}
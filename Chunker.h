@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A piece of a file found by Chunker
+struct Chunk {
+    size_t offset = 0;
+    size_t length = 0;
+    uint64_t hash = 0;  // Checksums::Xxh64 of the bytes
+};
+
+// Content-defined chunking (FastCDC): a gear rolling hash over the last 64
+// bytes picks cut points from the content itself, so an insertion or
+// deletion only changes the chunks around it, and the rest of the file
+// still splits into the same chunks at shifted offsets.
+//
+// Cut points are never closer than kMinSize (those bytes aren't hashed at
+// all) and at most kMaxSize apart. Below kAvgSize a stricter mask makes a
+// cut less likely, above it a looser one, which keeps sizes close to the
+// average ("normalized chunking").
+class Chunker {
+public:
+    static const size_t kMinSize = 2 * 1024;
+    static const size_t kAvgSize = 8 * 1024;
+    static const size_t kMaxSize = 64 * 1024;
+
+    // Changes whenever the cut points for the same input would change
+    // (sizes, masks or the gear table); stored in indexes and patches
+    static const uint32_t kVersion = 1;
+
+    // Length of the chunk starting at data
+    static size_t Cut(const uint8_t* data, size_t len);
+
+    // Appends the chunks of data to chunks, with their hashes
+    static void Split(const uint8_t* data, size_t len, std::vector<Chunk>& chunks);
+};
@@ -0,0 +1,538 @@
+#include "Deflate.h"
+#include "Checksums.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int kWindowSize = 32768;
+const int kWindowMask = kWindowSize - 1;
+const int kHashBits = 15;
+const int kHashSize = 1 << kHashBits;
+const int kMinMatch = 3;
+const int kMaxMatch = 258;
+const size_t kMaxBlockSymbols = 1 << 15;
+
+struct LevelConfig {
+    int maxChain;     // Hash chain entries to examine
+    int niceLength;   // Stop searching once a match this long is found
+    int maxInsert;    // Only insert every string of matches up to this length
+    bool lazy;        // Try a match at the next byte before committing
+};
+
+const LevelConfig kLevels[10] = {
+    { 0,    0,   0,   false },  // 0: stored only
+    { 4,    16,  8,   false },
+    { 8,    32,  16,  false },
+    { 16,   64,  32,  false },
+    { 16,   32,  258, true  },
+    { 32,   64,  258, true  },
+    { 128,  128, 258, true  },
+    { 256,  192, 258, true  },
+    { 1024, 258, 258, true  },
+    { 4096, 258, 258, true  },
+};
+
+const uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint8_t kCodeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+struct LengthTable {
+    uint8_t code[kMaxMatch + 1];  // length -> code index (0..28)
+    LengthTable() {
+        for (int c = 0; c < 29; c++) {
+            int end = (c == 28) ? kMaxMatch : kLengthBase[c] + (1 << kLengthExtra[c]) - 1;
+            for (int l = kLengthBase[c]; l <= end && l <= kMaxMatch; l++) {
+                code[l] = (uint8_t)c;
+            }
+        }
+        code[kMaxMatch] = 28;
+    }
+};
+
+const LengthTable& GetLengthTable() {
+    static const LengthTable table;
+    return table;
+}
+
+inline int DistCode(int dist) {
+    unsigned v = (unsigned)dist - 1;
+    if (v < 4) return (int)v;
+    int l = 31;
+    while (!(v & (1u << l))) l--;
+    return 2 * l + (int)((v >> (l - 1)) & 1);
+}
+
+inline int DistExtra(int code) {
+    return code < 4 ? 0 : (code / 2) - 1;
+}
+
+inline int DistBase(int code) {
+    return code < 4 ? code + 1 : ((2 + (code & 1)) << ((code / 2) - 1)) + 1;
+}
+
+struct Symbol {
+    uint16_t litLen;  // Literal byte, or match length when dist != 0
+    uint16_t dist;
+};
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void Put(uint32_t bits, int count) {
+        m_buf |= (uint64_t)bits << m_count;
+        m_count += count;
+        while (m_count >= 8) {
+            m_out.push_back((uint8_t)m_buf);
+            m_buf >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void AlignToByte() {
+        if (m_count > 0) {
+            m_out.push_back((uint8_t)m_buf);
+            m_buf = 0;
+            m_count = 0;
+        }
+    }
+
+    std::vector<uint8_t>& Bytes() { return m_out; }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint64_t m_buf = 0;
+    int m_count = 0;
+};
+
+// Moffat-Katajainen in-place minimum redundancy code lengths.
+// a[] holds ascending frequencies on entry and code lengths on exit.
+void MinimumRedundancy(std::vector<int>& a) {
+    int n = (int)a.size();
+    if (n == 0) return;
+    if (n == 1) { a[0] = 1; return; }
+
+    a[0] += a[1];
+    int root = 0, leaf = 2;
+    for (int next = 1; next < n - 1; next++) {
+        if (leaf >= n || a[root] < a[leaf]) { a[next] = a[root]; a[root++] = next; }
+        else a[next] = a[leaf++];
+        if (leaf >= n || (root < next && a[root] < a[leaf])) { a[next] += a[root]; a[root++] = next; }
+        else a[next] += a[leaf++];
+    }
+
+    a[n - 2] = 0;
+    for (int next = n - 3; next >= 0; next--) a[next] = a[a[next]] + 1;
+
+    int avail = 1, used = 0, depth = 0;
+    root = n - 2;
+    int next = n - 1;
+    while (avail > 0) {
+        while (root >= 0 && a[root] == depth) { used++; root--; }
+        while (avail > used) { a[next--] = depth; avail--; }
+        avail = 2 * used;
+        depth++;
+        used = 0;
+    }
+}
+
+// Builds length-limited Huffman code lengths for freqs
+void BuildLengths(const uint32_t* freqs, int count, int maxBits, uint8_t* lengths) {
+    std::vector<uint32_t> f(freqs, freqs + count);
+    for (;;) {
+        std::vector<int> order;
+        for (int i = 0; i < count; i++) {
+            if (f[i] > 0) order.push_back(i);
+        }
+        std::fill(lengths, lengths + count, (uint8_t)0);
+        if (order.empty()) return;
+
+        std::stable_sort(order.begin(), order.end(),
+            [&](int x, int y) { return f[x] < f[y]; });
+        std::vector<int> a(order.size());
+        for (size_t i = 0; i < order.size(); i++) a[i] = (int)f[order[i]];
+        MinimumRedundancy(a);
+
+        int longest = 0;
+        for (size_t i = 0; i < order.size(); i++) {
+            lengths[order[i]] = (uint8_t)a[i];
+            longest = std::max(longest, a[i]);
+        }
+        if (longest <= maxBits) return;
+
+        // Flatten the distribution and retry
+        for (int i = 0; i < count; i++) {
+            if (f[i] > 0) f[i] = (f[i] >> 1) | 1;
+        }
+    }
+}
+
+// Canonical codes, bit-reversed for LSB-first output
+void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+    uint16_t blCount[16] = {};
+    for (int i = 0; i < count; i++) blCount[lengths[i]]++;
+    blCount[0] = 0;
+
+    uint16_t nextCode[16] = {};
+    uint16_t code = 0;
+    for (int bits = 1; bits < 16; bits++) {
+        code = (uint16_t)((code + blCount[bits - 1]) << 1);
+        nextCode[bits] = code;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int len = lengths[i];
+        if (len == 0) { codes[i] = 0; continue; }
+        uint16_t c = nextCode[len]++;
+        uint16_t rev = 0;
+        for (int b = 0; b < len; b++) {
+            rev = (uint16_t)((rev << 1) | ((c >> b) & 1));
+        }
+        codes[i] = rev;
+    }
+}
+
+class BlockWriter {
+public:
+    BlockWriter(BitWriter& bits) : m_bits(bits) {}
+
+    void Write(const std::vector<Symbol>& syms, const uint8_t* raw, size_t rawLen, bool final) {
+        const LengthTable& lt = GetLengthTable();
+
+        uint32_t litFreq[286] = {};
+        uint32_t distFreq[30] = {};
+        uint64_t extraBits = 0;
+        for (const Symbol& s : syms) {
+            if (s.dist == 0) {
+                litFreq[s.litLen]++;
+            } else {
+                int lc = lt.code[s.litLen];
+                int dc = DistCode(s.dist);
+                litFreq[257 + lc]++;
+                distFreq[dc]++;
+                extraBits += kLengthExtra[lc] + DistExtra(dc);
+            }
+        }
+        litFreq[256] = 1;
+
+        // Dynamic code lengths
+        uint8_t litLen[286], distLen[30];
+        BuildLengths(litFreq, 286, 15, litLen);
+        BuildLengths(distFreq, 30, 15, distLen);
+        EnsureTwoCodes(distLen, 30);
+
+        int hlit = 286;
+        while (hlit > 257 && litLen[hlit - 1] == 0) hlit--;
+        int hdist = 30;
+        while (hdist > 1 && distLen[hdist - 1] == 0) hdist--;
+
+        std::vector<uint8_t> all(litLen, litLen + hlit);
+        all.insert(all.end(), distLen, distLen + hdist);
+        std::vector<std::pair<uint8_t, uint8_t>> rle;  // (symbol, extra value)
+        EncodeRunLengths(all, rle);
+
+        uint32_t clFreq[19] = {};
+        for (auto& r : rle) clFreq[r.first]++;
+        uint8_t clLen[19];
+        BuildLengths(clFreq, 19, 7, clLen);
+        EnsureTwoCodes(clLen, 19);
+        int hclen = 19;
+        while (hclen > 4 && clLen[kCodeLengthOrder[hclen - 1]] == 0) hclen--;
+
+        uint64_t dynBits = 3 + 5 + 5 + 4 + 3 * (uint64_t)hclen + extraBits;
+        for (auto& r : rle) {
+            dynBits += clLen[r.first];
+            dynBits += r.first == 16 ? 2 : r.first == 17 ? 3 : r.first == 18 ? 7 : 0;
+        }
+        uint64_t fixBits = 3 + extraBits;
+        for (int i = 0; i < 286; i++) {
+            dynBits += (uint64_t)litFreq[i] * litLen[i];
+            fixBits += (uint64_t)litFreq[i] * FixedLitLength(i);
+        }
+        for (int i = 0; i < 30; i++) {
+            dynBits += (uint64_t)distFreq[i] * distLen[i];
+            fixBits += (uint64_t)distFreq[i] * 5;
+        }
+        uint64_t storedBits = 3 + 7 + 32 + (uint64_t)rawLen * 8 + 40 * (rawLen / 65535);
+
+        if (storedBits <= dynBits && storedBits <= fixBits) {
+            WriteStored(raw, rawLen, final);
+            return;
+        }
+
+        uint16_t litCodes[286], distCodes[30];
+        if (fixBits <= dynBits) {
+            uint8_t fixedLit[288], fixedDist[30];
+            for (int i = 0; i < 288; i++) fixedLit[i] = (uint8_t)FixedLitLength(i);
+            for (int i = 0; i < 30; i++) fixedDist[i] = 5;
+            uint16_t fixedLitCodes[288];
+            BuildCodes(fixedLit, 288, fixedLitCodes);
+            BuildCodes(fixedDist, 30, distCodes);
+            m_bits.Put(final ? 1 : 0, 1);
+            m_bits.Put(1, 2);
+            WriteSymbols(syms, fixedLitCodes, fixedLit, distCodes, fixedDist);
+            return;
+        }
+
+        BuildCodes(litLen, 286, litCodes);
+        BuildCodes(distLen, 30, distCodes);
+        uint16_t clCodes[19];
+        BuildCodes(clLen, 19, clCodes);
+
+        m_bits.Put(final ? 1 : 0, 1);
+        m_bits.Put(2, 2);
+        m_bits.Put((uint32_t)(hlit - 257), 5);
+        m_bits.Put((uint32_t)(hdist - 1), 5);
+        m_bits.Put((uint32_t)(hclen - 4), 4);
+        for (int i = 0; i < hclen; i++) {
+            m_bits.Put(clLen[kCodeLengthOrder[i]], 3);
+        }
+        for (auto& r : rle) {
+            m_bits.Put(clCodes[r.first], clLen[r.first]);
+            if (r.first == 16) m_bits.Put(r.second, 2);
+            else if (r.first == 17) m_bits.Put(r.second, 3);
+            else if (r.first == 18) m_bits.Put(r.second, 7);
+        }
+        WriteSymbols(syms, litCodes, litLen, distCodes, distLen);
+    }
+
+    void WriteStored(const uint8_t* raw, size_t rawLen, bool final) {
+        do {
+            size_t n = std::min(rawLen, (size_t)65535);
+            rawLen -= n;
+            m_bits.Put((final && rawLen == 0) ? 1 : 0, 1);
+            m_bits.Put(0, 2);
+            m_bits.AlignToByte();
+            m_bits.Put((uint32_t)n, 16);
+            m_bits.Put((uint32_t)(~n & 0xFFFF), 16);
+            std::vector<uint8_t>& out = m_bits.Bytes();
+            out.insert(out.end(), raw, raw + n);
+            raw += n;
+        } while (rawLen > 0);
+    }
+
+private:
+    BitWriter& m_bits;
+
+    static int FixedLitLength(int sym) {
+        if (sym < 144) return 8;
+        if (sym < 256) return 9;
+        if (sym < 280) return 7;
+        return 8;
+    }
+
+    // Strict decoders reject incomplete trees, so pad single-code sets
+    static void EnsureTwoCodes(uint8_t* lengths, int count) {
+        int used = 0, first = -1;
+        for (int i = 0; i < count; i++) {
+            if (lengths[i]) { used++; if (first < 0) first = i; }
+        }
+        if (used >= 2) return;
+        lengths[first == 0 ? 1 : 0] = 1;
+        lengths[first > 0 ? first : (first == 0 ? 0 : 1)] = 1;
+    }
+
+    static void EncodeRunLengths(const std::vector<uint8_t>& lens,
+        std::vector<std::pair<uint8_t, uint8_t>>& rle) {
+        size_t i = 0;
+        while (i < lens.size()) {
+            uint8_t v = lens[i];
+            size_t run = 1;
+            while (i + run < lens.size() && lens[i + run] == v) run++;
+            size_t left = run;
+            if (v == 0) {
+                while (left >= 11) {
+                    size_t n = std::min(left, (size_t)138);
+                    rle.push_back({ 18, (uint8_t)(n - 11) });
+                    left -= n;
+                }
+                if (left >= 3) {
+                    rle.push_back({ 17, (uint8_t)(left - 3) });
+                    left = 0;
+                }
+            } else {
+                rle.push_back({ v, 0 });
+                left--;
+                while (left >= 3) {
+                    size_t n = std::min(left, (size_t)6);
+                    rle.push_back({ 16, (uint8_t)(n - 3) });
+                    left -= n;
+                }
+            }
+            while (left-- > 0) rle.push_back({ v, 0 });
+            i += run;
+        }
+    }
+
+    void WriteSymbols(const std::vector<Symbol>& syms,
+        const uint16_t* litCodes, const uint8_t* litLen,
+        const uint16_t* distCodes, const uint8_t* distLen) {
+        const LengthTable& lt = GetLengthTable();
+        for (const Symbol& s : syms) {
+            if (s.dist == 0) {
+                m_bits.Put(litCodes[s.litLen], litLen[s.litLen]);
+                continue;
+            }
+            int lc = lt.code[s.litLen];
+            m_bits.Put(litCodes[257 + lc], litLen[257 + lc]);
+            if (kLengthExtra[lc]) m_bits.Put(s.litLen - kLengthBase[lc], kLengthExtra[lc]);
+            int dc = DistCode(s.dist);
+            m_bits.Put(distCodes[dc], distLen[dc]);
+            if (DistExtra(dc)) m_bits.Put((uint32_t)(s.dist - DistBase(dc)), DistExtra(dc));
+        }
+        m_bits.Put(litCodes[256], litLen[256]);
+    }
+};
+
+class Matcher {
+public:
+    Matcher(const uint8_t* data, size_t len, const LevelConfig& cfg)
+        : m_data(data), m_len(len), m_cfg(cfg),
+          m_head(kHashSize, -1), m_prev(kWindowSize, -1) {}
+
+    void Insert(size_t pos) {
+        if (pos + kMinMatch > m_len) return;
+        uint32_t h = Hash(pos);
+        m_prev[pos & kWindowMask] = m_head[h];
+        m_head[h] = (int32_t)pos;
+    }
+
+    // Longest match at pos against earlier data; returns length (0 if < kMinMatch)
+    int Find(size_t pos, int prevLength, int& dist) const {
+        if (pos + kMinMatch > m_len) return 0;
+        int maxLen = (int)std::min((size_t)kMaxMatch, m_len - pos);
+        if (prevLength >= maxLen) return 0;  // Can't beat it, and ref[best] would read past the end
+        int best = std::max(prevLength, kMinMatch - 1);
+        int chain = m_cfg.maxChain;
+        if (prevLength >= 32) chain >>= 2;
+
+        const uint8_t* cur = m_data + pos;
+        int32_t cand = m_head[Hash(pos)];
+        int bestLen = 0;
+        while (cand >= 0 && chain-- > 0) {
+            size_t d = pos - (size_t)cand;
+            if (d == 0 || d > (size_t)kWindowSize) break;
+            const uint8_t* ref = m_data + cand;
+            if (ref[best] == cur[best] && ref[0] == cur[0] && ref[1] == cur[1]) {
+                int l = 2;
+                while (l < maxLen && ref[l] == cur[l]) l++;
+                if (l > best) {
+                    best = l;
+                    bestLen = l;
+                    dist = (int)d;
+                    if (l >= m_cfg.niceLength || l == maxLen) break;
+                }
+            }
+            int32_t next = m_prev[cand & kWindowMask];
+            if (next >= cand) break;
+            cand = next;
+        }
+        return bestLen >= kMinMatch ? bestLen : 0;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_len;
+    const LevelConfig& m_cfg;
+    std::vector<int32_t> m_head;
+    std::vector<int32_t> m_prev;
+
+    uint32_t Hash(size_t pos) const {
+        uint32_t v = (uint32_t)m_data[pos] | ((uint32_t)m_data[pos + 1] << 8) | ((uint32_t)m_data[pos + 2] << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+};
+
+} // namespace
+
+void Deflate::Compress(const uint8_t* data, size_t len, int level, std::vector<uint8_t>& out) {
+    level = std::max(0, std::min(9, level));
+    BitWriter bits(out);
+    BlockWriter writer(bits);
+
+    if (level == 0 || len == 0) {
+        writer.WriteStored(data, len, true);
+        bits.AlignToByte();
+        return;
+    }
+
+    const LevelConfig& cfg = kLevels[level];
+    Matcher matcher(data, len, cfg);
+    std::vector<Symbol> syms;
+    syms.reserve(kMaxBlockSymbols + 2);
+
+    size_t blockStart = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        int dist = 0;
+        int matchLen = matcher.Find(pos, 0, dist);
+
+        if (matchLen > 0 && cfg.lazy && matchLen < cfg.niceLength && pos + 1 < len) {
+            // Lazy evaluation: prefer a longer match starting one byte later
+            size_t inserted = pos;
+            matcher.Insert(pos);
+            int nextDist = 0;
+            int nextLen = matcher.Find(pos + 1, matchLen, nextDist);
+            if (nextLen > matchLen) {
+                syms.push_back({ data[pos], 0 });
+                pos++;
+                matchLen = nextLen;
+                dist = nextDist;
+            }
+            syms.push_back({ (uint16_t)matchLen, (uint16_t)dist });
+            size_t end = pos + matchLen;
+            for (size_t p = pos; p < end; p++) {
+                if (p != inserted) matcher.Insert(p);
+            }
+            pos = end;
+        } else if (matchLen > 0) {
+            syms.push_back({ (uint16_t)matchLen, (uint16_t)dist });
+            size_t end = pos + matchLen;
+            if (matchLen <= cfg.maxInsert) {
+                for (size_t p = pos; p < end; p++) matcher.Insert(p);
+            } else {
+                matcher.Insert(pos);
+            }
+            pos = end;
+        } else {
+            matcher.Insert(pos);
+            syms.push_back({ data[pos], 0 });
+            pos++;
+        }
+
+        if (syms.size() >= kMaxBlockSymbols) {
+            writer.Write(syms, data + blockStart, pos - blockStart, pos >= len);
+            syms.clear();
+            blockStart = pos;
+        }
+    }
+
+    if (!syms.empty() || blockStart == 0) {
+        writer.Write(syms, data + blockStart, pos - blockStart, true);
+    }
+    bits.AlignToByte();
+}
+
+void Deflate::CompressZlib(const uint8_t* data, size_t len, int level, std::vector<uint8_t>& out) {
+    // CMF: deflate, 32K window. FLG: level hint, FCHECK makes CMF*256+FLG % 31 == 0
+    uint8_t cmf = 0x78;
+    uint8_t flevel = level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3;
+    uint8_t flg = (uint8_t)(flevel << 6);
+    flg = (uint8_t)(flg + (31 - ((cmf * 256 + flg) % 31)) % 31);
+    out.push_back(cmf);
+    out.push_back(flg);
+
+    Compress(data, len, level, out);
+
+    uint32_t adler = Checksums::Adler32(1, data, len);
+    out.push_back((uint8_t)(adler >> 24));
+    out.push_back((uint8_t)(adler >> 16));
+    out.push_back((uint8_t)(adler >> 8));
+    out.push_back((uint8_t)adler);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small speed-tuned DEFLATE (RFC 1951) encoder.
+// Level 0 stores, 1-3 favour speed (short hash chains, greedy parsing),
+// 4-9 add lazy matching and longer chains. Each block picks the cheapest
+// of stored, fixed Huffman and dynamic Huffman coding.
+class Deflate {
+public:
+    static const int kDefaultLevel = 6;
+
+    // Appends a raw DEFLATE stream for data to out
+    static void Compress(const uint8_t* data, size_t len, int level, std::vector<uint8_t>& out);
+
+    // Appends a zlib (RFC 1950) stream: header, DEFLATE data, Adler32 trailer
+    static void CompressZlib(const uint8_t* data, size_t len, int level, std::vector<uint8_t>& out);
+};
@@ -0,0 +1,371 @@
+#include "DeltaPatch.h"
+#include "Checksums.h"
+#include "Deflate.h"
+#include "FileUtil.h"
+#include "Inflate.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+const char kMagic[4] = { 'W', 'W', 'D', 'P' };
+const uint64_t kFormatVersion = 1;
+const int kLiteralLevel = 6;
+
+const wchar_t kTempSuffix[] = L".patch-tmp";
+const wchar_t kNewSuffix[] = L".patch-new";
+const wchar_t kOldSuffix[] = L".patch-old";
+
+struct PatchOp {
+    uint32_t length = 0;
+    bool literal = false;
+    uint64_t hash = 0;
+};
+
+struct PatchFile {
+    std::string path;
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    std::vector<PatchOp> ops;
+};
+
+struct ParsedPatch {
+    uint64_t baseHash = 0;
+    uint64_t targetHash = 0;
+    std::vector<PatchFile> files;
+    std::vector<uint8_t> literals;
+};
+
+// Bytes a chunk hash resolves to while applying
+struct Slice {
+    const char* data = nullptr;
+    uint32_t length = 0;
+};
+
+void PutU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back((char)(v >> (8 * i)));
+}
+
+bool GetU64(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    if (end - p < 8) return false;
+    v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    p += 8;
+    return true;
+}
+
+bool Parse(const uint8_t* data, size_t len, ParsedPatch& patch, std::string& error) {
+    if (len < 8 || memcmp(data, kMagic, 4) != 0) {
+        error = "not a patch";
+        return false;
+    }
+    const uint8_t* end = data + len - 4;
+    uint32_t crc = (uint32_t)end[0] | ((uint32_t)end[1] << 8) | ((uint32_t)end[2] << 16) | ((uint32_t)end[3] << 24);
+    if (Checksums::Crc32(0, data, len - 4) != crc) {
+        error = "patch is damaged (checksum mismatch)";
+        return false;
+    }
+
+    const uint8_t* p = data + 4;
+    uint64_t version = 0, chunkerVersion = 0, count = 0;
+    if (!Varint::Get(p, end, version) || version != kFormatVersion || !Varint::Get(p, end, chunkerVersion)) {
+        error = "unsupported patch version";
+        return false;
+    }
+    if (chunkerVersion != Chunker::kVersion) {
+        error = "patch was made with a different chunker version";
+        return false;
+    }
+    error = "patch is malformed";
+    if (!GetU64(p, end, patch.baseHash) || !GetU64(p, end, patch.targetHash) || !Varint::Get(p, end, count)) {
+        return false;
+    }
+
+    uint64_t literalTotal = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        PatchFile f;
+        uint64_t opCount = 0;
+        if (!Varint::GetString(p, end, f.path) || !Varint::Get(p, end, f.size) || !GetU64(p, end, f.hash) ||
+            !Varint::Get(p, end, opCount) || opCount > (uint64_t)(end - p)) {
+            return false;
+        }
+        if (!ChunkIndex::IsSafePath(f.path)) {
+            error = "patch contains an unsafe path: " + f.path;
+            return false;
+        }
+        uint64_t total = 0;
+        f.ops.resize((size_t)opCount);
+        for (PatchOp& op : f.ops) {
+            uint64_t v = 0;
+            if (!Varint::Get(p, end, v)) return false;
+            op.literal = (v & 1) != 0;
+            uint64_t length = v >> 1;
+            if (!length || length > Chunker::kMaxSize) return false;
+            op.length = (uint32_t)length;
+            if (op.literal) {
+                literalTotal += length;
+            } else if (!GetU64(p, end, op.hash)) {
+                return false;
+            }
+            total += length;
+        }
+        if (total != f.size) {
+            return false;
+        }
+        patch.files.push_back(std::move(f));
+    }
+
+    uint64_t literalBytes = 0, zlibBytes = 0;
+    if (!Varint::Get(p, end, literalBytes) || literalBytes != literalTotal || !Varint::Get(p, end, zlibBytes) ||
+        zlibBytes != (uint64_t)(end - p)) {
+        return false;
+    }
+    if (literalBytes && (!Inflate::DecompressZlib(p, (size_t)zlibBytes, (size_t)literalBytes, patch.literals) ||
+        patch.literals.size() != literalBytes)) {
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+// "app\" and "app" name the same folder, but the swap siblings must be
+// built next to it rather than inside it. A drive root ("C:\") is kept.
+std::wstring StripSeparators(const std::wstring& path) {
+    size_t end = path.size();
+    while (end > 1 && (path[end - 1] == L'\\' || path[end - 1] == L'/') && path[end - 2] != L':') end--;
+    return path.substr(0, end);
+}
+
+bool WriteTree(const std::wstring& root, const std::vector<PatchFile>& files,
+    const std::vector<std::string>& contents) {
+    if (!FileUtil::MakeDirectories(root)) {
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        std::wstring path = FileUtil::Join(root, Utf8::ToWide(files[i].path));
+        size_t slash = files[i].path.rfind('/');
+        if (slash != std::string::npos &&
+            !FileUtil::MakeDirectories(FileUtil::Join(root, Utf8::ToWide(files[i].path.substr(0, slash))))) {
+            return false;
+        }
+        if (!FileUtil::Write(path, contents[i].data(), contents[i].size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool DeltaPatch::Create(const TreeIndex& base, const std::wstring& newRoot, std::string& patch,
+    DeltaStats* stats, TreeIndex* newIndex) {
+    if (base.chunkerVersion != Chunker::kVersion) {
+        return false;
+    }
+    TreeIndex target;
+    std::vector<std::string> contents;
+    if (!ChunkIndex::Build(newRoot, target, &contents)) {
+        return false;
+    }
+
+    // Chunks the applying side will have: the old version's, plus every
+    // literal once it has been sent
+    std::unordered_set<uint64_t> known;
+    for (const IndexedFile& f : base.files) {
+        for (const IndexedChunk& c : f.chunks) known.insert(c.hash);
+    }
+
+    DeltaStats s;
+    std::string literals;
+    patch.assign(kMagic, 4);
+    Varint::Put(patch, kFormatVersion);
+    Varint::Put(patch, Chunker::kVersion);
+    PutU64(patch, base.Hash());
+    PutU64(patch, target.Hash());
+    Varint::Put(patch, target.files.size());
+    for (size_t i = 0; i < target.files.size(); i++) {
+        const IndexedFile& f = target.files[i];
+        Varint::PutString(patch, f.path);
+        Varint::Put(patch, f.size);
+        PutU64(patch, f.hash);
+        Varint::Put(patch, f.chunks.size());
+        size_t offset = 0;
+        for (const IndexedChunk& c : f.chunks) {
+            if (known.count(c.hash)) {
+                Varint::Put(patch, (uint64_t)c.length << 1);
+                PutU64(patch, c.hash);
+                s.reusedChunks++;
+                s.reusedBytes += c.length;
+            } else {
+                Varint::Put(patch, (uint64_t)c.length << 1 | 1);
+                literals.append(contents[i], offset, c.length);
+                known.insert(c.hash);
+            }
+            offset += c.length;
+        }
+        s.chunks += f.chunks.size();
+    }
+
+    std::vector<uint8_t> compressed;
+    if (!literals.empty()) {
+        Deflate::CompressZlib((const uint8_t*)literals.data(), literals.size(), kLiteralLevel, compressed);
+    }
+    Varint::Put(patch, literals.size());
+    Varint::Put(patch, compressed.size());
+    patch.append((const char*)compressed.data(), compressed.size());
+    uint32_t crc = Checksums::Crc32(0, (const uint8_t*)patch.data(), patch.size());
+    for (int i = 0; i < 4; i++) patch.push_back((char)(crc >> (8 * i)));
+
+    s.files = target.files.size();
+    s.literalBytes = literals.size();
+    s.patchBytes = patch.size();
+    if (stats) *stats = s;
+    if (newIndex) *newIndex = std::move(target);
+    return true;
+}
+
+bool DeltaPatch::Apply(const std::wstring& path, const uint8_t* data, size_t len, std::string& error,
+    DeltaStats* stats) {
+    std::wstring dir = StripSeparators(path);
+    ParsedPatch patch;
+    if (!Parse(data, len, patch, error)) {
+        return false;
+    }
+    if (!Recover(dir)) {
+        error = "could not recover from an interrupted update";
+        return false;
+    }
+
+    TreeIndex local;
+    std::vector<std::string> contents;
+    if (FileUtil::Exists(dir) && !ChunkIndex::Build(dir, local, &contents)) {
+        error = "could not read the local copy";
+        return false;
+    }
+    uint64_t localHash = local.Hash();
+    if (localHash == patch.targetHash) {
+        if (stats) {
+            *stats = DeltaStats();
+            stats->upToDate = true;
+        }
+        return true;
+    }
+    if (localHash != patch.baseHash) {
+        error = "local copy is not the version this patch was made from";
+        return false;
+    }
+
+    std::unordered_map<uint64_t, Slice> slices;
+    for (size_t i = 0; i < local.files.size(); i++) {
+        const char* p = contents[i].data();
+        for (const IndexedChunk& c : local.files[i].chunks) {
+            Slice slice;
+            slice.data = p;
+            slice.length = c.length;
+            slices.emplace(c.hash, slice);
+            p += c.length;
+        }
+    }
+
+    // Build every file before touching the disk
+    DeltaStats s;
+    std::vector<std::string> output(patch.files.size());
+    const char* literal = (const char*)patch.literals.data();
+    for (size_t i = 0; i < patch.files.size(); i++) {
+        const PatchFile& f = patch.files[i];
+        std::string& out = output[i];
+        out.reserve((size_t)f.size);
+        for (const PatchOp& op : f.ops) {
+            if (op.literal) {
+                Slice slice;
+                slice.data = literal;
+                slice.length = op.length;
+                slices.emplace(Checksums::Xxh64(literal, op.length), slice);
+                out.append(literal, op.length);
+                literal += op.length;
+                continue;
+            }
+            auto it = slices.find(op.hash);
+            if (it == slices.end() || it->second.length != op.length) {
+                error = "patch refers to a chunk the local copy doesn't have";
+                return false;
+            }
+            out.append(it->second.data, op.length);
+            s.reusedChunks++;
+            s.reusedBytes += op.length;
+        }
+        if (Checksums::Xxh64(out.data(), out.size()) != f.hash) {
+            error = "patched file doesn't match: " + f.path;
+            return false;
+        }
+        s.chunks += f.ops.size();
+    }
+    s.files = patch.files.size();
+    s.literalBytes = patch.literals.size();
+    s.patchBytes = len;
+    contents.clear();
+
+    std::wstring temp = dir + kTempSuffix;
+    std::wstring fresh = dir + kNewSuffix;
+    std::wstring old = dir + kOldSuffix;
+    if (!WriteTree(temp, patch.files, output)) {
+        FileUtil::RemoveTree(temp);
+        error = "could not write the new version";
+        return false;
+    }
+    // A complete ".patch-new" is the commit point, see Recover
+    if (!FileUtil::Rename(temp, fresh)) {
+        FileUtil::RemoveTree(temp);
+        error = "could not write the new version";
+        return false;
+    }
+    bool hadDir = FileUtil::Exists(dir);
+    if (hadDir && !FileUtil::Rename(dir, old)) {
+        FileUtil::RemoveTree(fresh);
+        error = "could not replace the local copy (files in use?)";
+        return false;
+    }
+    if (!FileUtil::Rename(fresh, dir)) {
+        if (hadDir) FileUtil::Rename(old, dir);
+        FileUtil::RemoveTree(fresh);
+        error = "could not replace the local copy (files in use?)";
+        return false;
+    }
+    if (hadDir) FileUtil::RemoveTree(old);
+
+    if (stats) *stats = s;
+    return true;
+}
+
+bool DeltaPatch::Recover(const std::wstring& path) {
+    std::wstring dir = StripSeparators(path);
+    std::wstring temp = dir + kTempSuffix;
+    std::wstring fresh = dir + kNewSuffix;
+    std::wstring old = dir + kOldSuffix;
+
+    // Stopped while writing: the old tree is still in place
+    if (FileUtil::Exists(temp) && !FileUtil::RemoveTree(temp)) {
+        return false;
+    }
+    if (FileUtil::Exists(fresh)) {
+        // Stopped after the commit point: finish the swap
+        if (FileUtil::Exists(dir)) {
+            if (FileUtil::Exists(old) && !FileUtil::RemoveTree(old)) return false;
+            if (!FileUtil::Rename(dir, old)) return false;
+        }
+        if (!FileUtil::Rename(fresh, dir)) {
+            return false;
+        }
+    } else if (!FileUtil::Exists(dir) && FileUtil::Exists(old)) {
+        // Only a failed rollback leaves this; the old tree is intact
+        return FileUtil::Rename(old, dir);
+    }
+    if (FileUtil::Exists(old) && !FileUtil::RemoveTree(old)) {
+        return false;
+    }
+    return true;
+}
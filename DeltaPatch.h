@@ -0,0 +1,54 @@
+#pragma once
+#include "ChunkIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct DeltaStats {
+    uint64_t files = 0;             // Files in the new version
+    uint64_t chunks = 0;
+    uint64_t reusedChunks = 0;      // Chunks copied from the local copy (or from earlier in the patch)
+    uint64_t reusedBytes = 0;
+    uint64_t literalBytes = 0;      // New bytes carried by the patch, before compression
+    uint64_t patchBytes = 0;
+    bool upToDate = false;          // Apply found the new version already in place
+};
+
+// Delta updates for local web app trees. A patch lists every file of the
+// new version as a sequence of chunks (see Chunker): a chunk the old
+// version already has is a reference by hash, anything else is carried in
+// a single zlib stream. So a patch only needs the old version's index, and
+// applying it only needs the old tree.
+//
+//   "WWDP" version chunkerVersion baseHash(8) targetHash(8) fileCount
+//   { path size hash(8) opCount { op [hash(8)] } }
+//   literalBytes zlibBytes zlib  crc32(4)
+//
+// An op is the varint (length << 1 | literal); copies are followed by the
+// chunk hash. baseHash and targetHash are TreeIndex::Hash of the two
+// versions.
+//
+// Apply builds the whole new version in memory and checks every file's
+// hash, writes it next to the directory ("<dir>.patch-tmp"), renames that
+// to "<dir>.patch-new" once complete, then swaps it with the directory.
+// An interrupted apply leaves either the old tree or a complete new one,
+// which Recover (also run by Apply) puts in place. Empty directories are
+// not carried over.
+class DeltaPatch {
+public:
+    // newIndex, when given, receives the new version's index (to keep for
+    // the next diff)
+    static bool Create(const TreeIndex& base, const std::wstring& newRoot, std::string& patch,
+        DeltaStats* stats = nullptr, TreeIndex* newIndex = nullptr);
+
+    // Updates dir to the patch's version. dir must hold exactly the version
+    // the patch was made from (or already the new one, which is a no-op);
+    // a missing dir stands for an empty tree. On failure dir is unchanged
+    // and error says why.
+    static bool Apply(const std::wstring& dir, const uint8_t* patch, size_t len, std::string& error,
+        DeltaStats* stats = nullptr);
+
+    // Finishes a swap an interrupted Apply left behind and removes its
+    // temporary directories
+    static bool Recover(const std::wstring& dir);
+};
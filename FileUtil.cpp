@@ -0,0 +1,329 @@
+#include "FileUtil.h"
+#include "Utf8.h"
+#include <atomic>
+#include <cstring>
+#include <cwchar>
+
+#ifdef _WIN32
+#include <share.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+static const wchar_t kSeparator = L'\\';
+
+static int64_t FileTimeToUnix(const FILETIME& ft) {
+    uint64_t t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (int64_t)(t / 10000000ULL) - 11644473600LL;
+}
+#else
+static const wchar_t kSeparator = L'/';
+
+static bool WriteAll(int fd, const void* data, size_t len) {
+    const char* p = (const char*)data;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, p + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+#endif
+
+bool FileUtil::Read(const std::wstring& path, std::string& data) {
+#ifdef _WIN32
+    // Appenders (Append) may hold the file open; they must not fail either
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart > 0x7FFFFFFF) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    data.resize((size_t)size.QuadPart);
+    DWORD read = 0;
+    BOOL ok = data.empty() || ::ReadFile(hFile, &data[0], (DWORD)data.size(), &read, NULL);
+    CloseHandle(hFile);
+    return ok && read == data.size();
+#else
+    int fd = open(Utf8::FromWide(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    data.resize((size_t)st.st_size);
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = read(fd, &data[done], data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(fd);
+    data.resize(done);
+    return done == (size_t)st.st_size;
+#endif
+}
+
+bool FileUtil::Write(const std::wstring& path, const void* data, size_t len) {
+    static std::atomic<unsigned> counter(0);
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    std::wstring tempPath = path + L"." + std::to_wstring(pid) + L"-" + std::to_wstring(counter++) + L".tmp";
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    DWORD written = 0;
+    BOOL ok = ::WriteFile(hFile, data, (DWORD)len, &written, NULL) && written == len;
+    ok = ok && FlushFileBuffers(hFile);
+    CloseHandle(hFile);
+
+    if (!ok || !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+    return true;
+#else
+    std::string temp = Utf8::FromWide(tempPath);
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = WriteAll(fd, data, len) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+
+    if (!ok || rename(temp.c_str(), Utf8::FromWide(path).c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool FileUtil::Append(const std::wstring& path, const void* data, size_t len) {
+#ifdef _WIN32
+    // Other processes may append (or rename the file) at the same time
+    HANDLE hFile = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    DWORD written = 0;
+    BOOL ok = ::WriteFile(hFile, data, (DWORD)len, &written, NULL) && written == len;
+    ok = ok && FlushFileBuffers(hFile);
+    CloseHandle(hFile);
+    return ok != FALSE;
+#else
+    int fd = open(Utf8::FromWide(path).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = WriteAll(fd, data, len) && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+FILE* FileUtil::OpenRead(const std::wstring& path) {
+#ifdef _WIN32
+    return _wfsopen(path.c_str(), L"rb", _SH_DENYWR);
+#else
+    return std::fopen(Utf8::FromWide(path).c_str(), "rbe");
+#endif
+}
+
+bool FileUtil::Exists(const std::wstring& path) {
+#ifdef _WIN32
+    return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+    struct stat st;
+    return stat(Utf8::FromWide(path).c_str(), &st) == 0;
+#endif
+}
+
+bool FileUtil::Stat(const std::wstring& path, Entry& info) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+        return false;
+    }
+    info.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    info.size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    info.modifiedTime = FileTimeToUnix(data.ftLastWriteTime);
+    info.accessTime = FileTimeToUnix(data.ftLastAccessTime);
+    return true;
+#else
+    struct stat st;
+    if (stat(Utf8::FromWide(path).c_str(), &st) != 0) {
+        return false;
+    }
+    info.isDirectory = S_ISDIR(st.st_mode);
+    info.size = (uint64_t)st.st_size;
+    info.modifiedTime = (int64_t)st.st_mtime;
+    info.accessTime = (int64_t)st.st_atime;
+    return true;
+#endif
+}
+
+std::wstring FileUtil::Absolute(const std::wstring& path) {
+#ifdef _WIN32
+    DWORD len = GetFullPathNameW(path.c_str(), 0, NULL, NULL);
+    if (len == 0) {
+        return path;
+    }
+    std::wstring full(len, L'\0');
+    len = GetFullPathNameW(path.c_str(), len, &full[0], NULL);
+    full.resize(len);
+    return full;
+#else
+    if (path.empty() || path[0] == L'/') {
+        return path;
+    }
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        return path;
+    }
+    std::wstring rel = path.compare(0, 2, L"./") == 0 ? path.substr(2) : path;
+    return Join(Utf8::ToWide(cwd), rel);
+#endif
+}
+
+bool FileUtil::Remove(const std::wstring& path) {
+#ifdef _WIN32
+    return DeleteFileW(path.c_str()) != FALSE;
+#else
+    return unlink(Utf8::FromWide(path).c_str()) == 0;
+#endif
+}
+
+bool FileUtil::RemoveTree(const std::wstring& path) {
+    std::vector<Entry> entries;
+    if (!List(path, entries)) {
+        return false;
+    }
+    bool ok = true;
+    for (const Entry& e : entries) {
+        std::wstring child = Join(path, e.name);
+#ifdef _WIN32
+        DWORD attributes = GetFileAttributesW(child.c_str());
+        bool link = attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_REPARSE_POINT);
+        if (e.isDirectory && link) {
+            ok = RemoveDirectoryW(child.c_str()) != FALSE && ok;
+            continue;
+        }
+#else
+        struct stat st;
+        bool link = lstat(Utf8::FromWide(child).c_str(), &st) == 0 && S_ISLNK(st.st_mode);
+        if (link) {
+            ok = Remove(child) && ok;
+            continue;
+        }
+#endif
+        ok = (e.isDirectory ? RemoveTree(child) : Remove(child)) && ok;
+    }
+#ifdef _WIN32
+    return RemoveDirectoryW(path.c_str()) != FALSE && ok;
+#else
+    return rmdir(Utf8::FromWide(path).c_str()) == 0 && ok;
+#endif
+}
+
+bool FileUtil::Rename(const std::wstring& from, const std::wstring& to) {
+#ifdef _WIN32
+    return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+    return rename(Utf8::FromWide(from).c_str(), Utf8::FromWide(to).c_str()) == 0;
+#endif
+}
+
+bool FileUtil::MakeDirectories(const std::wstring& path) {
+    if (path.empty()) return false;
+    if (Exists(path)) return true;
+
+    size_t sep = path.find_last_of(L"\\/");
+    if (sep != std::wstring::npos && sep > 0 && path[sep - 1] != L':') {
+        MakeDirectories(path.substr(0, sep));
+    }
+#ifdef _WIN32
+    return CreateDirectoryW(path.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(Utf8::FromWide(path).c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+bool FileUtil::List(const std::wstring& dir, std::vector<Entry>& entries) {
+#ifdef _WIN32
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileExW(Join(dir, L"*").c_str(), FindExInfoBasic, &fd,
+        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+    do {
+        if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0) continue;
+        Entry e;
+        e.name = fd.cFileName;
+        e.isDirectory = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        e.size = ((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+        e.modifiedTime = FileTimeToUnix(fd.ftLastWriteTime);
+        e.accessTime = FileTimeToUnix(fd.ftLastAccessTime);
+        entries.push_back(e);
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+    return true;
+#else
+    std::string base = Utf8::FromWide(dir);
+    DIR* d = opendir(base.c_str());
+    if (!d) {
+        return false;
+    }
+    while (struct dirent* de = readdir(d)) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+        struct stat st;
+        if (lstat((base + "/" + de->d_name).c_str(), &st) != 0) continue;
+        Entry e;
+        e.name = Utf8::ToWide(de->d_name);
+        e.isDirectory = S_ISDIR(st.st_mode);
+        e.size = (uint64_t)st.st_size;
+        e.modifiedTime = (int64_t)st.st_mtime;
+        e.accessTime = (int64_t)st.st_atime;
+        entries.push_back(e);
+    }
+    closedir(d);
+    return true;
+#endif
+}
+
+std::wstring FileUtil::Join(const std::wstring& dir, const std::wstring& name) {
+    if (dir.empty()) return name;
+    wchar_t last = dir[dir.size() - 1];
+    if (last == L'\\' || last == L'/') return dir + name;
+    return dir + kSeparator + name;
+}
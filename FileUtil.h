@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Portable file helpers (Win32 on Windows, POSIX elsewhere).
+// Paths are wide strings everywhere; on POSIX they are converted to UTF-8.
+class FileUtil {
+public:
+    struct Entry {
+        std::wstring name;
+        bool isDirectory = false;
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;  // Seconds since the Unix epoch
+        int64_t accessTime = 0;    // May lag or equal modifiedTime if the volume doesn't track access
+    };
+
+    static bool Read(const std::wstring& path, std::string& data);
+
+    // Opens path for buffered binary reading, for files too large to Read
+    // at once; the caller fcloses it
+    static FILE* OpenRead(const std::wstring& path);
+
+    // Writes to a temporary sibling, flushes, then renames over path. The
+    // temporary name is unique per process and call, so concurrent writers
+    // of the same path don't clobber each other's file
+    static bool Write(const std::wstring& path, const void* data, size_t len);
+
+    // Appends to path (created if missing) and flushes to disk before returning
+    static bool Append(const std::wstring& path, const void* data, size_t len);
+
+    static bool Exists(const std::wstring& path);
+
+    // Size and times of a single file or directory (name is left empty)
+    static bool Stat(const std::wstring& path, Entry& info);
+
+    // Resolves a relative path against the current directory
+    static std::wstring Absolute(const std::wstring& path);
+    static bool Remove(const std::wstring& path);
+
+    // Deletes a directory and everything below it. Symbolic links and
+    // junctions inside are removed, not followed.
+    static bool RemoveTree(const std::wstring& path);
+
+    // Atomically renames from to to, replacing any existing file
+    static bool Rename(const std::wstring& from, const std::wstring& to);
+    static bool MakeDirectories(const std::wstring& path);
+
+    // Lists directory entries, excluding "." and ".."
+    static bool List(const std::wstring& dir, std::vector<Entry>& entries);
+
+    static std::wstring Join(const std::wstring& dir, const std::wstring& name);
+};
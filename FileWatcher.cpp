@@ -0,0 +1,250 @@
+#include "FileWatcher.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <cwctype>
+#else
+#include "Utf8.h"
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Watched files keyed by their name within the directory
+typedef std::map<std::wstring, std::wstring> FileNames;
+
+#ifdef _WIN32
+std::wstring Lower(std::wstring s) {
+    for (wchar_t& c : s) c = (wchar_t)towlower(c);
+    return s;
+}
+
+size_t FindSeparator(const std::wstring& path) {
+    return path.find_last_of(L"\\/");
+}
+#else
+std::wstring Lower(const std::wstring& s) {
+    return s;
+}
+
+size_t FindSeparator(const std::wstring& path) {
+    return path.find_last_of(L'/');
+}
+#endif
+
+void ReportAll(const FileNames& files, std::vector<std::wstring>& changed) {
+    for (const auto& f : files) {
+        changed.push_back(f.second);
+    }
+}
+
+void ReportName(const FileNames& files, const std::wstring& name, std::vector<std::wstring>& changed) {
+    auto it = files.find(Lower(name));
+    if (it != files.end()) {
+        changed.push_back(it->second);
+    }
+}
+
+}
+
+#ifdef _WIN32
+
+struct FileWatcher::Directory {
+    std::wstring path;
+    FileNames files;
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    DWORD buffer[16 * 1024];  // DWORD-aligned as ReadDirectoryChangesW requires
+    bool pending = false;
+
+    ~Directory() {
+        if (pending) {
+            CancelIo(handle);
+            DWORD bytes;
+            GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+        }
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+        if (overlapped.hEvent) CloseHandle(overlapped.hEvent);
+    }
+
+    bool Open() {
+        handle = CreateFileW(path.c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        return handle != INVALID_HANDLE_VALUE && overlapped.hEvent && Issue();
+    }
+
+    bool Issue() {
+        ResetEvent(overlapped.hEvent);
+        pending = ReadDirectoryChangesW(handle, buffer, sizeof(buffer), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE |
+            FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_CREATION,
+            NULL, &overlapped, NULL) != FALSE;
+        return pending;
+    }
+
+    // Collects the completed notification and queues the next one
+    void Collect(std::vector<std::wstring>& changed) {
+        DWORD bytes = 0;
+        pending = false;
+        if (!GetOverlappedResult(handle, &overlapped, &bytes, FALSE) || bytes == 0) {
+            ReportAll(files, changed);  // Buffer overflowed: anything may have changed
+        } else {
+            const BYTE* p = (const BYTE*)buffer;
+            for (;;) {
+                const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)p;
+                ReportName(files, std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)), changed);
+                if (!info->NextEntryOffset) break;
+                p += info->NextEntryOffset;
+            }
+        }
+        Issue();
+    }
+};
+
+FileWatcher::FileWatcher() {
+}
+
+FileWatcher::~FileWatcher() {
+}
+
+bool FileWatcher::Wait(int timeoutMs, std::vector<std::wstring>& changed) {
+    std::vector<HANDLE> events;
+    std::vector<Directory*> dirs;
+    for (auto& d : m_directories) {
+        if (d.second->pending && events.size() < MAXIMUM_WAIT_OBJECTS) {
+            events.push_back(d.second->overlapped.hEvent);
+            dirs.push_back(d.second.get());
+        }
+    }
+    if (events.empty()) {
+        Sleep(timeoutMs);
+        return true;
+    }
+
+    DWORD timeout = (DWORD)timeoutMs;
+    for (;;) {
+        DWORD r = WaitForMultipleObjects((DWORD)events.size(), events.data(), FALSE, timeout);
+        if (r == WAIT_TIMEOUT) return true;
+        if (r >= WAIT_OBJECT_0 + events.size()) {
+            std::wcerr << L"Error: Waiting for file changes failed (" << GetLastError() << L")\n";
+            return false;
+        }
+        dirs[r - WAIT_OBJECT_0]->Collect(changed);
+        timeout = 0;  // Drain whatever else is already signalled
+    }
+}
+
+#else
+
+struct FileWatcher::Directory {
+    std::wstring path;
+    FileNames files;
+    int wd = -1;
+};
+
+FileWatcher::FileWatcher() {
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) {
+        std::wcerr << L"Error: inotify is not available\n";
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    if (m_inotify >= 0) close(m_inotify);
+}
+
+bool FileWatcher::Wait(int timeoutMs, std::vector<std::wstring>& changed) {
+    if (m_inotify < 0) {
+        return false;
+    }
+
+    pollfd pfd = { m_inotify, POLLIN, 0 };
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) {
+        return ready == 0;
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    ssize_t len;
+    while ((len = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + len; ) {
+            const inotify_event* ev = (const inotify_event*)p;
+            p += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                for (auto& d : m_directories) ReportAll(d.second->files, changed);
+                continue;
+            }
+            for (auto& d : m_directories) {
+                if (d.second->wd != ev->wd) continue;
+                if (ev->len) {
+                    ReportName(d.second->files, Utf8::ToWide(ev->name), changed);
+                } else if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    ReportAll(d.second->files, changed);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+#endif
+
+bool FileWatcher::SetFiles(const std::vector<std::wstring>& files) {
+    std::map<std::wstring, FileNames> wanted;
+    std::map<std::wstring, std::wstring> dirPaths;
+    for (const std::wstring& file : files) {
+        size_t sep = FindSeparator(file);
+        std::wstring dir = L".";
+        if (sep != std::wstring::npos) {
+            // Keep the separator for roots ("/", "C:\\")
+            bool root = sep == 0 || file[sep - 1] == L':';
+            dir = file.substr(0, root ? sep + 1 : sep);
+        }
+        std::wstring name = sep == std::wstring::npos ? file : file.substr(sep + 1);
+        wanted[Lower(dir)][Lower(name)] = file;
+        dirPaths[Lower(dir)] = dir;
+    }
+
+    // Drop directories that are no longer needed
+    for (auto it = m_directories.begin(); it != m_directories.end(); ) {
+        if (wanted.count(it->first)) {
+            ++it;
+            continue;
+        }
+#ifndef _WIN32
+        if (it->second->wd >= 0) inotify_rm_watch(m_inotify, it->second->wd);
+#endif
+        it = m_directories.erase(it);
+    }
+
+    bool ok = true;
+    for (auto& w : wanted) {
+        std::unique_ptr<Directory>& dir = m_directories[w.first];
+        if (!dir) {
+            dir.reset(new Directory());
+            dir->path = dirPaths[w.first];
+        }
+        dir->files = w.second;
+
+#ifdef _WIN32
+        if (dir->handle == INVALID_HANDLE_VALUE && !dir->Open()) {
+#else
+        if (dir->wd < 0 && m_inotify >= 0) {
+            dir->wd = inotify_add_watch(m_inotify, Utf8::FromWide(dir->path).c_str(),
+                IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF);
+        }
+        if (dir->wd < 0) {
+#endif
+            std::wcerr << L"Warning: Cannot watch directory: " << dir->path << L"\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
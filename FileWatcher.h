@@ -0,0 +1,36 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Waits for changes to a set of files.
+//
+// Files are watched through their parent directories (inotify on Linux,
+// overlapped ReadDirectoryChangesW on Windows), so editors that save by
+// writing a temporary file and renaming it over the original are seen too.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Replaces the watched set; paths should be absolute. Directories that
+    // stay in the set keep their watch, so no change is lost in between.
+    bool SetFiles(const std::vector<std::wstring>& files);
+
+    // Waits up to timeoutMs for a change and appends the watched paths that
+    // changed (possibly with duplicates). Returns false if waiting failed.
+    bool Wait(int timeoutMs, std::vector<std::wstring>& changed);
+
+private:
+    struct Directory;
+
+    // Key: directory path (lowercased on Windows)
+    std::map<std::wstring, std::unique_ptr<Directory>> m_directories;
+#ifndef _WIN32
+    int m_inotify = -1;
+#endif
+};
@@ -0,0 +1,100 @@
+#include "IcoBuilder.h"
+#include "PngEncoder.h"
+#include <cstring>
+
+namespace {
+
+void PutU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    PutU16(out, (uint16_t)v);
+    PutU16(out, (uint16_t)(v >> 16));
+}
+
+void PutU32At(std::vector<uint8_t>& out, size_t pos, uint32_t v) {
+    out[pos] = (uint8_t)v;
+    out[pos + 1] = (uint8_t)(v >> 8);
+    out[pos + 2] = (uint8_t)(v >> 16);
+    out[pos + 3] = (uint8_t)(v >> 24);
+}
+
+// BITMAPINFOHEADER + bottom-up BGRA + 1bpp AND mask
+void AppendDib(const IcoImage& img, std::vector<uint8_t>& out) {
+    const uint32_t s = img.size;
+    PutU32(out, 40);          // biSize
+    PutU32(out, s);           // biWidth
+    PutU32(out, s * 2);       // biHeight (color + mask)
+    PutU16(out, 1);           // biPlanes
+    PutU16(out, 32);          // biBitCount
+    PutU32(out, 0);           // biCompression = BI_RGB
+    PutU32(out, 0);           // biSizeImage
+    PutU32(out, 0);
+    PutU32(out, 0);
+    PutU32(out, 0);
+    PutU32(out, 0);
+
+    for (int y = (int)s - 1; y >= 0; y--) {
+        const uint8_t* row = img.bgra.data() + (size_t)y * s * 4;
+        out.insert(out.end(), row, row + s * 4);
+    }
+
+    // Mask rows are padded to 32 bits; transparent where alpha is zero
+    const uint32_t maskStride = ((s + 31) / 32) * 4;
+    for (int y = (int)s - 1; y >= 0; y--) {
+        const uint8_t* row = img.bgra.data() + (size_t)y * s * 4;
+        size_t start = out.size();
+        out.resize(start + maskStride, 0);
+        for (uint32_t x = 0; x < s; x++) {
+            if (row[x * 4 + 3] == 0) out[start + x / 8] |= (uint8_t)(0x80 >> (x % 8));
+        }
+    }
+}
+
+} // namespace
+
+bool IcoBuilder::Build(const std::vector<IcoImage>& images, uint32_t pngThreshold,
+    int pngLevel, std::vector<uint8_t>& out) {
+    if (images.empty() || images.size() > 0xFFFF) return false;
+
+    out.clear();
+    PutU16(out, 0);                          // idReserved
+    PutU16(out, 1);                          // idType = icon
+    PutU16(out, (uint16_t)images.size());    // idCount
+
+    const size_t dirStart = out.size();
+    out.resize(dirStart + images.size() * 16, 0);
+
+    for (size_t i = 0; i < images.size(); i++) {
+        const IcoImage& img = images[i];
+        if (img.size == 0 || img.size > 256 || img.bgra.size() < (size_t)img.size * img.size * 4) {
+            return false;
+        }
+
+        size_t offset = out.size();
+        if (img.size >= pngThreshold) {
+            std::vector<uint8_t> png;
+            if (!PngEncoder::Encode(img.bgra.data(), img.size, img.size, (size_t)img.size * 4,
+                PngEncoder::Layout::BGRA, pngLevel, png)) {
+                return false;
+            }
+            out.insert(out.end(), png.begin(), png.end());
+        } else {
+            AppendDib(img, out);
+        }
+
+        size_t entry = dirStart + i * 16;
+        out[entry + 0] = (uint8_t)(img.size & 0xFF);   // 256 is stored as 0
+        out[entry + 1] = (uint8_t)(img.size & 0xFF);
+        out[entry + 2] = 0;                            // bColorCount
+        out[entry + 3] = 0;                            // bReserved
+        out[entry + 4] = 1;                            // wPlanes
+        out[entry + 6] = 32;                           // wBitCount
+        PutU32At(out, entry + 8, (uint32_t)(out.size() - offset));
+        PutU32At(out, entry + 12, (uint32_t)offset);
+    }
+
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// A single square icon image
+struct IcoImage {
+    uint32_t size = 0;          // Width and height in pixels (1-256)
+    std::vector<uint8_t> bgra;  // Top-down, non-premultiplied BGRA, size*size*4 bytes
+};
+
+// Serializes icon images into an in-memory .ico file.
+// Entries at or above pngThreshold are embedded as PNG (supported by
+// Windows Vista and later); smaller ones use a 32-bit DIB with AND mask.
+class IcoBuilder {
+public:
+    static const uint32_t kDefaultPngThreshold = 64;
+
+    static bool Build(const std::vector<IcoImage>& images, uint32_t pngThreshold,
+        int pngLevel, std::vector<uint8_t>& out);
+};
@@ -0,0 +1,61 @@
+#include "IconCache.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include <vector>
+
+namespace {
+
+// Bumped whenever conversion output changes (2: transparent margins trimmed,
+// 3: large sources box-reduced while streaming, 4: streamed sources sized
+// from the trimmed content), so conversions cached by an older build are
+// not reused
+const uint64_t kConversionVersion = 4;
+
+std::wstring Hex(uint64_t value, int digits) {
+    static const wchar_t kHex[] = L"0123456789abcdef";
+    std::wstring out(digits, L'0');
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = kHex[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+}
+
+std::wstring IconCache::SourcePrefix(const std::wstring& absSource) {
+    std::string utf8 = Utf8::FromWide(absSource);
+    return L"webwrap_icon_" + Hex(Checksums::Fnv1a64(utf8.data(), utf8.size()), 16) + L"_";
+}
+
+std::wstring IconCache::VersionedPath(const std::wstring& cacheDir, const std::wstring& source) {
+    FileUtil::Entry info;
+    if (!FileUtil::Stat(source, info) || info.isDirectory) {
+        return L"";
+    }
+    return VersionedPath(cacheDir, FileUtil::Absolute(source), info);
+}
+
+std::wstring IconCache::VersionedPath(const std::wstring& cacheDir, const std::wstring& absSource,
+    const FileUtil::Entry& info) {
+    uint64_t version[3] = { info.size, (uint64_t)info.modifiedTime, kConversionVersion };
+    uint64_t hash = Checksums::Fnv1a64(version, sizeof(version));
+    return FileUtil::Join(cacheDir, SourcePrefix(absSource) + Hex(hash, 8) + L".ico");
+}
+
+void IconCache::RemoveOtherVersions(const std::wstring& cacheDir, const std::wstring& source,
+    const std::wstring& keep) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(cacheDir, entries)) {
+        return;
+    }
+
+    std::wstring prefix = SourcePrefix(FileUtil::Absolute(source));
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(cacheDir, e.name);
+        if (!e.isDirectory && e.name.compare(0, prefix.size(), prefix) == 0 && path != keep) {
+            FileUtil::Remove(path);
+        }
+    }
+}
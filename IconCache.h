@@ -0,0 +1,26 @@
+#pragma once
+#include "FileUtil.h"
+#include <string>
+
+// Naming for converted .ico files kept in a cache directory.
+//
+// The name combines a hash of the source path with a hash of the source's
+// size and modification time, so editing an icon in place yields a new
+// cache entry (and a new icon location, which also makes Explorer drop its
+// cached image) instead of silently reusing the stale conversion.
+class IconCache {
+public:
+    // Cache path for the current version of source; empty if source can't be read
+    static std::wstring VersionedPath(const std::wstring& cacheDir, const std::wstring& source);
+
+    // Same, for an absolute source path whose size and times are already known
+    static std::wstring VersionedPath(const std::wstring& cacheDir, const std::wstring& absSource,
+        const FileUtil::Entry& info);
+
+    // Deletes cached conversions of source other than keep
+    static void RemoveOtherVersions(const std::wstring& cacheDir, const std::wstring& source,
+        const std::wstring& keep);
+
+private:
+    static std::wstring SourcePrefix(const std::wstring& absSource);
+};
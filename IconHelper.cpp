@@ -1,7 +1,12 @@
 #include "IconHelper.h"
+#include "IconCache.h"
+#include "IcoBuilder.h"
+#include "FileUtil.h"
+#include "IconPipeline.h"
+#include "IconSource.h"
+#include "PngDecoder.h"
 #include <iostream>
 #include <algorithm>
-#include <functional>
 #include <gdiplus.h>
 #include <shlwapi.h>
 
@@ -36,151 +41,108 @@ bool IconHelper::IsIcoFile(const std::wstring& path) {
     return ext == L".ico";
 }
 
-bool IconHelper::ConvertPngToIco(const std::wstring& pngPath, const std::wstring& icoPath) {
-    static GdiplusInit gdiplusInit;
+bool IconHelper::IsSvgFile(const std::wstring& path) {
+    std::wstring ext = PathFindExtensionW(path.c_str());
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+    return ext == L".svg";
+}
 
-    // Load the PNG image
-    Bitmap* pngBitmap = Bitmap::FromFile(pngPath.c_str());
-    if (!pngBitmap || pngBitmap->GetLastStatus() != Ok) {
-        std::wcerr << L"Error: Failed to load PNG file: " << pngPath << L"\n";
-        if (pngBitmap) delete pngBitmap;
+bool IconHelper::NeedsConversion(const std::wstring& path) {
+    return IsPngFile(path) || IsSvgFile(path);
+}
+
+bool IconHelper::ConvertToIco(const std::wstring& srcPath, const std::wstring& icoPath) {
+    return IsSvgFile(srcPath) ? ConvertSvgToIco(srcPath, icoPath) : ConvertPngToIco(srcPath, icoPath);
+}
+
+bool IconHelper::ConvertSvgToIco(const std::wstring& svgPath, const std::wstring& icoPath) {
+    std::string text;
+    if (!FileUtil::Read(svgPath, text)) {
+        std::wcerr << L"Error: Failed to read SVG file: " << svgPath << L"\n";
         return false;
     }
 
-    // Get original dimensions
-    UINT width = pngBitmap->GetWidth();
-    UINT height = pngBitmap->GetHeight();
-
-    // Determine target size (scale to fit common icon sizes)
-    UINT targetSize = 256;
-    if (width <= 16 || height <= 16) targetSize = 16;
-    else if (width <= 32 || height <= 32) targetSize = 32;
-    else if (width <= 48 || height <= 48) targetSize = 48;
-    else if (width <= 64 || height <= 64) targetSize = 64;
-    else if (width <= 128 || height <= 128) targetSize = 128;
-
-    // Create a square bitmap with the target size
-    Bitmap* iconBitmap = new Bitmap(targetSize, targetSize, PixelFormat32bppARGB);
-    Graphics* graphics = Graphics::FromImage(iconBitmap);
-    
-    if (!graphics) {
-        delete pngBitmap;
-        delete iconBitmap;
+    PreparedIcon icon;
+    if (!IconSource::FromSvg(text, icon)) {
+        std::wcerr << L"Error: Failed to parse SVG file: " << svgPath << L"\n";
         return false;
     }
 
-    // Set high quality scaling
-    graphics->SetInterpolationMode(InterpolationModeHighQualityBicubic);
-    graphics->SetSmoothingMode(SmoothingModeHighQuality);
-    graphics->SetPixelOffsetMode(PixelOffsetModeHighQuality);
-
-    // Calculate scaling to fit within square while maintaining aspect ratio
-    float scale = min((float)targetSize / width, (float)targetSize / height);
-    UINT scaledWidth = (UINT)(width * scale);
-    UINT scaledHeight = (UINT)(height * scale);
-    UINT offsetX = (targetSize - scaledWidth) / 2;
-    UINT offsetY = (targetSize - scaledHeight) / 2;
+    if (!FileUtil::Write(icoPath, icon.ico.data(), icon.ico.size())) {
+        std::wcerr << L"Error: Failed to write ICO file: " << icoPath << L"\n";
+        return false;
+    }
 
-    // Clear with transparent background
-    graphics->Clear(Color(0, 0, 0, 0));
+    return true;
+}
 
-    // Draw the scaled image
-    Rect destRect(offsetX, offsetY, scaledWidth, scaledHeight);
-    graphics->DrawImage(pngBitmap, destRect);
+// Decodes any image GDI+ understands into top-down BGRA
+static bool DecodeWithGdiplus(const std::wstring& path, PngImage& image) {
+    static GdiplusInit gdiplusInit;
 
-    // Get HICON from bitmap
-    HICON hIcon = NULL;
-    iconBitmap->GetHICON(&hIcon);
+    Bitmap* bitmap = Bitmap::FromFile(path.c_str());
+    if (!bitmap || bitmap->GetLastStatus() != Ok) {
+        if (bitmap) delete bitmap;
+        return false;
+    }
 
-    // Clean up GDI+ objects
-    delete graphics;
-    delete iconBitmap;
-    delete pngBitmap;
+    image.width = bitmap->GetWidth();
+    image.height = bitmap->GetHeight();
+    image.bgra.resize((size_t)image.width * image.height * 4);
+
+    // PixelFormat32bppARGB is BGRA in memory
+    BitmapData data;
+    Rect lockRect(0, 0, image.width, image.height);
+    bool locked = bitmap->LockBits(&lockRect, ImageLockModeRead, PixelFormat32bppARGB, &data) == Ok;
+    if (locked) {
+        for (UINT y = 0; y < image.height; y++) {
+            memcpy(&image.bgra[(size_t)y * image.width * 4], (BYTE*)data.Scan0 + y * data.Stride, image.width * 4);
+        }
+        bitmap->UnlockBits(&data);
+    }
+    delete bitmap;
+    return locked;
+}
 
-    if (!hIcon) {
-        std::wcerr << L"Error: Failed to create icon from PNG\n";
+bool IconHelper::PrepareIcon(const std::wstring& absPath, PreparedIcon& icon, bool useCache) {
+    wchar_t tempPath[MAX_PATH] = L"";
+    if (useCache) {
+        GetTempPathW(MAX_PATH, tempPath);
+    }
+    IconPipelineStats stats;
+    if (IconSource::Load(absPath, tempPath, icon, &stats)) {
+        return true;
+    }
+    if (!IsPngFile(absPath)) {
         return false;
     }
 
-    // Save as ICO file
-    HANDLE hFile = CreateFileW(icoPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        std::wcerr << L"Error: Failed to create ICO file: " << icoPath << L"\n";
-        DestroyIcon(hIcon);
+    // Built-in decoder first; GDI+ covers anything it rejects (for example
+    // a JPEG saved with a .png extension)
+    PngImage image;
+    IconPipelineOptions options;
+    options.trim = true;
+    options.padding = IconSource::kPadding;
+    if (!DecodeWithGdiplus(absPath, image) ||
+        !IconPipeline::PixelsToIco(image.bgra.data(), image.width, image.height,
+            (size_t)image.width * 4, 0, icon.ico, nullptr, &stats, options)) {
         return false;
     }
+    icon.colors = stats.colors;
+    return true;
+}
 
-    // Write ICO file header
-    ICONDIR iconDir;
-    iconDir.idReserved = 0;
-    iconDir.idType = 1;
-    iconDir.idCount = 1;
-
-    DWORD written;
-    WriteFile(hFile, &iconDir, sizeof(ICONDIR), &written, NULL);
-
-    // Get icon info
-    ICONINFO iconInfo;
-    GetIconInfo(hIcon, &iconInfo);
-
-    BITMAP bmp;
-    GetObject(iconInfo.hbmColor, sizeof(BITMAP), &bmp);
-
-    // Write ICONDIRENTRY
-    ICONDIRENTRY iconEntry;
-    iconEntry.bWidth = (BYTE)targetSize;
-    iconEntry.bHeight = (BYTE)targetSize;
-    iconEntry.bColorCount = 0;
-    iconEntry.bReserved = 0;
-    iconEntry.wPlanes = 1;
-    iconEntry.wBitCount = 32;
-    iconEntry.dwBytesInRes = 0; // Will calculate
-    iconEntry.dwImageOffset = sizeof(ICONDIR) + sizeof(ICONDIRENTRY);
-
-    // Calculate image data size
-    DWORD imageSize = sizeof(BITMAPINFOHEADER) + (targetSize * targetSize * 4);
-    iconEntry.dwBytesInRes = imageSize;
-
-    WriteFile(hFile, &iconEntry, sizeof(ICONDIRENTRY), &written, NULL);
-
-    // Write BITMAPINFOHEADER
-    BITMAPINFOHEADER bmih;
-    ZeroMemory(&bmih, sizeof(BITMAPINFOHEADER));
-    bmih.biSize = sizeof(BITMAPINFOHEADER);
-    bmih.biWidth = targetSize;
-    bmih.biHeight = targetSize * 2; // Double height for mask
-    bmih.biPlanes = 1;
-    bmih.biBitCount = 32;
-    bmih.biCompression = BI_RGB;
-
-    WriteFile(hFile, &bmih, sizeof(BITMAPINFOHEADER), &written, NULL);
-
-    // Get bitmap bits
-    HDC hdc = GetDC(NULL);
-    BITMAPINFO bmi;
-    ZeroMemory(&bmi, sizeof(BITMAPINFO));
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = targetSize;
-    bmi.bmiHeader.biHeight = -((LONG)targetSize); // Top-down
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 32;
-    bmi.bmiHeader.biCompression = BI_RGB;
-
-    BYTE* bits = new BYTE[targetSize * targetSize * 4];
-    GetDIBits(hdc, iconInfo.hbmColor, 0, targetSize, bits, &bmi, DIB_RGB_COLORS);
-
-    // Write color data (bottom-up for ICO format)
-    for (int y = targetSize - 1; y >= 0; y--) {
-        WriteFile(hFile, bits + (y * targetSize * 4), targetSize * 4, &written, NULL);
+bool IconHelper::ConvertPngToIco(const std::wstring& pngPath, const std::wstring& icoPath) {
+    PreparedIcon icon;
+    if (!PrepareIcon(FileUtil::Absolute(pngPath), icon, false)) {
+        std::wcerr << L"Error: Failed to load PNG file: " << pngPath << L"\n";
+        return false;
     }
 
-    delete[] bits;
-    ReleaseDC(NULL, hdc);
-    DeleteObject(iconInfo.hbmColor);
-    DeleteObject(iconInfo.hbmMask);
-
-    CloseHandle(hFile);
-    DestroyIcon(hIcon);
+    if (!FileUtil::Write(icoPath, icon.ico.data(), icon.ico.size())) {
+        std::wcerr << L"Error: Failed to write ICO file: " << icoPath << L"\n";
+        return false;
+    }
 
     return true;
 }
@@ -190,83 +152,26 @@ HICON IconHelper::LoadIconFromFile(const std::wstring& path) {
         return nullptr;
     }
 
-    // Convert to absolute path
-    wchar_t absolutePath[MAX_PATH];
-    DWORD result = GetFullPathNameW(path.c_str(), MAX_PATH, absolutePath, nullptr);
-    if (result == 0) {
-        std::wcerr << L"Error: Failed to get absolute path for: " << path << L"\n";
+    std::wstring absPath = FileUtil::Absolute(path);
+    if (!IsPngFile(absPath) && !IsSvgFile(absPath) && !IsIcoFile(absPath)) {
+        std::wcerr << L"Error: Unsupported icon file format. Please use .ico, .png or .svg files.\n";
         return nullptr;
     }
 
-    std::wstring absPath(absolutePath);
-
-    // Validate file exists
-    if (GetFileAttributesW(absPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-        std::wcerr << L"Error: Icon file does not exist: " << absPath << L"\n";
+    // Converted in memory and created straight from the .ico bytes
+    PreparedIcon icon;
+    if (!PrepareIcon(absPath, icon)) {
+        std::wcerr << L"Error: Failed to load icon: " << absPath << L"\n";
         return nullptr;
     }
 
-    // Check if it's a PNG file
-    if (IsPngFile(absPath)) {
-        // Create persistent ICO file with unique name based on source PNG
-        wchar_t tempPath[MAX_PATH];
-        GetTempPathW(MAX_PATH, tempPath);
-        
-        // Generate unique filename based on absolute PNG path hash
-        size_t pathHash = std::hash<std::wstring>{}(absPath);
-        wchar_t hashStr[32];
-        swprintf_s(hashStr, L"%zu", pathHash);
-        std::wstring icoPath = std::wstring(tempPath) + L"webwrap_icon_" + hashStr + L".ico";
-
-        // Convert PNG to ICO (only if not already converted)
-        if (GetFileAttributesW(icoPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-            if (!ConvertPngToIco(absPath, icoPath)) {
-                std::wcerr << L"Error: Failed to convert PNG to ICO format\n";
-                return nullptr;
-            }
-        }
-
-        // Load the converted ICO with specific size for better quality
-        HICON hIcon = (HICON)LoadImageW(
-            nullptr,
-            icoPath.c_str(),
-            IMAGE_ICON,
-            32,  // Width - standard icon size
-            32,  // Height - standard icon size
-            LR_LOADFROMFILE);
-
-        if (!hIcon) {
-            DWORD error = GetLastError();
-            std::wcerr << L"Error: Failed to load converted icon. Error code: " << error << L"\n";
-            std::wcerr << L"ICO path: " << icoPath << L"\n";
-            return nullptr;
-        }
-
-        return hIcon;
-    }
-    else if (IsIcoFile(absPath)) {
-        // Load ICO file directly with specific size using absolute path
-        HICON hIcon = (HICON)LoadImageW(
-            nullptr,
-            absPath.c_str(),
-            IMAGE_ICON,
-            32,  // Width - standard icon size
-            32,  // Height - standard icon size
-            LR_LOADFROMFILE);
-
-        if (!hIcon) {
-            DWORD error = GetLastError();
-            std::wcerr << L"Error: Failed to load icon from file: " << absPath 
-                       << L". Error code: " << error << L"\n";
-            return nullptr;
-        }
-
-        return hIcon;
-    }
-    else {
-        std::wcerr << L"Error: Unsupported icon file format. Please use .ico or .png files.\n";
-        return nullptr;
+    HICON hIcon = LoadIconFromIcoData(icon.ico.data(), icon.ico.size(), 32);
+    if (!hIcon) {
+        DWORD error = GetLastError();
+        std::wcerr << L"Error: Failed to create icon from: " << absPath
+                   << L". Error code: " << error << L"\n";
     }
+    return hIcon;
 }
 
 std::wstring IconHelper::GetConvertedIconPath(const std::wstring& path) {
@@ -288,24 +193,76 @@ std::wstring IconHelper::GetConvertedIconPath(const std::wstring& path) {
         return absPath;
     }
 
-    // If it's a PNG file, return the converted ICO path
-    if (IsPngFile(absPath)) {
+    // If it's a PNG or SVG file, return the converted ICO path
+    if (NeedsConversion(absPath)) {
         wchar_t tempPath[MAX_PATH];
         GetTempPathW(MAX_PATH, tempPath);
-        
-        // Generate unique filename based on absolute PNG path hash
-        size_t pathHash = std::hash<std::wstring>{}(absPath);
-        wchar_t hashStr[32];
-        swprintf_s(hashStr, L"%zu", pathHash);
-        std::wstring icoPath = std::wstring(tempPath) + L"webwrap_icon_" + hashStr + L".ico";
-        
+
+        // Cached per source version, so an icon edited in place is reconverted
+        std::wstring icoPath = IconCache::VersionedPath(tempPath, absPath);
+        if (icoPath.empty()) {
+            return absPath;
+        }
+
         // Convert if not already done
-        if (GetFileAttributesW(icoPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-            ConvertPngToIco(absPath, icoPath);
+        if (GetFileAttributesW(icoPath.c_str()) == INVALID_FILE_ATTRIBUTES &&
+            ConvertToIco(absPath, icoPath)) {
+            IconCache::RemoveOtherVersions(tempPath, absPath, icoPath);
         }
         
         return icoPath;
     }
 
     return absPath;
-}
\ No newline at end of file
+}
+
+HICON IconHelper::LoadIconFromIcoData(const uint8_t* ico, size_t len, int size) {
+    size_t offset = 0, bytes = 0;
+    if (!IconSource::FindEntry(ico, len, (uint32_t)size, offset, bytes)) {
+        return nullptr;
+    }
+
+    // Takes DIB and PNG entries alike, scaling if the entry isn't size x size
+    return CreateIconFromResourceEx((PBYTE)ico + offset, (DWORD)bytes, TRUE,
+        0x00030000, size, size, LR_DEFAULTCOLOR);
+}
+
+bool IconHelper::GetIconColors(HICON hIcon, ImageColors& colors) {
+    ICONINFO info = {};
+    if (!hIcon || !GetIconInfo(hIcon, &info)) {
+        return false;
+    }
+
+    BITMAP bm = {};
+    bool ok = info.hbmColor && GetObjectW(info.hbmColor, sizeof(bm), &bm) && bm.bmWidth > 0 && bm.bmHeight > 0;
+    if (ok) {
+        // Read the color bitmap back as top-down 32-bit BGRA
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = bm.bmWidth;
+        bmi.bmiHeader.biHeight = -bm.bmHeight;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        std::vector<uint8_t> bgra((size_t)bm.bmWidth * bm.bmHeight * 4);
+        HDC hdc = GetDC(nullptr);
+        ok = GetDIBits(hdc, info.hbmColor, 0, bm.bmHeight, bgra.data(), &bmi, DIB_RGB_COLORS) != 0;
+        ReleaseDC(nullptr, hdc);
+
+        if (ok) {
+            // Icons without an alpha channel rely on the mask; treat them as opaque
+            bool hasAlpha = false;
+            for (size_t i = 3; i < bgra.size() && !hasAlpha; i += 4) hasAlpha = bgra[i] != 0;
+            if (!hasAlpha) {
+                for (size_t i = 3; i < bgra.size(); i += 4) bgra[i] = 255;
+            }
+            colors = ImageAnalysis::Colors(bgra.data(), bm.bmWidth, bm.bmHeight, (size_t)bm.bmWidth * 4);
+            ok = colors.valid;
+        }
+    }
+
+    if (info.hbmColor) DeleteObject(info.hbmColor);
+    if (info.hbmMask) DeleteObject(info.hbmMask);
+    return ok;
+}
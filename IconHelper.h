@@ -1,6 +1,9 @@
 #pragma once
 #include <windows.h>
+#include <cstdint>
 #include <string>
+#include "IconSource.h"
+#include "ImageAnalysis.h"
 
 // ICO file format structures
 #pragma pack(push, 1)
@@ -26,7 +29,23 @@ class IconHelper {
 public:
     static HICON LoadIconFromFile(const std::wstring& path);
     static bool ConvertPngToIco(const std::wstring& pngPath, const std::wstring& icoPath);
+    static bool ConvertSvgToIco(const std::wstring& svgPath, const std::wstring& icoPath);
+    static bool ConvertToIco(const std::wstring& srcPath, const std::wstring& icoPath);
     static bool IsPngFile(const std::wstring& path);
     static bool IsIcoFile(const std::wstring& path);
+    static bool IsSvgFile(const std::wstring& path);
+    static bool NeedsConversion(const std::wstring& path);
     static std::wstring GetConvertedIconPath(const std::wstring& path);
+
+    // .ico bytes for an icon file (absolute path), converted in memory or
+    // read from the temp directory's conversion cache (useCache), falling
+    // back to GDI+ for raster files the built-in decoder rejects
+    static bool PrepareIcon(const std::wstring& absPath, PreparedIcon& icon, bool useCache = true);
+
+    // Creates a size x size icon from .ico file contents in memory (such as
+    // a bundled or prepared icon), using the smallest entry at least that large
+    static HICON LoadIconFromIcoData(const uint8_t* ico, size_t len, int size);
+
+    // Dominant and accent colors of a loaded icon (used for the loading screen)
+    static bool GetIconColors(HICON hIcon, ImageColors& colors);
 };
@@ -0,0 +1,160 @@
+#include "IconPipeline.h"
+#include "Deflate.h"
+#include "ImageAnalysis.h"
+#include "ImageResample.h"
+#include "PngDecoder.h"
+#include <algorithm>
+#include <chrono>
+
+// Deflate level for PNG-compressed ICO entries
+static const int kIcoPngLevel = Deflate::kDefaultLevel;
+
+// Longer side from which PNGs are streamed rather than decoded whole
+// (16 MB of BGRA at 2048 x 2048)
+static const uint32_t kStreamThreshold = 2048;
+
+// The streamed intermediate keeps this many pixels per icon pixel along the
+// longer side, leaving the bicubic resample (and trimming) real detail to work with
+static const uint32_t kStreamOversample = 4;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Part of the image the icon is made from: the content plus padding when
+// trimming, else everything
+static ImageRect UsedRect(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    const IconPipelineOptions& options) {
+    ImageRect used;
+    used.width = width;
+    used.height = height;
+    if (options.trim) {
+        ImageRect bounds = ImageAnalysis::AlphaBounds(bgra, width, height, stride);
+        used = ImageAnalysis::TrimRect(bounds, width, height, options.padding);
+    }
+    return used;
+}
+
+uint32_t IconPipeline::ChooseSize(uint32_t width, uint32_t height) {
+    if (width <= 16 || height <= 16) return 16;
+    if (width <= 32 || height <= 32) return 32;
+    if (width <= 48 || height <= 48) return 48;
+    if (width <= 64 || height <= 64) return 64;
+    if (width <= 128 || height <= 128) return 128;
+    return 256;
+}
+
+bool IconPipeline::Encode(const std::vector<IcoImage>& images, std::vector<uint8_t>& ico) {
+    // Large entries are stored as PNG, small ones as uncompressed DIB
+    return IcoBuilder::Build(images, IcoBuilder::kDefaultPngThreshold, kIcoPngLevel, ico);
+}
+
+bool IconPipeline::PngToIco(const uint8_t* png, size_t len, uint32_t size, std::vector<uint8_t>& ico,
+    IcoImage* rendered, IconPipelineStats* stats, const IconPipelineOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    PngImage image;
+    if (!PngDecoder::Decode(png, len, image)) {
+        return false;
+    }
+    if (stats) stats->decodeMs = MillisecondsSince(start);
+
+    return PixelsToIco(image.bgra.data(), image.width, image.height, (size_t)image.width * 4,
+        size, ico, rendered, stats, options);
+}
+
+bool IconPipeline::PixelsToIco(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint32_t size, std::vector<uint8_t>& ico, IcoImage* rendered, IconPipelineStats* stats,
+    const IconPipelineOptions& options) {
+    if (!width || !height) {
+        return false;
+    }
+    if (stats) {
+        stats->sourceWidth = width;
+        stats->sourceHeight = height;
+    }
+
+    // Trimming only moves the origin and shrinks the extent; the pixels
+    // are resampled in place
+    auto start = std::chrono::steady_clock::now();
+    ImageRect used = UsedRect(bgra, width, height, stride, options);
+    if (stats) {
+        stats->usedRect = used;
+        stats->colors = ImageAnalysis::Colors(bgra, width, height, stride);
+        stats->analyzeMs = MillisecondsSince(start);
+    }
+    const uint8_t* origin = bgra + used.y * stride + (size_t)used.x * 4;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<IcoImage> images(1);
+    images[0].size = size ? size : ChooseSize(used.width, used.height);
+    ImageResample::FitSquare(origin, used.width, used.height, stride, images[0].size, images[0].bgra);
+    if (stats) stats->resampleMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    ico.clear();
+    if (!Encode(images, ico)) {
+        return false;
+    }
+    if (stats) stats->encodeMs = MillisecondsSince(start);
+
+    if (rendered) *rendered = std::move(images[0]);
+    return true;
+}
+
+bool IconPipeline::ShouldStream(const PngInfo& info) {
+    return !info.interlaced && (info.width >= kStreamThreshold || info.height >= kStreamThreshold);
+}
+
+bool IconPipeline::StreamPngToIco(const PngRowReader::Source& source, uint32_t size,
+    std::vector<uint8_t>& ico, IcoImage* rendered, IconPipelineStats* stats,
+    const IconPipelineOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    PngRowReader reader(source);
+    if (!reader.Open()) {
+        return false;
+    }
+    const PngInfo& info = reader.Info();
+
+    // ChooseSize only grows with the extent, so the size picked for the
+    // trimmed content below is at most the one for the whole image
+    uint32_t reduceTo = size ? size : ChooseSize(info.width, info.height);
+    uint32_t factor = BoxReducer::Factor(info.width, info.height, reduceTo * kStreamOversample);
+    BoxReducer reducer(info.width, info.height, factor, factor);
+    std::vector<uint8_t> row((size_t)info.width * 4);
+    for (uint32_t y = 0; y < info.height; y++) {
+        if (!reader.ReadRow(row.data())) {
+            return false;
+        }
+        reducer.PushRow(row.data());
+    }
+    if (!reader.Finish()) {
+        return false;
+    }
+    if (stats) stats->decodeMs = MillisecondsSince(start);
+
+    // Size from the trimmed content in source pixels, as PixelsToIco does
+    // for a full decode
+    if (!size) {
+        ImageRect used = UsedRect(reducer.Pixels().data(), reducer.Width(), reducer.Height(),
+            (size_t)reducer.Width() * 4, options);
+        size = ChooseSize(std::min<uint32_t>(used.width * factor, info.width),
+            std::min<uint32_t>(used.height * factor, info.height));
+    }
+
+    if (!PixelsToIco(reducer.Pixels().data(), reducer.Width(), reducer.Height(),
+            (size_t)reducer.Width() * 4, size, ico, rendered, stats, options)) {
+        return false;
+    }
+
+    // Report the source, not the intermediate, geometry
+    if (stats) {
+        ImageRect& used = stats->usedRect;
+        used.x *= factor;
+        used.y *= factor;
+        used.width = std::min<uint32_t>(used.width * factor, info.width - used.x);
+        used.height = std::min<uint32_t>(used.height * factor, info.height - used.y);
+        stats->sourceWidth = info.width;
+        stats->sourceHeight = info.height;
+    }
+    return true;
+}
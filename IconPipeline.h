@@ -0,0 +1,64 @@
+#pragma once
+#include "IcoBuilder.h"
+#include "ImageAnalysis.h"
+#include "PngDecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How the source is prepared before resampling
+struct IconPipelineOptions {
+    bool trim = false;          // Cut transparent margins down to padding
+    float padding = 0.0625f;    // Kept around the content, as a fraction of its longer side
+};
+
+// Stage timings, sizes and analysis results from one conversion
+struct IconPipelineStats {
+    double decodeMs = 0.0;
+    double analyzeMs = 0.0;
+    double resampleMs = 0.0;
+    double encodeMs = 0.0;
+    uint32_t sourceWidth = 0;
+    uint32_t sourceHeight = 0;
+    ImageRect usedRect;         // Part of the source that was resampled
+    ImageColors colors;
+};
+
+// The raster PNG -> .ico conversion behind IconHelper::ConvertPngToIco,
+// kept free of Windows APIs so it can be measured anywhere.
+class IconPipeline {
+public:
+    // Icon size picked for a source image (the smallest standard size that
+    // covers the shorter side, up to 256)
+    static uint32_t ChooseSize(uint32_t width, uint32_t height);
+
+    // Decodes png, fits it into a size x size icon (0 = ChooseSize) and
+    // serializes it. rendered and stats are optional outputs; the source's
+    // colors are only analyzed when stats is given.
+    static bool PngToIco(const uint8_t* png, size_t len, uint32_t size, std::vector<uint8_t>& ico,
+        IcoImage* rendered = nullptr, IconPipelineStats* stats = nullptr,
+        const IconPipelineOptions& options = IconPipelineOptions());
+
+    // Same for pixels that are already decoded (top-down, non-premultiplied BGRA)
+    static bool PixelsToIco(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint32_t size, std::vector<uint8_t>& ico,
+        IcoImage* rendered = nullptr, IconPipelineStats* stats = nullptr,
+        const IconPipelineOptions& options = IconPipelineOptions());
+
+    // Whether a PNG with this header should go through StreamPngToIco:
+    // large enough that a full decode would cost more than the icon needs,
+    // and not interlaced
+    static bool ShouldStream(const PngInfo& info);
+
+    // PngToIco with bounded memory: rows are decoded one at a time from
+    // source and box-averaged down to about four times the icon size
+    // before the usual trim and resample. Peak memory is a few source rows
+    // plus the reduced image, independent of the source size. When size is
+    // 0 it is chosen from the trimmed content, as for PngToIco.
+    static bool StreamPngToIco(const PngRowReader::Source& source, uint32_t size,
+        std::vector<uint8_t>& ico, IcoImage* rendered = nullptr, IconPipelineStats* stats = nullptr,
+        const IconPipelineOptions& options = IconPipelineOptions());
+
+    // Serializes finished icon images with the shared encoder settings
+    static bool Encode(const std::vector<IcoImage>& images, std::vector<uint8_t>& ico);
+};
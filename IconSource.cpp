@@ -0,0 +1,179 @@
+#include "IconSource.h"
+#include "FileUtil.h"
+#include "IconCache.h"
+#include "SvgImage.h"
+#include <cstdio>
+#include <cwctype>
+
+const uint32_t IconSource::kSvgSizes[9] = { 16, 20, 24, 32, 40, 48, 64, 128, 256 };
+const float IconSource::kPadding = 0.0625f;
+
+namespace {
+
+uint32_t ReadLe(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+bool HasExtension(const std::wstring& path, const wchar_t* ext) {
+    size_t dot = path.find_last_of(L'.');
+    size_t slash = path.find_last_of(L"/\\");
+    if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash)) return false;
+    std::wstring actual = path.substr(dot);
+    for (wchar_t& c : actual) c = (wchar_t)towlower(c);
+    return actual == ext;
+}
+
+IconPipelineOptions TrimOptions() {
+    IconPipelineOptions options;
+    options.trim = true;
+    options.padding = IconSource::kPadding;
+    return options;
+}
+
+// Very large PNGs are reduced a row at a time straight from the file, so a
+// 10000 x 10000 source doesn't need 400 MB of pixels for a 256 px icon.
+// Returns false for anything the full decode should handle.
+bool StreamLargePng(const std::wstring& path, PreparedIcon& icon, IconPipelineStats* stats) {
+    FILE* file = FileUtil::OpenRead(path);
+    if (!file) {
+        return false;
+    }
+
+    // The header alone decides, before any pixel data is read
+    uint8_t head[PngDecoder::kProbeBytes];
+    PngInfo info;
+    bool ok = fread(head, 1, sizeof(head), file) == sizeof(head) &&
+        PngDecoder::Probe(head, sizeof(head), info) && IconPipeline::ShouldStream(info) &&
+        fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        ok = IconPipeline::StreamPngToIco([file](uint8_t* buffer, size_t capacity) {
+            return fread(buffer, 1, capacity, file);
+        }, 0, icon.ico, nullptr, stats, TrimOptions());
+    }
+    fclose(file);
+    if (!ok) icon.ico.clear();
+    return ok;
+}
+
+}
+
+bool IconSource::IsIco(const std::wstring& path) {
+    return HasExtension(path, L".ico");
+}
+
+bool IconSource::IsPng(const std::wstring& path) {
+    return HasExtension(path, L".png");
+}
+
+bool IconSource::IsSvg(const std::wstring& path) {
+    return HasExtension(path, L".svg");
+}
+
+bool IconSource::FromPng(const uint8_t* png, size_t len, PreparedIcon& icon, IconPipelineStats* stats) {
+    // The pipeline analyzes colors only when there are stats to put them in
+    IconPipelineStats local;
+    if (!stats) stats = &local;
+    if (!IconPipeline::PngToIco(png, len, 0, icon.ico, nullptr, stats, TrimOptions())) {
+        icon.ico.clear();
+        return false;
+    }
+    icon.colors = stats->colors;
+    icon.fromCache = false;
+    return true;
+}
+
+bool IconSource::FromSvg(const std::string& text, PreparedIcon& icon) {
+    std::unique_ptr<SvgImage> svg = SvgImage::Parse(text);
+    if (!svg) {
+        return false;
+    }
+
+    // Rasterize directly at every size instead of resampling one bitmap.
+    // The finished .ico (under IconCache::VersionedPath) is the per-size
+    // cache; Load serves it without parsing the SVG again
+    std::vector<IcoImage> images;
+    for (uint32_t size : kSvgSizes) {
+        IcoImage image;
+        image.size = size;
+        image.bgra = svg->Render(size);
+        images.push_back(std::move(image));
+    }
+    const IcoImage& largest = images.back();
+    icon.colors = ImageAnalysis::Colors(largest.bgra.data(), largest.size, largest.size, (size_t)largest.size * 4);
+    icon.fromCache = false;
+    return IconPipeline::Encode(images, icon.ico);
+}
+
+bool IconSource::Load(const std::wstring& absPath, const std::wstring& cacheDir, PreparedIcon& icon,
+    IconPipelineStats* stats) {
+    icon = PreparedIcon();
+    IconPipelineStats local;
+    if (!stats) stats = &local;  // For the colors
+    bool png = IsPng(absPath), svg = IsSvg(absPath);
+    if (!png && !svg) {
+        // .ico (or anything else Windows may load) is used as it is
+        std::string data;
+        if (!FileUtil::Read(absPath, data)) {
+            return false;
+        }
+        icon.ico.assign(data.begin(), data.end());
+        return true;
+    }
+
+    // A conversion made earlier for a shortcut saves converting again
+    FileUtil::Entry info;
+    if (!FileUtil::Stat(absPath, info) || info.isDirectory) {
+        return false;
+    }
+    if (!cacheDir.empty()) {
+        std::string cached;
+        size_t offset = 0, bytes = 0;
+        if (FileUtil::Read(IconCache::VersionedPath(cacheDir, absPath, info), cached) &&
+            FindEntry((const uint8_t*)cached.data(), cached.size(), 32, offset, bytes)) {
+            icon.ico.assign(cached.begin(), cached.end());
+            icon.fromCache = true;
+            return true;
+        }
+    }
+
+    if (png && StreamLargePng(absPath, icon, stats)) {
+        icon.colors = stats->colors;
+        return true;
+    }
+    std::string data;
+    if (!FileUtil::Read(absPath, data)) {
+        return false;
+    }
+    return png ? FromPng((const uint8_t*)data.data(), data.size(), icon, stats) : FromSvg(data, icon);
+}
+
+bool IconSource::FindEntry(const uint8_t* ico, size_t len, uint32_t size, size_t& offset, size_t& bytes) {
+    // ICONDIR (6 bytes) then one 16-byte ICONDIRENTRY per image
+    if (len < 6 || ReadLe(ico, 2) != 0 || ReadLe(ico + 2, 2) != 1) {
+        return false;
+    }
+    uint32_t count = ReadLe(ico + 4, 2);
+    if (len < 6 + (size_t)count * 16) {
+        return false;
+    }
+
+    uint32_t bestSize = 0;
+    bool found = false;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* e = ico + 6 + i * 16;
+        uint32_t entrySize = e[0] ? e[0] : 256;
+        uint32_t entryBytes = ReadLe(e + 8, 4), entryOffset = ReadLe(e + 12, 4);
+        if (entryOffset > len || entryBytes > len - entryOffset) continue;
+        bool better = !found ||
+            (entrySize >= size ? bestSize < size || entrySize < bestSize : bestSize < size && entrySize > bestSize);
+        if (better) {
+            found = true;
+            bestSize = entrySize;
+            offset = entryOffset;
+            bytes = entryBytes;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "IconPipeline.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An icon ready to hand to the window: .ico file bytes in memory, plus the
+// source's colors when they were found while converting
+struct PreparedIcon {
+    std::vector<uint8_t> ico;
+    ImageColors colors;           // valid only when converted (not for .ico or cached sources)
+    bool fromCache = false;
+};
+
+// Turns an icon file (.ico, .png or .svg) into .ico bytes without any
+// intermediate file: the source is read once, converted in memory, and the
+// result is ready for CreateIconFromResourceEx. When cacheDir is given and
+// holds a conversion of the current version of the source (IconCache; e.g.
+// written for a shortcut), that file is read instead of converting again.
+// Nothing is written.
+class IconSource {
+public:
+    // Sizes rasterized from vector sources (shell and title bar sizes at common DPIs)
+    static const uint32_t kSvgSizes[9];
+
+    // Transparent margins of raster sources are cut down to this fraction
+    // of the glyph, so logos with wide margins stay legible at 16 and 32 px
+    static const float kPadding;
+
+    // absPath must already be absolute (it is used as the cache key as is)
+    static bool Load(const std::wstring& absPath, const std::wstring& cacheDir, PreparedIcon& icon,
+        IconPipelineStats* stats = nullptr);
+
+    // Converts file contents of the given kind
+    static bool FromPng(const uint8_t* png, size_t len, PreparedIcon& icon, IconPipelineStats* stats = nullptr);
+    static bool FromSvg(const std::string& text, PreparedIcon& icon);
+
+    // Offset and length of the entry in ico best suited for a size x size
+    // icon: the smallest at least that large, else the largest there is
+    static bool FindEntry(const uint8_t* ico, size_t len, uint32_t size, size_t& offset, size_t& bytes);
+
+    static bool IsIco(const std::wstring& path);
+    static bool IsPng(const std::wstring& path);
+    static bool IsSvg(const std::wstring& path);
+};
@@ -0,0 +1,206 @@
+#include "ImageAnalysis.h"
+#include <cmath>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WW_ANALYSIS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Histogram bins: 4 bits per channel
+const int kBinBits = 4;
+const int kBins = 1 << (3 * kBinBits);
+
+// An accent has to cover at least this much of the visible image and be
+// at least this saturated (HSV saturation, 0-1)
+const float kMinAccentShare = 0.02f;
+const float kMinAccentSaturation = 0.35f;
+
+// Index of the first pixel in [begin, end) with alpha > threshold, or end
+uint32_t FirstVisible(const uint8_t* row, uint32_t begin, uint32_t end, uint8_t threshold) {
+    uint32_t x = begin;
+#ifdef WW_ANALYSIS_SSE2
+    const __m128i limit = _mm_set1_epi32(threshold);
+    for (; x + 4 <= end; x += 4) {
+        __m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(row + x * 4)), 24);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(alpha, limit)));
+        if (mask) {
+            while (!(mask & 1)) {
+                mask >>= 1;
+                x++;
+            }
+            return x;
+        }
+    }
+#endif
+    for (; x < end; x++) {
+        if (row[x * 4 + 3] > threshold) return x;
+    }
+    return end;
+}
+
+// Index of the last pixel in [begin, end) with alpha > threshold, or end
+uint32_t LastVisible(const uint8_t* row, uint32_t begin, uint32_t end, uint8_t threshold) {
+    uint32_t x = end;
+#ifdef WW_ANALYSIS_SSE2
+    const __m128i limit = _mm_set1_epi32(threshold);
+    for (; x >= begin + 4; x -= 4) {
+        __m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(row + (x - 4) * 4)), 24);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(alpha, limit)));
+        if (mask) {
+            uint32_t last = x - 1;
+            while (!(mask & 8)) {
+                mask <<= 1;
+                last--;
+            }
+            return last;
+        }
+    }
+#endif
+    while (x > begin) {
+        x--;
+        if (row[x * 4 + 3] > threshold) return x;
+    }
+    return end;
+}
+
+struct Bin {
+    uint64_t weight = 0;  // Sum of alpha
+    uint64_t b = 0, g = 0, r = 0;  // Sums of premultiplied channels
+};
+
+ImageColor BinColor(const Bin& bin, uint64_t total) {
+    ImageColor c;
+    c.b = (uint8_t)((bin.b + bin.weight / 2) / bin.weight);
+    c.g = (uint8_t)((bin.g + bin.weight / 2) / bin.weight);
+    c.r = (uint8_t)((bin.r + bin.weight / 2) / bin.weight);
+    c.share = (float)bin.weight / (float)total;
+    return c;
+}
+
+float Saturation(const ImageColor& c) {
+    int hi = c.r > c.g ? c.r : c.g;
+    hi = hi > c.b ? hi : c.b;
+    int lo = c.r < c.g ? c.r : c.g;
+    lo = lo < c.b ? lo : c.b;
+    return hi ? (float)(hi - lo) / (float)hi : 0.0f;
+}
+
+}
+
+ImageRect ImageAnalysis::AlphaBounds(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint8_t threshold) {
+    ImageRect bounds;
+    if (!width || !height) {
+        return bounds;
+    }
+
+    // Top and bottom rows with anything visible
+    uint32_t top = 0;
+    while (top < height && FirstVisible(bgra + top * stride, 0, width, threshold) == width) top++;
+    if (top == height) {
+        return bounds;
+    }
+    uint32_t bottom = height - 1;
+    while (bottom > top && FirstVisible(bgra + bottom * stride, 0, width, threshold) == width) bottom--;
+
+    // Each row in between only has to be searched outside the columns
+    // already known to be covered
+    uint32_t left = width, right = 0;
+    for (uint32_t y = top; y <= bottom; y++) {
+        const uint8_t* row = bgra + y * stride;
+        uint32_t l = FirstVisible(row, 0, left, threshold);
+        if (l < left) left = l;
+        if (right + 1 < width) {
+            uint32_t r = LastVisible(row, right + 1, width, threshold);
+            if (r != width) right = r;
+        }
+        if (left == 0 && right + 1 == width) break;
+    }
+
+    bounds.x = left;
+    bounds.y = top;
+    bounds.width = right - left + 1;
+    bounds.height = bottom - top + 1;
+    return bounds;
+}
+
+ImageRect ImageAnalysis::TrimRect(const ImageRect& bounds, uint32_t width, uint32_t height, float padding) {
+    ImageRect rect;
+    if (bounds.Empty()) {
+        rect.width = width;
+        rect.height = height;
+        return rect;
+    }
+
+    uint32_t longer = bounds.width > bounds.height ? bounds.width : bounds.height;
+    uint32_t pad = (uint32_t)std::lround((padding > 0.0f ? padding : 0.0f) * longer);
+    uint32_t x0 = bounds.x > pad ? bounds.x - pad : 0;
+    uint32_t y0 = bounds.y > pad ? bounds.y - pad : 0;
+    uint64_t x1 = (uint64_t)bounds.x + bounds.width + pad;
+    uint64_t y1 = (uint64_t)bounds.y + bounds.height + pad;
+    rect.x = x0;
+    rect.y = y0;
+    rect.width = (uint32_t)(x1 < width ? x1 : width) - x0;
+    rect.height = (uint32_t)(y1 < height ? y1 : height) - y0;
+    return rect;
+}
+
+ImageColors ImageAnalysis::Colors(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride) {
+    ImageColors colors;
+    if (!width || !height) {
+        return colors;
+    }
+
+    // Sample on a regular grid so the cost stays flat for large sources
+    uint64_t pixels = (uint64_t)width * height;
+    uint32_t step = 1;
+    while (pixels / ((uint64_t)step * step) > kColorSamples) step++;
+
+    std::vector<Bin> bins(kBins);
+    const int shift = 8 - kBinBits;
+    uint64_t total = 0;
+    for (uint32_t y = step / 2; y < height; y += step) {
+        const uint8_t* row = bgra + y * stride;
+        for (uint32_t x = step / 2; x < width; x += step) {
+            const uint8_t* p = row + x * 4;
+            uint32_t a = p[3];
+            if (!a) continue;
+            // Bin on the color itself, weight by coverage
+            Bin& bin = bins[((p[2] >> shift) << (2 * kBinBits)) | ((p[1] >> shift) << kBinBits) | (p[0] >> shift)];
+            bin.weight += a;
+            bin.b += p[0] * a;
+            bin.g += p[1] * a;
+            bin.r += p[2] * a;
+            total += a;
+        }
+    }
+    if (!total) {
+        return colors;
+    }
+
+    const Bin* dominant = nullptr;
+    const Bin* accent = nullptr;
+    float accentScore = 0.0f;
+    for (const Bin& bin : bins) {
+        if (!bin.weight) continue;
+        if (!dominant || bin.weight > dominant->weight) dominant = &bin;
+
+        ImageColor c = BinColor(bin, total);
+        float saturation = Saturation(c);
+        int value = c.r > c.g ? (c.r > c.b ? c.r : c.b) : (c.g > c.b ? c.g : c.b);
+        if (c.share < kMinAccentShare || saturation < kMinAccentSaturation || value < 64) continue;
+        float score = c.share * saturation;
+        if (score > accentScore) {
+            accentScore = score;
+            accent = &bin;
+        }
+    }
+
+    colors.valid = true;
+    colors.dominant = BinColor(*dominant, total);
+    colors.accent = accent ? BinColor(*accent, total) : colors.dominant;
+    return colors;
+}
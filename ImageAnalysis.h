@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Rectangle within an image, in pixels
+struct ImageRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool Empty() const { return width == 0 || height == 0; }
+};
+
+struct ImageColor {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    float share = 0.0f;  // Fraction of the visible (alpha-weighted) image in this color
+};
+
+struct ImageColors {
+    bool valid = false;   // False for fully transparent images
+    ImageColor dominant;  // Most common color
+    ImageColor accent;    // Most common saturated color (dominant if there is none)
+};
+
+// Source image analysis run before icon resampling.
+// All functions take top-down, non-premultiplied BGRA. The alpha scan uses
+// SSE2 on x86 with a scalar fallback elsewhere.
+class ImageAnalysis {
+public:
+    // Smallest rectangle holding every pixel with alpha above threshold;
+    // empty if there is none
+    static ImageRect AlphaBounds(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint8_t threshold = 0);
+
+    // Crop rectangle for bounds with padding (a fraction of the longer side
+    // of bounds) on every side, clamped to the image. Transparent margins
+    // wider than the padding are cut down to it; the whole image is
+    // returned for empty bounds.
+    static ImageRect TrimRect(const ImageRect& bounds, uint32_t width, uint32_t height, float padding);
+
+    // Dominant and accent colors from a 4-bit-per-channel histogram of
+    // alpha-weighted (premultiplied) pixels; large images are sampled on a
+    // grid of about kColorSamples pixels
+    static ImageColors Colors(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride);
+
+    static const uint32_t kColorSamples = 256 * 1024;
+};
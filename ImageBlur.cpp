@@ -0,0 +1,101 @@
+#include "ImageBlur.h"
+#include <vector>
+
+namespace {
+
+// One box pass along a line of n pixels: src and dst are step bytes apart
+// per pixel. scale is 65536 / (2 * radius + 1), rounded.
+void BoxLine(const uint8_t* src, uint8_t* dst, size_t step, uint32_t n, uint32_t radius, uint32_t scale) {
+    const uint32_t last = n - 1;
+    uint32_t s0 = src[0] * (radius + 1), s1 = src[1] * (radius + 1);
+    uint32_t s2 = src[2] * (radius + 1), s3 = src[3] * (radius + 1);
+    for (uint32_t i = 1; i <= radius; i++) {
+        const uint8_t* p = src + (i < last ? i : last) * step;
+        s0 += p[0];
+        s1 += p[1];
+        s2 += p[2];
+        s3 += p[3];
+    }
+
+    // Window slides by adding the pixel entering on the right and dropping
+    // the one leaving on the left; only the ends need clamping
+    uint32_t x = 0;
+    auto slide = [&](const uint8_t* add, const uint8_t* sub) {
+        uint8_t* out = dst + x * step;
+        out[0] = (uint8_t)((s0 * scale + 0x8000) >> 16);
+        out[1] = (uint8_t)((s1 * scale + 0x8000) >> 16);
+        out[2] = (uint8_t)((s2 * scale + 0x8000) >> 16);
+        out[3] = (uint8_t)((s3 * scale + 0x8000) >> 16);
+        s0 += add[0] - sub[0];
+        s1 += add[1] - sub[1];
+        s2 += add[2] - sub[2];
+        s3 += add[3] - sub[3];
+    };
+    for (; x < n && x <= radius; x++) {
+        uint32_t in = x + radius + 1;
+        slide(src + (in < last ? in : last) * step, src);
+    }
+    for (; x + radius + 1 < n; x++) {
+        slide(src + (x + radius + 1) * step, src + (x - radius) * step);
+    }
+    for (; x < n; x++) {
+        slide(src + last * step, src + (x - radius) * step);
+    }
+}
+
+} // namespace
+
+void ImageBlur::Box(uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint32_t radius, int passes) {
+    if (!width || !height || !radius || passes <= 0) return;
+
+    const uint32_t scale = (65536 + radius) / (2 * radius + 1);
+    const size_t rowBytes = (size_t)width * 4;
+    std::vector<uint8_t> scratch(rowBytes * height);
+
+    for (int pass = 0; pass < passes; pass++) {
+        // Rows into scratch, then columns back into the image. Columns are
+        // walked side by side (one row at a time) rather than one whole
+        // column at a time, which would touch a new cache line per pixel.
+        for (uint32_t y = 0; y < height; y++) {
+            BoxLine(bgra + y * stride, &scratch[y * rowBytes], 4, width, radius, scale);
+        }
+
+        std::vector<uint32_t> sums(rowBytes);
+        const uint32_t last = height - 1;
+        for (size_t i = 0; i < rowBytes; i++) {
+            sums[i] = scratch[i] * (radius + 1);
+        }
+        for (uint32_t i = 1; i <= radius; i++) {
+            const uint8_t* row = &scratch[(i < last ? i : last) * rowBytes];
+            for (size_t k = 0; k < rowBytes; k++) sums[k] += row[k];
+        }
+        for (uint32_t y = 0; y < height; y++) {
+            uint8_t* out = bgra + y * stride;
+            uint32_t in = y + radius + 1;
+            uint32_t outIndex = y > radius ? y - radius : 0;
+            const uint8_t* add = &scratch[(in < last ? in : last) * rowBytes];
+            const uint8_t* sub = &scratch[outIndex * rowBytes];
+            for (size_t k = 0; k < rowBytes; k++) {
+                uint32_t sum = sums[k];
+                out[k] = (uint8_t)((sum * scale + 0x8000) >> 16);
+                sums[k] = sum + add[k] - sub[k];
+            }
+        }
+    }
+}
+
+void ImageBlur::Tint(uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint8_t r, uint8_t g, uint8_t b, unsigned amount) {
+    if (amount > 256) amount = 256;
+    const unsigned keep = 256 - amount;
+    const unsigned tb = b * amount + 128, tg = g * amount + 128, tr = r * amount + 128;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t* p = bgra + y * stride;
+        for (uint32_t x = 0; x < width; x++, p += 4) {
+            p[0] = (uint8_t)((p[0] * keep + tb) >> 8);
+            p[1] = (uint8_t)((p[1] * keep + tg) >> 8);
+            p[2] = (uint8_t)((p[2] * keep + tr) >> 8);
+        }
+    }
+}
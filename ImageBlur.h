@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Blur and tint for the launch snapshot (see SnapshotStore).
+// Images are top-down BGRA; channels are filtered independently, so alpha
+// is not premultiplied first. Meant for opaque images.
+class ImageBlur {
+public:
+    // Runs passes box blurs of 2 * radius + 1 pixels along each axis, in
+    // place. Each pass is a running sum, so the cost per pixel doesn't grow
+    // with the radius; three passes come close to a Gaussian with sigma
+    // sqrt((radius + 1) * radius). Edge pixels are repeated past the border.
+    static void Box(uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint32_t radius, int passes = 3);
+
+    // Moves color channels toward (r, g, b) by amount / 256; alpha is kept
+    static void Tint(uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint8_t r, uint8_t g, uint8_t b, unsigned amount);
+};
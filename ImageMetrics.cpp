@@ -0,0 +1,209 @@
+#include "ImageMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WW_METRICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const int kWindow = 8;
+const int kWindowStep = 4;
+const double kC1 = (0.01 * 255) * (0.01 * 255);
+const double kC2 = (0.03 * 255) * (0.03 * 255);
+
+void Premultiply(const uint8_t* src, size_t pixels, std::vector<uint8_t>& dst) {
+    dst.resize(pixels * 4);
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t* s = src + i * 4;
+        uint8_t* d = &dst[i * 4];
+        int a = s[3];
+        d[0] = (uint8_t)((s[0] * a + 127) / 255);
+        d[1] = (uint8_t)((s[1] * a + 127) / 255);
+        d[2] = (uint8_t)((s[2] * a + 127) / 255);
+        d[3] = (uint8_t)a;
+    }
+}
+
+// Per-channel window sums: x, y, x^2, y^2, xy
+struct WindowSums {
+    uint32_t sx[4], sy[4], sxx[4], syy[4], sxy[4];
+};
+
+void WindowScalar(const uint8_t* a, const uint8_t* b, size_t stride, int w, int h, WindowSums& s) {
+    for (int c = 0; c < 4; c++) s.sx[c] = s.sy[c] = s.sxx[c] = s.syy[c] = s.sxy[c] = 0;
+    for (int y = 0; y < h; y++) {
+        const uint8_t* pa = a + y * stride;
+        const uint8_t* pb = b + y * stride;
+        for (int x = 0; x < w * 4; x++) {
+            uint32_t va = pa[x], vb = pb[x];
+            int c = x & 3;
+            s.sx[c] += va;
+            s.sy[c] += vb;
+            s.sxx[c] += va * va;
+            s.syy[c] += vb * vb;
+            s.sxy[c] += va * vb;
+        }
+    }
+}
+
+#ifdef WW_METRICS_SSE2
+
+// Squares/products of eight 16-bit lanes widened to two vectors of 32-bit
+// lanes, each holding one pixel's four channels
+inline void AddProducts(__m128i x, __m128i y, __m128i& acc) {
+    __m128i lo = _mm_mullo_epi16(x, y);
+    __m128i hi = _mm_mulhi_epu16(x, y);
+    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(lo, hi));
+    acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(lo, hi));
+}
+
+inline void AddWidened(__m128i x, __m128i& acc) {
+    const __m128i zero = _mm_setzero_si128();
+    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(x, zero));
+    acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(x, zero));
+}
+
+// 8x8 window: each row is two 16-byte loads of four BGRA pixels
+void Window8Sse2(const uint8_t* a, const uint8_t* b, size_t stride, WindowSums& s) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sx = zero, sy = zero, sxx = zero, syy = zero, sxy = zero;
+    for (int y = 0; y < kWindow; y++) {
+        for (int half = 0; half < 2; half++) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + y * stride + half * 16));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + y * stride + half * 16));
+            __m128i a0 = _mm_unpacklo_epi8(va, zero), a1 = _mm_unpackhi_epi8(va, zero);
+            __m128i b0 = _mm_unpacklo_epi8(vb, zero), b1 = _mm_unpackhi_epi8(vb, zero);
+            AddWidened(_mm_add_epi16(a0, a1), sx);
+            AddWidened(_mm_add_epi16(b0, b1), sy);
+            AddProducts(a0, a0, sxx); AddProducts(a1, a1, sxx);
+            AddProducts(b0, b0, syy); AddProducts(b1, b1, syy);
+            AddProducts(a0, b0, sxy); AddProducts(a1, b1, sxy);
+        }
+    }
+    _mm_storeu_si128((__m128i*)s.sx, sx);
+    _mm_storeu_si128((__m128i*)s.sy, sy);
+    _mm_storeu_si128((__m128i*)s.sxx, sxx);
+    _mm_storeu_si128((__m128i*)s.syy, syy);
+    _mm_storeu_si128((__m128i*)s.sxy, sxy);
+}
+
+// Sum of squared byte differences
+uint64_t SumSquaredSse2(const uint8_t* a, const uint8_t* b, size_t len, size_t& done) {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t total = 0;
+    done = 0;
+    while (len - done >= 16) {
+        // 32-bit lanes gain at most 2 * 2 * 255^2 per iteration
+        size_t blocks = std::min<size_t>((len - done) / 16, 4096);
+        __m128i acc = zero;
+        for (size_t i = 0; i < blocks; i++, done += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + done));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + done));
+            __m128i d0 = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i d1 = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(d0, d0));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(d1, d1));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        total += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return total;
+}
+
+// Largest absolute difference of the alpha bytes
+int MaxAlphaSse2(const uint8_t* a, const uint8_t* b, size_t len, size_t& done) {
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+    __m128i best = _mm_setzero_si128();
+    for (done = 0; len - done >= 16; done += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + done));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + done));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        best = _mm_max_epu8(best, _mm_and_si128(diff, alphaMask));
+    }
+    uint8_t lanes[16];
+    _mm_storeu_si128((__m128i*)lanes, best);
+    int m = 0;
+    for (int i = 3; i < 16; i += 4) m = std::max(m, (int)lanes[i]);
+    return m;
+}
+
+#endif // WW_METRICS_SSE2
+
+double WindowSsim(const WindowSums& s, int n) {
+    double total = 0.0;
+    for (int c = 0; c < 4; c++) {
+        double mx = (double)s.sx[c] / n;
+        double my = (double)s.sy[c] / n;
+        double vx = (double)s.sxx[c] / n - mx * mx;
+        double vy = (double)s.syy[c] / n - my * my;
+        double cov = (double)s.sxy[c] / n - mx * my;
+        total += ((2 * mx * my + kC1) * (2 * cov + kC2)) /
+            ((mx * mx + my * my + kC1) * (vx + vy + kC2));
+    }
+    return total / 4;
+}
+
+} // namespace
+
+ImageQuality ImageMetrics::Compare(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height) {
+    ImageQuality q;
+    const size_t pixels = (size_t)width * height;
+    if (!pixels) return q;
+
+    std::vector<uint8_t> pa, pb;
+    Premultiply(a, pixels, pa);
+    Premultiply(b, pixels, pb);
+    const uint8_t* x = pa.data();
+    const uint8_t* y = pb.data();
+    const size_t len = pixels * 4;
+    const size_t stride = (size_t)width * 4;
+
+    // PSNR and alpha error over every byte
+    size_t done = 0;
+    uint64_t sse = 0;
+    int maxAlpha = 0;
+#ifdef WW_METRICS_SSE2
+    sse = SumSquaredSse2(x, y, len, done);
+    maxAlpha = MaxAlphaSse2(x, y, len, done);
+#endif
+    for (size_t i = done; i < len; i++) {
+        int d = (int)x[i] - (int)y[i];
+        sse += (uint64_t)(d * d);
+        if ((i & 3) == 3) maxAlpha = std::max(maxAlpha, std::abs(d));
+    }
+    q.maxAlphaError = maxAlpha;
+    double mse = (double)sse / len;
+    q.psnr = mse > 0.0 ? std::min((double)kMaxPsnr, 10.0 * std::log10(255.0 * 255.0 / mse)) : kMaxPsnr;
+
+    // SSIM over 8x8 windows every 4 pixels; tiny images use one window
+    WindowSums sums;
+    if (width < (uint32_t)kWindow || height < (uint32_t)kWindow) {
+        WindowScalar(x, y, stride, (int)width, (int)height, sums);
+        q.ssim = WindowSsim(sums, (int)pixels);
+        return q;
+    }
+
+    double total = 0.0;
+    int windows = 0;
+    for (uint32_t wy = 0; wy + kWindow <= height; wy += kWindowStep) {
+        for (uint32_t wx = 0; wx + kWindow <= width; wx += kWindowStep) {
+            const uint8_t* wa = x + wy * stride + wx * 4;
+            const uint8_t* wb = y + wy * stride + wx * 4;
+#ifdef WW_METRICS_SSE2
+            Window8Sse2(wa, wb, stride, sums);
+#else
+            WindowScalar(wa, wb, stride, kWindow, kWindow, sums);
+#endif
+            total += WindowSsim(sums, kWindow * kWindow);
+            windows++;
+        }
+    }
+    q.ssim = total / windows;
+    return q;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// Similarity of two images of the same size
+struct ImageQuality {
+    double ssim = 1.0;       // Mean SSIM over 8x8 windows and all four channels
+    double psnr = 0.0;       // Peak signal-to-noise ratio in dB (kMaxPsnr when identical)
+    int maxAlphaError = 0;   // Largest per-pixel alpha difference (0-255)
+};
+
+// Image comparison kernels used by the icon benchmark.
+// Colors are compared premultiplied, so differences hidden under full
+// transparency don't count. SSE2 kernels are used on x86 with scalar
+// fallbacks elsewhere.
+class ImageMetrics {
+public:
+    // Reported instead of infinity for identical images
+    static const int kMaxPsnr = 100;
+
+    // Both images are top-down, non-premultiplied BGRA with tightly packed rows
+    static ImageQuality Compare(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height);
+};
@@ -0,0 +1,208 @@
+#include "ImageResample.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float kSupport = 2.0f;
+
+float Bicubic(float x) {
+    const float a = -0.5f;
+    x = std::fabs(x);
+    if (x < 1.0f) return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+    if (x < 2.0f) return (((x - 5.0f) * x + 8.0f) * x - 4.0f) * a;
+    return 0.0f;
+}
+
+// Per-output-pixel filter taps along one axis
+struct Taps {
+    std::vector<int> first;      // First source index per output pixel
+    std::vector<int> count;      // Taps per output pixel
+    std::vector<float> weights;  // count[i] weights starting at i * stride
+    int stride = 0;
+
+    void Build(int inSize, int outSize) {
+        const float scale = (float)inSize / (float)outSize;
+        const float filterScale = std::max(scale, 1.0f);
+        const float support = kSupport * filterScale;
+        stride = (int)std::ceil(support) * 2 + 1;
+
+        first.resize(outSize);
+        count.resize(outSize);
+        weights.assign((size_t)outSize * stride, 0.0f);
+        for (int i = 0; i < outSize; i++) {
+            float center = (i + 0.5f) * scale;
+            int x0 = std::max(0, (int)(center - support + 0.5f));
+            int x1 = std::min(inSize, (int)(center + support + 0.5f));
+            float* w = &weights[(size_t)i * stride];
+            float total = 0.0f;
+            int n = std::min(x1 - x0, stride);
+            for (int k = 0; k < n; k++) {
+                w[k] = Bicubic((x0 + k - center + 0.5f) / filterScale);
+                total += w[k];
+            }
+            if (total != 0.0f) {
+                for (int k = 0; k < n; k++) w[k] /= total;
+            }
+            first[i] = x0;
+            count[i] = n;
+        }
+    }
+};
+
+inline uint8_t ClampByte(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 255.0f) return 255;
+    return (uint8_t)(v + 0.5f);
+}
+
+} // namespace
+
+void ImageResample::Resize(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, size_t dstStride) {
+    if (!width || !height || !dstWidth || !dstHeight) return;
+
+    Taps tx, ty;
+    tx.Build((int)width, (int)dstWidth);
+    ty.Build((int)height, (int)dstHeight);
+
+    // Horizontal pass into premultiplied float rows
+    std::vector<float> premul((size_t)width * 4);
+    std::vector<float> horiz((size_t)dstWidth * height * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* src = bgra + y * stride;
+        for (uint32_t x = 0; x < width; x++) {
+            float a = src[x * 4 + 3] * (1.0f / 255.0f);
+            premul[x * 4 + 0] = src[x * 4 + 0] * a;
+            premul[x * 4 + 1] = src[x * 4 + 1] * a;
+            premul[x * 4 + 2] = src[x * 4 + 2] * a;
+            premul[x * 4 + 3] = src[x * 4 + 3];
+        }
+
+        float* out = &horiz[(size_t)y * dstWidth * 4];
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            const float* w = &tx.weights[(size_t)x * tx.stride];
+            const float* p = &premul[(size_t)tx.first[x] * 4];
+            float b = 0, g = 0, r = 0, a = 0;
+            for (int k = 0; k < tx.count[x]; k++, p += 4) {
+                b += p[0] * w[k];
+                g += p[1] * w[k];
+                r += p[2] * w[k];
+                a += p[3] * w[k];
+            }
+            out[x * 4 + 0] = b;
+            out[x * 4 + 1] = g;
+            out[x * 4 + 2] = r;
+            out[x * 4 + 3] = a;
+        }
+    }
+
+    // Vertical pass, then back to non-premultiplied bytes
+    std::vector<float> acc((size_t)dstWidth * 4);
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const float* w = &ty.weights[(size_t)y * ty.stride];
+        for (int k = 0; k < ty.count[y]; k++) {
+            const float* row = &horiz[(size_t)(ty.first[y] + k) * dstWidth * 4];
+            const float wk = w[k];
+            for (size_t i = 0; i < acc.size(); i++) acc[i] += row[i] * wk;
+        }
+
+        uint8_t* out = dst + y * dstStride;
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            const float* p = &acc[x * 4];
+            uint8_t a = ClampByte(p[3]);
+            if (a == 0) {
+                memset(out + x * 4, 0, 4);
+                continue;
+            }
+            float inv = 255.0f / p[3];
+            out[x * 4 + 0] = ClampByte(p[0] * inv);
+            out[x * 4 + 1] = ClampByte(p[1] * inv);
+            out[x * 4 + 2] = ClampByte(p[2] * inv);
+            out[x * 4 + 3] = a;
+        }
+    }
+}
+
+void ImageResample::FitSquare(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    uint32_t size, std::vector<uint8_t>& out) {
+    out.assign((size_t)size * size * 4, 0);
+    if (!width || !height || !size) return;
+
+    float scale = std::min((float)size / width, (float)size / height);
+    uint32_t scaledWidth = std::max(1u, (uint32_t)(width * scale));
+    uint32_t scaledHeight = std::max(1u, (uint32_t)(height * scale));
+    uint32_t offsetX = (size - scaledWidth) / 2;
+    uint32_t offsetY = (size - scaledHeight) / 2;
+
+    Resize(bgra, width, height, stride,
+        out.data() + ((size_t)offsetY * size + offsetX) * 4, scaledWidth, scaledHeight, (size_t)size * 4);
+}
+
+BoxReducer::BoxReducer(uint32_t width, uint32_t height, uint32_t factorX, uint32_t factorY)
+    : m_width(width), m_height(height),
+      m_factorX(factorX ? factorX : 1), m_factorY(factorY ? factorY : 1) {
+    m_outWidth = (width + m_factorX - 1) / m_factorX;
+    m_outHeight = (height + m_factorY - 1) / m_factorY;
+    m_sums.assign((size_t)m_outWidth * 4, 0);
+    m_pixels.assign((size_t)m_outWidth * m_outHeight * 4, 0);
+}
+
+void BoxReducer::PushRow(const uint8_t* bgra) {
+    if (m_row >= m_height) {
+        return;
+    }
+
+    uint64_t* sum = m_sums.data();
+    for (uint32_t x = 0; x < m_width; x += m_factorX, sum += 4) {
+        uint32_t end = std::min<uint32_t>(x + m_factorX, m_width);
+        uint32_t b = 0, g = 0, r = 0, a = 0;
+        for (const uint8_t* p = bgra + (size_t)x * 4; p < bgra + (size_t)end * 4; p += 4) {
+            b += p[0] * p[3];
+            g += p[1] * p[3];
+            r += p[2] * p[3];
+            a += p[3];
+        }
+        sum[0] += b;
+        sum[1] += g;
+        sum[2] += r;
+        sum[3] += a;
+    }
+
+    m_row++;
+    if (++m_boxRows == m_factorY || m_row == m_height) {
+        EmitRow();
+    }
+}
+
+void BoxReducer::EmitRow() {
+    uint32_t outY = (m_row - 1) / m_factorY;
+    uint8_t* dst = &m_pixels[(size_t)outY * m_outWidth * 4];
+    const uint64_t* sum = m_sums.data();
+    for (uint32_t x = 0; x < m_outWidth; x++, sum += 4, dst += 4) {
+        uint32_t boxWidth = std::min<uint32_t>(m_factorX, m_width - x * m_factorX);
+        uint64_t area = (uint64_t)boxWidth * m_boxRows;
+        uint64_t alpha = sum[3];
+        if (!alpha) {
+            dst[0] = dst[1] = dst[2] = dst[3] = 0;
+            continue;
+        }
+        // Un-premultiply with rounding: color = sum(c * a) / sum(a)
+        dst[0] = (uint8_t)((sum[0] + alpha / 2) / alpha);
+        dst[1] = (uint8_t)((sum[1] + alpha / 2) / alpha);
+        dst[2] = (uint8_t)((sum[2] + alpha / 2) / alpha);
+        dst[3] = (uint8_t)((alpha + area / 2) / area);
+    }
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+    m_boxRows = 0;
+}
+
+uint32_t BoxReducer::Factor(uint32_t width, uint32_t height, uint32_t minOutput) {
+    uint32_t longer = std::max(width, height);
+    if (!minOutput || longer <= minOutput) {
+        return 1;
+    }
+    return longer / minOutput;
+}
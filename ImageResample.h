@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// High-quality image scaling for icon generation.
+// Separable bicubic (a = -0.5) convolution whose support widens with the
+// downscale factor, so large sources are properly low-passed instead of
+// aliased. Filtering happens on premultiplied alpha so transparent pixels
+// don't bleed their color into edges.
+class ImageResample {
+public:
+    // Scales a top-down, non-premultiplied BGRA image to fit a size x size
+    // canvas, preserving aspect ratio and centering it on transparency.
+    static void FitSquare(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint32_t size, std::vector<uint8_t>& out);
+
+    // Scales to exactly dstWidth x dstHeight (dst stride is dstWidth * 4)
+    static void Resize(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, size_t dstStride);
+};
+
+// Averages factorX x factorY boxes of a BGRA image that arrives one row at
+// a time, so a huge source can be reduced while holding only one row of
+// accumulators plus the (much smaller) output. Boxes on the right and
+// bottom edges cover whatever source is left. Averaging is done on
+// premultiplied alpha, like ImageResample.
+class BoxReducer {
+public:
+    BoxReducer(uint32_t width, uint32_t height, uint32_t factorX, uint32_t factorY);
+
+    // Adds the next source row (width non-premultiplied BGRA pixels)
+    void PushRow(const uint8_t* bgra);
+
+    uint32_t Width() const { return m_outWidth; }
+    uint32_t Height() const { return m_outHeight; }
+
+    // Reduced image, top-down non-premultiplied BGRA; complete once every
+    // source row has been pushed
+    const std::vector<uint8_t>& Pixels() const { return m_pixels; }
+
+    // Largest box size that keeps the reduced longer side at least minOutput
+    static uint32_t Factor(uint32_t width, uint32_t height, uint32_t minOutput);
+
+private:
+    void EmitRow();
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_factorX;
+    uint32_t m_factorY;
+    uint32_t m_outWidth;
+    uint32_t m_outHeight;
+    uint32_t m_row = 0;               // Source rows pushed so far
+    uint32_t m_boxRows = 0;           // Source rows in the current box row
+    std::vector<uint64_t> m_sums;     // Premultiplied B, G, R and alpha per output pixel
+    std::vector<uint8_t> m_pixels;
+};
@@ -0,0 +1,538 @@
+#include "Inflate.h"
+#include "Checksums.h"
+#include <cstring>
+
+namespace {
+
+const int kFastBits = 10;
+const int kMaxBits = 15;
+
+const uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+const uint8_t kCodeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// Streaming input buffer size and the bytes kept from the previous fill,
+// so AlignToByte can step back over bits that were already buffered
+const size_t kInputChunk = 64 * 1024;
+const size_t kInputKeep = 8;
+
+// LSB-first bit reader. Reads past the end yield zero bits and are
+// counted so that consuming them can be detected as truncation.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t len) : m_p(data), m_end(data + len) {}
+
+    // Streaming: input is pulled from source whenever the buffer runs dry
+    explicit BitReader(const InflateStream::Source& source)
+        : m_p(nullptr), m_end(nullptr), m_source(&source), m_buffer(kInputKeep + kInputChunk) {}
+
+    void Refill() {
+        while (m_count <= 56) {
+            if (m_p < m_end || Pull()) {
+                m_bits |= (uint64_t)*m_p++ << m_count;
+            } else {
+                m_padding++;
+            }
+            m_count += 8;
+        }
+    }
+
+    // Copies n bytes straight from the input; only valid right after AlignToByte
+    bool ReadBytes(uint8_t* dst, size_t n) {
+        while (n) {
+            if (m_p == m_end && !Pull()) return false;
+            size_t chunk = (size_t)(m_end - m_p) < n ? (size_t)(m_end - m_p) : n;
+            memcpy(dst, m_p, chunk);
+            m_p += chunk;
+            dst += chunk;
+            n -= chunk;
+        }
+        return true;
+    }
+
+    uint32_t Peek(int n) const { return (uint32_t)(m_bits & ((1ull << n) - 1)); }
+
+    void Consume(int n) {
+        m_bits >>= n;
+        m_count -= n;
+    }
+
+    uint32_t Bits(int n) {
+        if (n == 0) return 0;
+        Refill();
+        uint32_t v = Peek(n);
+        Consume(n);
+        return v;
+    }
+
+    // False once bits beyond the end of the input have been consumed
+    bool Ok() const { return m_padding * 8 <= (size_t)m_count; }
+
+    // Drops buffered bits and returns the byte position for stored blocks
+    const uint8_t* AlignToByte() {
+        Consume(m_count & 7);
+        size_t buffered = (size_t)(m_count / 8);
+        if (buffered < m_padding) return nullptr;
+        m_p -= buffered - m_padding;
+        m_bits = 0;
+        m_count = 0;
+        m_padding = 0;
+        return m_p;
+    }
+
+    void Resume(const uint8_t* p) { m_p = p; }
+    const uint8_t* End() const { return m_end; }
+
+private:
+    bool Pull() {
+        if (!m_source || m_sourceDone) return false;
+        uint8_t* base = m_buffer.data();
+        size_t keep = m_p ? (size_t)(m_p - base) : 0;
+        if (keep > kInputKeep) keep = kInputKeep;
+        if (keep) memmove(base, m_p - keep, keep);
+        size_t n = (*m_source)(base + keep, kInputChunk);
+        m_p = base + keep;
+        m_end = m_p + n;
+        m_sourceDone = n == 0;
+        return n > 0;
+    }
+
+    const uint8_t* m_p;
+    const uint8_t* m_end;
+    uint64_t m_bits = 0;
+    int m_count = 0;
+    size_t m_padding = 0;
+    const InflateStream::Source* m_source = nullptr;
+    std::vector<uint8_t> m_buffer;
+    bool m_sourceDone = false;
+};
+
+struct Huffman {
+    uint16_t fast[1 << kFastBits];  // (symbol << 4) | length, 0 = not in table
+    uint16_t count[kMaxBits + 1];
+    uint16_t symbol[288];
+
+    bool Build(const uint8_t* lengths, int n) {
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; i++) count[lengths[i]]++;
+        count[0] = 0;
+
+        int left = 1;
+        for (int len = 1; len <= kMaxBits; len++) {
+            left = (left << 1) - count[len];
+            if (left < 0) return false;  // Over-subscribed
+        }
+
+        uint16_t offset[kMaxBits + 2];
+        offset[1] = 0;
+        for (int len = 1; len <= kMaxBits; len++) {
+            offset[len + 1] = (uint16_t)(offset[len] + count[len]);
+        }
+        for (int i = 0; i < n; i++) {
+            if (lengths[i]) symbol[offset[lengths[i]]++] = (uint16_t)i;
+        }
+
+        // Canonical codes, bit-reversed for LSB-first lookup
+        memset(fast, 0, sizeof(fast));
+        int code = 0;
+        int index = 0;
+        for (int len = 1; len <= kFastBits; len++) {
+            for (int k = 0; k < count[len]; k++, index++, code++) {
+                int rev = 0;
+                for (int b = 0; b < len; b++) rev |= ((code >> b) & 1) << (len - 1 - b);
+                uint16_t entry = (uint16_t)((symbol[index] << 4) | len);
+                for (int j = rev; j < (1 << kFastBits); j += 1 << len) fast[j] = entry;
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    int Decode(BitReader& br) const {
+        br.Refill();
+        uint16_t e = fast[br.Peek(kFastBits)];
+        if (e) {
+            br.Consume(e & 15);
+            return e >> 4;
+        }
+
+        // Long code: walk the canonical code one bit at a time
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len <= kMaxBits; len++) {
+            code |= (int)br.Bits(1);
+            int c = count[len];
+            if (code - c < first) return symbol[index + (code - first)];
+            index += c;
+            first = (first + c) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+struct FixedTables {
+    Huffman litLen;
+    Huffman dist;
+    FixedTables() {
+        uint8_t lengths[288];
+        for (int i = 0; i < 144; i++) lengths[i] = 8;
+        for (int i = 144; i < 256; i++) lengths[i] = 9;
+        for (int i = 256; i < 280; i++) lengths[i] = 7;
+        for (int i = 280; i < 288; i++) lengths[i] = 8;
+        litLen.Build(lengths, 288);
+        for (int i = 0; i < 30; i++) lengths[i] = 5;
+        dist.Build(lengths, 30);
+    }
+};
+
+const FixedTables& GetFixedTables() {
+    static const FixedTables tables;
+    return tables;
+}
+
+bool ReadDynamicTables(BitReader& br, Huffman& litLen, Huffman& dist) {
+    int hlit = (int)br.Bits(5) + 257;
+    int hdist = (int)br.Bits(5) + 1;
+    int hclen = (int)br.Bits(4) + 4;
+    if (hlit > 286 || hdist > 30) return false;
+
+    uint8_t clLengths[19] = { 0 };
+    for (int i = 0; i < hclen; i++) clLengths[kCodeLengthOrder[i]] = (uint8_t)br.Bits(3);
+    Huffman cl;
+    if (!cl.Build(clLengths, 19)) return false;
+
+    uint8_t lengths[286 + 30];
+    int n = 0;
+    while (n < hlit + hdist) {
+        int sym = cl.Decode(br);
+        if (sym < 0 || !br.Ok()) return false;
+        if (sym < 16) {
+            lengths[n++] = (uint8_t)sym;
+            continue;
+        }
+
+        uint8_t value = 0;
+        int repeat;
+        if (sym == 16) {
+            if (n == 0) return false;
+            value = lengths[n - 1];
+            repeat = 3 + (int)br.Bits(2);
+        } else if (sym == 17) {
+            repeat = 3 + (int)br.Bits(3);
+        } else {
+            repeat = 11 + (int)br.Bits(7);
+        }
+        if (n + repeat > hlit + hdist) return false;
+        while (repeat--) lengths[n++] = value;
+    }
+
+    if (lengths[256] == 0) return false;  // No end-of-block code
+    return litLen.Build(lengths, hlit) && dist.Build(lengths + hlit, hdist);
+}
+
+class Output {
+public:
+    Output(std::vector<uint8_t>& out, size_t maxOutput)
+        : m_out(out), m_start(out.size()), m_pos(out.size()), m_limit(out.size() + maxOutput) {}
+
+    ~Output() { m_out.resize(m_pos); }
+
+    bool Reserve(size_t n) {
+        if (n > m_limit - m_pos) return false;
+        if (m_pos + n > m_out.size()) {
+            size_t grow = m_out.size() - m_start;
+            if (grow < 65536) grow = 65536;
+            size_t size = m_out.size() + grow;
+            if (size < m_pos + n) size = m_pos + n;
+            if (size > m_limit) size = m_limit;
+            m_out.resize(size);
+        }
+        return true;
+    }
+
+    void Put(uint8_t b) { m_out[m_pos++] = b; }
+
+    void Put(const uint8_t* p, size_t n) {
+        memcpy(&m_out[m_pos], p, n);
+        m_pos += n;
+    }
+
+    bool Copy(size_t dist, size_t len) {
+        if (dist > m_pos - m_start) return false;
+        uint8_t* dst = &m_out[m_pos];
+        const uint8_t* src = dst - dist;
+        if (dist >= len) {
+            memcpy(dst, src, len);
+        } else {
+            for (size_t i = 0; i < len; i++) dst[i] = src[i];
+        }
+        m_pos += len;
+        return true;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    size_t m_start;
+    size_t m_pos;
+    size_t m_limit;
+};
+
+bool InflateBlock(BitReader& br, Output& out, const Huffman& litLen, const Huffman& dist) {
+    for (;;) {
+        int sym = litLen.Decode(br);
+        if (sym < 0 || !br.Ok()) return false;
+
+        if (sym < 256) {
+            if (!out.Reserve(1)) return false;
+            out.Put((uint8_t)sym);
+            continue;
+        }
+        if (sym == 256) return true;
+
+        sym -= 257;
+        if (sym >= 29) return false;
+        size_t len = kLengthBase[sym] + br.Bits(kLengthExtra[sym]);
+
+        int dsym = dist.Decode(br);
+        if (dsym < 0 || dsym >= 30) return false;
+        size_t d = kDistBase[dsym] + br.Bits(kDistExtra[dsym]);
+        if (!br.Ok() || !out.Reserve(len) || !out.Copy(d, len)) return false;
+    }
+}
+
+} // namespace
+
+bool Inflate::Decompress(const uint8_t* data, size_t len, size_t maxOutput, std::vector<uint8_t>& out) {
+    BitReader br(data, len);
+    Output output(out, maxOutput);
+    Huffman litLen, dist;
+
+    bool last = false;
+    while (!last) {
+        last = br.Bits(1) != 0;
+        uint32_t type = br.Bits(2);
+
+        if (type == 0) {
+            const uint8_t* p = br.AlignToByte();
+            if (!p || br.End() - p < 4) return false;
+            uint32_t n = p[0] | (p[1] << 8);
+            uint32_t nn = p[2] | (p[3] << 8);
+            p += 4;
+            if ((n ^ 0xFFFF) != nn || (size_t)(br.End() - p) < n) return false;
+            if (!output.Reserve(n)) return false;
+            output.Put(p, n);
+            br.Resume(p + n);
+        } else if (type == 1) {
+            const FixedTables& fixed = GetFixedTables();
+            if (!InflateBlock(br, output, fixed.litLen, fixed.dist)) return false;
+        } else if (type == 2) {
+            if (!ReadDynamicTables(br, litLen, dist) || !InflateBlock(br, output, litLen, dist)) return false;
+        } else {
+            return false;
+        }
+        if (!br.Ok()) return false;
+    }
+    return true;
+}
+
+bool Inflate::DecompressZlib(const uint8_t* data, size_t len, size_t maxOutput, std::vector<uint8_t>& out) {
+    if (len < 6) return false;
+    uint8_t cmf = data[0];
+    uint8_t flg = data[1];
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+        return false;
+    }
+
+    size_t start = out.size();
+    if (!Decompress(data + 2, len - 6, maxOutput, out)) return false;
+
+    const uint8_t* t = data + len - 4;
+    uint32_t expected = ((uint32_t)t[0] << 24) | ((uint32_t)t[1] << 16) | ((uint32_t)t[2] << 8) | t[3];
+    return Checksums::Adler32(1, out.data() + start, out.size() - start) == expected;
+}
+
+namespace {
+
+// History a DEFLATE match may reach back into, plus room for new output
+const size_t kWindow = 32 * 1024;
+const size_t kOutputRoom = 64 * 1024;
+const size_t kMaxMatch = 258;
+
+}
+
+struct InflateStream::State {
+    enum class Mode { ZlibHeader, BlockHeader, Stored, Codes, Done };
+
+    explicit State(const Source& source) : source(source), input(this->source), window(kWindow + kOutputRoom) {}
+
+    Source source;
+    BitReader input;
+    std::vector<uint8_t> window;
+    size_t pos = 0;       // End of decoded output in window
+    size_t read = 0;      // End of output handed to the caller
+    size_t history = 0;   // Bytes before pos a match may reference
+    Mode mode = Mode::ZlibHeader;
+    bool lastBlock = false;
+    size_t storedLeft = 0;
+    Huffman litLen, dist;
+    const Huffman* codes = nullptr;
+    const Huffman* distCodes = nullptr;
+    uint32_t adler = 1;
+
+    // Keeps the last kWindow bytes and frees the rest for new output
+    void Slide() {
+        size_t keep = pos < kWindow ? pos : kWindow;
+        memmove(window.data(), window.data() + pos - keep, keep);
+        pos = read = keep;
+    }
+
+    // Decodes more output into window; false on malformed input
+    bool Step() {
+        switch (mode) {
+        case Mode::ZlibHeader: {
+            uint8_t cmf = (uint8_t)input.Bits(8);
+            uint8_t flg = (uint8_t)input.Bits(8);
+            if (!input.Ok() || (cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 ||
+                (flg & 0x20)) {
+                return false;
+            }
+            mode = Mode::BlockHeader;
+            return true;
+        }
+        case Mode::BlockHeader: {
+            if (lastBlock) {
+                mode = Mode::Done;
+                return true;
+            }
+            lastBlock = input.Bits(1) != 0;
+            uint32_t type = input.Bits(2);
+            if (type == 0) {
+                uint8_t lens[4];
+                if (!input.AlignToByte() || !input.ReadBytes(lens, 4)) return false;
+                uint32_t n = lens[0] | (lens[1] << 8);
+                if ((n ^ 0xFFFF) != (uint32_t)(lens[2] | (lens[3] << 8))) return false;
+                storedLeft = n;
+                mode = Mode::Stored;
+            } else if (type == 1) {
+                codes = &GetFixedTables().litLen;
+                distCodes = &GetFixedTables().dist;
+                mode = Mode::Codes;
+            } else if (type == 2) {
+                if (!ReadDynamicTables(input, litLen, dist)) return false;
+                codes = &litLen;
+                distCodes = &dist;
+                mode = Mode::Codes;
+            } else {
+                return false;
+            }
+            return input.Ok();
+        }
+        case Mode::Stored: {
+            size_t n = window.size() - pos < storedLeft ? window.size() - pos : storedLeft;
+            if (!input.ReadBytes(window.data() + pos, n)) return false;
+            pos += n;
+            history += n;
+            storedLeft -= n;
+            if (!storedLeft) mode = Mode::BlockHeader;
+            return true;
+        }
+        case Mode::Codes:
+            // Stop with room for one more match so the caller can slide
+            while (pos + kMaxMatch <= window.size()) {
+                int sym = codes->Decode(input);
+                if (sym < 0 || !input.Ok()) return false;
+                if (sym < 256) {
+                    window[pos++] = (uint8_t)sym;
+                    history++;
+                    continue;
+                }
+                if (sym == 256) {
+                    mode = Mode::BlockHeader;
+                    return true;
+                }
+
+                sym -= 257;
+                if (sym >= 29) return false;
+                size_t len = kLengthBase[sym] + input.Bits(kLengthExtra[sym]);
+                int dsym = distCodes->Decode(input);
+                if (dsym < 0 || dsym >= 30) return false;
+                size_t d = kDistBase[dsym] + input.Bits(kDistExtra[dsym]);
+                if (!input.Ok() || d > history || d > pos) return false;
+
+                uint8_t* dst = window.data() + pos;
+                const uint8_t* src = dst - d;
+                if (d >= len) {
+                    memcpy(dst, src, len);
+                } else {
+                    for (size_t i = 0; i < len; i++) dst[i] = src[i];
+                }
+                pos += len;
+                history += len;
+            }
+            return true;
+        case Mode::Done:
+            return false;
+        }
+        return false;
+    }
+};
+
+InflateStream::InflateStream(Source source) : m_state(new State(source)) {
+}
+
+InflateStream::~InflateStream() {
+}
+
+bool InflateStream::Read(uint8_t* out, size_t len) {
+    State& s = *m_state;
+    while (len) {
+        if (s.read < s.pos) {
+            size_t n = s.pos - s.read < len ? s.pos - s.read : len;
+            memcpy(out, s.window.data() + s.read, n);
+            s.adler = Checksums::Adler32(s.adler, out, n);
+            s.read += n;
+            out += n;
+            len -= n;
+            continue;
+        }
+        if (s.pos + kMaxMatch > s.window.size()) {
+            s.Slide();
+        }
+        if (s.mode == State::Mode::Done || !s.Step()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InflateStream::Finish() {
+    State& s = *m_state;
+
+    // Any output left over means the stream is longer than expected
+    while (s.mode != State::Mode::Done) {
+        if (s.read < s.pos) return false;
+        if (s.pos + kMaxMatch > s.window.size()) s.Slide();
+        if (!s.Step()) return false;
+    }
+    if (s.read < s.pos) {
+        return false;
+    }
+
+    uint8_t t[4];
+    if (!s.input.AlignToByte() || !s.input.ReadBytes(t, 4)) {
+        return false;
+    }
+    uint32_t expected = ((uint32_t)t[0] << 24) | ((uint32_t)t[1] << 16) | ((uint32_t)t[2] << 8) | t[3];
+    return s.adler == expected;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// DEFLATE (RFC 1951) decoder, the counterpart of Deflate.
+// Huffman codes up to 10 bits are resolved with a single table lookup;
+// longer codes fall back to a canonical bit-by-bit walk.
+class Inflate {
+public:
+    // Appends the decoded raw DEFLATE stream to out. Fails on malformed
+    // input or if more than maxOutput bytes would be produced.
+    static bool Decompress(const uint8_t* data, size_t len, size_t maxOutput, std::vector<uint8_t>& out);
+
+    // Same for a zlib (RFC 1950) stream; the Adler32 trailer is verified
+    static bool DecompressZlib(const uint8_t* data, size_t len, size_t maxOutput, std::vector<uint8_t>& out);
+};
+
+// Incremental zlib decoder: compressed input is pulled from a callback and
+// output is read in pieces of any size, so memory stays at a 32 KB history
+// window plus a small input buffer however long the stream is.
+class InflateStream {
+public:
+    // Fills buffer with up to capacity bytes; 0 means end of input
+    typedef std::function<size_t(uint8_t* buffer, size_t capacity)> Source;
+
+    explicit InflateStream(Source source);
+    ~InflateStream();
+
+    InflateStream(const InflateStream&) = delete;
+    InflateStream& operator=(const InflateStream&) = delete;
+
+    // Reads exactly len decoded bytes; false on malformed or truncated input
+    bool Read(uint8_t* out, size_t len);
+
+    // Call once all expected output has been read: checks that the stream
+    // ends there and that the Adler32 trailer matches
+    bool Finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,170 @@
+#include "InjectBundle.h"
+#include "AppPaths.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Minifier.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cwchar>
+#include <cwctype>
+#include <vector>
+
+namespace {
+
+// Bumped whenever the bundle layout or the minifiers change, so bundles
+// cached by an older build are not reused
+const uint64_t kBundleVersion = 1;
+
+// First line of a cached bundle: /*<16 hex digits>*/
+const size_t kHeaderSize = 21;
+
+std::string Hex(uint64_t value, int digits) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string out(digits, '0');
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = kHex[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+bool HasExtension(const std::wstring& name, const wchar_t* ext) {
+    size_t len = wcslen(ext);
+    if (name.size() <= len) return false;
+    for (size_t i = 0; i < len; i++) {
+        if ((wchar_t)towlower(name[name.size() - len + i]) != ext[i]) return false;
+    }
+    return true;
+}
+
+// .js and .css files directly in dir, in name order
+bool ListSources(const std::wstring& dir, std::vector<FileUtil::Entry>& sources) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) {
+        return false;
+    }
+    sources.clear();
+    for (const FileUtil::Entry& e : entries) {
+        if (!e.isDirectory && (HasExtension(e.name, L".js") || HasExtension(e.name, L".css"))) {
+            sources.push_back(e);
+        }
+    }
+    std::sort(sources.begin(), sources.end(),
+        [](const FileUtil::Entry& a, const FileUtil::Entry& b) { return a.name < b.name; });
+    return true;
+}
+
+// Double-quoted JavaScript string literal
+std::string JsString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out.push_back(c);
+        }
+    }
+    return out + "\"";
+}
+
+}
+
+std::wstring InjectBundle::CacheDirectory() {
+    return AppPaths::DataFile(L"inject");
+}
+
+bool InjectBundle::Build(const std::wstring& dir, std::string& script, InjectStats* stats) {
+    std::vector<FileUtil::Entry> sources;
+    if (!ListSources(dir, sources)) {
+        return false;
+    }
+
+    std::string css, js;
+    size_t sourceBytes = 0;
+    for (const FileUtil::Entry& e : sources) {
+        std::string text;
+        if (!FileUtil::Read(FileUtil::Join(dir, e.name), text)) {
+            return false;
+        }
+        sourceBytes += text.size();
+        if (HasExtension(e.name, L".css")) {
+            css += Minifier::Css(text);
+        } else {
+            js += "(function(){try{" + Minifier::Js(text) + "\n}catch(e){console.error(" +
+                JsString("[ww inject] " + Utf8::FromWide(e.name)) + ",e)}})();";
+        }
+    }
+
+    // Only the top-level page; styles go in as soon as there is an element to hold them
+    script = "if(window===window.top){";
+    if (!css.empty()) {
+        script += "(function(){var css=" + JsString(css) + ";function add(){var s=document.createElement(\"style\");"
+            "s.textContent=css;document.documentElement.appendChild(s)}"
+            "if(document.documentElement)add();else document.addEventListener(\"DOMContentLoaded\",add)})();";
+    }
+    script += js + "}";
+
+    if (stats) {
+        stats->files = sources.size();
+        stats->sourceBytes = sourceBytes;
+        stats->bundleBytes = script.size();
+        stats->cacheHit = false;
+    }
+    return true;
+}
+
+bool InjectBundle::Load(const std::wstring& dir, const std::wstring& cacheDir, std::string& script,
+    InjectStats* stats) {
+    if (cacheDir.empty()) {
+        return Build(dir, script, stats);
+    }
+
+    std::vector<FileUtil::Entry> sources;
+    if (!ListSources(dir, sources)) {
+        return false;
+    }
+    std::string version = Hex(kBundleVersion, 4);
+    for (const FileUtil::Entry& e : sources) {
+        version += Utf8::FromWide(e.name) + '\n' + Hex(e.size, 16) + Hex((uint64_t)e.modifiedTime, 16);
+    }
+    std::string absDir = Utf8::FromWide(FileUtil::Absolute(dir));
+    std::wstring prefix = L"inject_" + Utf8::ToWide(Hex(Checksums::Fnv1a64(absDir.data(), absDir.size()), 16)) + L"_";
+    std::wstring cachePath = FileUtil::Join(cacheDir,
+        prefix + Utf8::ToWide(Hex(Checksums::Fnv1a64(version.data(), version.size()), 16)) + L".js");
+
+    std::string cached;
+    if (FileUtil::Read(cachePath, cached) && cached.size() >= kHeaderSize &&
+        cached.compare(0, 2, "/*") == 0 &&
+        cached.compare(2, 16, Hex(Checksums::Fnv1a64(cached.data() + kHeaderSize, cached.size() - kHeaderSize), 16)) == 0) {
+        script = cached.substr(kHeaderSize);
+        if (stats) {
+            stats->files = sources.size();
+            stats->sourceBytes = 0;
+            stats->bundleBytes = script.size();
+            stats->cacheHit = true;
+        }
+        return true;
+    }
+
+    if (!Build(dir, script, stats)) {
+        return false;
+    }
+
+    // Write the new version and drop older ones for this folder; a failed
+    // write only costs a rebuild next time
+    std::string file = "/*" + Hex(Checksums::Fnv1a64(script.data(), script.size()), 16) + "*/\n" + script;
+    FileUtil::MakeDirectories(cacheDir);
+    if (FileUtil::Write(cachePath, file.data(), file.size())) {
+        std::vector<FileUtil::Entry> entries;
+        FileUtil::List(cacheDir, entries);
+        for (const FileUtil::Entry& e : entries) {
+            std::wstring path = FileUtil::Join(cacheDir, e.name);
+            if (!e.isDirectory && e.name.compare(0, prefix.size(), prefix) == 0 && path != cachePath) {
+                FileUtil::Remove(path);
+            }
+        }
+    }
+    return true;
+}
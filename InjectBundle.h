@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+struct InjectStats {
+    size_t files = 0;
+    size_t sourceBytes = 0;   // Only known when the bundle was built
+    size_t bundleBytes = 0;
+    bool cacheHit = false;
+};
+
+// Combines the .js and .css files in a folder into one minified script for
+// AddScriptToExecuteOnDocumentCreated. Files go in name order; each script
+// runs in its own function with errors logged, so one broken fix doesn't
+// stop the others, and styles are added as a <style> element.
+//
+// Built bundles are cached as <cacheDir>/inject_<folder hash>_<hash>.js,
+// where the second hash covers each source's name, size and modification
+// time, so a launch with unchanged sources reads one file and doesn't
+// minify anything. The cached file starts with a hash of its content and
+// is rebuilt if that doesn't match.
+class InjectBundle {
+public:
+    // Cache folder in the per-user data folder
+    static std::wstring CacheDirectory();
+
+    // Bundle for dir, from cacheDir when up to date (cacheDir may be empty)
+    static bool Load(const std::wstring& dir, const std::wstring& cacheDir, std::string& script,
+        InjectStats* stats = nullptr);
+
+    // Reads, minifies and wraps the sources in dir, without the cache
+    static bool Build(const std::wstring& dir, std::string& script, InjectStats* stats = nullptr);
+};
@@ -0,0 +1,214 @@
+#include "KvStore.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// Record layout (little-endian):
+//   u32 magic, u32 crc, u32 keyLen, u32 valueLen, i64 expiresAt, key, value
+// crc covers everything after itself. valueLen == kTombstone erases the key.
+const uint32_t kMagic = 0x5657564B;  // "KVWV"
+const uint32_t kTombstone = 0xFFFFFFFF;
+const size_t kHeaderSize = 24;
+const uint32_t kMaxField = 1u << 20;
+
+// Compact once dead records outnumber live ones by this factor
+const size_t kCompactRatio = 2;
+const size_t kCompactMinDead = 64;
+
+void PutU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out += (char)(v >> (i * 8));
+}
+
+void PutI64(std::string& out, int64_t v) {
+    for (int i = 0; i < 8; i++) out += (char)((uint64_t)v >> (i * 8));
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int64_t GetI64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return (int64_t)v;
+}
+
+std::string EncodeRecord(const std::string& key, const std::string* value, int64_t expiresAt) {
+    std::string rec;
+    PutU32(rec, kMagic);
+    PutU32(rec, 0);
+    PutU32(rec, (uint32_t)key.size());
+    PutU32(rec, value ? (uint32_t)value->size() : kTombstone);
+    PutI64(rec, expiresAt);
+    rec += key;
+    if (value) rec += *value;
+
+    uint32_t crc = Checksums::Crc32(0, (const uint8_t*)rec.data() + 8, rec.size() - 8);
+    for (int i = 0; i < 4; i++) rec[4 + i] = (char)(crc >> (i * 8));
+    return rec;
+}
+
+int64_t WallClock() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+KvStore::KvStore() : m_clock(WallClock) {}
+
+bool KvStore::Expired(const Entry& e) const {
+    return e.expiresAt != 0 && e.expiresAt <= m_clock();
+}
+
+bool KvStore::Open(const std::wstring& path) {
+    m_path = path;
+    m_entries.clear();
+    m_deadRecords = 0;
+
+    std::string data;
+    if (!FileUtil::Read(path, data)) {
+        return !FileUtil::Exists(path);
+    }
+    Replay(data);
+    return true;
+}
+
+// Applies every valid record in data to m_entries, then drops expired entries
+void KvStore::Replay(const std::string& data) {
+    const uint8_t* p = (const uint8_t*)data.data();
+    size_t pos = 0;
+    bool skipping = false;
+    while (pos < data.size()) {
+        bool valid = data.size() - pos >= kHeaderSize && GetU32(p + pos) == kMagic;
+        uint32_t keyLen = valid ? GetU32(p + pos + 8) : 0;
+        uint32_t valueLen = valid ? GetU32(p + pos + 12) : 0;
+        bool tombstone = valueLen == kTombstone;
+        if (tombstone) valueLen = 0;
+        valid = valid && keyLen <= kMaxField && valueLen <= kMaxField &&
+            data.size() - pos - kHeaderSize >= (size_t)keyLen + valueLen;
+        size_t recordSize = kHeaderSize + keyLen + valueLen;
+        valid = valid && Checksums::Crc32(0, p + pos + 8, recordSize - 8) == GetU32(p + pos + 4);
+
+        // A torn record (crash, or another process still appending) would
+        // hide everything after it; resume at the next record instead
+        if (!valid) {
+            if (!skipping) m_deadRecords++;
+            skipping = true;
+            pos++;
+            continue;
+        }
+        skipping = false;
+
+        std::string key(data, pos + kHeaderSize, keyLen);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            m_deadRecords++;
+        }
+        if (tombstone) {
+            if (it != m_entries.end()) m_entries.erase(it);
+            m_deadRecords++;
+        } else {
+            Entry& e = m_entries[key];
+            e.value.assign(data, pos + kHeaderSize + keyLen, valueLen);
+            e.expiresAt = GetI64(p + pos + 16);
+        }
+        pos += recordSize;
+    }
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (Expired(it->second)) {
+            it = m_entries.erase(it);
+            m_deadRecords++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool KvStore::Get(const std::string& key, std::string& value) const {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || Expired(it->second)) {
+        return false;
+    }
+    value = it->second.value;
+    return true;
+}
+
+bool KvStore::Put(const std::string& key, const std::string& value, int64_t ttlSeconds) {
+    if (key.size() > kMaxField || value.size() > kMaxField) {
+        return false;
+    }
+
+    int64_t expiresAt = ttlSeconds > 0 ? m_clock() + ttlSeconds : 0;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_deadRecords++;
+    }
+    Entry& e = m_entries[key];
+    e.value = value;
+    e.expiresAt = expiresAt;
+    return AppendRecord(key, &value, expiresAt);
+}
+
+bool KvStore::Erase(const std::string& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return true;
+    }
+    m_entries.erase(it);
+    m_deadRecords += 2;
+    return AppendRecord(key, nullptr, 0);
+}
+
+bool KvStore::AppendRecord(const std::string& key, const std::string* value, int64_t expiresAt) {
+    if (m_path.empty()) {
+        return true;  // In-memory store
+    }
+
+    // Appended even when compacting next, so the reload in Compact sees it
+    std::string rec = EncodeRecord(key, value, expiresAt);
+    if (!FileUtil::Append(m_path, rec.data(), rec.size())) {
+        return false;
+    }
+    if (m_deadRecords >= kCompactMinDead && m_deadRecords > m_entries.size() * kCompactRatio) {
+        return Compact();
+    }
+    return true;
+}
+
+bool KvStore::Compact() {
+    // Other processes share the file; start from everything they (and we)
+    // appended since Open rather than from this process's snapshot
+    if (!m_path.empty()) {
+        std::string log;
+        if (FileUtil::Read(m_path, log)) {
+            m_entries.clear();
+            Replay(log);
+        } else if (FileUtil::Exists(m_path)) {
+            return false;
+        }
+    }
+
+    std::string data;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (Expired(it->second)) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        data += EncodeRecord(it->first, &it->second.value, it->second.expiresAt);
+        ++it;
+    }
+
+    if (m_path.empty()) {
+        return true;
+    }
+    if (!FileUtil::Write(m_path, data.data(), data.size())) {
+        return false;
+    }
+    m_deadRecords = 0;
+    return true;
+}
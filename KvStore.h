@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Small persistent string key-value store with per-entry expiry.
+//
+// The file is an append-only log of CRC-protected records, so a crash
+// mid-write can only lose the record being written: loading skips torn or
+// corrupt bytes up to the next valid record. Lookups are served from memory.
+// Several processes may share the file: records are appended whole, and
+// compaction first merges everything appended since Open, so only records
+// appended while the compacted file is being written can be lost.
+class KvStore {
+public:
+    // Seconds since the Unix epoch
+    using Clock = std::function<int64_t()>;
+
+    KvStore();
+
+    // Loads path (a missing file is an empty store). Returns false only if
+    // the file exists but can't be read.
+    bool Open(const std::wstring& path);
+
+    // Finds a live (unexpired) entry
+    bool Get(const std::string& key, std::string& value) const;
+
+    // ttlSeconds <= 0 stores an entry that never expires
+    bool Put(const std::string& key, const std::string& value, int64_t ttlSeconds);
+    bool Erase(const std::string& key);
+
+    // Rewrites the log with only live entries, after reloading it to pick
+    // up other processes' records
+    bool Compact();
+
+    size_t Size() const { return m_entries.size(); }
+
+    // Replaces the wall clock (for expiry tests and benchmarks)
+    void SetClock(Clock clock) { m_clock = std::move(clock); }
+
+private:
+    struct Entry {
+        std::string value;
+        int64_t expiresAt;  // 0 = never
+    };
+
+    bool AppendRecord(const std::string& key, const std::string* value, int64_t expiresAt);
+    void Replay(const std::string& data);
+    bool Expired(const Entry& e) const;
+
+    std::wstring m_path;
+    std::unordered_map<std::string, Entry> m_entries;
+    size_t m_deadRecords = 0;  // Overwritten, erased or expired records (and torn bytes) still in the log
+    Clock m_clock;
+};
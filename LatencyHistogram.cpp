@@ -0,0 +1,145 @@
+#include "LatencyHistogram.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const uint64_t kSubBucketCount = 1ULL << LatencyHistogram::kSubBucketBits;
+const uint64_t kHalfCount = kSubBucketCount / 2;
+
+int HighestBit(uint64_t v) {
+    int bit = 0;
+    while (v >>= 1) bit++;
+    return bit;
+}
+
+}
+
+// Values below kSubBucketCount map 1:1; above that, bucket group g covers
+// [64 << g, 128 << g) in 64 steps of (1 << g)
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return (size_t)value;
+    }
+    int group = HighestBit(value) - (kSubBucketBits - 1);
+    return (size_t)(group * kHalfCount + (value >> group));
+}
+
+uint64_t LatencyHistogram::BucketLowest(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    uint64_t group = index / kHalfCount - 1;
+    uint64_t sub = index % kHalfCount + kHalfCount;
+    return sub << group;
+}
+
+uint64_t LatencyHistogram::BucketHighest(size_t index) {
+    if (index + 1 >= kBucketCount) {
+        return UINT64_MAX;
+    }
+    return BucketLowest(index + 1) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (m_counts.empty()) {
+        m_counts.assign(kBucketCount, 0);
+    }
+    m_counts[BucketIndex(value)] += count;
+    m_total += count;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    if (other.m_total == 0) {
+        return;
+    }
+    if (m_counts.empty()) {
+        m_counts.assign(kBucketCount, 0);
+    }
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_total += other.m_total;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+    if (m_total == 0) {
+        return 0;
+    }
+    p = std::min(std::max(p, 0.0), 100.0);
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)m_total);
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += m_counts[i];
+        if (seen >= rank) {
+            return std::max(std::min(BucketHighest(i), m_max), m_min);
+        }
+    }
+    return m_max;
+}
+
+void LatencyHistogram::Serialize(std::string& out) const {
+    size_t used = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        used += m_counts[i] != 0;
+    }
+    Varint::Put(out, used);
+    if (used == 0) {
+        return;
+    }
+    Varint::Put(out, m_min);
+    Varint::Put(out, m_max);
+
+    // Bucket indexes are delta-coded, so clustered latencies stay small
+    size_t previous = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        if (m_counts[i]) {
+            Varint::Put(out, i - previous);
+            Varint::Put(out, m_counts[i]);
+            previous = i;
+        }
+    }
+}
+
+bool LatencyHistogram::Deserialize(const uint8_t*& p, const uint8_t* end) {
+    *this = LatencyHistogram();
+    uint64_t used = 0;
+    if (!Varint::Get(p, end, used) || used > kBucketCount) {
+        return false;
+    }
+    if (used == 0) {
+        return true;
+    }
+
+    uint64_t minValue = 0, maxValue = 0;
+    if (!Varint::Get(p, end, minValue) || !Varint::Get(p, end, maxValue) || minValue > maxValue) {
+        return false;
+    }
+    m_counts.assign(kBucketCount, 0);
+    uint64_t index = 0;
+    for (uint64_t n = 0; n < used; ++n) {
+        uint64_t delta = 0, count = 0;
+        if (!Varint::Get(p, end, delta) || !Varint::Get(p, end, count) || count == 0) {
+            return false;
+        }
+        index += delta;
+        if (index >= kBucketCount || (n > 0 && delta == 0)) {
+            return false;
+        }
+        m_counts[index] += count;
+        m_total += count;
+    }
+    m_min = minValue;
+    m_max = maxValue;
+    return true;
+}
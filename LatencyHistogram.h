@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HDR-style log-linear histogram of non-negative integer values (the
+// metrics code records microseconds). Each power-of-two range is split into
+// 64 linear sub-buckets, so any reported percentile is within 1/64 (~1.6%)
+// of a recorded value across the whole uint64 range, in a fixed set of
+// buckets. Histograms with the same layout merge by adding counts, which is
+// what lets per-launch samples be combined across launches and apps.
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 7;
+    static const size_t kBucketCount = (64 - kSubBucketBits + 2) << (kSubBucketBits - 1);
+
+    void Record(uint64_t value, uint64_t count = 1);
+    void Merge(const LatencyHistogram& other);
+
+    // Value at or below which p percent of recorded values fall (p in [0, 100]),
+    // reported as the largest value in that value's bucket; 0 when empty
+    uint64_t Percentile(double p) const;
+
+    uint64_t Count() const { return m_total; }
+    uint64_t Min() const { return m_total ? m_min : 0; }
+    uint64_t Max() const { return m_max; }
+
+    // Sparse encoding: only non-empty buckets are written
+    void Serialize(std::string& out) const;
+    bool Deserialize(const uint8_t*& p, const uint8_t* end);
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketLowest(size_t index);
+    static uint64_t BucketHighest(size_t index);
+
+private:
+    std::vector<uint64_t> m_counts;  // Allocated on first Record
+    uint64_t m_total = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+};
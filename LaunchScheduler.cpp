@@ -0,0 +1,393 @@
+#include "LaunchScheduler.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+const char* const LaunchScheduler::kReadyVariable = "WW_READY_SIGNAL";
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Upper bound on concurrency: two wait handles per starting app must fit
+// in one WaitForMultipleObjects call
+const unsigned kMaxConcurrency = 32;
+
+#ifndef _WIN32
+// Descriptor the ready pipe is given in the child
+const int kReadyFd = 3;
+#endif
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A started process that hasn't become ready yet
+struct Child {
+    size_t index = 0;
+    Clock::time_point started;
+#ifdef _WIN32
+    HANDLE process = nullptr;
+    HANDLE ready = nullptr;
+#else
+    pid_t pid = -1;
+    int readyFd = -1;
+#endif
+};
+
+enum class ChildState { Starting, Ready, Exited };
+
+#ifdef _WIN32
+// Quotes one argument the way CommandLineToArgvW splits it
+std::wstring QuoteArgument(const std::wstring& arg) {
+    if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) {
+        return arg;
+    }
+    std::wstring out = L"\"";
+    size_t backslashes = 0;
+    for (wchar_t c : arg) {
+        if (c == L'\\') {
+            backslashes++;
+            continue;
+        }
+        // Backslashes only escape when they precede a quote
+        out.append(c == L'"' ? backslashes * 2 + 1 : backslashes, L'\\');
+        backslashes = 0;
+        out += c;
+    }
+    out.append(backslashes * 2, L'\\');
+    return out + L"\"";
+}
+
+bool Spawn(const LaunchItem& item, size_t index, Child& child) {
+    static LONG s_sequence = 0;
+    std::wstring eventName = L"Local\\WebWrapReady-" + std::to_wstring(GetCurrentProcessId()) + L"-" +
+        std::to_wstring(InterlockedIncrement(&s_sequence)) + L"-" + std::to_wstring(index);
+    child.ready = CreateEventW(nullptr, TRUE, FALSE, eventName.c_str());
+    if (!child.ready) {
+        return false;
+    }
+
+    // The child's environment is ours plus the event name
+    std::wstring variable = Utf8::ToWide(LaunchScheduler::kReadyVariable) + L"=";
+    std::wstring environment;
+    LPWCH current = GetEnvironmentStringsW();
+    for (LPWCH p = current; p && *p; p += wcslen(p) + 1) {
+        if (_wcsnicmp(p, variable.c_str(), variable.size()) != 0) {
+            environment.append(p, wcslen(p) + 1);
+        }
+    }
+    if (current) FreeEnvironmentStringsW(current);
+    environment += variable + eventName;
+    environment.push_back(L'\0');
+    environment.push_back(L'\0');
+
+    std::wstring commandLine = QuoteArgument(item.executable);
+    for (const std::wstring& arg : item.args) {
+        commandLine += L" " + QuoteArgument(arg);
+    }
+
+    STARTUPINFOW si = { sizeof(si) };
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessW(item.executable.c_str(), &commandLine[0], nullptr, nullptr, FALSE,
+            CREATE_UNICODE_ENVIRONMENT, &environment[0], nullptr, &si, &pi)) {
+        CloseHandle(child.ready);
+        child.ready = nullptr;
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    child.process = pi.hProcess;
+    return true;
+}
+
+uint32_t ProcessId(const Child& child) {
+    return GetProcessId(child.process);
+}
+
+void Release(Child& child) {
+    if (child.process) CloseHandle(child.process);
+    if (child.ready) CloseHandle(child.ready);
+    child.process = child.ready = nullptr;
+}
+
+// Waits up to timeoutMs for any child to become ready or exit
+void WaitAny(std::vector<Child>& children, int timeoutMs, std::vector<ChildState>& states) {
+    std::vector<HANDLE> handles;
+    for (const Child& c : children) {
+        handles.push_back(c.ready);
+        handles.push_back(c.process);
+    }
+    states.assign(children.size(), ChildState::Starting);
+    DWORD r = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, (DWORD)timeoutMs);
+    if (r >= WAIT_OBJECT_0 + handles.size()) {
+        return;
+    }
+
+    // Several may have finished together; check them all
+    for (size_t i = 0; i < children.size(); i++) {
+        if (WaitForSingleObject(children[i].ready, 0) == WAIT_OBJECT_0) {
+            states[i] = ChildState::Ready;
+        } else if (WaitForSingleObject(children[i].process, 0) == WAIT_OBJECT_0) {
+            states[i] = ChildState::Exited;
+        }
+    }
+}
+#else
+bool Spawn(const LaunchItem& item, size_t index, Child& child) {
+    (void)index;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        return false;
+    }
+
+    // dup2 onto the same descriptor would keep close-on-exec set
+    if (fds[1] == kReadyFd) {
+        int moved = fcntl(fds[1], F_DUPFD_CLOEXEC, kReadyFd + 1);
+        close(fds[1]);
+        fds[1] = moved;
+    }
+
+    std::string variable = std::string(LaunchScheduler::kReadyVariable) + "=";
+    std::vector<std::string> envStrings;
+    for (char** e = environ; e && *e; e++) {
+        if (strncmp(*e, variable.c_str(), variable.size()) != 0) envStrings.push_back(*e);
+    }
+    envStrings.push_back(variable + std::to_string(kReadyFd));
+
+    std::string path = Utf8::FromWide(item.executable);
+    std::vector<std::string> argStrings(1, path);
+    for (const std::wstring& arg : item.args) argStrings.push_back(Utf8::FromWide(arg));
+
+    std::vector<char*> argv, envp;
+    for (std::string& s : argStrings) argv.push_back(&s[0]);
+    for (std::string& s : envStrings) envp.push_back(&s[0]);
+    argv.push_back(nullptr);
+    envp.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], kReadyFd);
+    pid_t pid = -1;
+    int err = fds[1] < 0 ? EBADF : posix_spawn(&pid, path.c_str(), &actions, nullptr, argv.data(), envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    if (fds[1] >= 0) close(fds[1]);
+    if (err != 0) {
+        close(fds[0]);
+        return false;
+    }
+
+    child.pid = pid;
+    child.readyFd = fds[0];
+    return true;
+}
+
+uint32_t ProcessId(const Child& child) {
+    return (uint32_t)child.pid;
+}
+
+void Release(Child& child) {
+    if (child.readyFd >= 0) close(child.readyFd);
+    child.readyFd = -1;
+}
+
+void WaitAny(std::vector<Child>& children, int timeoutMs, std::vector<ChildState>& states) {
+    std::vector<pollfd> fds;
+    for (const Child& c : children) {
+        pollfd p = { c.readyFd, POLLIN, 0 };
+        fds.push_back(p);
+    }
+    states.assign(children.size(), ChildState::Starting);
+    if (poll(fds.data(), fds.size(), timeoutMs) <= 0) {
+        return;
+    }
+
+    // A byte means ready; end of file means the child exited without one
+    for (size_t i = 0; i < children.size(); i++) {
+        if (!fds[i].revents) continue;
+        char byte;
+        ssize_t n = read(children[i].readyFd, &byte, 1);
+        if (n > 0) {
+            states[i] = ChildState::Ready;
+        } else if (n == 0 || errno != EINTR) {
+            states[i] = ChildState::Exited;
+            waitpid(children[i].pid, nullptr, WNOHANG);
+        }
+    }
+}
+#endif
+
+bool CpuBusy() {
+#ifdef _WIN32
+    // Share of non-idle time over a short sample
+    FILETIME idle0, kernel0, user0, idle1, kernel1, user1;
+    if (!GetSystemTimes(&idle0, &kernel0, &user0)) return false;
+    Sleep(100);
+    if (!GetSystemTimes(&idle1, &kernel1, &user1)) return false;
+    auto ticks = [](const FILETIME& a, const FILETIME& b) {
+        return (((uint64_t)b.dwHighDateTime << 32) | b.dwLowDateTime) -
+            (((uint64_t)a.dwHighDateTime << 32) | a.dwLowDateTime);
+    };
+    uint64_t total = ticks(kernel0, kernel1) + ticks(user0, user1);  // Kernel time includes idle
+    return total > 0 && ticks(idle0, idle1) * 4 < total;
+#else
+    double load = 0;
+    FILE* f = std::fopen("/proc/loadavg", "r");
+    bool read = f && std::fscanf(f, "%lf", &load) == 1;
+    if (f) std::fclose(f);
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    return read && load > cores * 0.75;
+#endif
+}
+
+bool SystemDiskSeeks() {
+#ifdef _WIN32
+    wchar_t windows[MAX_PATH];
+    if (!GetWindowsDirectoryW(windows, MAX_PATH)) return false;
+    std::wstring volume = L"\\\\.\\" + std::wstring(windows, 2);
+    HANDLE h = CreateFileW(volume.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+
+    STORAGE_PROPERTY_QUERY query = {};
+    query.PropertyId = StorageDeviceSeekPenaltyProperty;
+    query.QueryType = PropertyStandardQuery;
+    DEVICE_SEEK_PENALTY_DESCRIPTOR seek = {};
+    DWORD bytes = 0;
+    BOOL ok = DeviceIoControl(h, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query),
+        &seek, sizeof(seek), &bytes, nullptr);
+    CloseHandle(h);
+    return ok && bytes >= sizeof(seek) && seek.IncursSeekPenalty;
+#else
+    // The root filesystem's device, or the disk holding that partition
+    struct stat st;
+    if (stat("/", &st) != 0) return false;
+    std::string dev = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    const char* const candidates[] = { "/queue/rotational", "/../queue/rotational" };
+    for (const char* candidate : candidates) {
+        FILE* f = std::fopen((dev + candidate).c_str(), "r");
+        if (!f) continue;
+        int rotational = 0;
+        bool read = std::fscanf(f, "%d", &rotational) == 1;
+        std::fclose(f);
+        if (read) return rotational != 0;
+    }
+    return false;
+#endif
+}
+
+}
+
+unsigned LaunchScheduler::AutoConcurrency() {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned limit = std::min(4u, std::max(1u, cores / 2));
+    if (CpuBusy() || SystemDiskSeeks()) {
+        limit = std::max(1u, limit / 2);
+    }
+    return limit;
+}
+
+std::vector<LaunchResult> LaunchScheduler::Run(const std::vector<LaunchItem>& items, const LaunchOptions& options) {
+    std::vector<LaunchResult> results(items.size());
+    std::vector<size_t> order(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        results[i].name = items[i].name;
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&items](size_t a, size_t b) {
+        return items[a].priority < items[b].priority;
+    });
+
+    unsigned limit = options.concurrency ? options.concurrency : AutoConcurrency();
+    limit = std::min(limit, kMaxConcurrency);
+    Clock::time_point runStart = Clock::now();
+    std::vector<Child> starting;
+    std::vector<ChildState> states;
+    size_t next = 0;
+
+    while (next < order.size() || !starting.empty()) {
+        // Fill free slots in priority order
+        while (starting.size() < limit && next < order.size()) {
+            size_t index = order[next++];
+            LaunchResult& r = results[index];
+            Child child;
+            child.index = index;
+            child.started = Clock::now();
+            r.startMs = MillisecondsSince(runStart);
+            if (!Spawn(items[index], index, child)) {
+                std::wcerr << L"Error: Failed to start " << items[index].name << L"\n";
+                continue;
+            }
+            r.started = true;
+            r.processId = ProcessId(child);
+            starting.push_back(child);
+        }
+        if (starting.empty()) {
+            break;
+        }
+
+        // Sleep until a child changes state or the earliest timeout
+        double waitMs = options.readyTimeoutMs;
+        for (const Child& c : starting) {
+            waitMs = std::min(waitMs, options.readyTimeoutMs - MillisecondsSince(c.started));
+        }
+        WaitAny(starting, (int)std::max(0.0, std::ceil(waitMs)), states);
+
+        for (size_t i = starting.size(); i-- > 0; ) {
+            Child& c = starting[i];
+            LaunchResult& r = results[c.index];
+            double elapsed = MillisecondsSince(c.started);
+            if (states[i] == ChildState::Starting && elapsed < options.readyTimeoutMs) {
+                continue;
+            }
+            r.ready = states[i] == ChildState::Ready;
+            r.exited = states[i] == ChildState::Exited;
+            r.timedOut = states[i] == ChildState::Starting;
+            r.readyMs = elapsed;
+            Release(c);
+            starting.erase(starting.begin() + i);
+        }
+    }
+    return results;
+}
+
+bool LaunchScheduler::SignalReady() {
+    const char* value = getenv(kReadyVariable);
+    if (!value || !*value) {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE event = OpenEventW(EVENT_MODIFY_STATE, FALSE, Utf8::ToWide(value).c_str());
+    bool ok = event && SetEvent(event);
+    if (event) CloseHandle(event);
+    _putenv_s(kReadyVariable, "");  // Not inherited by the browser processes
+#else
+    int fd = atoi(value);
+    char byte = 1;
+    bool ok = fd > 2 && write(fd, &byte, 1) == 1;
+    if (fd > 2) close(fd);
+    unsetenv(kReadyVariable);
+#endif
+    return ok;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One process to start
+struct LaunchItem {
+    std::wstring name;
+    std::wstring executable;
+    std::vector<std::wstring> args;
+    int priority = 0;              // Lower starts first; ties keep list order
+};
+
+struct LaunchOptions {
+    unsigned concurrency = 0;      // Apps starting at the same time; 0 = AutoConcurrency()
+    int readyTimeoutMs = 15000;    // A slot is freed after this even without a ready signal
+};
+
+// What happened to one item, in milliseconds from the start of the run
+struct LaunchResult {
+    std::wstring name;
+    bool started = false;
+    bool ready = false;
+    bool timedOut = false;
+    bool exited = false;           // Exited (or closed its signal) before becoming ready
+    uint32_t processId = 0;
+    double startMs = 0.0;          // When the process was started
+    double readyMs = 0.0;          // Start to ready, timeout or exit
+};
+
+// Starts a fleet of processes a few at a time, so they don't all compete
+// for the CPU and disk at once and each becomes usable sooner.
+//
+// Items start in priority order. At most `concurrency` are starting at any
+// moment; a slot frees up when its process signals readiness, exits, or
+// reaches the timeout. Processes keep running after Run returns.
+//
+// A child signals readiness by calling SignalReady(), which finds the
+// channel through the kReadyVariable environment variable: a named event
+// on Windows, an inherited pipe on POSIX (started with posix_spawn).
+class LaunchScheduler {
+public:
+    static const char* const kReadyVariable;
+
+    // Results are in the same order as items
+    static std::vector<LaunchResult> Run(const std::vector<LaunchItem>& items, const LaunchOptions& options);
+
+    // Half the logical cores, at most 4, halved again when the CPU is
+    // already busy or the system disk has to seek
+    static unsigned AutoConcurrency();
+
+    // Child side: tells the scheduler that started this process that it is
+    // ready. Returns false when not started by a scheduler; only the first
+    // call signals.
+    static bool SignalReady();
+};
@@ -0,0 +1,98 @@
+#include "Manifest.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cwctype>
+
+static std::wstring TrimW(const std::wstring& v) {
+    size_t b = 0, e = v.size();
+    while (b < e && iswspace(v[b])) b++;
+    while (e > b && iswspace(v[e - 1])) e--;
+    return v.substr(b, e - b);
+}
+
+static bool EqualsIgnoreCase(const std::wstring& a, const std::wstring& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (towlower(a[i]) != towlower(b[i])) return false;
+    }
+    return true;
+}
+
+static std::wstring Unquote(const std::wstring& v) {
+    if (v.size() >= 2 && ((v.front() == L'"' && v.back() == L'"') || (v.front() == L'\'' && v.back() == L'\''))) {
+        return v.substr(1, v.size() - 2);
+    }
+    return v;
+}
+
+bool Manifest::Parse(const std::string& text, std::vector<ManifestEntry>& entries, std::wstring& error) {
+    std::wstring content = Utf8::ToWide(text);
+    if (!content.empty() && content[0] == 0xFEFF) content.erase(0, 1);
+
+    entries.clear();
+    size_t pos = 0;
+    int lineNo = 0;
+    while (pos <= content.size()) {
+        size_t eol = content.find(L'\n', pos);
+        if (eol == std::wstring::npos) eol = content.size();
+        std::wstring line = TrimW(content.substr(pos, eol - pos));
+        pos = eol + 1;
+        lineNo++;
+
+        if (line.empty() || line[0] == L'#' || line[0] == L';') continue;
+
+        if (line[0] == L'[') {
+            if (line.back() != L']' || line.size() < 3) {
+                error = L"line " + std::to_wstring(lineNo) + L": malformed section header";
+                return false;
+            }
+            ManifestEntry entry;
+            entry.name = TrimW(line.substr(1, line.size() - 2));
+            for (const ManifestEntry& existing : entries) {
+                if (EqualsIgnoreCase(existing.name, entry.name)) {
+                    error = L"line " + std::to_wstring(lineNo) + L": duplicate app name: " + entry.name;
+                    return false;
+                }
+            }
+            entries.push_back(entry);
+            continue;
+        }
+
+        size_t eq = line.find(L'=');
+        if (eq == std::wstring::npos) {
+            error = L"line " + std::to_wstring(lineNo) + L": expected key = value";
+            return false;
+        }
+        if (entries.empty()) {
+            error = L"line " + std::to_wstring(lineNo) + L": key outside of an [App] section";
+            return false;
+        }
+
+        std::wstring key = TrimW(line.substr(0, eq));
+        std::transform(key.begin(), key.end(), key.begin(), ::towlower);
+        std::wstring value = Unquote(TrimW(line.substr(eq + 1)));
+
+        ManifestEntry& entry = entries.back();
+        if (key == L"target") entry.target = value;
+        else if (key == L"icon") entry.icon = value;
+        else entry.extra[key] = value;
+    }
+
+    for (const ManifestEntry& entry : entries) {
+        if (entry.target.empty()) {
+            error = L"app \"" + entry.name + L"\" has no target";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Manifest::Load(const std::wstring& path, std::vector<ManifestEntry>& entries, std::wstring& error) {
+    std::string text;
+    if (!FileUtil::Read(path, text)) {
+        error = L"cannot read manifest: " + path;
+        return false;
+    }
+    return Parse(text, entries, error);
+}
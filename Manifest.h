@@ -0,0 +1,25 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+// One wrapped app described in a manifest
+struct ManifestEntry {
+    std::wstring name;
+    std::wstring target;
+    std::wstring icon;
+    std::map<std::wstring, std::wstring> extra;  // Keys not understood by every command
+};
+
+// Loads app manifests: INI-style UTF-8 text with one [App Name] section per
+// app and key = value lines (target, icon, ...). Lines starting with # or ;
+// are comments.
+//
+//   [Gmail]
+//   target = https://mail.google.com
+//   icon = C:\Icons\gmail.png
+class Manifest {
+public:
+    static bool Parse(const std::string& text, std::vector<ManifestEntry>& entries, std::wstring& error);
+    static bool Load(const std::wstring& path, std::vector<ManifestEntry>& entries, std::wstring& error);
+};
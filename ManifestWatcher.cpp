@@ -0,0 +1,186 @@
+#include "ManifestWatcher.h"
+#include "FileUtil.h"
+#include "WorkerPool.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Longest single wait, so Stop() is noticed promptly
+const int kIdleWaitMs = 100;
+
+int MillisecondsSince(Clock::time_point start) {
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+bool SameEntry(const ManifestEntry& a, const ManifestEntry& b) {
+    return a.target == b.target && a.icon == b.icon && a.extra == b.extra;
+}
+
+}
+
+ManifestWatcher::ManifestWatcher(const std::wstring& manifestPath, const WatchActions& actions, WorkerPool& pool)
+    : m_manifestPath(FileUtil::Absolute(manifestPath))
+    , m_actions(actions)
+    , m_pool(pool)
+    , m_stop(false) {
+}
+
+bool ManifestWatcher::Start() {
+    std::wstring error;
+    if (!Manifest::Load(m_manifestPath, m_entries, error)) {
+        std::wcerr << L"Error: " << error << L"\n";
+        return false;
+    }
+    Resubscribe();
+    return true;
+}
+
+void ManifestWatcher::Run() {
+    while (!m_stop) {
+        Poll(kIdleWaitMs);
+    }
+}
+
+void ManifestWatcher::Stop() {
+    m_stop = true;
+}
+
+std::wstring ManifestWatcher::IconPath(const ManifestEntry& entry) const {
+    // Relative icons resolve against the current directory, as in --sync
+    return entry.icon.empty() ? L"" : FileUtil::Absolute(entry.icon);
+}
+
+void ManifestWatcher::Resubscribe() {
+    std::vector<std::wstring> files(1, m_manifestPath);
+    for (const ManifestEntry& entry : m_entries) {
+        if (!entry.icon.empty()) {
+            files.push_back(IconPath(entry));
+        }
+    }
+    m_watcher.SetFiles(files);
+}
+
+bool ManifestWatcher::Poll(int timeoutMs, WatchBatch* batch) {
+    // Notifications for unwatched neighbours (such as an editor's temporary
+    // file) come back empty; keep waiting for the rest of the timeout
+    std::vector<std::wstring> changed;
+    Clock::time_point waitStart = Clock::now();
+    while (changed.empty()) {
+        int left = timeoutMs - MillisecondsSince(waitStart);
+        if (m_stop || left <= 0 || !m_watcher.Wait(left, changed)) {
+            return false;
+        }
+    }
+
+    // Coalesce the burst: wait for a quiet period, bounded by kMaxDelayMs
+    Clock::time_point first = Clock::now();
+    Clock::time_point last = first;
+    WatchBatch result;
+    std::set<std::wstring> paths(changed.begin(), changed.end());
+    result.events = changed.size();
+    while (!m_stop) {
+        int quietLeft = kQuietMs - MillisecondsSince(last);
+        int delayLeft = kMaxDelayMs - MillisecondsSince(first);
+        if (quietLeft <= 0 || delayLeft <= 0) {
+            break;
+        }
+        changed.clear();
+        if (!m_watcher.Wait(quietLeft < delayLeft ? quietLeft : delayLeft, changed)) {
+            break;
+        }
+        if (!changed.empty()) {
+            last = Clock::now();
+            result.events += changed.size();
+            paths.insert(changed.begin(), changed.end());
+        }
+    }
+
+    // Work out which apps need regenerating: name -> icon changed
+    std::map<std::wstring, bool> updates;
+    std::vector<std::wstring> removals;
+    if (paths.count(m_manifestPath)) {
+        std::vector<ManifestEntry> entries;
+        std::wstring error;
+        if (Manifest::Load(m_manifestPath, entries, error)) {
+            std::map<std::wstring, const ManifestEntry*> previous;
+            for (const ManifestEntry& e : m_entries) previous[e.name] = &e;
+            for (const ManifestEntry& e : entries) {
+                auto it = previous.find(e.name);
+                if (it == previous.end() || !SameEntry(*it->second, e)) {
+                    updates[e.name] = false;
+                }
+                if (it != previous.end()) previous.erase(it);
+            }
+            for (const auto& p : previous) removals.push_back(p.first);
+            m_entries.swap(entries);
+        } else {
+            // Most likely caught mid-save; the next write triggers another batch
+            std::wcerr << L"Warning: Keeping previous manifest: " << error << L"\n";
+        }
+    }
+    for (const ManifestEntry& e : m_entries) {
+        if (!e.icon.empty() && paths.count(IconPath(e))) {
+            updates[e.name] = true;
+        }
+    }
+
+    // One job per icon: apps sharing an icon are regenerated in turn, so the
+    // icon is converted once and never written by two workers at a time
+    std::map<std::wstring, std::vector<ManifestEntry>> jobs;
+    for (const ManifestEntry& e : m_entries) {
+        if (updates.count(e.name)) {
+            jobs[e.icon.empty() ? L"|" + e.name : IconPath(e)].push_back(e);
+        }
+    }
+
+    std::mutex resultMutex;
+    for (auto& job : jobs) {
+        if (!m_actions.updateApp) break;
+        std::vector<ManifestEntry> group;
+        group.swap(job.second);
+        bool iconChanged = false;
+        for (const ManifestEntry& e : group) iconChanged = iconChanged || updates[e.name];
+        m_pool.Submit([this, group, iconChanged, first, &result, &resultMutex]() {
+            for (size_t i = 0; i < group.size(); ++i) {
+                bool ok = m_actions.updateApp(group[i], iconChanged && i == 0);
+                int ms = MillisecondsSince(first);
+                std::lock_guard<std::mutex> lock(resultMutex);
+                std::wcout << (ok ? L"Updated: " : L"Failed: ") << group[i].name << L" (" << ms << L" ms)\n";
+                if (ok) result.updated++; else result.failed++;
+            }
+        });
+    }
+    for (const std::wstring& name : removals) {
+        if (!m_actions.removeApp) continue;
+        m_pool.Submit([this, name, first, &result, &resultMutex]() {
+            bool ok = m_actions.removeApp(name);
+            int ms = MillisecondsSince(first);
+            std::lock_guard<std::mutex> lock(resultMutex);
+            std::wcout << (ok ? L"Removed: " : L"Failed: ") << name << L" (" << ms << L" ms)\n";
+            if (ok) result.removed++; else result.failed++;
+        });
+    }
+    m_pool.WaitIdle();
+    result.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - first).count();
+
+    // Icons may have been added, renamed or dropped
+    Resubscribe();
+
+    std::wcout << L"Change batch: " << result.events << L" events, " << result.updated
+               << L" updated, " << result.removed << L" removed";
+    if (result.failed) {
+        std::wcout << L", " << result.failed << L" failed";
+    }
+    std::wcout << L" (" << (int)result.latencyMs << L" ms after first change)\n";
+
+    if (batch) {
+        *batch = result;
+    }
+    return true;
+}
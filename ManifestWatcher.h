@@ -0,0 +1,71 @@
+#pragma once
+#include "FileWatcher.h"
+#include "Manifest.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+// What the watcher does for each affected app. Both run on pool threads,
+// so they must be safe to call concurrently for different apps.
+struct WatchActions {
+    // Regenerate the app's icon and shortcut; iconChanged is set when the
+    // icon file itself was edited (not just the manifest entry)
+    std::function<bool(const ManifestEntry& entry, bool iconChanged)> updateApp;
+
+    // The app was removed from the manifest
+    std::function<bool(const std::wstring& name)> removeApp;
+};
+
+struct WatchBatch {
+    size_t events = 0;           // Raw change notifications coalesced into the batch
+    size_t updated = 0;
+    size_t removed = 0;
+    size_t failed = 0;
+    double latencyMs = 0;        // First notification to the last job finishing
+};
+
+// Watches a manifest and the icons it references and re-runs only the work
+// that a change affects.
+//
+// Notifications are debounced: a batch is processed once no further change
+// has arrived for kQuietMs (editors often write a file several times per
+// save), or kMaxDelayMs after the first change at the latest. A manifest
+// change is diffed against the previous entries, so only added or edited
+// apps are regenerated and removed ones are cleaned up; an icon change
+// regenerates just the apps that use that icon.
+class ManifestWatcher {
+public:
+    ManifestWatcher(const std::wstring& manifestPath, const WatchActions& actions, WorkerPool& pool);
+
+    // Loads the manifest and starts watching; no actions are run
+    bool Start();
+
+    // Processes batches until Stop() is called
+    void Run();
+
+    // Safe to call from any thread (e.g. a console control handler)
+    void Stop();
+
+    // Waits up to timeoutMs for a change and processes one batch. Returns
+    // true if a batch ran.
+    bool Poll(int timeoutMs, WatchBatch* batch = nullptr);
+
+    const std::vector<ManifestEntry>& Entries() const { return m_entries; }
+
+    static const int kQuietMs = 150;
+    static const int kMaxDelayMs = 1000;
+
+private:
+    void Resubscribe();
+    std::wstring IconPath(const ManifestEntry& entry) const;
+
+    std::wstring m_manifestPath;
+    WatchActions m_actions;
+    WorkerPool& m_pool;
+    FileWatcher m_watcher;
+    std::vector<ManifestEntry> m_entries;
+    std::atomic<bool> m_stop;
+};
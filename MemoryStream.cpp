@@ -0,0 +1,62 @@
+#include "MemoryStream.h"
+#include <cstring>
+
+Microsoft::WRL::ComPtr<IStream> MemoryStream::Create(const uint8_t* data, size_t size) {
+    return Microsoft::WRL::Make<MemoryStream>(data, size);
+}
+
+STDMETHODIMP MemoryStream::Read(void* pv, ULONG cb, ULONG* pcbRead) {
+    size_t left = m_size - m_position;
+    ULONG n = cb < left ? cb : (ULONG)left;
+    memcpy(pv, m_data + m_position, n);
+    m_position += n;
+    if (pcbRead) *pcbRead = n;
+    return n == cb ? S_OK : S_FALSE;
+}
+
+STDMETHODIMP MemoryStream::Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* newPosition) {
+    LONGLONG base;
+    switch (origin) {
+    case STREAM_SEEK_SET: base = 0; break;
+    case STREAM_SEEK_CUR: base = (LONGLONG)m_position; break;
+    case STREAM_SEEK_END: base = (LONGLONG)m_size; break;
+    default: return STG_E_INVALIDFUNCTION;
+    }
+    LONGLONG position = base + move.QuadPart;
+    if (position < 0) {
+        return STG_E_INVALIDFUNCTION;
+    }
+    // Seeking past the end is allowed; reads there return nothing
+    m_position = (ULONGLONG)position < m_size ? (size_t)position : m_size;
+    if (newPosition) newPosition->QuadPart = (ULONGLONG)position;
+    return S_OK;
+}
+
+STDMETHODIMP MemoryStream::CopyTo(IStream* target, ULARGE_INTEGER cb, ULARGE_INTEGER* read, ULARGE_INTEGER* written) {
+    size_t left = m_size - m_position;
+    ULONG n = cb.QuadPart < left ? (ULONG)cb.QuadPart : (ULONG)left;
+    ULONG done = 0;
+    HRESULT hr = target->Write(m_data + m_position, n, &done);
+    m_position += n;
+    if (read) read->QuadPart = n;
+    if (written) written->QuadPart = done;
+    return hr;
+}
+
+STDMETHODIMP MemoryStream::Stat(STATSTG* stat, DWORD) {
+    ZeroMemory(stat, sizeof(*stat));
+    stat->type = STGTY_STREAM;
+    stat->cbSize.QuadPart = m_size;
+    stat->grfMode = STGM_READ;
+    return S_OK;
+}
+
+STDMETHODIMP MemoryStream::Clone(IStream** stream) {
+    Microsoft::WRL::ComPtr<MemoryStream> clone = Microsoft::WRL::Make<MemoryStream>(m_data, m_size);
+    if (!clone) {
+        return E_OUTOFMEMORY;
+    }
+    clone->m_position = m_position;
+    *stream = clone.Detach();
+    return S_OK;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <windows.h>
+#include <objidl.h>
+#include <wrl.h>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only IStream over memory owned by someone else (for example a
+// mapped AppBundle), so WebView2 can read a response without a copy.
+// The memory must outlive the stream and every clone of it.
+class MemoryStream : public Microsoft::WRL::RuntimeClass<
+    Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>,
+    Microsoft::WRL::ChainInterfaces<IStream, ISequentialStream>> {
+public:
+    MemoryStream(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    static Microsoft::WRL::ComPtr<IStream> Create(const uint8_t* data, size_t size);
+
+    // ISequentialStream
+    STDMETHODIMP Read(void* pv, ULONG cb, ULONG* pcbRead) override;
+    STDMETHODIMP Write(const void*, ULONG, ULONG*) override { return STG_E_ACCESSDENIED; }
+
+    // IStream
+    STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* newPosition) override;
+    STDMETHODIMP SetSize(ULARGE_INTEGER) override { return STG_E_ACCESSDENIED; }
+    STDMETHODIMP CopyTo(IStream* target, ULARGE_INTEGER cb, ULARGE_INTEGER* read, ULARGE_INTEGER* written) override;
+    STDMETHODIMP Commit(DWORD) override { return S_OK; }
+    STDMETHODIMP Revert() override { return S_OK; }
+    STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override { return STG_E_INVALIDFUNCTION; }
+    STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override { return STG_E_INVALIDFUNCTION; }
+    STDMETHODIMP Stat(STATSTG* stat, DWORD flags) override;
+    STDMETHODIMP Clone(IStream** stream) override;
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_position = 0;
+};
@@ -0,0 +1,181 @@
+#include "MetricsLog.h"
+#include "AppPaths.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Record layout: u32 magic, u32 payloadLen, u32 crc(payload), payload.
+// Payload: u8 type, then
+//   kLaunch:    app, phaseCount, { name, microseconds }
+//   kHistogram: app, launches, phaseCount, { name, LatencyHistogram }
+// with every integer a varint and every string length-prefixed.
+const uint32_t kMagic = 0x4C4D5757;  // "WWML"
+const size_t kHeaderSize = 12;
+const uint32_t kMaxPayload = 1u << 24;
+const uint8_t kLaunch = 1;
+const uint8_t kHistogram = 2;
+
+void PutU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out += (char)(v >> (i * 8));
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void Frame(std::string& out, const std::string& payload) {
+    PutU32(out, kMagic);
+    PutU32(out, (uint32_t)payload.size());
+    PutU32(out, Checksums::Crc32(0, (const uint8_t*)payload.data(), payload.size()));
+    out += payload;
+}
+
+AppLatency& FindApp(std::vector<AppLatency>& apps, const std::string& name) {
+    for (AppLatency& a : apps) {
+        if (a.app == name) return a;
+    }
+    apps.push_back(AppLatency());
+    apps.back().app = name;
+    return apps.back();
+}
+
+bool ParsePayload(const uint8_t* p, const uint8_t* end, std::vector<AppLatency>& apps) {
+    if (p >= end) return false;
+    uint8_t type = *p++;
+
+    std::string app;
+    uint64_t launches = 1;
+    uint64_t phaseCount = 0;
+    if (!Varint::GetString(p, end, app)) return false;
+    if (type != kLaunch && (type != kHistogram || !Varint::Get(p, end, launches))) return false;
+    if (!Varint::Get(p, end, phaseCount) || phaseCount > (uint64_t)(end - p)) return false;
+
+    // Decode the whole record before touching apps, so a corrupt one adds nothing
+    std::vector<std::string> names((size_t)phaseCount);
+    std::vector<uint64_t> samples;
+    std::vector<LatencyHistogram> histograms;
+    for (uint64_t i = 0; i < phaseCount; ++i) {
+        if (!Varint::GetString(p, end, names[i])) return false;
+        if (type == kLaunch) {
+            uint64_t micros = 0;
+            if (!Varint::Get(p, end, micros)) return false;
+            samples.push_back(micros);
+        } else {
+            histograms.push_back(LatencyHistogram());
+            if (!histograms.back().Deserialize(p, end)) return false;
+        }
+    }
+    if (p != end) return false;
+
+    AppLatency& target = FindApp(apps, app);
+    target.launches += launches;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (type == kLaunch) {
+            target.Phase(names[i]).Record(samples[i]);
+        } else {
+            target.Phase(names[i]).Merge(histograms[i]);
+        }
+    }
+    return true;
+}
+}
+
+LatencyHistogram& AppLatency::Phase(const std::string& name) {
+    for (PhaseHistogram& p : phases) {
+        if (p.phase == name) return p.histogram;
+    }
+    phases.push_back(PhaseHistogram());
+    phases.back().phase = name;
+    return phases.back().histogram;
+}
+
+void AppLatency::Merge(const AppLatency& other) {
+    launches += other.launches;
+    for (const PhaseHistogram& p : other.phases) {
+        Phase(p.phase).Merge(p.histogram);
+    }
+}
+
+bool MetricsLog::AppendLaunch(const std::wstring& path, const std::string& app,
+    const std::vector<StartupTiming::Phase>& phases) {
+    std::string payload;
+    payload += (char)kLaunch;
+    Varint::PutString(payload, app);
+    Varint::Put(payload, phases.size());
+    for (const StartupTiming::Phase& p : phases) {
+        Varint::PutString(payload, p.name);
+        Varint::Put(payload, (uint64_t)std::llround(std::max(p.ms, 0.0) * 1000.0));
+    }
+
+    // One write per launch keeps concurrent appends from interleaving
+    std::string record;
+    Frame(record, payload);
+    return FileUtil::Append(path, record.data(), record.size());
+}
+
+bool MetricsLog::Load(const std::wstring& path, std::vector<AppLatency>& apps) {
+    std::string data;
+    if (!FileUtil::Read(path, data)) {
+        return !FileUtil::Exists(path);
+    }
+
+    const uint8_t* p = (const uint8_t*)data.data();
+    size_t pos = 0;
+    while (data.size() - pos >= kHeaderSize) {
+        uint32_t len = GetU32(p + pos + 4);
+        bool valid = GetU32(p + pos) == kMagic && len <= kMaxPayload && len <= data.size() - pos - kHeaderSize
+            && Checksums::Crc32(0, p + pos + kHeaderSize, len) == GetU32(p + pos + 8)
+            && ParsePayload(p + pos + kHeaderSize, p + pos + kHeaderSize + len, apps);
+        if (valid) {
+            pos += kHeaderSize + len;
+        } else {
+            // Resynchronize on the next record after a torn or corrupt one
+            pos++;
+        }
+    }
+
+    std::sort(apps.begin(), apps.end(),
+        [](const AppLatency& a, const AppLatency& b) { return a.app < b.app; });
+    return true;
+}
+
+bool MetricsLog::Compact(const std::wstring& path) {
+    // Move the log aside so launches keep appending to a fresh file. A
+    // leftover from an interrupted compaction is finished first.
+    std::wstring aside = path + L".compacting";
+    if (!FileUtil::Exists(aside) && !FileUtil::Rename(path, aside)) {
+        return !FileUtil::Exists(path);
+    }
+
+    std::vector<AppLatency> apps;
+    if (!Load(aside, apps)) {
+        return false;
+    }
+
+    std::string records;
+    for (const AppLatency& a : apps) {
+        std::string payload;
+        payload += (char)kHistogram;
+        Varint::PutString(payload, a.app);
+        Varint::Put(payload, a.launches);
+        Varint::Put(payload, a.phases.size());
+        for (const PhaseHistogram& p : a.phases) {
+            Varint::PutString(payload, p.phase);
+            p.histogram.Serialize(payload);
+        }
+        Frame(records, payload);
+    }
+
+    if (!records.empty() && !FileUtil::Append(path, records.data(), records.size())) {
+        return false;
+    }
+    return FileUtil::Remove(aside);
+}
+
+std::wstring MetricsLog::DefaultPath() {
+    return AppPaths::DataFile(L"metrics.log");
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "LatencyHistogram.h"
+#include "StartupTiming.h"
+#include <string>
+#include <vector>
+
+struct PhaseHistogram {
+    std::string phase;
+    LatencyHistogram histogram;  // Microseconds
+};
+
+struct AppLatency {
+    std::string app;
+    uint64_t launches = 0;
+    std::vector<PhaseHistogram> phases;  // In order of first appearance
+
+    LatencyHistogram& Phase(const std::string& name);
+    void Merge(const AppLatency& other);
+};
+
+// Append-only file of startup timings shared by every launch.
+//
+// Each launch appends one self-contained, CRC-checked record with a single
+// write, so concurrent launches never lock or rewrite anything. Compact()
+// folds accumulated launch records into one histogram record per app. Torn
+// or corrupt records are skipped on load.
+class MetricsLog {
+public:
+    static bool AppendLaunch(const std::wstring& path, const std::string& app,
+        const std::vector<StartupTiming::Phase>& phases);
+
+    // Merges every record in path into apps (sorted by app name)
+    static bool Load(const std::wstring& path, std::vector<AppLatency>& apps);
+
+    // Replaces the launch records with per-app histograms. A launch that
+    // opened the file before compaction started but wrote after it was
+    // read can be lost.
+    static bool Compact(const std::wstring& path);
+
+    // Default location in the per-user data folder
+    static std::wstring DefaultPath();
+};
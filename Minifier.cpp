@@ -0,0 +1,212 @@
+#include "Minifier.h"
+#include <cstring>
+
+namespace {
+
+enum Gap { kNone, kSpace, kNewline };
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Letters, digits, _, $, escapes and any non-ASCII byte
+bool IsIdent(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+        c == '_' || c == '$' || c == '\\' || (unsigned char)c >= 0x80;
+}
+
+class JsMinifier {
+public:
+    explicit JsMinifier(const std::string& source) : m_src(source) {}
+
+    std::string Run() {
+        m_out.reserve(m_src.size());
+        while (m_pos < m_src.size()) {
+            char c = m_src[m_pos];
+            if (IsSpace(c)) {
+                Widen(c == '\n' || c == '\r' ? kNewline : kSpace);
+                m_pos++;
+            } else if (StartsWith("//")) {
+                while (m_pos < m_src.size() && m_src[m_pos] != '\n') m_pos++;
+                Widen(kSpace);
+            } else if (StartsWith("/*!")) {
+                size_t end = m_src.find("*/", m_pos + 3);
+                end = end == std::string::npos ? m_src.size() : end + 2;
+                Emit(m_src.substr(m_pos, end - m_pos), false);
+                m_pos = end;
+            } else if (StartsWith("/*")) {
+                size_t end = m_src.find("*/", m_pos + 2);
+                end = end == std::string::npos ? m_src.size() : end + 2;
+                bool multiline = memchr(m_src.data() + m_pos, '\n', end - m_pos) != nullptr;
+                Widen(multiline ? kNewline : kSpace);
+                m_pos = end;
+            } else if (c == '"' || c == '\'' || c == '`' || (c == '/' && RegexAllowed())) {
+                bool regex = c == '/';
+                size_t end = regex ? SkipRegex(m_pos) : c == '`' ? SkipTemplate(m_pos) : SkipString(m_pos);
+                Emit(m_src.substr(m_pos, end - m_pos), regex);
+                m_pos = end;
+            } else {
+                Emit(std::string(1, c), false);
+                m_pos++;
+            }
+        }
+        return m_out;
+    }
+
+private:
+    const std::string& m_src;
+    std::string m_out;
+    size_t m_pos = 0;
+    Gap m_gap = kNone;
+    bool m_afterRegex = false;
+
+    bool StartsWith(const char* s) const {
+        return m_src.compare(m_pos, strlen(s), s) == 0;
+    }
+
+    void Widen(Gap gap) {
+        if (gap > m_gap) m_gap = gap;
+    }
+
+    // Appends token, first writing the pending gap if it still matters
+    void Emit(const std::string& token, bool regex) {
+        if (m_gap != kNone && !m_out.empty()) {
+            char p = m_out.back(), n = token[0];
+            bool joinable = strchr("{;,(=:[", p) || strchr("}),;]", n);
+            if (m_gap == kNewline && !joinable) {
+                m_out.push_back('\n');
+            } else if ((IsIdent(p) && IsIdent(n)) || (p == '+' && n == '+') || (p == '-' && n == '-') ||
+                (p >= '0' && p <= '9' && n == '.') || (p == '<' && n == '!') || (m_afterRegex && IsIdent(n))) {
+                m_out.push_back(m_gap == kNewline ? '\n' : ' ');
+            }
+        }
+        m_gap = kNone;
+        m_afterRegex = regex;
+        m_out += token;
+    }
+
+    // A / starts a regular expression unless it follows an operand
+    bool RegexAllowed() const {
+        if (m_out.empty()) return true;
+        char p = m_out.back();
+        if (p == ')' || p == ']' || p == '}' || p == '"' || p == '\'' || p == '`') return false;
+        if (!IsIdent(p)) return true;
+        size_t start = m_out.size();
+        while (start > 0 && IsIdent(m_out[start - 1])) start--;
+        std::string word = m_out.substr(start);
+        static const char* const kKeywords[] = { "return", "typeof", "case", "do", "else", "in",
+            "instanceof", "new", "delete", "void", "throw", "yield", "await" };
+        for (const char* k : kKeywords) {
+            if (word == k) return true;
+        }
+        return false;
+    }
+
+    size_t SkipString(size_t pos) const {
+        char quote = m_src[pos++];
+        while (pos < m_src.size() && m_src[pos] != quote && m_src[pos] != '\n') {
+            pos += m_src[pos] == '\\' ? 2 : 1;
+        }
+        return pos < m_src.size() ? pos + 1 : m_src.size();
+    }
+
+    // Past the closing backtick, stepping over ${...} expressions, which
+    // may hold strings and templates of their own
+    size_t SkipTemplate(size_t pos) const {
+        pos++;
+        while (pos < m_src.size() && m_src[pos] != '`') {
+            if (m_src[pos] == '\\') {
+                pos += 2;
+            } else if (m_src[pos] == '$' && pos + 1 < m_src.size() && m_src[pos + 1] == '{') {
+                pos = SkipExpression(pos + 2);
+            } else {
+                pos++;
+            }
+        }
+        return pos < m_src.size() ? pos + 1 : m_src.size();
+    }
+
+    size_t SkipExpression(size_t pos) const {
+        int depth = 1;
+        while (pos < m_src.size()) {
+            char c = m_src[pos];
+            if (c == '"' || c == '\'') {
+                pos = SkipString(pos);
+            } else if (c == '`') {
+                pos = SkipTemplate(pos);
+            } else {
+                if (c == '{') depth++;
+                if (c == '}' && --depth == 0) return pos + 1;
+                pos++;
+            }
+        }
+        return pos;
+    }
+
+    // Past the closing slash; a slash inside [...] doesn't end it
+    size_t SkipRegex(size_t pos) const {
+        bool inClass = false;
+        pos++;
+        while (pos < m_src.size() && m_src[pos] != '\n') {
+            char c = m_src[pos];
+            if (c == '\\') {
+                pos += 2;
+                continue;
+            }
+            if (c == '[') inClass = true;
+            else if (c == ']') inClass = false;
+            else if (c == '/' && !inClass) return pos + 1;
+            pos++;
+        }
+        return pos < m_src.size() ? pos : m_src.size();
+    }
+};
+
+}
+
+std::string Minifier::Js(const std::string& source) {
+    return JsMinifier(source).Run();
+}
+
+std::string Minifier::Css(const std::string& source) {
+    std::string out;
+    out.reserve(source.size());
+    bool gap = false;
+    size_t pos = 0;
+    while (pos < source.size()) {
+        char c = source[pos];
+        if (IsSpace(c)) {
+            gap = true;
+            pos++;
+            continue;
+        }
+        if (source.compare(pos, 2, "/*") == 0 && source.compare(pos, 3, "/*!") != 0) {
+            size_t end = source.find("*/", pos + 2);
+            pos = end == std::string::npos ? source.size() : end + 2;
+            gap = true;
+            continue;
+        }
+
+        size_t end = pos + 1;
+        if (c == '"' || c == '\'') {
+            while (end < source.size() && source[end] != c && source[end] != '\n') {
+                end += source[end] == '\\' ? 2 : 1;
+            }
+            end = end < source.size() ? end + 1 : source.size();
+        } else if (c == '/' && source.compare(pos, 3, "/*!") == 0) {
+            end = source.find("*/", pos + 3);
+            end = end == std::string::npos ? source.size() : end + 2;
+        }
+
+        if (gap && !out.empty() && !strchr("{};,>(:", out.back()) && !strchr("{};,>)", c)) {
+            out.push_back(' ');
+        }
+        gap = false;
+        if (c == '}' && !out.empty() && out.back() == ';') {
+            out.pop_back();  // The last declaration needs no semicolon
+        }
+        out.append(source, pos, end - pos);
+        pos = end;
+    }
+    return out;
+}
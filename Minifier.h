@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+// Whitespace and comment stripping for small injected scripts and styles.
+//
+// Neither minifier renames anything or rewrites syntax; they only drop what
+// the parser ignores, so the output behaves exactly like the input. String,
+// template and regular expression literals are copied untouched, and a line
+// break is kept wherever JavaScript's automatic semicolon insertion could
+// depend on it. Comments starting with /*! (licenses) are kept.
+class Minifier {
+public:
+    static std::string Js(const std::string& source);
+    static std::string Css(const std::string& source);
+};
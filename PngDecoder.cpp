@@ -0,0 +1,512 @@
+#include "PngDecoder.h"
+#include "Checksums.h"
+#include "Inflate.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// Adam7 pass origins and steps
+const int kPassX[7] = { 0, 4, 0, 2, 0, 1, 0 };
+const int kPassY[7] = { 0, 0, 4, 0, 2, 0, 1 };
+const int kPassDx[7] = { 8, 8, 4, 4, 2, 2, 1 };
+const int kPassDy[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+inline uint32_t GetU32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+struct Header {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int bitDepth = 0;
+    int colorType = 0;
+    int interlace = 0;
+
+    int Channels() const {
+        switch (colorType) {
+        case 0: return 1;  // Gray
+        case 2: return 3;  // RGB
+        case 3: return 1;  // Palette index
+        case 4: return 2;  // Gray + alpha
+        case 6: return 4;  // RGBA
+        default: return 0;
+        }
+    }
+
+    bool Valid() const {
+        switch (colorType) {
+        case 0: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+        case 3: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+        case 2: case 4: case 6: return bitDepth == 8 || bitDepth == 16;
+        default: return false;
+        }
+    }
+
+    size_t RowBytes(uint32_t w) const { return ((size_t)w * Channels() * bitDepth + 7) / 8; }
+    int FilterBpp() const { return (Channels() * bitDepth + 7) / 8; }
+};
+
+struct Palette {
+    uint8_t bgra[256][4];
+    int size = 0;
+    bool hasKey = false;
+    uint16_t key[3] = { 0, 0, 0 };  // tRNS color key for gray / RGB images
+};
+
+inline uint8_t PaethPredict(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+// Reverses the row filter in place; prev is null for the first row of a pass
+bool Unfilter(int type, uint8_t* row, const uint8_t* prev, size_t len, int bpp) {
+    switch (type) {
+    case 0:
+        break;
+    case 1:
+        for (size_t i = bpp; i < len; i++) row[i] = (uint8_t)(row[i] + row[i - bpp]);
+        break;
+    case 2:
+        if (prev) {
+            for (size_t i = 0; i < len; i++) row[i] = (uint8_t)(row[i] + prev[i]);
+        }
+        break;
+    case 3:
+        for (size_t i = 0; i < len; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int b = prev ? prev[i] : 0;
+            row[i] = (uint8_t)(row[i] + ((a + b) >> 1));
+        }
+        break;
+    case 4:
+        for (size_t i = 0; i < len; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+            row[i] = (uint8_t)(row[i] + PaethPredict(a, b, c));
+        }
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+inline uint16_t Sample(const uint8_t* row, uint32_t index, int bitDepth) {
+    switch (bitDepth) {
+    case 16: return (uint16_t)((row[index * 2] << 8) | row[index * 2 + 1]);
+    case 8: return row[index];
+    default: {
+        uint32_t bit = index * bitDepth;
+        int shift = 8 - bitDepth - (int)(bit & 7);
+        return (uint16_t)((row[bit >> 3] >> shift) & ((1 << bitDepth) - 1));
+    }
+    }
+}
+
+inline uint8_t To8(uint16_t v, int bitDepth) {
+    switch (bitDepth) {
+    case 16: return (uint8_t)(v >> 8);
+    case 8: return (uint8_t)v;
+    default: return (uint8_t)(v * 255 / ((1 << bitDepth) - 1));
+    }
+}
+
+// Expands one unfiltered row into BGRA pixels at dst, dst + step, ...
+void ExpandRow(const Header& h, const Palette& pal, const uint8_t* row, uint32_t count,
+    uint8_t* dst, size_t step) {
+    const int bd = h.bitDepth;
+
+    // Fast paths for the common 8-bit layouts
+    if (bd == 8 && h.colorType == 6) {
+        for (uint32_t x = 0; x < count; x++, dst += step, row += 4) {
+            dst[0] = row[2]; dst[1] = row[1]; dst[2] = row[0]; dst[3] = row[3];
+        }
+        return;
+    }
+    if (bd == 8 && h.colorType == 2 && !pal.hasKey) {
+        for (uint32_t x = 0; x < count; x++, dst += step, row += 3) {
+            dst[0] = row[2]; dst[1] = row[1]; dst[2] = row[0]; dst[3] = 255;
+        }
+        return;
+    }
+
+    for (uint32_t x = 0; x < count; x++, dst += step) {
+        switch (h.colorType) {
+        case 0: {
+            uint16_t g = Sample(row, x, bd);
+            uint8_t v = To8(g, bd);
+            dst[0] = dst[1] = dst[2] = v;
+            dst[3] = (pal.hasKey && g == pal.key[0]) ? 0 : 255;
+            break;
+        }
+        case 2: {
+            uint16_t r = Sample(row, x * 3, bd);
+            uint16_t g = Sample(row, x * 3 + 1, bd);
+            uint16_t b = Sample(row, x * 3 + 2, bd);
+            dst[0] = To8(b, bd); dst[1] = To8(g, bd); dst[2] = To8(r, bd);
+            dst[3] = (pal.hasKey && r == pal.key[0] && g == pal.key[1] && b == pal.key[2]) ? 0 : 255;
+            break;
+        }
+        case 3: {
+            uint16_t i = Sample(row, x, bd);
+            if (i < pal.size) {
+                memcpy(dst, pal.bgra[i], 4);
+            } else {
+                dst[0] = dst[1] = dst[2] = 0;
+                dst[3] = 255;
+            }
+            break;
+        }
+        case 4: {
+            uint8_t v = To8(Sample(row, x * 2, bd), bd);
+            dst[0] = dst[1] = dst[2] = v;
+            dst[3] = To8(Sample(row, x * 2 + 1, bd), bd);
+            break;
+        }
+        case 6:
+            dst[0] = To8(Sample(row, x * 4 + 2, bd), bd);
+            dst[1] = To8(Sample(row, x * 4 + 1, bd), bd);
+            dst[2] = To8(Sample(row, x * 4, bd), bd);
+            dst[3] = To8(Sample(row, x * 4 + 3, bd), bd);
+            break;
+        }
+    }
+}
+
+struct Pass {
+    uint32_t x0 = 0, y0 = 0, dx = 1, dy = 1;
+    uint32_t width = 0, height = 0;
+};
+
+Pass GetPass(const Header& h, int pass) {
+    Pass p;
+    p.width = h.width;
+    p.height = h.height;
+    if (h.interlace) {
+        p.x0 = kPassX[pass]; p.y0 = kPassY[pass];
+        p.dx = kPassDx[pass]; p.dy = kPassDy[pass];
+        p.width = h.width > p.x0 ? (h.width - p.x0 + p.dx - 1) / p.dx : 0;
+        p.height = h.height > p.y0 ? (h.height - p.y0 + p.dy - 1) / p.dy : 0;
+    }
+    return p;
+}
+
+bool ParseHeader(const uint8_t* data, size_t len, Header& h) {
+    if (len < 33 || memcmp(data, kSignature, 8) != 0) return false;
+    if (GetU32(data + 8) != 13 || memcmp(data + 12, "IHDR", 4) != 0) return false;
+    const uint8_t* p = data + 16;
+    h.width = GetU32(p);
+    h.height = GetU32(p + 4);
+    h.bitDepth = p[8];
+    h.colorType = p[9];
+    h.interlace = p[12];
+    return h.width > 0 && h.height > 0 && h.Valid() && p[10] == 0 && p[11] == 0 && h.interlace <= 1;
+}
+
+} // namespace
+
+bool PngDecoder::ReadSize(const uint8_t* data, size_t len, uint32_t& width, uint32_t& height) {
+    Header h;
+    if (!ParseHeader(data, len, h)) return false;
+    width = h.width;
+    height = h.height;
+    return true;
+}
+
+bool PngDecoder::Probe(const uint8_t* data, size_t len, PngInfo& info) {
+    Header h;
+    if (!ParseHeader(data, len, h)) return false;
+    info.width = h.width;
+    info.height = h.height;
+    info.bitDepth = h.bitDepth;
+    info.colorType = h.colorType;
+    info.interlaced = h.interlace != 0;
+    return true;
+}
+
+bool PngDecoder::Decode(const uint8_t* data, size_t len, PngImage& image) {
+    Header h;
+    if (!ParseHeader(data, len, h)) return false;
+    if ((uint64_t)h.width * h.height > kMaxPixels) return false;
+
+    Palette pal;
+    std::vector<uint8_t> idat;
+    bool sawEnd = false;
+
+    size_t pos = 8;
+    while (pos + 12 <= len) {
+        uint32_t chunkLen = GetU32(data + pos);
+        const uint8_t* type = data + pos + 4;
+        const uint8_t* body = data + pos + 8;
+        if (chunkLen > len - pos - 12) return false;
+        if (GetU32(body + chunkLen) != Checksums::Crc32(0, type, chunkLen + 4)) return false;
+
+        if (memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), body, body + chunkLen);
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            if (chunkLen % 3 != 0 || chunkLen > 768) return false;
+            pal.size = (int)(chunkLen / 3);
+            for (int i = 0; i < pal.size; i++) {
+                pal.bgra[i][0] = body[i * 3 + 2];
+                pal.bgra[i][1] = body[i * 3 + 1];
+                pal.bgra[i][2] = body[i * 3];
+                pal.bgra[i][3] = 255;
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (h.colorType == 3) {
+                for (uint32_t i = 0; i < chunkLen && i < (uint32_t)pal.size; i++) pal.bgra[i][3] = body[i];
+            } else if (h.colorType == 0 && chunkLen >= 2) {
+                pal.hasKey = true;
+                pal.key[0] = (uint16_t)((body[0] << 8) | body[1]);
+            } else if (h.colorType == 2 && chunkLen >= 6) {
+                pal.hasKey = true;
+                for (int c = 0; c < 3; c++) pal.key[c] = (uint16_t)((body[c * 2] << 8) | body[c * 2 + 1]);
+            }
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            sawEnd = true;
+            break;
+        } else if (!(type[0] & 0x20)) {
+            if (memcmp(type, "IHDR", 4) != 0) return false;  // Unknown critical chunk
+        }
+        pos += 12 + chunkLen;
+    }
+    if (!sawEnd || idat.empty() || (h.colorType == 3 && pal.size == 0)) return false;
+
+    // Size of the filtered data for all passes
+    const int passes = h.interlace ? 7 : 1;
+    size_t expected = 0;
+    for (int pass = 0; pass < passes; pass++) {
+        Pass p = GetPass(h, pass);
+        if (p.width && p.height) expected += (h.RowBytes(p.width) + 1) * p.height;
+    }
+
+    std::vector<uint8_t> raw;
+    raw.reserve(expected);
+    if (!Inflate::DecompressZlib(idat.data(), idat.size(), expected, raw) || raw.size() != expected) {
+        return false;
+    }
+    std::vector<uint8_t>().swap(idat);
+
+    image.width = h.width;
+    image.height = h.height;
+    image.bgra.assign((size_t)h.width * h.height * 4, 0);
+
+    const int bpp = h.FilterBpp();
+    uint8_t* in = raw.data();
+    for (int pass = 0; pass < passes; pass++) {
+        Pass p = GetPass(h, pass);
+        if (!p.width || !p.height) continue;
+
+        size_t rowBytes = h.RowBytes(p.width);
+        const uint8_t* prev = nullptr;
+        for (uint32_t y = 0; y < p.height; y++) {
+            uint8_t* row = in + 1;
+            if (!Unfilter(in[0], row, prev, rowBytes, bpp)) return false;
+            uint8_t* dst = image.bgra.data() + (((size_t)(p.y0 + y * p.dy) * h.width) + p.x0) * 4;
+            ExpandRow(h, pal, row, p.width, dst, (size_t)p.dx * 4);
+            prev = row;
+            in += rowBytes + 1;
+        }
+    }
+    return true;
+}
+
+struct PngRowReader::State {
+    explicit State(const Source& source) : source(source) {}
+
+    Source source;
+    PngInfo info;
+    Header header;
+    Palette palette;
+    std::unique_ptr<InflateStream> inflate;
+    std::vector<uint8_t> rows[2];    // Current and previous raw row, each with its filter byte
+    int current = 0;
+    uint32_t rowsRead = 0;
+    uint32_t idatLeft = 0;           // Body bytes left in the current IDAT chunk
+    uint32_t idatCrc = 0;
+    bool failed = false;
+    bool dataDone = false;
+    uint8_t pending[8];              // Chunk header read while looking for more IDAT data
+    bool hasPending = false;
+
+    bool ReadExact(uint8_t* dst, size_t n) {
+        while (n) {
+            size_t got = source(dst, n);
+            if (!got) return false;
+            dst += got;
+            n -= got;
+        }
+        return true;
+    }
+
+    // Reads the CRC following a chunk body and compares it
+    bool CheckCrc(uint32_t crc) {
+        uint8_t stored[4];
+        return ReadExact(stored, 4) && GetU32(stored) == crc;
+    }
+
+    // Concatenated IDAT bodies, fed to the inflater
+    size_t ReadImageData(uint8_t* buffer, size_t capacity) {
+        while (!idatLeft) {
+            if (failed || dataDone) return 0;
+            if (!CheckCrc(idatCrc)) {
+                failed = true;
+                return 0;
+            }
+            uint8_t next[8];
+            if (!ReadExact(next, 8)) {
+                failed = true;
+                return 0;
+            }
+            if (memcmp(next + 4, "IDAT", 4) != 0) {
+                memcpy(pending, next, 8);
+                hasPending = true;
+                dataDone = true;
+                return 0;
+            }
+            idatLeft = GetU32(next);
+            idatCrc = Checksums::Crc32(0, next + 4, 4);
+        }
+        size_t n = capacity < idatLeft ? capacity : idatLeft;
+        if (!ReadExact(buffer, n)) {
+            failed = true;
+            return 0;
+        }
+        idatCrc = Checksums::Crc32(idatCrc, buffer, n);
+        idatLeft -= (uint32_t)n;
+        return n;
+    }
+};
+
+PngRowReader::PngRowReader(Source source) : m_state(new State(source)) {
+}
+
+PngRowReader::~PngRowReader() {
+}
+
+const PngInfo& PngRowReader::Info() const {
+    return m_state->info;
+}
+
+bool PngRowReader::Open() {
+    State& s = *m_state;
+    uint8_t head[PngDecoder::kProbeBytes];
+    if (!s.ReadExact(head, sizeof(head)) || !ParseHeader(head, sizeof(head), s.header) ||
+        GetU32(head + 29) != Checksums::Crc32(0, head + 12, 17)) {
+        return false;
+    }
+    PngDecoder::Probe(head, sizeof(head), s.info);
+    if (s.info.interlaced) {
+        return false;
+    }
+
+    // Palette and transparency come before the image data
+    for (;;) {
+        uint8_t chunk[8];
+        if (!s.ReadExact(chunk, 8)) return false;
+        uint32_t chunkLen = GetU32(chunk);
+        const uint8_t* type = chunk + 4;
+        if (chunkLen > 0x7FFFFFFF) return false;
+
+        if (memcmp(type, "IDAT", 4) == 0) {
+            s.idatLeft = chunkLen;
+            s.idatCrc = Checksums::Crc32(0, type, 4);
+            break;
+        }
+        if (memcmp(type, "IEND", 4) == 0 || (!(type[0] & 0x20) && memcmp(type, "PLTE", 4) != 0)) {
+            return false;  // No image data, or an unknown critical chunk
+        }
+
+        // Ancillary chunks are skipped in pieces; PLTE and tRNS are small
+        uint32_t crc = Checksums::Crc32(0, type, 4);
+        bool keep = memcmp(type, "PLTE", 4) == 0 || memcmp(type, "tRNS", 4) == 0;
+        std::vector<uint8_t> body(keep ? chunkLen : (chunkLen < 4096 ? chunkLen : 4096));
+        for (uint32_t left = chunkLen; left; ) {
+            size_t n = keep ? left : (left < body.size() ? left : body.size());
+            if (!s.ReadExact(body.data(), n)) return false;
+            crc = Checksums::Crc32(crc, body.data(), n);
+            left -= (uint32_t)n;
+        }
+        if (!s.CheckCrc(crc)) return false;
+
+        if (memcmp(type, "PLTE", 4) == 0) {
+            if (chunkLen % 3 != 0 || chunkLen > 768) return false;
+            s.palette.size = (int)(chunkLen / 3);
+            for (int i = 0; i < s.palette.size; i++) {
+                s.palette.bgra[i][0] = body[i * 3 + 2];
+                s.palette.bgra[i][1] = body[i * 3 + 1];
+                s.palette.bgra[i][2] = body[i * 3];
+                s.palette.bgra[i][3] = 255;
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            const Header& h = s.header;
+            if (h.colorType == 3) {
+                for (uint32_t i = 0; i < chunkLen && i < (uint32_t)s.palette.size; i++) {
+                    s.palette.bgra[i][3] = body[i];
+                }
+            } else if (h.colorType == 0 && chunkLen >= 2) {
+                s.palette.hasKey = true;
+                s.palette.key[0] = (uint16_t)((body[0] << 8) | body[1]);
+            } else if (h.colorType == 2 && chunkLen >= 6) {
+                s.palette.hasKey = true;
+                for (int c = 0; c < 3; c++) {
+                    s.palette.key[c] = (uint16_t)((body[c * 2] << 8) | body[c * 2 + 1]);
+                }
+            }
+        }
+    }
+    if (s.header.colorType == 3 && s.palette.size == 0) {
+        return false;
+    }
+
+    State* state = m_state.get();
+    s.inflate.reset(new InflateStream([state](uint8_t* buffer, size_t capacity) {
+        return state->ReadImageData(buffer, capacity);
+    }));
+    size_t rowBytes = s.header.RowBytes(s.header.width) + 1;
+    s.rows[0].assign(rowBytes, 0);
+    s.rows[1].assign(rowBytes, 0);
+    return true;
+}
+
+bool PngRowReader::ReadRow(uint8_t* bgra) {
+    State& s = *m_state;
+    if (!s.inflate || s.rowsRead >= s.header.height) {
+        return false;
+    }
+
+    std::vector<uint8_t>& row = s.rows[s.current];
+    const std::vector<uint8_t>& prev = s.rows[s.current ^ 1];
+    size_t rowBytes = row.size() - 1;
+    if (!s.inflate->Read(row.data(), row.size()) ||
+        !Unfilter(row[0], row.data() + 1, s.rowsRead ? prev.data() + 1 : nullptr, rowBytes,
+            s.header.FilterBpp())) {
+        return false;
+    }
+    ExpandRow(s.header, s.palette, row.data() + 1, s.header.width, bgra, 4);
+    s.current ^= 1;
+    s.rowsRead++;
+    return true;
+}
+
+bool PngRowReader::Finish() {
+    State& s = *m_state;
+    if (!s.inflate || s.rowsRead != s.header.height || !s.inflate->Finish()) {
+        return false;
+    }
+
+    // Drain any IDAT padding after the zlib stream, verifying CRCs
+    uint8_t scratch[4096];
+    while (s.ReadImageData(scratch, sizeof(scratch))) {
+    }
+    return !s.failed;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Decoded image, top-down, non-premultiplied BGRA (the layout IcoImage and
+// Windows DIBs use)
+struct PngImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> bgra;
+};
+
+// Header fields, available from the first 33 bytes of the file
+struct PngInfo {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int bitDepth = 0;
+    int colorType = 0;
+    bool interlaced = false;
+};
+
+// Portable PNG reader covering every standard color type and bit depth,
+// palettes with tRNS transparency and Adam7 interlacing. 16-bit samples
+// are reduced to 8 bits; gamma and color profile chunks are ignored.
+class PngDecoder {
+public:
+    // Largest width * height accepted, to bound memory on hostile input
+    static const uint32_t kMaxPixels = 1u << 26;
+
+    static bool Decode(const uint8_t* data, size_t len, PngImage& image);
+
+    // Reads only the IHDR dimensions
+    static bool ReadSize(const uint8_t* data, size_t len, uint32_t& width, uint32_t& height);
+
+    // Parses the signature and IHDR; needs kProbeBytes of data, no pixels are decoded
+    static bool Probe(const uint8_t* data, size_t len, PngInfo& info);
+
+    static const size_t kProbeBytes = 33;
+};
+
+// Decodes a non-interlaced PNG one row at a time from a byte source, so
+// memory is a couple of raw rows and a 32 KB inflate window whatever the
+// image size. Chunk CRCs and the zlib checksum are verified as data
+// streams past.
+class PngRowReader {
+public:
+    // Fills buffer with up to capacity bytes of the file; 0 at the end
+    typedef std::function<size_t(uint8_t* buffer, size_t capacity)> Source;
+
+    explicit PngRowReader(Source source);
+    ~PngRowReader();
+
+    PngRowReader(const PngRowReader&) = delete;
+    PngRowReader& operator=(const PngRowReader&) = delete;
+
+    // Reads the header and the chunks before the image data. Fails for
+    // interlaced images, whose rows arrive out of order.
+    bool Open();
+
+    const PngInfo& Info() const;
+
+    // Decodes the next row (top to bottom) into Info().width BGRA pixels
+    bool ReadRow(uint8_t* bgra);
+
+    // After the last row: checks the end of the image data
+    bool Finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,137 @@
+#include "PngEncoder.h"
+#include "Checksums.h"
+#include "Deflate.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+void WriteChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t len) {
+    PutU32(out, (uint32_t)len);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (len) out.insert(out.end(), data, data + len);
+    PutU32(out, Checksums::Crc32(0, out.data() + start, len + 4));
+}
+
+inline uint8_t Paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+// Applies filter type to row (bpp bytes per pixel) using prev (or null for the first row)
+void FilterRow(int type, const uint8_t* row, const uint8_t* prev, size_t len, int bpp, uint8_t* dst) {
+    for (size_t i = 0; i < len; i++) {
+        int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+        int b = prev ? prev[i] : 0;
+        int c = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+        int x = row[i];
+        switch (type) {
+        case 0: dst[i] = (uint8_t)x; break;
+        case 1: dst[i] = (uint8_t)(x - a); break;
+        case 2: dst[i] = (uint8_t)(x - b); break;
+        case 3: dst[i] = (uint8_t)(x - ((a + b) >> 1)); break;
+        default: dst[i] = (uint8_t)(x - Paeth(a, b, c)); break;
+        }
+    }
+}
+
+// Minimum sum of absolute differences heuristic (residuals as signed bytes)
+uint64_t FilterCost(const uint8_t* filtered, size_t len) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += (uint64_t)std::abs((int)(int8_t)filtered[i]);
+    }
+    return sum;
+}
+
+} // namespace
+
+bool PngEncoder::Encode(const uint8_t* pixels, uint32_t width, uint32_t height, size_t stride,
+    Layout layout, int level, std::vector<uint8_t>& out) {
+    if (!pixels || width == 0 || height == 0) return false;
+
+    bool opaque = true;
+    for (uint32_t y = 0; y < height && opaque; y++) {
+        const uint8_t* src = pixels + y * stride;
+        for (uint32_t x = 0; x < width; x++) {
+            if (src[x * 4 + 3] != 255) { opaque = false; break; }
+        }
+    }
+
+    const int bpp = opaque ? 3 : 4;
+    const size_t rowBytes = (size_t)width * bpp;
+    const int ri = layout == Layout::BGRA ? 2 : 0;
+    const int bi = layout == Layout::BGRA ? 0 : 2;
+
+    std::vector<uint8_t> raw((rowBytes + 1) * height);
+    std::vector<uint8_t> cur(rowBytes), prev(rowBytes), trial(rowBytes), best(rowBytes);
+
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* src = pixels + y * stride;
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t* d = &cur[x * bpp];
+            d[0] = src[x * 4 + ri];
+            d[1] = src[x * 4 + 1];
+            d[2] = src[x * 4 + bi];
+            if (bpp == 4) d[3] = src[x * 4 + 3];
+        }
+
+        const uint8_t* up = y > 0 ? prev.data() : nullptr;
+        int bestType = 0;
+        if (level == 0) {
+            // Stored output gains nothing from filtering
+            memcpy(best.data(), cur.data(), rowBytes);
+        } else {
+            uint64_t bestCost = UINT64_MAX;
+            for (int type = 0; type < 5; type++) {
+                FilterRow(type, cur.data(), up, rowBytes, bpp, trial.data());
+                uint64_t cost = FilterCost(trial.data(), rowBytes);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestType = type;
+                    best.swap(trial);
+                }
+            }
+        }
+
+        uint8_t* dst = &raw[y * (rowBytes + 1)];
+        dst[0] = (uint8_t)bestType;
+        memcpy(dst + 1, best.data(), rowBytes);
+        prev.swap(cur);
+    }
+
+    std::vector<uint8_t> idat;
+    idat.reserve(raw.size() / 2);
+    Deflate::CompressZlib(raw.data(), raw.size(), level, idat);
+
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    out.insert(out.end(), kSignature, kSignature + 8);
+
+    uint8_t ihdr[13];
+    ihdr[0] = (uint8_t)(width >> 24); ihdr[1] = (uint8_t)(width >> 16);
+    ihdr[2] = (uint8_t)(width >> 8);  ihdr[3] = (uint8_t)width;
+    ihdr[4] = (uint8_t)(height >> 24); ihdr[5] = (uint8_t)(height >> 16);
+    ihdr[6] = (uint8_t)(height >> 8);  ihdr[7] = (uint8_t)height;
+    ihdr[8] = 8;                     // Bit depth
+    ihdr[9] = opaque ? 2 : 6;        // RGB or RGBA
+    ihdr[10] = 0;                    // Deflate
+    ihdr[11] = 0;                    // Adaptive filtering
+    ihdr[12] = 0;                    // No interlace
+    WriteChunk(out, "IHDR", ihdr, sizeof(ihdr));
+    WriteChunk(out, "IDAT", idat.data(), idat.size());
+    WriteChunk(out, "IEND", nullptr, 0);
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Portable PNG writer for 8-bit RGBA/BGRA images.
+// Each scanline picks the filter with the smallest sum of absolute
+// residuals, and the result is compressed with the built-in Deflate.
+class PngEncoder {
+public:
+    // Pixel layout of the input rows
+    enum class Layout { RGBA, BGRA };
+
+    // Encodes width x height pixels (stride bytes per row, top-down).
+    // Fully opaque images are written as RGB to save the alpha channel.
+    static bool Encode(const uint8_t* pixels, uint32_t width, uint32_t height, size_t stride,
+        Layout layout, int level, std::vector<uint8_t>& out);
+};
@@ -0,0 +1,290 @@
+#include "Prewarmer.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET SocketHandle;
+static const SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+static const SocketHandle kInvalidSocket = -1;
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Granularity at which a pending connect notices cancellation
+const int kPollSliceMs = 20;
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void CloseSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool SetNonBlocking(SocketHandle s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool ConnectPending() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+enum class ConnectStatus { Connected, Failed, TimedOut, Cancelled };
+
+// Non-blocking connect polled in short slices so cancellation and the
+// deadline are honoured promptly
+ConnectStatus ConnectOnce(const std::string& address, uint16_t port,
+    const std::atomic<bool>& cancel, Clock::time_point deadline) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* info = nullptr;
+    if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &info) != 0 || !info) {
+        return ConnectStatus::Failed;
+    }
+
+    SocketHandle s = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (s == kInvalidSocket || !SetNonBlocking(s)) {
+        if (s != kInvalidSocket) CloseSocket(s);
+        freeaddrinfo(info);
+        return ConnectStatus::Failed;
+    }
+
+    ConnectStatus status = ConnectStatus::Failed;
+    if (connect(s, info->ai_addr, (int)info->ai_addrlen) == 0) {
+        status = ConnectStatus::Connected;
+    } else if (ConnectPending()) {
+        for (;;) {
+            if (cancel) {
+                status = ConnectStatus::Cancelled;
+                break;
+            }
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (remaining <= 0) {
+                status = ConnectStatus::TimedOut;
+                break;
+            }
+
+            fd_set writable, failed;
+            FD_ZERO(&writable);
+            FD_ZERO(&failed);
+            FD_SET(s, &writable);
+            FD_SET(s, &failed);  // Windows reports connect errors here
+            long slice = (long)std::min<long long>(remaining, kPollSliceMs);
+            timeval tv = { 0, slice * 1000 };
+            int ready = select((int)s + 1, nullptr, &writable, &failed, &tv);
+            if (ready < 0) {
+#ifndef _WIN32
+                if (errno == EINTR) continue;
+#endif
+                break;
+            }
+            if (ready == 0) continue;
+
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&error, &len);
+            status = (error == 0 && FD_ISSET(s, &writable)) ? ConnectStatus::Connected : ConnectStatus::Failed;
+            break;
+        }
+    }
+
+    CloseSocket(s);
+    freeaddrinfo(info);
+    return status;
+}
+
+}
+
+Prewarmer::Prewarmer() : m_resolver(&Prewarmer::SystemResolve) {
+}
+
+Prewarmer::~Prewarmer() {
+    Cancel();
+}
+
+bool Prewarmer::ParseOrigin(const std::wstring& url, std::string& host, uint16_t& port) {
+    std::string u = Utf8::FromWide(url);
+    size_t schemeEnd = u.find("://");
+    if (schemeEnd == std::string::npos) {
+        return false;
+    }
+    std::string scheme = u.substr(0, schemeEnd);
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+    if (scheme == "http") {
+        port = 80;
+    } else if (scheme == "https") {
+        port = 443;
+    } else {
+        return false;
+    }
+
+    size_t start = schemeEnd + 3;
+    size_t end = u.find_first_of("/?#", start);
+    std::string authority = u.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) {
+        authority = authority.substr(at + 1);
+    }
+
+    // [v6]:port or name:port
+    std::string portText;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) return false;
+        host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size()) {
+            if (authority[close + 1] != ':') return false;
+            portText = authority.substr(close + 2);
+        }
+    } else {
+        size_t colon = authority.find(':');
+        host = authority.substr(0, colon);
+        if (colon != std::string::npos) portText = authority.substr(colon + 1);
+    }
+
+    if (!portText.empty()) {
+        if (portText.size() > 5 || portText.find_first_not_of("0123456789") != std::string::npos) return false;
+        unsigned long p = std::stoul(portText);
+        if (p == 0 || p > 65535) return false;
+        port = (uint16_t)p;
+    }
+
+    // Internationalized names would need punycode; leave those to the browser
+    for (char& c : host) {
+        if ((unsigned char)c >= 0x80) return false;
+        c = (char)tolower((unsigned char)c);
+    }
+    return !host.empty();
+}
+
+std::vector<std::string> Prewarmer::SystemResolve(const std::string& host) {
+    std::vector<std::string> addresses;
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* info = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &info) != 0) {
+        return addresses;
+    }
+    for (addrinfo* ai = info; ai; ai = ai->ai_next) {
+        char text[NI_MAXHOST];
+        if (getnameinfo(ai->ai_addr, (socklen_t)ai->ai_addrlen, text, sizeof(text), nullptr, 0, NI_NUMERICHOST) == 0
+            && std::find(addresses.begin(), addresses.end(), text) == addresses.end()) {
+            addresses.push_back(text);
+        }
+    }
+    freeaddrinfo(info);
+    return addresses;
+}
+
+bool Prewarmer::Start(const std::wstring& url, int timeoutMs) {
+    std::string host;
+    uint16_t port = 0;
+    if (m_state || !ParseOrigin(url, host, port)) {
+        return false;
+    }
+
+    m_state = std::make_shared<State>();
+    std::thread(&Prewarmer::Run, m_state, host, port, m_resolver, timeoutMs).detach();
+    return true;
+}
+
+void Prewarmer::Run(std::shared_ptr<State> state, std::string host, uint16_t port,
+    Resolver resolver, int timeoutMs) {
+#ifdef _WIN32
+    WSADATA wsa;
+    bool winsock = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+#endif
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(timeoutMs);
+    PrewarmResult result;
+
+    std::vector<std::string> addresses = resolver(host);
+    result.dnsMs = MillisecondsSince(start);
+    result.addressCount = addresses.size();
+    result.resolved = !addresses.empty();
+
+    // Try addresses in resolver order until one connects, like the browser will
+    Clock::time_point connectStart = Clock::now();
+    ConnectStatus status = Clock::now() >= deadline ? ConnectStatus::TimedOut : ConnectStatus::Failed;
+    for (size_t i = 0; i < addresses.size() && status == ConnectStatus::Failed; ++i) {
+        status = state->cancel ? ConnectStatus::Cancelled : ConnectOnce(addresses[i], port, state->cancel, deadline);
+    }
+    if (result.resolved) {
+        result.connectMs = MillisecondsSince(connectStart);
+    }
+    result.connected = status == ConnectStatus::Connected;
+    result.cancelled = status == ConnectStatus::Cancelled || (!result.connected && state->cancel);
+    result.timedOut = status == ConnectStatus::TimedOut;
+
+#ifdef _WIN32
+    if (winsock) WSACleanup();
+#endif
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->result = result;
+    state->finished = true;
+    state->done.notify_all();
+}
+
+void Prewarmer::Cancel() {
+    if (m_state) {
+        m_state->cancel = true;
+    }
+}
+
+bool Prewarmer::Wait(int timeoutMs) {
+    if (!m_state) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    return m_state->done.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+        [this] { return m_state->finished; });
+}
+
+PrewarmResult Prewarmer::Result() const {
+    if (!m_state) {
+        return PrewarmResult();
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->result;
+}
+
+bool Prewarmer::Finished() const {
+    if (!m_state) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->finished;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct PrewarmResult {
+    bool resolved = false;
+    bool connected = false;
+    bool timedOut = false;
+    bool cancelled = false;
+    size_t addressCount = 0;
+    double dnsMs = 0;
+    double connectMs = 0;
+};
+
+// Resolves the origin of a URL and opens (then closes) a TCP connection to it
+// on a background thread, so the OS resolver cache and the network path are
+// warm by the time the browser makes its first request.
+//
+// Work is bounded by a deadline and can be cancelled; the thread never
+// outlives its shared state, so the Prewarmer can be destroyed at any time.
+// A resolver stuck past the deadline is abandoned rather than joined.
+class Prewarmer {
+public:
+    // Returns numeric addresses for host ("127.0.0.1", "::1", ...)
+    using Resolver = std::function<std::vector<std::string>(const std::string& host)>;
+
+    Prewarmer();
+    ~Prewarmer();
+
+    Prewarmer(const Prewarmer&) = delete;
+    Prewarmer& operator=(const Prewarmer&) = delete;
+
+    // Starts prewarming url's origin. Returns false (and does nothing) for
+    // non-http(s) URLs or if already started.
+    bool Start(const std::wstring& url, int timeoutMs);
+
+    // Stops outstanding work as soon as possible
+    void Cancel();
+
+    // Waits up to timeoutMs for the work to finish; true if it did
+    bool Wait(int timeoutMs);
+
+    // Snapshot of the result so far
+    PrewarmResult Result() const;
+    bool Finished() const;
+
+    // Replaces getaddrinfo (for tests with a simulated slow resolver)
+    void SetResolver(Resolver resolver) { m_resolver = std::move(resolver); }
+
+    // Splits an http(s) URL into lowercase host and port
+    static bool ParseOrigin(const std::wstring& url, std::string& host, uint16_t& port);
+
+    static std::vector<std::string> SystemResolve(const std::string& host);
+
+private:
+    struct State {
+        std::atomic<bool> cancel{ false };
+        mutable std::mutex mutex;
+        std::condition_variable done;
+        bool finished = false;
+        PrewarmResult result;
+    };
+
+    static void Run(std::shared_ptr<State> state, std::string host, uint16_t port,
+        Resolver resolver, int timeoutMs);
+
+    std::shared_ptr<State> m_state;
+    Resolver m_resolver;
+};
@@ -0,0 +1,172 @@
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+Rasterizer::Rasterizer(int width, int height)
+    : m_width(width), m_height(height), m_rows(height > 0 ? height : 0) {}
+
+void Rasterizer::Clear() {
+    for (auto& row : m_rows) row.clear();
+}
+
+void Rasterizer::AddPolygon(const std::vector<RasterPoint>& points) {
+    if (points.size() < 2) return;
+
+    // Dropping single edges would leave the loop open and smear winding
+    // across the rest of the row, so a polygon with any non-finite point
+    // (overflowed stroke expansion, say) is skipped whole
+    for (const RasterPoint& p : points) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)) return;
+    }
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        AddLine(points[i], points[i + 1]);
+    }
+    AddLine(points.back(), points.front());
+}
+
+void Rasterizer::AddLine(RasterPoint p0, RasterPoint p1) {
+    if (p0.y == p1.y) return;
+    if (!(std::isfinite(p0.x) && std::isfinite(p0.y) && std::isfinite(p1.x) && std::isfinite(p1.y))) return;
+
+    // Split where the edge crosses the canvas borders. Pieces left or right
+    // of it are clamped to vertical edges on the border, which keeps the
+    // winding of pixels inside intact; pieces above or below are clamped
+    // flat and contribute nothing. Done in double: differences of huge
+    // float coordinates overflow float.
+    const double w = m_width, h = m_height;
+    const double x0 = p0.x, y0 = p0.y;
+    const double dx = (double)p1.x - x0;
+    const double dy = (double)p1.y - y0;
+    double ts[6] = { 0.0 };
+    int n = 1;
+    const double cuts[4] = { dx != 0.0 ? (0.0 - x0) / dx : -1.0, dx != 0.0 ? (w - x0) / dx : -1.0,
+                             (0.0 - y0) / dy, (h - y0) / dy };
+    for (double t : cuts) {
+        if (!(t > 0.0 && t < 1.0)) continue;
+        int j = n++;
+        for (; ts[j - 1] > t; j--) ts[j] = ts[j - 1];
+        ts[j] = t;
+    }
+    ts[n++] = 1.0;
+
+    for (int i = 0; i + 1 < n; i++) {
+        double ax = x0 + dx * ts[i], ay = y0 + dy * ts[i];
+        double bx = x0 + dx * ts[i + 1], by = y0 + dy * ts[i + 1];
+        if (!(std::isfinite(ax) && std::isfinite(ay) && std::isfinite(bx) && std::isfinite(by))) continue;
+        RasterPoint a = { (float)std::min(std::max(ax, 0.0), w), (float)std::min(std::max(ay, 0.0), h) };
+        RasterPoint b = { (float)std::min(std::max(bx, 0.0), w), (float)std::min(std::max(by, 0.0), h) };
+        AddClipped(a, b);
+    }
+}
+
+void Rasterizer::Deposit(int y, int x, float delta) {
+    if (x >= m_width) return;  // Right of the canvas: never integrated
+    if (x < 0) x = 0;          // AddLine clips to x >= 0; only rounding gets here
+    m_rows[y].push_back({ x, delta });
+}
+
+// Signed area accumulation per scanline (the technique used by font-rs)
+void Rasterizer::AddClipped(RasterPoint p0, RasterPoint p1) {
+    if (p0.y == p1.y) return;
+
+    float dir = 1.0f;
+    if (p0.y > p1.y) {
+        std::swap(p0, p1);
+        dir = -1.0f;
+    }
+    if (p1.y <= 0.0f || p0.y >= (float)m_height) return;
+
+    const float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+    float x = p0.x;
+    int yStart = 0;
+    if (p0.y < 0.0f) {
+        x -= p0.y * dxdy;
+    } else {
+        yStart = (int)p0.y;
+    }
+    int yEnd = std::min(m_height, (int)std::ceil(p1.y));
+
+    for (int y = yStart; y < yEnd; y++) {
+        float dy = std::min((float)(y + 1), p1.y) - std::max((float)y, p0.y);
+        float xNext = x + dxdy * dy;
+        float d = dy * dir;
+        float x0 = std::min(x, xNext);
+        float x1 = std::max(x, xNext);
+        float x0Floor = std::floor(x0);
+        int x0i = (int)x0Floor;
+        float x1Ceil = std::ceil(x1);
+        int x1i = (int)x1Ceil;
+
+        if (x1i <= x0i + 1) {
+            // Edge stays within one pixel column on this row
+            float xmf = 0.5f * (x + xNext) - x0Floor;
+            Deposit(y, x0i, d - d * xmf);
+            Deposit(y, x0i + 1, d * xmf);
+        } else {
+            float s = 1.0f / (x1 - x0);
+            float x0f = x0 - x0Floor;
+            float a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+            float x1f = x1 - x1Ceil + 1.0f;
+            float am = 0.5f * s * x1f * x1f;
+            Deposit(y, x0i, d * a0);
+            if (x1i == x0i + 2) {
+                Deposit(y, x0i + 1, d * (1.0f - a0 - am));
+            } else {
+                float a1 = s * (1.5f - x0f);
+                Deposit(y, x0i + 1, d * (a1 - a0));
+                for (int xi = x0i + 2; xi < x1i - 1; xi++) {
+                    Deposit(y, xi, d * s);
+                }
+                float a2 = a1 + (float)(x1i - x0i - 3) * s;
+                Deposit(y, x1i - 1, d * (1.0f - a2 - am));
+            }
+            Deposit(y, x1i, d * am);
+        }
+        x = xNext;
+    }
+}
+
+void Rasterizer::Sweep(FillRule rule, const SpanFunc& span) {
+    for (int y = 0; y < m_height; y++) {
+        std::vector<Cell>& cells = m_rows[y];
+        if (cells.empty()) continue;
+
+        std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return a.x < b.x; });
+
+        // Deposit keeps cells within [0, width), so spans never leave the canvas
+        const int x0 = std::max(0, std::min(cells.front().x, m_width));
+        const int x1 = m_width;
+        if (x0 >= x1) continue;
+        m_coverage.assign((size_t)(x1 - x0), 0.0f);
+
+        float acc = 0.0f;
+        size_t ci = 0;
+        int last = x0;
+        for (int x = x0; x < x1; x++) {
+            while (ci < cells.size() && cells[ci].x == x) {
+                acc += cells[ci++].delta;
+            }
+            float a = std::fabs(acc);
+            if (rule == FillRule::EvenOdd) {
+                a = std::fmod(a, 2.0f);
+                if (a > 1.0f) a = 2.0f - a;
+            } else if (a > 1.0f) {
+                a = 1.0f;
+            }
+            m_coverage[x - x0] = a;
+            if (a > 1e-4f) last = x + 1;
+
+            // Past the final cell the accumulated winding is constant
+            if (ci == cells.size()) {
+                if (a <= 1e-4f) break;
+                std::fill(m_coverage.begin() + (x - x0), m_coverage.end(), a);
+                last = x1;
+                break;
+            }
+        }
+
+        if (last > x0) {
+            span(y, x0, last, m_coverage.data());
+        }
+    }
+}
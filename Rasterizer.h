@@ -0,0 +1,45 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+struct RasterPoint {
+    float x;
+    float y;
+};
+
+enum class FillRule { NonZero, EvenOdd };
+
+// Anti-aliasing polygon rasterizer based on a sparse scanline accumulator.
+// Each edge deposits signed area deltas into per-row cell lists; sweeping a
+// row integrates them into exact per-pixel coverage.
+class Rasterizer {
+public:
+    // Receives coverage in [0,1] for pixels x0..x1-1 of row y
+    typedef std::function<void(int y, int x0, int x1, const float* coverage)> SpanFunc;
+
+    Rasterizer(int width, int height);
+
+    void Clear();
+
+    // Adds one edge in device space; edges of each polygon must form closed loops
+    void AddLine(RasterPoint p0, RasterPoint p1);
+
+    // Adds a closed polygon (last point connects back to the first)
+    void AddPolygon(const std::vector<RasterPoint>& points);
+
+    void Sweep(FillRule rule, const SpanFunc& span);
+
+private:
+    struct Cell {
+        int x;
+        float delta;
+    };
+
+    int m_width;
+    int m_height;
+    std::vector<std::vector<Cell>> m_rows;
+    std::vector<float> m_coverage;
+
+    void AddClipped(RasterPoint p0, RasterPoint p1);
+    void Deposit(int y, int x, float delta);
+};
@@ -0,0 +1,90 @@
+#include "RedirectCache.h"
+#include "Utf8.h"
+#include <cwctype>
+
+namespace {
+
+const char kKeyPrefix[] = "redirect:";
+
+// Query/fragment parameters that carry single-use or secret values
+const wchar_t* const kSensitiveParams[] = {
+    L"code", L"state", L"nonce", L"token", L"access_token", L"id_token", L"refresh_token",
+    L"ticket", L"samlresponse", L"samlrequest", L"session_state", L"sig", L"signature",
+    L"password", L"otp",
+};
+
+std::wstring Lower(std::wstring s) {
+    for (auto& c : s) c = (wchar_t)std::towlower(c);
+    return s;
+}
+
+std::wstring Scheme(const std::wstring& url) {
+    size_t colon = url.find(L"://");
+    return colon == std::wstring::npos ? L"" : Lower(url.substr(0, colon));
+}
+
+// True if any name=value pair in the query or fragment uses a sensitive name
+bool HasSensitiveParams(const std::wstring& url) {
+    size_t start = url.find_first_of(L"?#");
+    if (start == std::wstring::npos) return false;
+
+    std::wstring params = Lower(url.substr(start + 1));
+    size_t pos = 0;
+    while (pos <= params.size()) {
+        size_t end = params.find_first_of(L"&#?;", pos);
+        if (end == std::wstring::npos) end = params.size();
+        size_t eq = params.find(L'=', pos);
+        std::wstring name = params.substr(pos, (eq < end ? eq : end) - pos);
+        for (const wchar_t* s : kSensitiveParams) {
+            if (name == s) return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+RedirectCache::RedirectCache(KvStore& store, int64_t ttlSeconds)
+    : m_store(store), m_ttl(ttlSeconds) {}
+
+bool RedirectCache::IsReplayable(const std::wstring& target, const std::wstring& finalUrl) {
+    std::wstring from = Scheme(target);
+    std::wstring to = Scheme(finalUrl);
+    if ((from != L"http" && from != L"https") || (to != L"http" && to != L"https")) {
+        return false;
+    }
+    if (from == L"https" && to == L"http") {
+        return false;  // Never memoize a downgrade
+    }
+    return !HasSensitiveParams(finalUrl);
+}
+
+std::wstring RedirectCache::Lookup(const std::wstring& target) const {
+    std::string value;
+    if (!m_store.Get(kKeyPrefix + Utf8::FromWide(target), value)) {
+        return L"";
+    }
+    return Utf8::ToWide(value);
+}
+
+void RedirectCache::RecordSettled(const std::wstring& target, const std::wstring& finalUrl) {
+    std::string key = kKeyPrefix + Utf8::FromWide(target);
+    if (finalUrl.empty() || finalUrl == target || !IsReplayable(target, finalUrl)) {
+        m_store.Erase(key);
+        return;
+    }
+
+    // Unchanged entries aren't rewritten, so they still expire on schedule
+    // and the chain gets re-validated periodically
+    std::string current;
+    std::string value = Utf8::FromWide(finalUrl);
+    if (m_store.Get(key, current) && current == value) {
+        return;
+    }
+    m_store.Put(key, value, m_ttl);
+}
+
+void RedirectCache::Invalidate(const std::wstring& target) {
+    m_store.Erase(kKeyPrefix + Utf8::FromWide(target));
+}
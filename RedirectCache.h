@@ -0,0 +1,32 @@
+#pragma once
+#include "KvStore.h"
+#include <string>
+
+// Remembers where a launch target settles after its redirect chain, so the
+// next launch can navigate there directly.
+//
+// Only URLs that are safe to replay are kept: same or upgraded scheme
+// (http(s) only) and no one-time credentials such as OAuth codes, tokens
+// or SAML responses in the query or fragment.
+class RedirectCache {
+public:
+    static const int64_t kDefaultTtlSeconds = 7 * 24 * 60 * 60;
+
+    explicit RedirectCache(KvStore& store, int64_t ttlSeconds = kDefaultTtlSeconds);
+
+    // Memoized final URL for target, or empty
+    std::wstring Lookup(const std::wstring& target) const;
+
+    // Called once navigation from target has settled on finalUrl
+    void RecordSettled(const std::wstring& target, const std::wstring& finalUrl);
+
+    // Called when navigating to the memoized URL failed
+    void Invalidate(const std::wstring& target);
+
+    // Policy check used by RecordSettled
+    static bool IsReplayable(const std::wstring& target, const std::wstring& finalUrl);
+
+private:
+    KvStore& m_store;
+    int64_t m_ttl;
+};
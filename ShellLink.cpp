@@ -0,0 +1,191 @@
+#include "ShellLink.h"
+#include <cstring>
+
+namespace {
+
+const uint32_t kHeaderSize = 0x4C;
+const uint8_t kLinkClsid[16] = {
+    0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 };
+
+// LinkFlags
+const uint32_t kHasLinkTargetIDList = 0x00000001;
+const uint32_t kHasLinkInfo = 0x00000002;
+const uint32_t kHasName = 0x00000004;
+const uint32_t kHasRelativePath = 0x00000008;
+const uint32_t kHasWorkingDir = 0x00000010;
+const uint32_t kHasArguments = 0x00000020;
+const uint32_t kHasIconLocation = 0x00000040;
+const uint32_t kIsUnicode = 0x00000080;
+
+// ExtraData block signatures
+const uint32_t kEnvironmentBlock = 0xA0000001;
+const uint32_t kIconEnvironmentBlock = 0xA0000007;
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t len) : m_data(data), m_len(len), m_pos(0) {}
+
+    bool Has(size_t n) const { return m_pos <= m_len && m_len - m_pos >= n; }
+    size_t Pos() const { return m_pos; }
+    void Seek(size_t pos) { m_pos = pos; }
+    bool Skip(size_t n) {
+        if (!Has(n)) return false;
+        m_pos += n;
+        return true;
+    }
+
+    bool U16(uint16_t& v) {
+        if (!Has(2)) return false;
+        v = (uint16_t)(m_data[m_pos] | (m_data[m_pos + 1] << 8));
+        m_pos += 2;
+        return true;
+    }
+
+    bool U32(uint32_t& v) {
+        if (!Has(4)) return false;
+        v = (uint32_t)m_data[m_pos] | ((uint32_t)m_data[m_pos + 1] << 8) |
+            ((uint32_t)m_data[m_pos + 2] << 16) | ((uint32_t)m_data[m_pos + 3] << 24);
+        m_pos += 4;
+        return true;
+    }
+
+    const uint8_t* Ptr() const { return m_data + m_pos; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_len;
+    size_t m_pos;
+};
+
+// UTF-16LE code units to wstring (surrogates combined when wchar_t is 32-bit)
+std::wstring FromUtf16(const uint8_t* p, size_t units) {
+    std::wstring out;
+    out.reserve(units);
+    for (size_t i = 0; i < units; i++) {
+        uint32_t c = (uint32_t)(p[i * 2] | (p[i * 2 + 1] << 8));
+        if (sizeof(wchar_t) > 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < units) {
+            uint32_t lo = (uint32_t)(p[i * 2 + 2] | (p[i * 2 + 3] << 8));
+            if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+                i++;
+            }
+        }
+        out += (wchar_t)c;
+    }
+    return out;
+}
+
+// Null-terminated UTF-16LE within [p, p + maxBytes)
+std::wstring FromUtf16Z(const uint8_t* p, size_t maxBytes) {
+    size_t units = 0;
+    while ((units + 1) * 2 <= maxBytes && (p[units * 2] | p[units * 2 + 1])) units++;
+    return FromUtf16(p, units);
+}
+
+// Null-terminated system code page string; decoded as Latin-1, which is
+// exact for ASCII paths and close enough for comparisons otherwise
+std::wstring FromAnsiZ(const uint8_t* p, size_t maxBytes) {
+    std::wstring out;
+    for (size_t i = 0; i < maxBytes && p[i]; i++) out += (wchar_t)p[i];
+    return out;
+}
+
+bool ReadStringData(Reader& r, bool unicode, std::wstring& out) {
+    uint16_t count;
+    if (!r.U16(count)) return false;
+    size_t bytes = unicode ? (size_t)count * 2 : count;
+    if (!r.Has(bytes)) return false;
+    if (unicode) {
+        out = FromUtf16(r.Ptr(), count);
+    } else {
+        out.clear();
+        for (size_t i = 0; i < count; i++) out += (wchar_t)r.Ptr()[i];
+    }
+    return r.Skip(bytes);
+}
+
+bool ReadLinkInfo(Reader& r, ShellLinkInfo& info) {
+    size_t start = r.Pos();
+    uint32_t size, headerSize, flags, volumeIdOffset, localBaseOffset, networkOffset, suffixOffset;
+    if (!r.U32(size) || size < 0x1C || !r.Has(size - 4)) return false;
+    if (!r.U32(headerSize) || !r.U32(flags) || !r.U32(volumeIdOffset) ||
+        !r.U32(localBaseOffset) || !r.U32(networkOffset) || !r.U32(suffixOffset)) {
+        return false;
+    }
+
+    uint32_t localBaseOffsetUnicode = 0;
+    if (headerSize >= 0x24) {
+        uint32_t suffixOffsetUnicode;
+        if (!r.U32(localBaseOffsetUnicode) || !r.U32(suffixOffsetUnicode)) return false;
+    }
+
+    r.Seek(start);
+    const uint8_t* base = r.Ptr();
+    if (flags & 1) {  // VolumeIDAndLocalBasePath
+        if (localBaseOffsetUnicode && localBaseOffsetUnicode < size) {
+            info.targetPath = FromUtf16Z(base + localBaseOffsetUnicode, size - localBaseOffsetUnicode);
+        } else if (localBaseOffset && localBaseOffset < size) {
+            info.targetPath = FromAnsiZ(base + localBaseOffset, size - localBaseOffset);
+        }
+    }
+    return r.Skip(size);
+}
+
+} // namespace
+
+bool ShellLink::Parse(const uint8_t* data, size_t len, ShellLinkInfo& info) {
+    info = ShellLinkInfo();
+    Reader r(data, len);
+
+    uint32_t headerSize;
+    if (!r.U32(headerSize) || headerSize != kHeaderSize || !r.Has(kHeaderSize - 4)) return false;
+    if (memcmp(r.Ptr(), kLinkClsid, 16) != 0) return false;
+    r.Skip(16);
+
+    uint32_t flags, attributes, iconIndex;
+    r.U32(flags);
+    r.U32(attributes);
+    r.Skip(24);            // Creation, access and write times
+    r.Skip(4);             // FileSize
+    r.U32(iconIndex);
+    info.iconIndex = (int)(int32_t)iconIndex;
+    r.Skip(4 + 2 + 2 + 4 + 4);  // ShowCommand, HotKey, reserved
+
+    if (flags & kHasLinkTargetIDList) {
+        uint16_t idListSize;
+        if (!r.U16(idListSize) || !r.Skip(idListSize)) return false;
+    }
+
+    if (flags & kHasLinkInfo) {
+        if (!ReadLinkInfo(r, info)) return false;
+    }
+
+    bool unicode = (flags & kIsUnicode) != 0;
+    if ((flags & kHasName) && !ReadStringData(r, unicode, info.description)) return false;
+    if ((flags & kHasRelativePath) && !ReadStringData(r, unicode, info.relativePath)) return false;
+    if ((flags & kHasWorkingDir) && !ReadStringData(r, unicode, info.workingDir)) return false;
+    if ((flags & kHasArguments) && !ReadStringData(r, unicode, info.arguments)) return false;
+    if ((flags & kHasIconLocation) && !ReadStringData(r, unicode, info.iconLocation)) return false;
+
+    // ExtraData: size-prefixed blocks terminated by a size below 4
+    uint32_t blockSize;
+    while (r.U32(blockSize) && blockSize >= 8) {
+        size_t blockStart = r.Pos() - 4;
+        uint32_t signature;
+        if (!r.Has(blockSize - 4) || !r.U32(signature)) break;
+
+        // Both blocks: TargetAnsi[260] followed by TargetUnicode[520 bytes]
+        if ((signature == kEnvironmentBlock || signature == kIconEnvironmentBlock) && blockSize >= 0x314) {
+            std::wstring target = FromUtf16Z(r.Ptr() + 260, 520);
+            if (target.empty()) target = FromAnsiZ(r.Ptr(), 260);
+            if (signature == kEnvironmentBlock && info.targetPath.empty()) info.targetPath = target;
+            if (signature == kIconEnvironmentBlock) {
+                info.iconEnvironment = target;
+                if (info.iconLocation.empty()) info.iconLocation = target;
+            }
+        }
+        r.Seek(blockStart + blockSize);
+    }
+    return true;
+}
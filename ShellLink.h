@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fields of a Windows .lnk file that shortcut reconciliation compares
+struct ShellLinkInfo {
+    std::wstring targetPath;     // LinkInfo local base path, else environment block target (%VARIABLES% unexpanded)
+    std::wstring description;    // NAME_STRING
+    std::wstring relativePath;
+    std::wstring workingDir;
+    std::wstring arguments;
+    std::wstring iconLocation;   // As stored; may hold %VARIABLES% (HasExpIcon), else the icon block target
+    std::wstring iconEnvironment;  // IconEnvironmentDataBlock target, %VARIABLES% unexpanded
+    int iconIndex = 0;
+};
+
+// Portable reader for the Shell Link binary format ([MS-SHLLINK]).
+// Only the header, LinkInfo, StringData and the environment/icon-environment
+// extra data blocks are interpreted; everything else is skipped by size.
+class ShellLink {
+public:
+    static bool Parse(const uint8_t* data, size_t len, ShellLinkInfo& info);
+};
@@ -1,71 +1,137 @@
 #include "ShortcutHelper.h"
 #include "IconHelper.h"
+#include "FileUtil.h"
+#include "Manifest.h"
+#include "ShortcutSync.h"
+#include "ManifestWatcher.h"
+#include "WorkerPool.h"
 #include <windows.h>
 #include <shobjidl.h>
 #include <shlobj.h>
 #include <shlguid.h>
 #include <objbase.h>
 #include <strsafe.h>
+#include <chrono>
 #include <iostream>
+#include <thread>
+
+// Watcher interrupted by Ctrl+C while --watch runs
+static ManifestWatcher* g_activeWatcher = nullptr;
+
+static BOOL WINAPI StopWatching(DWORD ctrlType) {
+    if (g_activeWatcher && (ctrlType == CTRL_C_EVENT || ctrlType == CTRL_BREAK_EVENT)) {
+        g_activeWatcher->Stop();
+        return TRUE;
+    }
+    return FALSE;
+}
+
+std::wstring ShortcutHelper::GetDesktopPath() {
+    // Get the Desktop folder path properly using Windows API
+    wchar_t desktopPath[MAX_PATH];
+    HRESULT hr = SHGetFolderPathW(nullptr, CSIDL_DESKTOPDIRECTORY, nullptr, 0, desktopPath);
+    if (FAILED(hr)) {
+        std::wcerr << L"Error: Failed to get desktop folder path. HRESULT: 0x"
+                   << std::hex << hr << std::dec << L"\n";
+        return L"";
+    }
+    return desktopPath;
+}
+
+std::wstring ShortcutHelper::GetAbsolutePath(const std::wstring& path) {
+    wchar_t absPath[MAX_PATH];
+    DWORD result = GetFullPathNameW(path.c_str(), MAX_PATH, absPath, nullptr);
+    if (result > 0 && result < MAX_PATH) {
+        return absPath;
+    }
+    // Fallback to original path if conversion fails
+    return path;
+}
+
+std::wstring ShortcutHelper::GetExePath() {
+    wchar_t exePath[MAX_PATH];
+    if (GetModuleFileNameW(nullptr, exePath, MAX_PATH) == 0) {
+        std::wcerr << L"Error: Failed to get module file name.\n";
+        return L"";
+    }
+    return exePath;
+}
+
+bool ShortcutHelper::SaveShortcut(const std::wstring& shortcutPath,
+    const std::wstring& arguments,
+    const std::wstring& iconLocation,
+    const std::wstring& description) {
 
-void ShortcutHelper::CreateShortcut(const std::wstring& name,
-    const std::wstring& iconPath,
-    const std::wstring& targetUrl) {
-    
     // Don't call CoInitialize here as it's already initialized in main via CoInitializeEx()
-    
+
+    std::wstring exePath = GetExePath();
+    if (exePath.empty()) {
+        return false;
+    }
+
     IShellLinkW* pLink = nullptr;
     HRESULT hr = CoCreateInstance(CLSID_ShellLink, nullptr, CLSCTX_INPROC_SERVER,
         IID_IShellLinkW, (LPVOID*)&pLink);
-    
+
     if (FAILED(hr)) {
-        std::wcerr << L"Error: Failed to create shell link instance. HRESULT: 0x" 
+        std::wcerr << L"Error: Failed to create shell link instance. HRESULT: 0x"
                    << std::hex << hr << std::dec << L"\n";
-        return;
+        return false;
     }
 
-    wchar_t exePath[MAX_PATH];
-    if (GetModuleFileNameW(nullptr, exePath, MAX_PATH) == 0) {
-        std::wcerr << L"Error: Failed to get module file name.\n";
-        pLink->Release();
-        return;
+    pLink->SetPath(exePath.c_str());
+    pLink->SetArguments(arguments.c_str());
+    pLink->SetDescription(description.c_str());
+    if (!iconLocation.empty()) {
+        pLink->SetIconLocation(iconLocation.c_str(), 0);
     }
 
-    // Build arguments string with absolute icon path
-    std::wstring args = L"--target \"" + targetUrl + L"\"";
-    if (!name.empty()) {
-        args += L" --name \"" + name + L"\"";
+    IPersistFile* pFile = nullptr;
+    hr = pLink->QueryInterface(IID_IPersistFile, (LPVOID*)&pFile);
+
+    if (SUCCEEDED(hr)) {
+        hr = pFile->Save(shortcutPath.c_str(), TRUE);
+        if (FAILED(hr)) {
+            std::wcerr << L"Error: Failed to save shortcut. HRESULT: 0x"
+                       << std::hex << hr << std::dec << L"\n";
+        }
+        pFile->Release();
+    } else {
+        std::wcerr << L"Error: Failed to query IPersistFile interface. HRESULT: 0x"
+                   << std::hex << hr << std::dec << L"\n";
     }
-    
+
+    pLink->Release();
+
+    // Don't call CoUninitialize here as COM is managed in main
+    return SUCCEEDED(hr);
+}
+
+void ShortcutHelper::CreateShortcut(const std::wstring& name,
+    const std::wstring& iconPath,
+    const std::wstring& targetUrl,
+    const std::wstring& profile) {
+
     // Convert icon path to absolute before adding to arguments
     std::wstring absoluteIconPath;
     if (!iconPath.empty()) {
-        wchar_t absPath[MAX_PATH];
-        DWORD result = GetFullPathNameW(iconPath.c_str(), MAX_PATH, absPath, nullptr);
-        if (result > 0 && result < MAX_PATH) {
-            absoluteIconPath = absPath;
-            args += L" --icon \"" + absoluteIconPath + L"\"";
-        } else {
-            // Fallback to original path if conversion fails
-            absoluteIconPath = iconPath;
-            args += L" --icon \"" + iconPath + L"\"";
-        }
+        absoluteIconPath = GetAbsolutePath(iconPath);
     }
 
-    pLink->SetPath(exePath);
-    pLink->SetArguments(args.c_str());
-    
+    std::wstring args = ShortcutSync::BuildArguments(targetUrl, name, absoluteIconPath, profile);
+
+    std::wstring iconLocation;
     if (!absoluteIconPath.empty()) {
         // Validate icon path exists before setting
         if (GetFileAttributesW(absoluteIconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
             // Get the ICO path (converts PNG if needed)
             std::wstring finalIconPath = IconHelper::GetConvertedIconPath(absoluteIconPath);
-            
+
             if (!finalIconPath.empty() && GetFileAttributesW(finalIconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                pLink->SetIconLocation(finalIconPath.c_str(), 0);
-                
-                if (IconHelper::IsPngFile(absoluteIconPath)) {
-                    std::wcout << L"Converted PNG icon to ICO format for shortcut\n";
+                iconLocation = finalIconPath;
+
+                if (IconHelper::NeedsConversion(absoluteIconPath)) {
+                    std::wcout << L"Converted icon to ICO format for shortcut\n";
                     std::wcout << L"Absolute icon path in shortcut: " << absoluteIconPath << L"\n";
                 }
             } else {
@@ -76,36 +142,207 @@ void ShortcutHelper::CreateShortcut(const std::wstring& name,
         }
     }
 
-    IPersistFile* pFile = nullptr;
-    hr = pLink->QueryInterface(IID_IPersistFile, (LPVOID*)&pFile);
-    
-    if (SUCCEEDED(hr)) {
-        // Get the Desktop folder path properly using Windows API
-        wchar_t desktopPath[MAX_PATH];
-        hr = SHGetFolderPathW(nullptr, CSIDL_DESKTOPDIRECTORY, nullptr, 0, desktopPath);
-        
-        if (SUCCEEDED(hr)) {
-            std::wstring shortcutPath = std::wstring(desktopPath) + L"\\" + name + L".lnk";
-            hr = pFile->Save(shortcutPath.c_str(), TRUE);
-            
-            if (SUCCEEDED(hr)) {
-                std::wcout << L"Shortcut created successfully at: " << shortcutPath << L"\n";
+    std::wstring desktopPath = GetDesktopPath();
+    if (desktopPath.empty()) {
+        return;
+    }
+
+    // Stamp the link so a later --sync recognizes it and its icon version
+    std::wstring shortcutPath = FileUtil::Join(desktopPath, name + L".lnk");
+    std::wstring description = ShortcutSync::Description(ShortcutSync::HashFile(absoluteIconPath));
+    if (SaveShortcut(shortcutPath, args, iconLocation, description)) {
+        std::wcout << L"Shortcut created successfully at: " << shortcutPath << L"\n";
+    }
+}
+
+std::wstring ShortcutHelper::BuildSpec(const ManifestEntry& entry, ShortcutSpec& spec) {
+    spec.name = entry.name;
+
+    std::wstring absoluteIconPath;
+    if (!entry.icon.empty()) {
+        absoluteIconPath = GetAbsolutePath(entry.icon);
+        if (GetFileAttributesW(absoluteIconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
+            spec.iconLocation = IconHelper::GetConvertedIconPath(absoluteIconPath);
+            spec.iconHash = ShortcutSync::HashFile(absoluteIconPath);
+        } else {
+            std::wcerr << L"Warning: Icon file not found for " << entry.name << L": "
+                       << absoluteIconPath << L"\n";
+        }
+    }
+    // Optional "profile = <group>" shares one browser profile between apps
+    auto profile = entry.extra.find(L"profile");
+    spec.arguments = ShortcutSync::BuildArguments(entry.target, entry.name, absoluteIconPath,
+        profile != entry.extra.end() ? profile->second : L"");
+    return absoluteIconPath;
+}
+
+bool ShortcutHelper::SyncShortcuts(const std::wstring& manifestPath, const std::wstring& folder) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<ManifestEntry> entries;
+    std::wstring error;
+    if (!Manifest::Load(manifestPath, entries, error)) {
+        std::wcerr << L"Error: " << error << L"\n";
+        return false;
+    }
+
+    std::wstring dir = folder.empty() ? GetDesktopPath() : GetAbsolutePath(folder);
+    std::wstring exePath = GetExePath();
+    if (dir.empty() || exePath.empty()) {
+        return false;
+    }
+
+    // Desired state. Converted icons are cached in the temp directory, so
+    // this only rasterizes icons that have never been converted before.
+    std::vector<ShortcutSpec> desired;
+    std::vector<std::wstring> sourceIcons;
+    for (const auto& entry : entries) {
+        ShortcutSpec spec;
+        sourceIcons.push_back(BuildSpec(entry, spec));
+        desired.push_back(spec);
+    }
+
+    std::vector<ExistingShortcut> existing;
+    if (!ShortcutSync::LoadExisting(dir, existing)) {
+        std::wcerr << L"Error: Failed to read shortcut folder: " << dir << L"\n";
+        return false;
+    }
+
+    std::vector<SyncStep> steps = ShortcutSync::Plan(desired, existing, exePath);
+
+    int created = 0, updated = 0, deleted = 0, unchanged = 0, failed = 0;
+    for (const auto& step : steps) {
+        std::wstring shortcutPath = FileUtil::Join(dir, step.name + L".lnk");
+
+        if (step.action == SyncAction::Keep) {
+            unchanged++;
+            continue;
+        }
+
+        if (step.action == SyncAction::Delete) {
+            if (FileUtil::Remove(shortcutPath)) {
+                std::wcout << L"Deleted: " << step.name << L"\n";
+                deleted++;
             } else {
-                std::wcerr << L"Error: Failed to save shortcut. HRESULT: 0x" 
-                           << std::hex << hr << std::dec << L"\n";
+                std::wcerr << L"Error: Failed to delete shortcut: " << shortcutPath << L"\n";
+                failed++;
             }
+            continue;
+        }
+
+        const ShortcutSpec& spec = desired[step.specIndex];
+        const std::wstring& sourceIcon = sourceIcons[step.specIndex];
+
+        // The converted ICO is cached by source path, so refresh it when the
+        // icon contents may have changed in place
+        if (step.action == SyncAction::Update && !spec.iconHash.empty() &&
+            IconHelper::NeedsConversion(sourceIcon)) {
+            IconHelper::ConvertToIco(sourceIcon, spec.iconLocation);
+        }
+
+        if (!SaveShortcut(shortcutPath, spec.arguments, spec.iconLocation,
+                ShortcutSync::Description(spec.iconHash))) {
+            failed++;
+        } else if (step.action == SyncAction::Create) {
+            std::wcout << L"Created: " << step.name << L"\n";
+            created++;
         } else {
-            std::wcerr << L"Error: Failed to get desktop folder path. HRESULT: 0x" 
-                       << std::hex << hr << std::dec << L"\n";
+            std::wcout << L"Updated: " << step.name << L"\n";
+            updated++;
         }
-        
-        pFile->Release();
-    } else {
-        std::wcerr << L"Error: Failed to query IPersistFile interface. HRESULT: 0x" 
-                   << std::hex << hr << std::dec << L"\n";
     }
-    
-    pLink->Release();
-    
-    // Don't call CoUninitialize here as COM is managed in main
-}
\ No newline at end of file
+
+    if (created + updated + deleted > 0) {
+        SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_PATHW, dir.c_str(), nullptr);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::wcout << L"Sync complete: " << created << L" created, " << updated << L" updated, "
+               << deleted << L" deleted, " << unchanged << L" unchanged";
+    if (failed > 0) {
+        std::wcout << L", " << failed << L" failed";
+    }
+    std::wcout << L" (" << elapsed << L" ms)\n";
+    return failed == 0;
+}
+
+bool ShortcutHelper::UpdateShortcut(const ManifestEntry& entry, const std::wstring& dir, bool iconChanged) {
+    ShortcutSpec spec;
+    std::wstring sourceIcon = BuildSpec(entry, spec);
+
+    // Converted icons are cached by size and modification time, which can
+    // miss two saves within the same second
+    if (iconChanged && !spec.iconLocation.empty() && IconHelper::NeedsConversion(sourceIcon)) {
+        IconHelper::ConvertToIco(sourceIcon, spec.iconLocation);
+    }
+
+    std::wstring shortcutPath = FileUtil::Join(dir, spec.name + L".lnk");
+    if (!SaveShortcut(shortcutPath, spec.arguments, spec.iconLocation,
+            ShortcutSync::Description(spec.iconHash))) {
+        return false;
+    }
+    SHChangeNotify(SHCNE_UPDATEITEM, SHCNF_PATHW, shortcutPath.c_str(), nullptr);
+    return true;
+}
+
+bool ShortcutHelper::RemoveShortcut(const std::wstring& name, const std::wstring& dir) {
+    std::wstring shortcutPath = FileUtil::Join(dir, name + L".lnk");
+    std::string data;
+    ShellLinkInfo link;
+    if (!FileUtil::Read(shortcutPath, data)) {
+        return true;  // Already gone
+    }
+
+    // Never delete a link the user made themselves under the same name
+    if (!ShellLink::Parse((const uint8_t*)data.data(), data.size(), link) ||
+        !ShortcutSync::IsOwned(link, GetExePath())) {
+        std::wcerr << L"Warning: Leaving shortcut not created by WebWrap: " << shortcutPath << L"\n";
+        return true;
+    }
+    if (!FileUtil::Remove(shortcutPath)) {
+        std::wcerr << L"Error: Failed to delete shortcut: " << shortcutPath << L"\n";
+        return false;
+    }
+    SHChangeNotify(SHCNE_DELETE, SHCNF_PATHW, shortcutPath.c_str(), nullptr);
+    return true;
+}
+
+bool ShortcutHelper::WatchManifest(const std::wstring& manifestPath, const std::wstring& folder) {
+    // Start from a consistent state, then follow changes
+    if (!SyncShortcuts(manifestPath, folder)) {
+        return false;
+    }
+
+    std::wstring dir = folder.empty() ? GetDesktopPath() : GetAbsolutePath(folder);
+    if (dir.empty()) {
+        return false;
+    }
+
+    WatchActions actions;
+    actions.updateApp = [dir](const ManifestEntry& entry, bool iconChanged) {
+        return UpdateShortcut(entry, dir, iconChanged);
+    };
+    actions.removeApp = [dir](const std::wstring& name) {
+        return RemoveShortcut(name, dir);
+    };
+
+    // Shell links are COM objects, so every worker needs its own apartment
+    unsigned threads = std::thread::hardware_concurrency();
+    WorkerPool pool(threads == 0 ? 1 : threads > 4 ? 4 : threads,
+        []() { CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE); },
+        []() { CoUninitialize(); });
+
+    ManifestWatcher watcher(manifestPath, actions, pool);
+    if (!watcher.Start()) {
+        return false;
+    }
+
+    g_activeWatcher = &watcher;
+    SetConsoleCtrlHandler(StopWatching, TRUE);
+    std::wcout << L"Watching " << manifestPath << L" and its icons (Ctrl+C to stop)\n";
+    watcher.Run();
+    SetConsoleCtrlHandler(StopWatching, FALSE);
+    g_activeWatcher = nullptr;
+    return true;
+}
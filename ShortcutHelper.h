@@ -1,9 +1,40 @@
 #pragma once
 #include <string>
 
+struct ManifestEntry;
+struct ShortcutSpec;
+
 class ShortcutHelper {
 public:
     static void CreateShortcut(const std::wstring& name,
         const std::wstring& iconPath,
-        const std::wstring& targetUrl);
+        const std::wstring& targetUrl,
+        const std::wstring& profile = L"");
+
+    // Brings the shortcuts in folder (the Desktop if empty) in line with a
+    // manifest: only new or changed entries are written, and shortcuts this
+    // tool created that are no longer listed are deleted
+    static bool SyncShortcuts(const std::wstring& manifestPath, const std::wstring& folder);
+
+    // Syncs once, then keeps folder in line with the manifest and the icons
+    // it references until Ctrl+C, regenerating only the affected shortcuts
+    static bool WatchManifest(const std::wstring& manifestPath, const std::wstring& folder);
+
+    // Rewrites one app's shortcut in dir; iconChanged forces the icon to be
+    // converted again
+    static bool UpdateShortcut(const ManifestEntry& entry, const std::wstring& dir, bool iconChanged);
+
+    // Deletes the app's shortcut from dir if this tool created it
+    static bool RemoveShortcut(const std::wstring& name, const std::wstring& dir);
+
+private:
+    // Fills spec from a manifest entry; returns the absolute source icon path
+    static std::wstring BuildSpec(const ManifestEntry& entry, ShortcutSpec& spec);
+    static bool SaveShortcut(const std::wstring& shortcutPath,
+        const std::wstring& arguments,
+        const std::wstring& iconLocation,
+        const std::wstring& description);
+    static std::wstring GetDesktopPath();
+    static std::wstring GetAbsolutePath(const std::wstring& path);
+    static std::wstring GetExePath();
 };
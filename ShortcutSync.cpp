@@ -0,0 +1,185 @@
+#include "ShortcutSync.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Utf8.h"
+#include <cstdlib>
+#include <cwctype>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static const wchar_t kDescriptionPrefix[] = L"WebWrap ";
+
+// Shell file names and paths compare case-insensitively on Windows
+static std::wstring FoldCase(const std::wstring& s) {
+    std::wstring out(s);
+    for (auto& c : out) c = (wchar_t)std::towlower(c);
+    return out;
+}
+
+static bool EndsWithIgnoreCase(const std::wstring& s, const std::wstring& suffix) {
+    return s.size() >= suffix.size() &&
+        FoldCase(s.substr(s.size() - suffix.size())) == FoldCase(suffix);
+}
+
+static bool ProcessEnvironment(const std::wstring& name, std::wstring& value) {
+#ifdef _WIN32
+    DWORD needed = GetEnvironmentVariableW(name.c_str(), nullptr, 0);
+    if (!needed) {
+        return false;
+    }
+    value.assign(needed, L'\0');
+    DWORD written = GetEnvironmentVariableW(name.c_str(), &value[0], needed);
+    value.resize(written < needed ? written : 0);
+    return written < needed;
+#else
+    const char* raw = getenv(Utf8::FromWide(name).c_str());
+    if (!raw) {
+        return false;
+    }
+    value = Utf8::ToWide(raw);
+    return true;
+#endif
+}
+
+std::wstring ShortcutSync::ExpandEnvironment(const std::wstring& text, const EnvLookup& environment) {
+    std::wstring out;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t open = text.find(L'%', pos);
+        size_t close = open == std::wstring::npos ? open : text.find(L'%', open + 1);
+        if (close == std::wstring::npos) {
+            break;
+        }
+        out.append(text, pos, open - pos);
+
+        std::wstring name = text.substr(open + 1, close - open - 1);
+        std::wstring value;
+        bool found = !name.empty() &&
+            (environment ? environment(name, value) : ProcessEnvironment(name, value));
+        if (found) {
+            out += value;
+            pos = close + 1;
+        } else {
+            // Leave the '%' as written; the closing one may open the next name
+            out += L'%';
+            pos = open + 1;
+        }
+    }
+    out.append(text, pos, std::wstring::npos);
+    return out;
+}
+
+// Paths as the shell would resolve them, for comparison
+static std::wstring ResolvePath(const std::wstring& path, const ShortcutSync::EnvLookup& environment) {
+    return FoldCase(ShortcutSync::ExpandEnvironment(path, environment));
+}
+
+std::wstring ShortcutSync::Description(const std::wstring& iconHash) {
+    return kDescriptionPrefix + iconHash;
+}
+
+std::wstring ShortcutSync::BuildArguments(const std::wstring& target,
+    const std::wstring& name,
+    const std::wstring& iconPath,
+    const std::wstring& profile) {
+    std::wstring args = L"--target \"" + target + L"\"";
+    if (!name.empty()) {
+        args += L" --name \"" + name + L"\"";
+    }
+    if (!iconPath.empty()) {
+        args += L" --icon \"" + iconPath + L"\"";
+    }
+    if (!profile.empty()) {
+        args += L" --profile \"" + profile + L"\"";
+    }
+    return args;
+}
+
+std::wstring ShortcutSync::HashFile(const std::wstring& path) {
+    std::string data;
+    if (path.empty() || !FileUtil::Read(path, data)) {
+        return L"";
+    }
+
+    uint64_t h = Checksums::Fnv1a64(data.data(), data.size());
+    static const wchar_t kHex[] = L"0123456789abcdef";
+    std::wstring out(16, L'0');
+    for (int i = 15; i >= 0; i--) {
+        out[i] = kHex[h & 0xF];
+        h >>= 4;
+    }
+    return out;
+}
+
+bool ShortcutSync::LoadExisting(const std::wstring& dir, std::vector<ExistingShortcut>& existing) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) {
+        return false;
+    }
+
+    for (const auto& entry : entries) {
+        if (entry.isDirectory || !EndsWithIgnoreCase(entry.name, L".lnk")) {
+            continue;
+        }
+
+        std::string data;
+        ExistingShortcut shortcut;
+        if (!FileUtil::Read(FileUtil::Join(dir, entry.name), data) ||
+            !ShellLink::Parse((const uint8_t*)data.data(), data.size(), shortcut.link)) {
+            continue;
+        }
+        shortcut.name = entry.name.substr(0, entry.name.size() - 4);
+        existing.push_back(std::move(shortcut));
+    }
+    return true;
+}
+
+std::vector<SyncStep> ShortcutSync::Plan(const std::vector<ShortcutSpec>& desired,
+    const std::vector<ExistingShortcut>& existing,
+    const std::wstring& exePath,
+    const EnvLookup& environment) {
+    std::wstring exe = ResolvePath(exePath, environment);
+    std::map<std::wstring, size_t> byName;
+    for (size_t i = 0; i < existing.size(); i++) {
+        byName[FoldCase(existing[i].name)] = i;
+    }
+
+    std::vector<SyncStep> steps;
+    std::vector<bool> claimed(existing.size(), false);
+    for (size_t i = 0; i < desired.size(); i++) {
+        const ShortcutSpec& spec = desired[i];
+        auto found = byName.find(FoldCase(spec.name));
+        if (found == byName.end()) {
+            steps.push_back({ SyncAction::Create, spec.name, i });
+            continue;
+        }
+
+        claimed[found->second] = true;
+        const ShellLinkInfo& link = existing[found->second].link;
+        // The shell may store the icon as %USERPROFILE%\...; its icon block
+        // holds the same path and wins when both are present
+        const std::wstring& icon = link.iconEnvironment.empty() ? link.iconLocation : link.iconEnvironment;
+        bool same = link.arguments == spec.arguments &&
+            ResolvePath(icon, environment) == ResolvePath(spec.iconLocation, environment) &&
+            link.description == Description(spec.iconHash) &&
+            (exe.empty() || ResolvePath(link.targetPath, environment) == exe);
+        steps.push_back({ same ? SyncAction::Keep : SyncAction::Update, spec.name, i });
+    }
+
+    for (size_t i = 0; i < existing.size(); i++) {
+        if (!claimed[i] && IsOwned(existing[i].link, exePath, environment)) {
+            steps.push_back({ SyncAction::Delete, existing[i].name, 0 });
+        }
+    }
+    return steps;
+}
+
+bool ShortcutSync::IsOwned(const ShellLinkInfo& link, const std::wstring& exePath,
+    const EnvLookup& environment) {
+    const std::wstring prefix = kDescriptionPrefix;
+    return link.description.compare(0, prefix.size(), prefix) == 0 ||
+        (!exePath.empty() && ResolvePath(link.targetPath, environment) == ResolvePath(exePath, environment));
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "ShellLink.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Shortcut as the manifest wants it to be
+struct ShortcutSpec {
+    std::wstring name;          // File name without .lnk
+    std::wstring arguments;
+    std::wstring iconLocation;  // Path passed to IShellLink::SetIconLocation
+    std::wstring iconHash;      // Fingerprint of the source icon contents
+};
+
+// Shortcut found on disk
+struct ExistingShortcut {
+    std::wstring name;          // File name without .lnk
+    ShellLinkInfo link;
+};
+
+enum class SyncAction { Create, Update, Delete, Keep };
+
+struct SyncStep {
+    SyncAction action;
+    std::wstring name;
+    size_t specIndex;           // Index into the desired list (unused for Delete)
+};
+
+// Platform-independent planning for --sync: decides which shortcuts have to
+// be written or removed so that unchanged .lnk files are never touched.
+class ShortcutSync {
+public:
+    // Value of an environment variable; false if it isn't set
+    typedef std::function<bool(const std::wstring& name, std::wstring& value)> EnvLookup;
+
+    // Description stamped on every shortcut we write; it marks the link as
+    // ours and records the icon fingerprint for the next comparison
+    static std::wstring Description(const std::wstring& iconHash);
+
+    // Command line the wrapper is launched with from a shortcut
+    static std::wstring BuildArguments(const std::wstring& target,
+        const std::wstring& name,
+        const std::wstring& iconPath,
+        const std::wstring& profile = L"");
+
+    // Hex FNV-1a of the file contents, empty if it can't be read
+    static std::wstring HashFile(const std::wstring& path);
+
+    // Reads and parses every .lnk in dir; unreadable links are skipped
+    static bool LoadExisting(const std::wstring& dir, std::vector<ExistingShortcut>& existing);
+
+    // Links that are not ours (not stamped and not pointing at exePath) are
+    // left alone even if the manifest no longer lists them. Paths are
+    // compared with %VARIABLES% expanded through environment (empty: the
+    // process environment), since the shell stores paths under the user
+    // profile as %USERPROFILE%\...
+    static std::vector<SyncStep> Plan(const std::vector<ShortcutSpec>& desired,
+        const std::vector<ExistingShortcut>& existing,
+        const std::wstring& exePath,
+        const EnvLookup& environment = EnvLookup());
+
+    // True if the link was written by this tool (stamped, or launching exePath)
+    static bool IsOwned(const ShellLinkInfo& link, const std::wstring& exePath,
+        const EnvLookup& environment = EnvLookup());
+
+    // Replaces %NAME% with the variable's value, like ExpandEnvironmentStrings;
+    // unknown variables are left as written
+    static std::wstring ExpandEnvironment(const std::wstring& text, const EnvLookup& environment = EnvLookup());
+};
@@ -0,0 +1,177 @@
+#include "SnapshotCodec.h"
+#include <cstring>
+
+namespace {
+
+const uint8_t kMagic[4] = { 'W', 'W', 'S', 'N' };
+
+// Op tags; the low six bits carry the payload
+const uint8_t kOpIndex = 0x00;  // Table slot
+const uint8_t kOpDiff = 0x40;   // dr, dg, db in -2..1, two bits each
+const uint8_t kOpLuma = 0x80;   // dg in -32..31, then dr - dg and db - dg in -8..7
+const uint8_t kOpRun = 0xC0;    // Previous pixel repeated 1..62 times
+const uint8_t kOpRgb = 0xFE;    // Literal b, g, r follows
+const uint8_t kMask = 0xC0;
+const int kMaxRun = 62;
+
+struct Color {
+    uint8_t b = 0, g = 0, r = 0;
+
+    bool operator==(const Color& o) const { return b == o.b && g == o.g && r == o.r; }
+    bool operator!=(const Color& o) const { return !(*this == o); }
+};
+
+inline int Slot(const Color& c) {
+    // QOI's hash with alpha fixed at 255
+    return (c.r * 3 + c.g * 5 + c.b * 7 + 255 * 11) & 63;
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+void SnapshotCodec::Encode(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    std::vector<uint8_t>& out) {
+    out.clear();
+    // Worst case is a literal per pixel; typical output is far smaller
+    out.reserve(kHeaderBytes + (size_t)width * height);
+    out.insert(out.end(), kMagic, kMagic + 4);
+    PutU32(out, width);
+    PutU32(out, height);
+
+    Color table[64];
+    Color prev;
+    int run = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* p = bgra + y * stride;
+        for (uint32_t x = 0; x < width; x++, p += 4) {
+            Color c;
+            c.b = p[0];
+            c.g = p[1];
+            c.r = p[2];
+            if (c == prev) {
+                if (++run == kMaxRun) {
+                    out.push_back((uint8_t)(kOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run) {
+                out.push_back((uint8_t)(kOpRun | (run - 1)));
+                run = 0;
+            }
+
+            int slot = Slot(c);
+            if (table[slot] == c) {
+                out.push_back((uint8_t)(kOpIndex | slot));
+            } else {
+                table[slot] = c;
+                int dr = (int8_t)(c.r - prev.r);
+                int dg = (int8_t)(c.g - prev.g);
+                int db = (int8_t)(c.b - prev.b);
+                int drg = dr - dg;
+                int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back((uint8_t)(kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    out.push_back((uint8_t)(kOpLuma | (dg + 32)));
+                    out.push_back((uint8_t)(((drg + 8) << 4) | (dbg + 8)));
+                } else {
+                    out.push_back(kOpRgb);
+                    out.push_back(c.b);
+                    out.push_back(c.g);
+                    out.push_back(c.r);
+                }
+            }
+            prev = c;
+        }
+    }
+    if (run) {
+        out.push_back((uint8_t)(kOpRun | (run - 1)));
+    }
+}
+
+bool SnapshotCodec::ReadSize(const uint8_t* data, size_t len, uint32_t& width, uint32_t& height) {
+    if (len < kHeaderBytes || memcmp(data, kMagic, 4) != 0) {
+        return false;
+    }
+    width = GetU32(data + 4);
+    height = GetU32(data + 8);
+    return true;
+}
+
+bool SnapshotCodec::Decode(const uint8_t* data, size_t len, SnapshotImage& image) {
+    uint32_t width = 0, height = 0;
+    if (!ReadSize(data, len, width, height) || !width || !height ||
+        (uint64_t)width * height > kMaxPixels) {
+        return false;
+    }
+
+    const size_t pixels = (size_t)width * height;
+    image.width = width;
+    image.height = height;
+    image.bgra.resize(pixels * 4);
+    uint8_t* dst = image.bgra.data();
+    uint8_t* end = dst + pixels * 4;
+    const uint8_t* p = data + kHeaderBytes;
+    const uint8_t* limit = data + len;
+
+    Color table[64];
+    Color c;
+    while (dst < end) {
+        if (p >= limit) {
+            return false;
+        }
+        uint8_t op = *p++;
+        if (op == kOpRgb) {
+            if (limit - p < 3) return false;
+            c.b = p[0];
+            c.g = p[1];
+            c.r = p[2];
+            p += 3;
+        } else if ((op & kMask) == kOpRun) {
+            int count = (op & 0x3F) + 1;
+            if (count > kMaxRun || (size_t)(end - dst) < (size_t)count * 4) return false;
+            for (int i = 0; i < count; i++, dst += 4) {
+                dst[0] = c.b;
+                dst[1] = c.g;
+                dst[2] = c.r;
+                dst[3] = 255;
+            }
+            continue;
+        } else if ((op & kMask) == kOpIndex) {
+            c = table[op];
+            // An index op never refers to a fresh slot, so nothing to store
+            dst[0] = c.b;
+            dst[1] = c.g;
+            dst[2] = c.r;
+            dst[3] = 255;
+            dst += 4;
+            continue;
+        } else if ((op & kMask) == kOpDiff) {
+            c.r = (uint8_t)(c.r + ((op >> 4) & 3) - 2);
+            c.g = (uint8_t)(c.g + ((op >> 2) & 3) - 2);
+            c.b = (uint8_t)(c.b + (op & 3) - 2);
+        } else {
+            if (p >= limit) return false;
+            int dg = (op & 0x3F) - 32;
+            uint8_t second = *p++;
+            c.r = (uint8_t)(c.r + dg + (second >> 4) - 8);
+            c.g = (uint8_t)(c.g + dg);
+            c.b = (uint8_t)(c.b + dg + (second & 15) - 8);
+        }
+        table[Slot(c)] = c;
+        dst[0] = c.b;
+        dst[1] = c.g;
+        dst[2] = c.r;
+        dst[3] = 255;
+        dst += 4;
+    }
+    return true;
+}
@@ -0,0 +1,162 @@
+#include "SnapshotStore.h"
+#include "AppPaths.h"
+#include "Checksums.h"
+#include "FileUtil.h"
+#include "Deflate.h"
+#include "ImageBlur.h"
+#include "Inflate.h"
+#include "ImageResample.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const wchar_t kExtension[] = L".snap";
+
+// Fastest Deflate level; higher ones save little on codec output
+const int kDeflateLevel = 1;
+
+std::wstring Hex(uint64_t value, int digits) {
+    static const wchar_t kHex[] = L"0123456789abcdef";
+    std::wstring out(digits, L'0');
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = kHex[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+bool IsSnapshot(const FileUtil::Entry& e) {
+    const size_t n = sizeof(kExtension) / sizeof(kExtension[0]) - 1;
+    return !e.isDirectory && e.name.size() > n && e.name.compare(e.name.size() - n, n, kExtension) == 0;
+}
+
+} // namespace
+
+std::wstring SnapshotStore::Directory() {
+    std::wstring dir = AppPaths::DataFile(L"Snapshots");
+    if (dir.empty() || !FileUtil::MakeDirectories(dir)) {
+        return L"";
+    }
+    return dir;
+}
+
+std::wstring SnapshotStore::PathFor(const std::wstring& dir, const std::wstring& key) {
+    std::string utf8 = Utf8::FromWide(key);
+    return FileUtil::Join(dir, Hex(Checksums::Fnv1a64(utf8.data(), utf8.size()), 16) + kExtension);
+}
+
+void SnapshotStore::Prepare(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+    SnapshotImage& out) {
+    out.width = out.height = 0;
+    out.bgra.clear();
+    if (!width || !height) {
+        return;
+    }
+
+    // Averaging boxes first keeps the bicubic pass short on high-DPI
+    // captures; it still gets twice the output size to filter from
+    const uint8_t* src = bgra;
+    uint32_t srcWidth = width, srcHeight = height;
+    size_t srcStride = stride;
+    std::vector<uint8_t> reduced;
+    uint32_t factor = BoxReducer::Factor(width, height, kMaxSide * 2);
+    if (factor > 1) {
+        BoxReducer reducer(width, height, factor, factor);
+        for (uint32_t y = 0; y < height; y++) {
+            reducer.PushRow(bgra + y * stride);
+        }
+        reduced = reducer.Pixels();
+        src = reduced.data();
+        srcWidth = reducer.Width();
+        srcHeight = reducer.Height();
+        srcStride = (size_t)srcWidth * 4;
+    }
+
+    uint32_t longer = std::max(width, height);
+    if (longer > kMaxSide) {
+        out.width = std::max<uint32_t>(1, (uint32_t)((uint64_t)width * kMaxSide / longer));
+        out.height = std::max<uint32_t>(1, (uint32_t)((uint64_t)height * kMaxSide / longer));
+        out.bgra.resize((size_t)out.width * out.height * 4);
+        ImageResample::Resize(src, srcWidth, srcHeight, srcStride, out.bgra.data(), out.width, out.height,
+            (size_t)out.width * 4);
+    } else {
+        out.width = width;
+        out.height = height;
+        out.bgra.resize((size_t)width * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            std::copy(bgra + y * stride, bgra + y * stride + (size_t)width * 4, &out.bgra[(size_t)y * width * 4]);
+        }
+    }
+
+    // Same blur relative to the image for small captures
+    uint32_t radius = std::max<uint32_t>(1, kBlurRadius * std::max(out.width, out.height) / kMaxSide);
+    ImageBlur::Box(out.bgra.data(), out.width, out.height, (size_t)out.width * 4, radius);
+}
+
+bool SnapshotStore::Save(const std::wstring& dir, const std::wstring& key, const uint8_t* bgra,
+    uint32_t width, uint32_t height, size_t stride, size_t* bytes) {
+    SnapshotImage prepared;
+    Prepare(bgra, width, height, stride, prepared);
+    if (prepared.bgra.empty()) {
+        return false;
+    }
+
+    std::vector<uint8_t> encoded, compressed;
+    SnapshotCodec::Encode(prepared.bgra.data(), prepared.width, prepared.height, (size_t)prepared.width * 4, encoded);
+    Deflate::CompressZlib(encoded.data(), encoded.size(), kDeflateLevel, compressed);
+    std::wstring path = PathFor(dir, key);
+    if (!FileUtil::Write(path, compressed.data(), compressed.size())) {
+        return false;
+    }
+    if (bytes) *bytes = compressed.size();
+    Trim(dir, kBudgetBytes, path);
+    return true;
+}
+
+bool SnapshotStore::Load(const std::wstring& dir, const std::wstring& key, SnapshotImage& image) {
+    std::string data;
+    if (!FileUtil::Read(PathFor(dir, key), data)) {
+        return false;
+    }
+    // Nothing larger than a literal per pixel at kMaxSide is ever written
+    std::vector<uint8_t> encoded;
+    size_t limit = SnapshotCodec::kHeaderBytes + (size_t)kMaxSide * kMaxSide * 4;
+    if (!Inflate::DecompressZlib((const uint8_t*)data.data(), data.size(), limit, encoded)) {
+        return false;
+    }
+    return SnapshotCodec::Decode(encoded.data(), encoded.size(), image);
+}
+
+size_t SnapshotStore::Trim(const std::wstring& dir, uint64_t budgetBytes, const std::wstring& keep) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) {
+        return 0;
+    }
+
+    // Newest first; whatever no longer fits goes
+    std::vector<FileUtil::Entry> snapshots;
+    for (const FileUtil::Entry& e : entries) {
+        if (IsSnapshot(e)) snapshots.push_back(e);
+    }
+    std::sort(snapshots.begin(), snapshots.end(), [](const FileUtil::Entry& a, const FileUtil::Entry& b) {
+        return a.modifiedTime > b.modifiedTime;
+    });
+
+    uint64_t total = 0;
+    size_t removed = 0;
+    for (const FileUtil::Entry& e : snapshots) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        if (path == keep) {
+            total += e.size;
+            continue;
+        }
+        if (total + e.size > budgetBytes && FileUtil::Remove(path)) {
+            removed++;
+            continue;
+        }
+        total += e.size;
+    }
+    return removed;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "SnapshotCodec.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Last-frame snapshots shown while an app's page loads.
+//
+// A capture of the rendered page is box-reduced and resampled to fit
+// kMaxSide, blurred (page text is unreadable on disk and on screen) and
+// stored with SnapshotCodec behind a level 1 zlib stream (which halves
+// the codec output and checks it with Adler-32), one file per app, named
+// by a hash of its key.
+// Only the most recently saved snapshots are kept, within kBudgetBytes for
+// the whole folder.
+class SnapshotStore {
+public:
+    // Longer side of a stored snapshot; it is stretched to the window
+    static const uint32_t kMaxSide = 320;
+
+    // Box blur radius at kMaxSide (three passes)
+    static const uint32_t kBlurRadius = 3;
+
+    // Total size of the snapshot folder
+    static const uint64_t kBudgetBytes = 2 * 1024 * 1024;
+
+    // Per-user snapshot folder, created on first use; empty if unavailable
+    static std::wstring Directory();
+
+    // Snapshot file for an app; key identifies it (e.g. name and target URL)
+    static std::wstring PathFor(const std::wstring& dir, const std::wstring& key);
+
+    // Downscales a top-down BGRA capture to fit kMaxSide and blurs it
+    static void Prepare(const uint8_t* bgra, uint32_t width, uint32_t height, size_t stride,
+        SnapshotImage& out);
+
+    // Prepares and stores a capture for key, then trims the folder to
+    // kBudgetBytes. bytes receives the stored size.
+    static bool Save(const std::wstring& dir, const std::wstring& key, const uint8_t* bgra,
+        uint32_t width, uint32_t height, size_t stride, size_t* bytes = nullptr);
+
+    // Reads key's snapshot; false if there is none or it is damaged
+    static bool Load(const std::wstring& dir, const std::wstring& key, SnapshotImage& image);
+
+    // Deletes the least recently saved snapshots other than keep until the
+    // folder holds at most budgetBytes. Returns the number deleted.
+    static size_t Trim(const std::wstring& dir, uint64_t budgetBytes, const std::wstring& keep);
+};
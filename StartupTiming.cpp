@@ -0,0 +1,58 @@
+#include "StartupTiming.h"
+#include "AllocTracker.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::mutex g_mutex;
+Clock::time_point g_start = Clock::now();
+Clock::time_point g_lastMark = g_start;
+std::vector<StartupTiming::Phase> g_phases;
+
+double Milliseconds(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}
+
+void StartupTiming::Start() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_start = g_lastMark = Clock::now();
+    g_phases.clear();
+}
+
+void StartupTiming::Mark(const char* phase) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    AllocTracker::EndPhase(phase);
+    Clock::time_point now = Clock::now();
+    g_phases.push_back(Phase{ phase, Milliseconds(now - g_lastMark) });
+    g_lastMark = now;
+}
+
+void StartupTiming::Record(const char* phase, double ms) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_phases.push_back(Phase{ phase, ms });
+}
+
+double StartupTiming::ElapsedMs() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return Milliseconds(Clock::now() - g_start);
+}
+
+std::vector<StartupTiming::Phase> StartupTiming::Phases() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_phases;
+}
+
+void StartupTiming::Report() {
+    std::vector<Phase> phases = Phases();
+    std::wcout << L"Startup timing:\n";
+    for (const Phase& p : phases) {
+        std::wcout << L"  " << std::wstring(p.name.begin(), p.name.end()) << L": " << p.ms << L" ms\n";
+    }
+    std::wcout << L"  total: " << ElapsedMs() << L" ms\n";
+}
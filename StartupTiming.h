@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Per-phase durations for the current launch, e.g. args -> icon -> window ->
+// environment -> controller -> navigation. Thread-safe, so background work
+// (connection prewarming) can add its own entries.
+class StartupTiming {
+public:
+    struct Phase {
+        std::string name;
+        double ms;
+    };
+
+    // Starts the clock; call first thing in WinMain
+    static void Start();
+
+    // Records the time since the previous Mark (or Start) as phase, and
+    // ends the matching AllocTracker phase; phase must be a string literal
+    static void Mark(const char* phase);
+
+    // Records a duration measured elsewhere, without moving the Mark cursor
+    static void Record(const char* phase, double ms);
+
+    static double ElapsedMs();
+    static std::vector<Phase> Phases();
+
+    // Prints every phase and the total to stdout
+    static void Report();
+};
@@ -0,0 +1,1432 @@
+#include "SvgImage.h"
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+const float kFlattenTolerance = 0.2f;  // Max deviation from curves in device pixels
+
+// ---------------------------------------------------------------------------
+// Geometry
+
+struct Matrix {
+    // x' = a*x + c*y + e, y' = b*x + d*y + f
+    float a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+
+    static Matrix Make(float a, float b, float c, float d, float e, float f) {
+        Matrix m;
+        m.a = a; m.b = b; m.c = c; m.d = d; m.e = e; m.f = f;
+        return m;
+    }
+
+    // Applies rhs first, then this
+    Matrix operator*(const Matrix& m) const {
+        return Make(a * m.a + c * m.b, b * m.a + d * m.b,
+                    a * m.c + c * m.d, b * m.c + d * m.d,
+                    a * m.e + c * m.f + e, b * m.e + d * m.f + f);
+    }
+
+    RasterPoint Apply(float x, float y) const {
+        return { a * x + c * y + e, b * x + d * y + f };
+    }
+
+    Matrix Inverse() const {
+        float det = a * d - b * c;
+        if (std::fabs(det) < 1e-12f) return Matrix();
+        float inv = 1.0f / det;
+        return Make(d * inv, -b * inv, -c * inv, a * inv,
+                    (c * f - d * e) * inv, (b * e - a * f) * inv);
+    }
+
+    float Scale() const { return std::sqrt(std::fabs(a * d - b * c)); }
+};
+
+struct PathCmd {
+    enum Op { Move, Line, Cubic, Close } op;
+    float p[6];
+};
+
+typedef std::vector<RasterPoint> Polyline;
+
+struct Subpath {
+    Polyline points;
+    bool closed = false;
+};
+
+// ---------------------------------------------------------------------------
+// Paint and style
+
+struct Color {
+    float r = 0, g = 0, b = 0, a = 1;
+};
+
+struct GradientStop {
+    float offset;
+    Color color;
+};
+
+enum class Spread { Pad, Reflect, Repeat };
+
+struct Gradient {
+    bool radial = false;
+    bool userSpace = false;
+    Spread spread = Spread::Pad;
+    Matrix transform;
+    float x1 = 0, y1 = 0, x2 = 1, y2 = 0;      // Linear
+    float cx = 0.5f, cy = 0.5f, r = 0.5f;      // Radial
+    float fx = 0.5f, fy = 0.5f;
+    std::vector<GradientStop> stops;
+    std::string href;
+    std::map<std::string, std::string> attrs;  // For resolving href inheritance
+};
+
+struct Paint {
+    enum Type { None, Solid, Url } type = Solid;
+    Color color;
+    std::string ref;
+    bool currentColor = false;
+};
+
+enum class LineJoin { Miter, Round, Bevel };
+enum class LineCap { Butt, Round, Square };
+
+struct Style {
+    Paint fill;
+    Paint stroke;
+    float fillOpacity = 1;
+    float strokeOpacity = 1;
+    float strokeWidth = 1;
+    float miterLimit = 4;
+    FillRule fillRule = FillRule::NonZero;
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Butt;
+    Color color;  // currentColor
+    bool visible = true;
+
+    Style() { stroke.type = Paint::None; }
+};
+
+struct Shape {
+    std::vector<PathCmd> path;
+    Style style;
+    Matrix transform;
+    float opacity = 1;
+    float bounds[4];  // Local space x0, y0, x1, y1 (for objectBoundingBox units)
+};
+
+// ---------------------------------------------------------------------------
+// Lexing helpers
+
+void SkipSpaceComma(const char*& s) {
+    while (*s && (isspace((unsigned char)*s) || *s == ',')) s++;
+}
+
+bool ParseNumber(const char*& s, float& out) {
+    SkipSpaceComma(s);
+    const char* p = s;
+    if (*p == '+' || *p == '-') p++;
+    bool digits = false;
+    while (isdigit((unsigned char)*p)) { p++; digits = true; }
+    if (*p == '.') {
+        p++;
+        while (isdigit((unsigned char)*p)) { p++; digits = true; }
+    }
+    if (!digits) return false;
+    if ((*p == 'e' || *p == 'E') && (isdigit((unsigned char)p[1]) ||
+        ((p[1] == '-' || p[1] == '+') && isdigit((unsigned char)p[2])))) {
+        p += 2;
+        while (isdigit((unsigned char)*p)) p++;
+    }
+    out = (float)strtod(std::string(s, p).c_str(), nullptr);
+    s = p;
+    return true;
+}
+
+bool ParseFlag(const char*& s, bool& out) {
+    SkipSpaceComma(s);
+    if (*s != '0' && *s != '1') return false;
+    out = *s == '1';
+    s++;
+    return true;
+}
+
+std::string Trim(const std::string& v) {
+    size_t b = 0, e = v.size();
+    while (b < e && isspace((unsigned char)v[b])) b++;
+    while (e > b && isspace((unsigned char)v[e - 1])) e--;
+    return v.substr(b, e - b);
+}
+
+std::string Lower(std::string v) {
+    for (char& ch : v) ch = (char)tolower((unsigned char)ch);
+    return v;
+}
+
+// Length in user units; percentages resolve against ref
+float ParseLength(const std::string& v, float ref, float fallback) {
+    const char* s = v.c_str();
+    float n;
+    if (!ParseNumber(s, n)) return fallback;
+    std::string unit = Lower(Trim(s));
+    if (unit.empty() || unit == "px") return n;
+    if (unit == "%") return n * ref / 100.0f;
+    if (unit == "pt") return n * 96.0f / 72.0f;
+    if (unit == "pc") return n * 16.0f;
+    if (unit == "mm") return n * 96.0f / 25.4f;
+    if (unit == "cm") return n * 96.0f / 2.54f;
+    if (unit == "in") return n * 96.0f;
+    if (unit == "em") return n * 16.0f;
+    if (unit == "ex") return n * 8.0f;
+    return n;
+}
+
+// Gradient coordinate: fraction for objectBoundingBox, user units otherwise
+float ParseGradientCoord(const std::string& v, float fallback) {
+    const char* s = v.c_str();
+    float n;
+    if (!ParseNumber(s, n)) return fallback;
+    return Trim(s) == "%" ? n / 100.0f : n;
+}
+
+float ParseOpacity(const std::string& v) {
+    const char* s = v.c_str();
+    float n;
+    if (!ParseNumber(s, n)) return 1.0f;
+    if (Trim(s) == "%") n /= 100.0f;
+    return std::min(1.0f, std::max(0.0f, n));
+}
+
+struct NamedColor {
+    const char* name;
+    uint32_t rgb;
+};
+
+const NamedColor kNamedColors[] = {
+    { "black", 0x000000 }, { "white", 0xFFFFFF }, { "red", 0xFF0000 },
+    { "green", 0x008000 }, { "blue", 0x0000FF }, { "yellow", 0xFFFF00 },
+    { "cyan", 0x00FFFF }, { "aqua", 0x00FFFF }, { "magenta", 0xFF00FF },
+    { "fuchsia", 0xFF00FF }, { "gray", 0x808080 }, { "grey", 0x808080 },
+    { "silver", 0xC0C0C0 }, { "maroon", 0x800000 }, { "olive", 0x808000 },
+    { "lime", 0x00FF00 }, { "teal", 0x008080 }, { "navy", 0x000080 },
+    { "purple", 0x800080 }, { "orange", 0xFFA500 }, { "pink", 0xFFC0CB },
+    { "brown", 0xA52A2A }, { "gold", 0xFFD700 }, { "indigo", 0x4B0082 },
+    { "violet", 0xEE82EE }, { "darkgray", 0xA9A9A9 }, { "lightgray", 0xD3D3D3 },
+    { "darkblue", 0x00008B }, { "darkgreen", 0x006400 }, { "darkred", 0x8B0000 },
+    { "whitesmoke", 0xF5F5F5 }, { "crimson", 0xDC143C }, { "tomato", 0xFF6347 },
+    { "coral", 0xFF7F50 }, { "skyblue", 0x87CEEB }, { "steelblue", 0x4682B4 },
+};
+
+bool ParseColor(const std::string& raw, Color& out) {
+    std::string v = Lower(Trim(raw));
+    if (v.empty()) return false;
+
+    if (v[0] == '#') {
+        std::string hex = v.substr(1);
+        for (char ch : hex) if (!isxdigit((unsigned char)ch)) return false;
+        uint32_t n = (uint32_t)strtoul(hex.c_str(), nullptr, 16);
+        if (hex.size() == 3 || hex.size() == 4) {
+            uint32_t r = (n >> (hex.size() == 4 ? 12 : 8)) & 0xF;
+            uint32_t g = (n >> (hex.size() == 4 ? 8 : 4)) & 0xF;
+            uint32_t b = (n >> (hex.size() == 4 ? 4 : 0)) & 0xF;
+            out.r = (r * 17) / 255.0f; out.g = (g * 17) / 255.0f; out.b = (b * 17) / 255.0f;
+            out.a = hex.size() == 4 ? ((n & 0xF) * 17) / 255.0f : 1.0f;
+            return true;
+        }
+        if (hex.size() == 6 || hex.size() == 8) {
+            int shift = hex.size() == 8 ? 8 : 0;
+            out.r = ((n >> (16 + shift)) & 0xFF) / 255.0f;
+            out.g = ((n >> (8 + shift)) & 0xFF) / 255.0f;
+            out.b = ((n >> shift) & 0xFF) / 255.0f;
+            out.a = hex.size() == 8 ? (n & 0xFF) / 255.0f : 1.0f;
+            return true;
+        }
+        return false;
+    }
+
+    if (v.compare(0, 4, "rgb(") == 0 || v.compare(0, 5, "rgba(") == 0) {
+        const char* s = v.c_str() + v.find('(') + 1;
+        float ch[4] = { 0, 0, 0, 1 };
+        for (int i = 0; i < 4; i++) {
+            if (!ParseNumber(s, ch[i])) {
+                if (i < 3) return false;
+                break;
+            }
+            SkipSpaceComma(s);
+            if (*s == '%') {
+                ch[i] = i < 3 ? ch[i] * 2.55f : ch[i] / 100.0f;
+                s++;
+            }
+            while (*s == ' ' || *s == ',' || *s == '/') s++;
+        }
+        out.r = std::min(255.0f, std::max(0.0f, ch[0])) / 255.0f;
+        out.g = std::min(255.0f, std::max(0.0f, ch[1])) / 255.0f;
+        out.b = std::min(255.0f, std::max(0.0f, ch[2])) / 255.0f;
+        out.a = std::min(1.0f, std::max(0.0f, ch[3]));
+        return true;
+    }
+
+    if (v == "transparent") {
+        out = Color();
+        out.a = 0;
+        return true;
+    }
+
+    for (const NamedColor& nc : kNamedColors) {
+        if (v == nc.name) {
+            out.r = ((nc.rgb >> 16) & 0xFF) / 255.0f;
+            out.g = ((nc.rgb >> 8) & 0xFF) / 255.0f;
+            out.b = (nc.rgb & 0xFF) / 255.0f;
+            out.a = 1.0f;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParsePaint(const std::string& raw, const Color& currentColor, Paint& out) {
+    std::string v = Trim(raw);
+    if (v == "none") {
+        out.type = Paint::None;
+        return true;
+    }
+    if (v.compare(0, 4, "url(") == 0) {
+        size_t hash = v.find('#');
+        size_t close = v.find(')');
+        if (hash == std::string::npos || close == std::string::npos || close < hash) return false;
+        out.type = Paint::Url;
+        out.ref = v.substr(hash + 1, close - hash - 1);
+        // Fallback color after the url() is used if the reference is missing
+        Color fallback;
+        fallback.a = 0;
+        ParseColor(v.substr(close + 1), fallback);
+        out.color = fallback;
+        return true;
+    }
+    if (v == "currentColor" || v == "currentcolor") {
+        out.type = Paint::Solid;
+        out.color = currentColor;
+        out.currentColor = true;
+        return true;
+    }
+    Color c;
+    if (!ParseColor(v, c)) return false;
+    out.type = Paint::Solid;
+    out.color = c;
+    out.currentColor = false;
+    return true;
+}
+
+Matrix ParseTransform(const std::string& v) {
+    Matrix result;
+    const char* s = v.c_str();
+    for (;;) {
+        SkipSpaceComma(s);
+        if (!*s) break;
+        const char* nameStart = s;
+        while (isalpha((unsigned char)*s)) s++;
+        std::string name(nameStart, s);
+        while (isspace((unsigned char)*s)) s++;
+        if (*s != '(') break;
+        s++;
+        float args[6];
+        int n = 0;
+        while (n < 6 && ParseNumber(s, args[n])) n++;
+        SkipSpaceComma(s);
+        if (*s == ')') s++;
+
+        Matrix m;
+        if (name == "matrix" && n == 6) {
+            m = Matrix::Make(args[0], args[1], args[2], args[3], args[4], args[5]);
+        } else if (name == "translate" && n >= 1) {
+            m = Matrix::Make(1, 0, 0, 1, args[0], n > 1 ? args[1] : 0);
+        } else if (name == "scale" && n >= 1) {
+            m = Matrix::Make(args[0], 0, 0, n > 1 ? args[1] : args[0], 0, 0);
+        } else if (name == "rotate" && n >= 1) {
+            float rad = args[0] * kPi / 180.0f;
+            float cs = std::cos(rad), sn = std::sin(rad);
+            m = Matrix::Make(cs, sn, -sn, cs, 0, 0);
+            if (n >= 3) {
+                m = Matrix::Make(1, 0, 0, 1, args[1], args[2]) * m *
+                    Matrix::Make(1, 0, 0, 1, -args[1], -args[2]);
+            }
+        } else if (name == "skewX" && n >= 1) {
+            m = Matrix::Make(1, 0, std::tan(args[0] * kPi / 180.0f), 1, 0, 0);
+        } else if (name == "skewY" && n >= 1) {
+            m = Matrix::Make(1, std::tan(args[0] * kPi / 180.0f), 0, 1, 0, 0);
+        } else {
+            break;
+        }
+        result = result * m;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Path construction
+
+class PathBuilder {
+public:
+    std::vector<PathCmd> cmds;
+
+    void MoveTo(float x, float y) {
+        cmds.push_back({ PathCmd::Move, { x, y } });
+        m_x = m_startX = x;
+        m_y = m_startY = y;
+    }
+
+    void LineTo(float x, float y) {
+        EnsureStarted();
+        cmds.push_back({ PathCmd::Line, { x, y } });
+        m_x = x;
+        m_y = y;
+    }
+
+    void CubicTo(float x1, float y1, float x2, float y2, float x, float y) {
+        EnsureStarted();
+        cmds.push_back({ PathCmd::Cubic, { x1, y1, x2, y2, x, y } });
+        m_x = x;
+        m_y = y;
+    }
+
+    void QuadTo(float qx, float qy, float x, float y) {
+        CubicTo(m_x + 2.0f / 3.0f * (qx - m_x), m_y + 2.0f / 3.0f * (qy - m_y),
+                x + 2.0f / 3.0f * (qx - x), y + 2.0f / 3.0f * (qy - y), x, y);
+    }
+
+    // SVG elliptical arc (endpoint parameterization, spec appendix F.6)
+    void ArcTo(float rx, float ry, float angle, bool largeArc, bool sweep, float x, float y) {
+        float x0 = m_x, y0 = m_y;
+        if (x0 == x && y0 == y) return;
+        rx = std::fabs(rx);
+        ry = std::fabs(ry);
+        if (rx == 0 || ry == 0) {
+            LineTo(x, y);
+            return;
+        }
+
+        float phi = angle * kPi / 180.0f;
+        float cs = std::cos(phi), sn = std::sin(phi);
+        float dx2 = (x0 - x) / 2.0f, dy2 = (y0 - y) / 2.0f;
+        float x1p = cs * dx2 + sn * dy2;
+        float y1p = -sn * dx2 + cs * dy2;
+
+        float lambda = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+        if (lambda > 1) {
+            float sq = std::sqrt(lambda);
+            rx *= sq;
+            ry *= sq;
+        }
+
+        float num = rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+        float den = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+        float coef = den > 0 ? std::sqrt(std::max(0.0f, num / den)) : 0;
+        if (largeArc == sweep) coef = -coef;
+        float cxp = coef * rx * y1p / ry;
+        float cyp = -coef * ry * x1p / rx;
+        float cx = cs * cxp - sn * cyp + (x0 + x) / 2.0f;
+        float cy = sn * cxp + cs * cyp + (y0 + y) / 2.0f;
+
+        float ux = (x1p - cxp) / rx, uy = (y1p - cyp) / ry;
+        float vx = (-x1p - cxp) / rx, vy = (-y1p - cyp) / ry;
+        float theta1 = std::atan2(uy, ux);
+        float delta = std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+        if (!sweep && delta > 0) delta -= 2 * kPi;
+        else if (sweep && delta < 0) delta += 2 * kPi;
+
+        // Split into pieces of at most 90 degrees, each approximated by a cubic
+        int segments = std::max(1, (int)std::ceil(std::fabs(delta) / (kPi / 2) - 1e-4f));
+        float step = delta / segments;
+        float k = 4.0f / 3.0f * std::tan(step / 4.0f);
+        float t = theta1;
+        for (int i = 0; i < segments; i++) {
+            float c1 = std::cos(t), s1 = std::sin(t);
+            float c2 = std::cos(t + step), s2 = std::sin(t + step);
+            float ex1 = c1 - k * s1, ey1 = s1 + k * c1;
+            float ex2 = c2 + k * s2, ey2 = s2 - k * c2;
+            auto map = [&](float ux_, float uy_, float& ox, float& oy) {
+                float px = rx * ux_, py = ry * uy_;
+                ox = cs * px - sn * py + cx;
+                oy = sn * px + cs * py + cy;
+            };
+            float ax, ay, bx, by, ex, ey;
+            map(ex1, ey1, ax, ay);
+            map(ex2, ey2, bx, by);
+            if (i == segments - 1) {
+                ex = x;
+                ey = y;
+            } else {
+                map(c2, s2, ex, ey);
+            }
+            CubicTo(ax, ay, bx, by, ex, ey);
+            t += step;
+        }
+    }
+
+    void Close() {
+        if (!cmds.empty() && cmds.back().op != PathCmd::Close) {
+            cmds.push_back({ PathCmd::Close, {} });
+        }
+        m_x = m_startX;
+        m_y = m_startY;
+    }
+
+    float X() const { return m_x; }
+    float Y() const { return m_y; }
+
+private:
+    float m_x = 0, m_y = 0, m_startX = 0, m_startY = 0;
+
+    void EnsureStarted() {
+        if (cmds.empty() || cmds.back().op == PathCmd::Close) {
+            cmds.push_back({ PathCmd::Move, { m_x, m_y } });
+        }
+    }
+};
+
+void ParsePathData(const std::string& d, PathBuilder& pb) {
+    const char* s = d.c_str();
+    char cmd = 0;
+    float lastCtrlX = 0, lastCtrlY = 0;
+    char lastCmd = 0;
+
+    for (;;) {
+        SkipSpaceComma(s);
+        if (!*s) break;
+        if (isalpha((unsigned char)*s)) {
+            cmd = *s++;
+        } else if (!cmd) {
+            break;
+        }
+
+        bool rel = islower((unsigned char)cmd) != 0;
+        float ox = rel ? pb.X() : 0, oy = rel ? pb.Y() : 0;
+        char upper = (char)toupper((unsigned char)cmd);
+        float v[7];
+        bool ok = true;
+
+        switch (upper) {
+        case 'M':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]);
+            if (ok) {
+                pb.MoveTo(ox + v[0], oy + v[1]);
+                cmd = rel ? 'l' : 'L';  // Subsequent pairs are implicit lineto
+            }
+            break;
+        case 'L':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]);
+            if (ok) pb.LineTo(ox + v[0], oy + v[1]);
+            break;
+        case 'H':
+            ok = ParseNumber(s, v[0]);
+            if (ok) pb.LineTo(ox + v[0], pb.Y());
+            break;
+        case 'V':
+            ok = ParseNumber(s, v[0]);
+            if (ok) pb.LineTo(pb.X(), oy + v[0]);
+            break;
+        case 'C':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]) && ParseNumber(s, v[2]) &&
+                 ParseNumber(s, v[3]) && ParseNumber(s, v[4]) && ParseNumber(s, v[5]);
+            if (ok) {
+                pb.CubicTo(ox + v[0], oy + v[1], ox + v[2], oy + v[3], ox + v[4], oy + v[5]);
+                lastCtrlX = ox + v[2];
+                lastCtrlY = oy + v[3];
+            }
+            break;
+        case 'S':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]) && ParseNumber(s, v[2]) && ParseNumber(s, v[3]);
+            if (ok) {
+                float cx = pb.X(), cy = pb.Y();
+                if (lastCmd == 'C' || lastCmd == 'S') {
+                    cx = 2 * pb.X() - lastCtrlX;
+                    cy = 2 * pb.Y() - lastCtrlY;
+                }
+                pb.CubicTo(cx, cy, ox + v[0], oy + v[1], ox + v[2], oy + v[3]);
+                lastCtrlX = ox + v[0];
+                lastCtrlY = oy + v[1];
+            }
+            break;
+        case 'Q':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]) && ParseNumber(s, v[2]) && ParseNumber(s, v[3]);
+            if (ok) {
+                pb.QuadTo(ox + v[0], oy + v[1], ox + v[2], oy + v[3]);
+                lastCtrlX = ox + v[0];
+                lastCtrlY = oy + v[1];
+            }
+            break;
+        case 'T':
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]);
+            if (ok) {
+                float qx = pb.X(), qy = pb.Y();
+                if (lastCmd == 'Q' || lastCmd == 'T') {
+                    qx = 2 * pb.X() - lastCtrlX;
+                    qy = 2 * pb.Y() - lastCtrlY;
+                }
+                pb.QuadTo(qx, qy, ox + v[0], oy + v[1]);
+                lastCtrlX = qx;
+                lastCtrlY = qy;
+            }
+            break;
+        case 'A': {
+            bool large = false, sweep = false;
+            ok = ParseNumber(s, v[0]) && ParseNumber(s, v[1]) && ParseNumber(s, v[2]) &&
+                 ParseFlag(s, large) && ParseFlag(s, sweep) &&
+                 ParseNumber(s, v[3]) && ParseNumber(s, v[4]);
+            if (ok) pb.ArcTo(v[0], v[1], v[2], large, sweep, ox + v[3], oy + v[4]);
+            break;
+        }
+        case 'Z':
+            pb.Close();
+            cmd = 0;  // Z takes no arguments; a number afterwards is an error
+            break;
+        default:
+            ok = false;
+            break;
+        }
+
+        // Per spec, stop rendering at the first error but keep what was parsed
+        if (!ok) break;
+        lastCmd = upper;
+    }
+}
+
+void EllipsePath(PathBuilder& pb, float cx, float cy, float rx, float ry) {
+    const float k = 0.5522847498f;
+    pb.MoveTo(cx + rx, cy);
+    pb.CubicTo(cx + rx, cy + ry * k, cx + rx * k, cy + ry, cx, cy + ry);
+    pb.CubicTo(cx - rx * k, cy + ry, cx - rx, cy + ry * k, cx - rx, cy);
+    pb.CubicTo(cx - rx, cy - ry * k, cx - rx * k, cy - ry, cx, cy - ry);
+    pb.CubicTo(cx + rx * k, cy - ry, cx + rx, cy - ry * k, cx + rx, cy);
+    pb.Close();
+}
+
+// ---------------------------------------------------------------------------
+// Minimal XML reader
+
+struct XmlElement {
+    std::string name;
+    std::map<std::string, std::string> attrs;
+    bool selfClosing = false;
+    bool closing = false;
+};
+
+std::string DecodeEntities(const std::string& v) {
+    if (v.find('&') == std::string::npos) return v;
+    std::string out;
+    for (size_t i = 0; i < v.size(); i++) {
+        if (v[i] != '&') {
+            out += v[i];
+            continue;
+        }
+        size_t semi = v.find(';', i);
+        if (semi == std::string::npos) {
+            out += v[i];
+            continue;
+        }
+        std::string ent = v.substr(i + 1, semi - i - 1);
+        if (ent == "amp") out += '&';
+        else if (ent == "lt") out += '<';
+        else if (ent == "gt") out += '>';
+        else if (ent == "quot") out += '"';
+        else if (ent == "apos") out += '\'';
+        else if (!ent.empty() && ent[0] == '#') {
+            long code = ent.size() > 1 && (ent[1] == 'x' || ent[1] == 'X')
+                ? strtol(ent.c_str() + 2, nullptr, 16) : strtol(ent.c_str() + 1, nullptr, 10);
+            out += code > 0 && code < 128 ? (char)code : ' ';
+        }
+        else out += v.substr(i, semi - i + 1);
+        i = semi;
+    }
+    return out;
+}
+
+std::string LocalName(const std::string& qname) {
+    size_t colon = qname.find(':');
+    return colon == std::string::npos ? qname : qname.substr(colon + 1);
+}
+
+class XmlReader {
+public:
+    explicit XmlReader(const std::string& text) : m_s(text), m_pos(0) {}
+
+    // Returns false at end of input or on malformed markup
+    bool Next(XmlElement& el) {
+        for (;;) {
+            size_t lt = m_s.find('<', m_pos);
+            if (lt == std::string::npos) return false;
+            m_pos = lt;
+            if (m_s.compare(m_pos, 4, "<!--") == 0) {
+                if (!SkipPast("-->")) return false;
+                continue;
+            }
+            if (m_s.compare(m_pos, 9, "<![CDATA[") == 0) {
+                if (!SkipPast("]]>")) return false;
+                continue;
+            }
+            if (m_s.compare(m_pos, 2, "<?") == 0) {
+                if (!SkipPast("?>")) return false;
+                continue;
+            }
+            if (m_s.compare(m_pos, 2, "<!") == 0) {
+                // DOCTYPE, possibly with an internal subset in brackets
+                int depth = 0;
+                while (m_pos < m_s.size()) {
+                    char ch = m_s[m_pos++];
+                    if (ch == '[') depth++;
+                    else if (ch == ']') depth--;
+                    else if (ch == '>' && depth <= 0) break;
+                }
+                continue;
+            }
+            return ParseTag(el);
+        }
+    }
+
+private:
+    const std::string& m_s;
+    size_t m_pos;
+
+    bool SkipPast(const char* end) {
+        size_t p = m_s.find(end, m_pos);
+        if (p == std::string::npos) return false;
+        m_pos = p + strlen(end);
+        return true;
+    }
+
+    bool ParseTag(XmlElement& el) {
+        el = XmlElement();
+        m_pos++;  // '<'
+        if (m_pos < m_s.size() && m_s[m_pos] == '/') {
+            el.closing = true;
+            m_pos++;
+        }
+        size_t nameStart = m_pos;
+        while (m_pos < m_s.size() && !isspace((unsigned char)m_s[m_pos]) &&
+               m_s[m_pos] != '>' && m_s[m_pos] != '/') {
+            m_pos++;
+        }
+        el.name = LocalName(m_s.substr(nameStart, m_pos - nameStart));
+
+        for (;;) {
+            while (m_pos < m_s.size() && isspace((unsigned char)m_s[m_pos])) m_pos++;
+            if (m_pos >= m_s.size()) return false;
+            if (m_s[m_pos] == '>') {
+                m_pos++;
+                return true;
+            }
+            if (m_s[m_pos] == '/') {
+                el.selfClosing = true;
+                m_pos++;
+                continue;
+            }
+            size_t keyStart = m_pos;
+            while (m_pos < m_s.size() && m_s[m_pos] != '=' && m_s[m_pos] != '>' &&
+                   !isspace((unsigned char)m_s[m_pos])) {
+                m_pos++;
+            }
+            std::string key = m_s.substr(keyStart, m_pos - keyStart);
+            while (m_pos < m_s.size() && isspace((unsigned char)m_s[m_pos])) m_pos++;
+            if (m_pos >= m_s.size() || m_s[m_pos] != '=') continue;
+            m_pos++;
+            while (m_pos < m_s.size() && isspace((unsigned char)m_s[m_pos])) m_pos++;
+            if (m_pos >= m_s.size()) return false;
+            char quote = m_s[m_pos];
+            if (quote != '"' && quote != '\'') return false;
+            size_t end = m_s.find(quote, m_pos + 1);
+            if (end == std::string::npos) return false;
+            std::string value = DecodeEntities(m_s.substr(m_pos + 1, end - m_pos - 1));
+            m_pos = end + 1;
+            if (key == "xlink:href") key = "href";
+            el.attrs[key] = value;
+        }
+    }
+};
+
+// Splits "a:b; c:d" declarations into attrs (style wins over presentation attributes)
+void MergeStyleAttribute(std::map<std::string, std::string>& attrs) {
+    auto it = attrs.find("style");
+    if (it == attrs.end()) return;
+    std::string style = it->second;
+    size_t pos = 0;
+    while (pos < style.size()) {
+        size_t semi = style.find(';', pos);
+        if (semi == std::string::npos) semi = style.size();
+        std::string decl = style.substr(pos, semi - pos);
+        size_t colon = decl.find(':');
+        if (colon != std::string::npos) {
+            std::string key = Lower(Trim(decl.substr(0, colon)));
+            std::string value = Trim(decl.substr(colon + 1));
+            size_t bang = value.find("!important");
+            if (bang != std::string::npos) value = Trim(value.substr(0, bang));
+            if (!key.empty()) attrs[key] = value;
+        }
+        pos = semi + 1;
+    }
+}
+
+const char* Attr(const std::map<std::string, std::string>& attrs, const char* key) {
+    auto it = attrs.find(key);
+    return it == attrs.end() ? nullptr : it->second.c_str();
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Scene
+
+struct SvgImage::Scene {
+    float viewX = 0, viewY = 0, viewW = 0, viewH = 0;
+    float width = 0, height = 0;
+    std::vector<Shape> shapes;
+    std::map<std::string, Gradient> gradients;
+
+    void ApplyStyle(const std::map<std::string, std::string>& attrs, Style& st, float& opacity) {
+        const char* v;
+        if ((v = Attr(attrs, "color"))) ParseColor(v, st.color);
+        if ((v = Attr(attrs, "fill"))) ParsePaint(v, st.color, st.fill);
+        if ((v = Attr(attrs, "stroke"))) ParsePaint(v, st.color, st.stroke);
+        if ((v = Attr(attrs, "fill-opacity"))) st.fillOpacity = ParseOpacity(v);
+        if ((v = Attr(attrs, "stroke-opacity"))) st.strokeOpacity = ParseOpacity(v);
+        if ((v = Attr(attrs, "stroke-width"))) st.strokeWidth = ParseLength(v, Diagonal(), 1.0f);
+        if ((v = Attr(attrs, "stroke-miterlimit"))) st.miterLimit = std::max(1.0f, (float)atof(v));
+        if ((v = Attr(attrs, "fill-rule"))) st.fillRule = Trim(v) == "evenodd" ? FillRule::EvenOdd : FillRule::NonZero;
+        if ((v = Attr(attrs, "stroke-linejoin"))) {
+            std::string j = Trim(v);
+            st.join = j == "round" ? LineJoin::Round : j == "bevel" ? LineJoin::Bevel : LineJoin::Miter;
+        }
+        if ((v = Attr(attrs, "stroke-linecap"))) {
+            std::string c = Trim(v);
+            st.cap = c == "round" ? LineCap::Round : c == "square" ? LineCap::Square : LineCap::Butt;
+        }
+        if ((v = Attr(attrs, "visibility"))) st.visible = Trim(v) == "visible";
+        if ((v = Attr(attrs, "opacity"))) opacity *= ParseOpacity(v);
+
+        // currentColor follows a color set on this element
+        if (Attr(attrs, "color")) {
+            if (st.fill.currentColor) st.fill.color = st.color;
+            if (st.stroke.currentColor) st.stroke.color = st.color;
+        }
+    }
+
+    float Diagonal() const {
+        return std::sqrt((viewW * viewW + viewH * viewH) / 2.0f);
+    }
+
+    bool BuildShape(const XmlElement& el, PathBuilder& pb) {
+        const auto& a = el.attrs;
+        auto len = [&](const char* key, float ref, float fallback) {
+            const char* v = Attr(a, key);
+            return v ? ParseLength(v, ref, fallback) : fallback;
+        };
+
+        if (el.name == "path") {
+            const char* d = Attr(a, "d");
+            if (!d) return false;
+            ParsePathData(d, pb);
+        } else if (el.name == "rect") {
+            float x = len("x", viewW, 0), y = len("y", viewH, 0);
+            float w = len("width", viewW, 0), h = len("height", viewH, 0);
+            if (w <= 0 || h <= 0) return false;
+            float rx = len("rx", viewW, -1), ry = len("ry", viewH, -1);
+            if (rx < 0 && ry < 0) rx = ry = 0;
+            else if (rx < 0) rx = ry;
+            else if (ry < 0) ry = rx;
+            rx = std::min(rx, w / 2);
+            ry = std::min(ry, h / 2);
+            if (rx <= 0 || ry <= 0) {
+                pb.MoveTo(x, y);
+                pb.LineTo(x + w, y);
+                pb.LineTo(x + w, y + h);
+                pb.LineTo(x, y + h);
+                pb.Close();
+            } else {
+                pb.MoveTo(x + rx, y);
+                pb.LineTo(x + w - rx, y);
+                pb.ArcTo(rx, ry, 0, false, true, x + w, y + ry);
+                pb.LineTo(x + w, y + h - ry);
+                pb.ArcTo(rx, ry, 0, false, true, x + w - rx, y + h);
+                pb.LineTo(x + rx, y + h);
+                pb.ArcTo(rx, ry, 0, false, true, x, y + h - ry);
+                pb.LineTo(x, y + ry);
+                pb.ArcTo(rx, ry, 0, false, true, x + rx, y);
+                pb.Close();
+            }
+        } else if (el.name == "circle") {
+            float r = len("r", Diagonal(), 0);
+            if (r <= 0) return false;
+            EllipsePath(pb, len("cx", viewW, 0), len("cy", viewH, 0), r, r);
+        } else if (el.name == "ellipse") {
+            float rx = len("rx", viewW, 0), ry = len("ry", viewH, 0);
+            if (rx <= 0 || ry <= 0) return false;
+            EllipsePath(pb, len("cx", viewW, 0), len("cy", viewH, 0), rx, ry);
+        } else if (el.name == "line") {
+            pb.MoveTo(len("x1", viewW, 0), len("y1", viewH, 0));
+            pb.LineTo(len("x2", viewW, 0), len("y2", viewH, 0));
+        } else if (el.name == "polyline" || el.name == "polygon") {
+            const char* pts = Attr(a, "points");
+            if (!pts) return false;
+            float x, y;
+            bool first = true;
+            while (ParseNumber(pts, x) && ParseNumber(pts, y)) {
+                if (first) pb.MoveTo(x, y);
+                else pb.LineTo(x, y);
+                first = false;
+            }
+            if (first) return false;
+            if (el.name == "polygon") pb.Close();
+        } else {
+            return false;
+        }
+        return !pb.cmds.empty();
+    }
+
+    void ParseGradient(const XmlElement& el) {
+        auto idIt = el.attrs.find("id");
+        if (idIt == el.attrs.end()) return;
+        Gradient g;
+        g.radial = el.name == "radialGradient";
+        g.attrs = el.attrs;
+        const char* href = Attr(el.attrs, "href");
+        if (href && href[0] == '#') g.href = href + 1;
+        gradients[idIt->second] = g;
+        currentGradient = idIt->second;
+    }
+
+    void ParseStop(const XmlElement& el) {
+        auto it = gradients.find(currentGradient);
+        if (it == gradients.end()) return;
+        std::map<std::string, std::string> attrs = el.attrs;
+        MergeStyleAttribute(attrs);
+
+        GradientStop stop;
+        const char* v = Attr(attrs, "offset");
+        stop.offset = v ? std::min(1.0f, std::max(0.0f, ParseGradientCoord(v, 0))) : 0;
+        stop.color = Color();
+        if ((v = Attr(attrs, "stop-color"))) ParseColor(v, stop.color);
+        if ((v = Attr(attrs, "stop-opacity"))) stop.color.a *= ParseOpacity(v);
+
+        std::vector<GradientStop>& stops = it->second.stops;
+        if (!stops.empty()) stop.offset = std::max(stop.offset, stops.back().offset);
+        stops.push_back(stop);
+    }
+
+    // Fills gradient geometry from its attributes, inheriting through href
+    void ResolveGradients() {
+        for (auto& kv : gradients) {
+            Gradient& g = kv.second;
+            std::map<std::string, std::string> attrs;
+            std::vector<GradientStop> stops = g.stops;
+            std::string ref = kv.first;
+            for (int depth = 0; depth < 8 && !ref.empty(); depth++) {
+                auto it = gradients.find(ref);
+                if (it == gradients.end()) break;
+                for (auto& a : it->second.attrs) attrs.insert(a);  // Nearest definition wins
+                if (stops.empty()) stops = it->second.stops;
+                ref = it->second.href;
+            }
+            g.stops = stops;
+
+            const char* v;
+            g.userSpace = (v = Attr(attrs, "gradientUnits")) && Trim(v) == "userSpaceOnUse";
+            if ((v = Attr(attrs, "gradientTransform"))) g.transform = ParseTransform(v);
+            if ((v = Attr(attrs, "spreadMethod"))) {
+                std::string sm = Trim(v);
+                g.spread = sm == "reflect" ? Spread::Reflect : sm == "repeat" ? Spread::Repeat : Spread::Pad;
+            }
+
+            auto coord = [&](const char* key, float ref, float fallbackFraction) {
+                const char* val = Attr(attrs, key);
+                if (!g.userSpace) return val ? ParseGradientCoord(val, fallbackFraction) : fallbackFraction;
+                return val ? ParseLength(val, ref, fallbackFraction * ref) : fallbackFraction * ref;
+            };
+            if (g.radial) {
+                g.cx = coord("cx", viewW, 0.5f);
+                g.cy = coord("cy", viewH, 0.5f);
+                g.r = coord("r", Diagonal(), 0.5f);
+                g.fx = Attr(attrs, "fx") ? coord("fx", viewW, 0.5f) : g.cx;
+                g.fy = Attr(attrs, "fy") ? coord("fy", viewH, 0.5f) : g.cy;
+            } else {
+                g.x1 = coord("x1", viewW, 0.0f);
+                g.y1 = coord("y1", viewH, 0.0f);
+                g.x2 = coord("x2", viewW, 1.0f);
+                g.y2 = coord("y2", viewH, 0.0f);
+            }
+        }
+    }
+
+    std::string currentGradient;  // Target of <stop> elements while parsing
+};
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Rendering
+
+void FlattenCubic(Polyline& out, RasterPoint p0, RasterPoint p1, RasterPoint p2, RasterPoint p3) {
+    // Wang's formula for the number of segments within tolerance
+    float ddx = std::max(std::fabs(p0.x - 2 * p1.x + p2.x), std::fabs(p1.x - 2 * p2.x + p3.x));
+    float ddy = std::max(std::fabs(p0.y - 2 * p1.y + p2.y), std::fabs(p1.y - 2 * p2.y + p3.y));
+    float dd = std::sqrt(ddx * ddx + ddy * ddy);
+    // Clamped before the int conversion: dd overflows to inf for huge coordinates
+    int n = (int)std::max(1.0f, std::min(std::ceil(std::sqrt(0.75f * dd / kFlattenTolerance)), 256.0f));
+    for (int i = 1; i <= n; i++) {
+        float t = (float)i / n, mt = 1 - t;
+        float a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+        out.push_back({ a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+                        a * p0.y + b * p1.y + c * p2.y + d * p3.y });
+    }
+}
+
+std::vector<Subpath> Flatten(const std::vector<PathCmd>& cmds, const Matrix& m) {
+    std::vector<Subpath> result;
+    RasterPoint cur = { 0, 0 };
+    for (const PathCmd& cmd : cmds) {
+        switch (cmd.op) {
+        case PathCmd::Move:
+            result.push_back(Subpath());
+            cur = m.Apply(cmd.p[0], cmd.p[1]);
+            result.back().points.push_back(cur);
+            break;
+        case PathCmd::Line:
+            if (result.empty()) break;
+            cur = m.Apply(cmd.p[0], cmd.p[1]);
+            result.back().points.push_back(cur);
+            break;
+        case PathCmd::Cubic:
+            if (result.empty()) break;
+            FlattenCubic(result.back().points, cur, m.Apply(cmd.p[0], cmd.p[1]),
+                m.Apply(cmd.p[2], cmd.p[3]), m.Apply(cmd.p[4], cmd.p[5]));
+            cur = result.back().points.back();
+            break;
+        case PathCmd::Close:
+            if (!result.empty()) {
+                result.back().closed = true;
+                cur = result.back().points.front();
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+void AddOriented(Rasterizer& ras, std::vector<RasterPoint> poly) {
+    float area = 0;
+    for (size_t i = 0; i < poly.size(); i++) {
+        const RasterPoint& a = poly[i];
+        const RasterPoint& b = poly[(i + 1) % poly.size()];
+        area += a.x * b.y - b.x * a.y;
+    }
+    // All stroke pieces share one winding so overlaps union under nonzero
+    if (area < 0) std::reverse(poly.begin(), poly.end());
+    ras.AddPolygon(poly);
+}
+
+void AddCircle(Rasterizer& ras, RasterPoint c, float r) {
+    int n = (int)std::max(8.0f, std::min(64.0f, std::ceil(r * 2.0f)));
+    std::vector<RasterPoint> poly;
+    for (int i = 0; i < n; i++) {
+        float a = 2 * kPi * i / n;
+        poly.push_back({ c.x + r * std::cos(a), c.y + r * std::sin(a) });
+    }
+    AddOriented(ras, poly);
+}
+
+void StrokeSubpath(Rasterizer& ras, Polyline pts, bool closed, float hw, const Style& st) {
+    // Drop repeated points so segment directions are well defined
+    Polyline clean;
+    for (const RasterPoint& p : pts) {
+        if (clean.empty() || std::fabs(p.x - clean.back().x) > 1e-4f || std::fabs(p.y - clean.back().y) > 1e-4f) {
+            clean.push_back(p);
+        }
+    }
+    if (closed && clean.size() > 2 &&
+        std::fabs(clean.front().x - clean.back().x) < 1e-4f && std::fabs(clean.front().y - clean.back().y) < 1e-4f) {
+        clean.pop_back();
+    }
+
+    if (clean.size() == 1) {
+        RasterPoint p = clean[0];
+        if (st.cap == LineCap::Round) AddCircle(ras, p, hw);
+        else if (st.cap == LineCap::Square) {
+            AddOriented(ras, { { p.x - hw, p.y - hw }, { p.x + hw, p.y - hw }, { p.x + hw, p.y + hw }, { p.x - hw, p.y + hw } });
+        }
+        return;
+    }
+    if (clean.size() < 2) return;
+
+    size_t segCount = closed ? clean.size() : clean.size() - 1;
+    std::vector<RasterPoint> dirs(segCount);
+    for (size_t i = 0; i < segCount; i++) {
+        RasterPoint a = clean[i], b = clean[(i + 1) % clean.size()];
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float l = std::sqrt(dx * dx + dy * dy);
+        dirs[i] = { dx / l, dy / l };
+    }
+
+    for (size_t i = 0; i < segCount; i++) {
+        RasterPoint a = clean[i], b = clean[(i + 1) % clean.size()];
+        RasterPoint d = dirs[i];
+        if (!closed && st.cap == LineCap::Square) {
+            if (i == 0) { a.x -= d.x * hw; a.y -= d.y * hw; }
+            if (i == segCount - 1) { b.x += d.x * hw; b.y += d.y * hw; }
+        }
+        RasterPoint n = { -d.y * hw, d.x * hw };
+        AddOriented(ras, { { a.x + n.x, a.y + n.y }, { b.x + n.x, b.y + n.y },
+                           { b.x - n.x, b.y - n.y }, { a.x - n.x, a.y - n.y } });
+    }
+
+    // Joins between consecutive segments
+    size_t joinCount = closed ? segCount : segCount - 1;
+    for (size_t j = 0; j < joinCount; j++) {
+        RasterPoint d1 = dirs[j], d2 = dirs[(j + 1) % segCount];
+        RasterPoint v = clean[(j + 1) % clean.size()];
+        float cross = d1.x * d2.y - d1.y * d2.x;
+        float dot = d1.x * d2.x + d1.y * d2.y;
+        if (std::fabs(cross) < 1e-6f && dot > 0) continue;  // Collinear
+
+        if (st.join == LineJoin::Round) {
+            AddCircle(ras, v, hw);
+            continue;
+        }
+
+        float sign = cross > 0 ? -1.0f : 1.0f;  // Outer side of the turn
+        RasterPoint n1 = { -d1.y * sign, d1.x * sign };
+        RasterPoint n2 = { -d2.y * sign, d2.x * sign };
+        RasterPoint o1 = { v.x + n1.x * hw, v.y + n1.y * hw };
+        RasterPoint o2 = { v.x + n2.x * hw, v.y + n2.y * hw };
+
+        float ndot = n1.x * n2.x + n1.y * n2.y;
+        float ratio = ndot > -0.9999f ? std::sqrt(2.0f / (1.0f + ndot)) : 1e9f;
+        if (st.join == LineJoin::Miter && ratio <= st.miterLimit) {
+            float k = hw / (1.0f + ndot);
+            RasterPoint m = { v.x + (n1.x + n2.x) * k, v.y + (n1.y + n2.y) * k };
+            AddOriented(ras, { v, o1, m, o2 });
+        } else {
+            AddOriented(ras, { v, o1, o2 });
+        }
+    }
+
+    if (!closed && st.cap == LineCap::Round) {
+        AddCircle(ras, clean.front(), hw);
+        AddCircle(ras, clean.back(), hw);
+    }
+}
+
+struct Canvas {
+    int size;
+    std::vector<float> px;  // Premultiplied RGBA
+
+    explicit Canvas(int s) : size(s), px((size_t)s * s * 4, 0.0f) {}
+
+    void Blend(int x, int y, const float* src, float coverage) {
+        float* d = &px[((size_t)y * size + x) * 4];
+        float a = src[3] * coverage;
+        float inv = 1.0f - a;
+        d[0] = src[0] * coverage + d[0] * inv;
+        d[1] = src[1] * coverage + d[1] * inv;
+        d[2] = src[2] * coverage + d[2] * inv;
+        d[3] = a + d[3] * inv;
+    }
+};
+
+// Premultiplied paint source for a span of pixels
+class Shader {
+public:
+    bool Init(const Paint& paint, float opacity, const SvgImage::Scene& scene,
+        const Matrix& toDevice, const float* bounds) {
+        if (paint.type == Paint::None) return false;
+
+        const Gradient* g = nullptr;
+        if (paint.type == Paint::Url) {
+            auto it = scene.gradients.find(paint.ref);
+            if (it != scene.gradients.end()) g = &it->second;
+        }
+
+        if (!g) {
+            Color c = paint.color;
+            if (paint.type == Paint::Url && c.a == 0) return false;
+            SetSolid(c, opacity);
+            return true;
+        }
+        if (g->stops.empty()) return false;
+        if (g->stops.size() == 1) {
+            SetSolid(g->stops[0].color, opacity);
+            return true;
+        }
+
+        // Gradient space -> device space
+        Matrix space = toDevice;
+        if (!g->userSpace) {
+            float bw = bounds[2] - bounds[0], bh = bounds[3] - bounds[1];
+            if (bw <= 0 || bh <= 0) return false;
+            space = space * Matrix::Make(bw, 0, 0, bh, bounds[0], bounds[1]);
+        }
+        space = space * g->transform;
+        m_inverse = space.Inverse();
+        m_gradient = g;
+        m_solid = false;
+
+        // 256-entry premultiplied color ramp
+        for (int i = 0; i < 256; i++) {
+            float t = i / 255.0f;
+            const std::vector<GradientStop>& st = g->stops;
+            Color c = st.front().color;
+            if (t >= st.back().offset) {
+                c = st.back().color;
+            } else if (t > st.front().offset) {
+                for (size_t k = 1; k < st.size(); k++) {
+                    if (t <= st[k].offset) {
+                        float span = st[k].offset - st[k - 1].offset;
+                        float f = span > 0 ? (t - st[k - 1].offset) / span : 1.0f;
+                        const Color& a = st[k - 1].color;
+                        const Color& b = st[k].color;
+                        c.r = a.r + (b.r - a.r) * f;
+                        c.g = a.g + (b.g - a.g) * f;
+                        c.b = a.b + (b.b - a.b) * f;
+                        c.a = a.a + (b.a - a.a) * f;
+                        break;
+                    }
+                }
+            }
+            float alpha = c.a * opacity;
+            m_ramp[i * 4 + 0] = c.r * alpha;
+            m_ramp[i * 4 + 1] = c.g * alpha;
+            m_ramp[i * 4 + 2] = c.b * alpha;
+            m_ramp[i * 4 + 3] = alpha;
+        }
+        return true;
+    }
+
+    const float* At(int x, int y) const {
+        if (m_solid) return m_color;
+
+        RasterPoint p = m_inverse.Apply(x + 0.5f, y + 0.5f);
+        const Gradient& g = *m_gradient;
+        float t;
+        if (g.radial) {
+            // Focal point is treated as coincident with the center
+            float dx = p.x - g.cx, dy = p.y - g.cy;
+            t = g.r > 0 ? std::sqrt(dx * dx + dy * dy) / g.r : 1.0f;
+        } else {
+            float vx = g.x2 - g.x1, vy = g.y2 - g.y1;
+            float len2 = vx * vx + vy * vy;
+            t = len2 > 0 ? ((p.x - g.x1) * vx + (p.y - g.y1) * vy) / len2 : 0.0f;
+        }
+
+        if (g.spread == Spread::Repeat) {
+            t -= std::floor(t);
+        } else if (g.spread == Spread::Reflect) {
+            t = std::fabs(std::fmod(t, 2.0f));
+            if (t > 1) t = 2 - t;
+        }
+        t = std::min(1.0f, std::max(0.0f, t));
+        return &m_ramp[(int)(t * 255.0f + 0.5f) * 4];
+    }
+
+private:
+    bool m_solid = true;
+    float m_color[4] = {};
+    const Gradient* m_gradient = nullptr;
+    Matrix m_inverse;
+    float m_ramp[256 * 4];
+
+    void SetSolid(const Color& c, float opacity) {
+        float alpha = c.a * opacity;
+        m_color[0] = c.r * alpha;
+        m_color[1] = c.g * alpha;
+        m_color[2] = c.b * alpha;
+        m_color[3] = alpha;
+        m_solid = true;
+    }
+};
+
+void PaintShape(Canvas& canvas, Rasterizer& ras, FillRule rule, const Shader& shader) {
+    ras.Sweep(rule, [&](int y, int x0, int x1, const float* coverage) {
+        for (int x = x0; x < x1; x++) {
+            float cov = coverage[x - x0];
+            if (cov <= 0.0f) continue;
+            canvas.Blend(x, y, shader.At(x, y), cov);
+        }
+    });
+}
+
+} // namespace
+
+SvgImage::SvgImage(std::unique_ptr<Scene> scene) : m_scene(std::move(scene)) {}
+
+SvgImage::~SvgImage() = default;
+
+float SvgImage::Width() const { return m_scene->width; }
+float SvgImage::Height() const { return m_scene->height; }
+
+std::unique_ptr<SvgImage> SvgImage::Parse(const std::string& text) {
+    std::unique_ptr<Scene> scene(new Scene());
+    XmlReader reader(text);
+    XmlElement el;
+
+    struct Frame {
+        std::string name;
+        Style style;
+        Matrix transform;
+        float opacity;
+        bool hidden;   // display:none or a non-rendered container
+    };
+    std::vector<Frame> stack;
+    bool sawRoot = false;
+
+    while (reader.Next(el)) {
+        if (el.closing) {
+            if (!stack.empty()) stack.pop_back();
+            if (el.name == "linearGradient" || el.name == "radialGradient") scene->currentGradient.clear();
+            continue;
+        }
+
+        MergeStyleAttribute(el.attrs);
+
+        if (!sawRoot) {
+            if (el.name != "svg") return nullptr;
+            sawRoot = true;
+
+            const char* vb = Attr(el.attrs, "viewBox");
+            float v[4];
+            const char* p = vb;
+            if (vb && ParseNumber(p, v[0]) && ParseNumber(p, v[1]) && ParseNumber(p, v[2]) && ParseNumber(p, v[3]) &&
+                v[2] > 0 && v[3] > 0) {
+                scene->viewX = v[0]; scene->viewY = v[1]; scene->viewW = v[2]; scene->viewH = v[3];
+            }
+            const char* w = Attr(el.attrs, "width");
+            const char* h = Attr(el.attrs, "height");
+            bool wPct = w && strchr(w, '%');
+            bool hPct = h && strchr(h, '%');
+            scene->width = (w && !wPct) ? ParseLength(w, 0, 0) : scene->viewW;
+            scene->height = (h && !hPct) ? ParseLength(h, 0, 0) : scene->viewH;
+            if (scene->viewW <= 0 || scene->viewH <= 0) {
+                scene->viewW = scene->width > 0 ? scene->width : 100;
+                scene->viewH = scene->height > 0 ? scene->height : 100;
+            }
+            if (scene->width <= 0) scene->width = scene->viewW;
+            if (scene->height <= 0) scene->height = scene->viewH;
+
+            Frame root;
+            root.name = el.name;
+            root.opacity = 1;
+            root.hidden = false;
+            scene->ApplyStyle(el.attrs, root.style, root.opacity);
+            if (!el.selfClosing) stack.push_back(root);
+            continue;
+        }
+
+        Frame parent;
+        if (!stack.empty()) {
+            parent = stack.back();
+        } else {
+            parent.opacity = 1;
+            parent.hidden = true;  // Content after the root element
+        }
+
+        Frame frame = parent;
+        frame.name = el.name;
+        const char* display = Attr(el.attrs, "display");
+        if (display && Trim(display) == "none") frame.hidden = true;
+        if (el.name == "defs" || el.name == "clipPath" || el.name == "mask" || el.name == "symbol" ||
+            el.name == "pattern" || el.name == "marker" || el.name == "style" || el.name == "text" ||
+            el.name == "metadata" || el.name == "title" || el.name == "desc") {
+            frame.hidden = true;
+        }
+        if (const char* tr = Attr(el.attrs, "transform")) {
+            frame.transform = parent.transform * ParseTransform(tr);
+        }
+        scene->ApplyStyle(el.attrs, frame.style, frame.opacity);
+
+        if (el.name == "linearGradient" || el.name == "radialGradient") {
+            scene->ParseGradient(el);
+        } else if (el.name == "stop") {
+            scene->ParseStop(el);
+        } else if (!frame.hidden && frame.style.visible) {
+            PathBuilder pb;
+            if (scene->BuildShape(el, pb)) {
+                Shape shape;
+                shape.path = pb.cmds;
+                shape.style = frame.style;
+                shape.transform = frame.transform;
+                shape.opacity = frame.opacity;
+
+                float* b = shape.bounds;
+                b[0] = b[1] = 1e30f;
+                b[2] = b[3] = -1e30f;
+                for (const PathCmd& c : shape.path) {
+                    int n = c.op == PathCmd::Cubic ? 3 : (c.op == PathCmd::Close ? 0 : 1);
+                    for (int i = 0; i < n; i++) {
+                        b[0] = std::min(b[0], c.p[i * 2]);
+                        b[1] = std::min(b[1], c.p[i * 2 + 1]);
+                        b[2] = std::max(b[2], c.p[i * 2]);
+                        b[3] = std::max(b[3], c.p[i * 2 + 1]);
+                    }
+                }
+                scene->shapes.push_back(shape);
+            }
+        }
+
+        if (!el.selfClosing) stack.push_back(frame);
+    }
+
+    if (!sawRoot) return nullptr;
+    scene->ResolveGradients();
+    return std::unique_ptr<SvgImage>(new SvgImage(std::move(scene)));
+}
+
+std::vector<uint8_t> SvgImage::Render(uint32_t size) const {
+    const Scene& sc = *m_scene;
+    Canvas canvas((int)size);
+    Rasterizer ras((int)size, (int)size);
+
+    // Aspect-fit the viewBox and center it
+    float scale = std::min(size / sc.viewW, size / sc.viewH);
+    float tx = (size - sc.viewW * scale) / 2 - sc.viewX * scale;
+    float ty = (size - sc.viewH * scale) / 2 - sc.viewY * scale;
+    Matrix view = Matrix::Make(scale, 0, 0, scale, tx, ty);
+
+    for (const Shape& shape : sc.shapes) {
+        Matrix m = view * shape.transform;
+        std::vector<Subpath> subpaths = Flatten(shape.path, m);
+        const Style& st = shape.style;
+
+        Shader fill;
+        if (fill.Init(st.fill, st.fillOpacity * shape.opacity, sc, m, shape.bounds)) {
+            ras.Clear();
+            for (const Subpath& sp : subpaths) ras.AddPolygon(sp.points);
+            PaintShape(canvas, ras, st.fillRule, fill);
+        }
+
+        Shader stroke;
+        float hw = st.strokeWidth * m.Scale() / 2.0f;
+        if (hw > 0 && std::isfinite(hw) && stroke.Init(st.stroke, st.strokeOpacity * shape.opacity, sc, m, shape.bounds)) {
+            ras.Clear();
+            for (const Subpath& sp : subpaths) StrokeSubpath(ras, sp.points, sp.closed, hw, st);
+            PaintShape(canvas, ras, FillRule::NonZero, stroke);
+        }
+    }
+
+    // Unpremultiply into BGRA8
+    std::vector<uint8_t> out((size_t)size * size * 4);
+    for (size_t i = 0; i < (size_t)size * size; i++) {
+        const float* p = &canvas.px[i * 4];
+        float a = std::min(1.0f, std::max(0.0f, p[3]));
+        uint8_t* d = &out[i * 4];
+        if (a <= 0.0f) {
+            d[0] = d[1] = d[2] = d[3] = 0;
+            continue;
+        }
+        d[0] = (uint8_t)(std::min(1.0f, p[2] / a) * 255.0f + 0.5f);
+        d[1] = (uint8_t)(std::min(1.0f, p[1] / a) * 255.0f + 0.5f);
+        d[2] = (uint8_t)(std::min(1.0f, p[0] / a) * 255.0f + 0.5f);
+        d[3] = (uint8_t)(a * 255.0f + 0.5f);
+    }
+    return out;
+}
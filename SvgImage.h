@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Parsed SVG document that can be rasterized at any icon size.
+// Covers the subset logos use in practice: path, rect, circle, ellipse,
+// line, polyline and polygon inside nested groups, transforms, solid and
+// linear/radial gradient paints, strokes with joins and caps, and opacity.
+// CSS style sheets, text, filters, masks and <use> are ignored.
+class SvgImage {
+public:
+    ~SvgImage();
+
+    // Returns nullptr if text is not a usable SVG document
+    static std::unique_ptr<SvgImage> Parse(const std::string& text);
+
+    // Renders the document aspect-fit and centered into a size x size canvas.
+    // Output is top-down, non-premultiplied BGRA.
+    std::vector<uint8_t> Render(uint32_t size) const;
+
+    float Width() const;
+    float Height() const;
+
+    // Parsed document (opaque outside SvgImage.cpp)
+    struct Scene;
+
+private:
+    explicit SvgImage(std::unique_ptr<Scene> scene);
+
+    std::unique_ptr<Scene> m_scene;
+};
@@ -0,0 +1,578 @@
+#include "TargetChecker.h"
+#include "Prewarmer.h"
+#include "TlsClient.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET SocketHandle;
+static const SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+static const SocketHandle kInvalidSocket = -1;
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// How often pending name lookups are looked at
+const int kLookupPollMs = 5;
+
+// Response headers larger than this are reported as a bad response
+const size_t kMaxHeaderBytes = 64 * 1024;
+
+void CloseSocket(SocketHandle s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool SetNonBlocking(SocketHandle s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool WouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+int PollSockets(pollfd* fds, size_t count, int timeoutMs) {
+#ifdef _WIN32
+    return WSAPoll(fds, (ULONG)count, timeoutMs);
+#else
+    return poll(fds, (nfds_t)count, timeoutMs);
+#endif
+}
+
+std::string Lower(std::string text) {
+    for (char& c : text) c = (char)tolower((unsigned char)c);
+    return text;
+}
+
+std::string Trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos) return std::string();
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Removes "." and ".." segments from an absolute path (RFC 3986 5.2.4)
+std::string RemoveDotSegments(const std::string& path) {
+    std::vector<std::string> segments;
+    size_t pos = 1;
+    while (pos <= path.size()) {
+        size_t slash = path.find('/', pos);
+        std::string segment = path.substr(pos, slash == std::string::npos ? std::string::npos : slash - pos);
+        bool last = slash == std::string::npos;
+        if (segment == "..") {
+            if (!segments.empty()) segments.pop_back();
+            if (last) segments.push_back("");
+        } else if (segment == ".") {
+            if (last) segments.push_back("");
+        } else {
+            segments.push_back(segment);
+        }
+        if (last) break;
+        pos = slash + 1;
+    }
+    std::string out;
+    for (const std::string& segment : segments) out += "/" + segment;
+    return out.empty() ? "/" : out;
+}
+
+// A name lookup shared by every request to one host
+struct Lookup {
+    std::mutex mutex;
+    bool done = false;
+    std::vector<std::string> addresses;
+};
+
+enum class Phase { Resolving, Connecting, Handshaking, Exchanging, Finished };
+
+// One attempt at a target, through its redirects
+struct Request {
+    size_t target = 0;
+    bool first = false;             // The target's first attempt; its chain is reported
+    Clock::time_point start;
+    Clock::time_point deadline;     // Of the current hop
+    std::vector<CheckHop> chain;
+    std::string url;
+    TargetChecker::Url parts;
+    Phase phase = Phase::Resolving;
+    std::shared_ptr<Lookup> lookup;
+    size_t nextAddress = 0;
+    SocketHandle socket = kInvalidSocket;
+    std::unique_ptr<TlsClient> tls;
+    std::string request;            // The GET for the current hop
+    std::string out;                // Bytes to send (encrypted for https)
+    size_t outPos = 0;
+    std::string response;           // Plain response bytes so far
+    bool ok = false;
+    std::string error;
+};
+
+class Loop {
+public:
+    Loop(const CheckOptions& options) : m_options(options) {
+        if (!m_options.resolver) m_options.resolver = &Prewarmer::SystemResolve;
+    }
+
+    void Begin(Request& r, const std::string& url);
+    void Advance(Request& r, short revents);
+    void CheckLookup(Request& r);
+    void Fail(Request& r, const std::string& error);
+
+private:
+    std::shared_ptr<Lookup> StartLookup(const std::string& host);
+    void ConnectNext(Request& r);
+    void Connected(Request& r);
+    void Received(Request& r, const char* data, size_t len);
+    void Responded(Request& r, int status, const std::string& location);
+    void CloseConnection(Request& r);
+
+    CheckOptions m_options;
+    std::map<std::string, std::shared_ptr<Lookup>> m_lookups;
+};
+
+std::shared_ptr<Lookup> Loop::StartLookup(const std::string& host) {
+    std::shared_ptr<Lookup>& lookup = m_lookups[host];
+    if (!lookup) {
+        lookup = std::make_shared<Lookup>();
+        std::shared_ptr<Lookup> shared = lookup;
+        CheckResolver resolver = m_options.resolver;
+        std::thread([shared, resolver, host] {
+            std::vector<std::string> addresses = resolver(host);
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->addresses = addresses;
+            shared->done = true;
+        }).detach();
+    }
+    return lookup;
+}
+
+void Loop::Begin(Request& r, const std::string& url) {
+    r.url = url;
+    r.chain.push_back(CheckHop());
+    r.chain.back().url = url;
+    r.deadline = Clock::now() + std::chrono::milliseconds(m_options.timeoutMs);
+    if (!TargetChecker::ParseUrl(url, r.parts)) {
+        Fail(r, "not an http(s) URL");
+        return;
+    }
+    if (r.parts.https && !TlsClient::Available()) {
+        Fail(r, "https not supported on this platform");
+        return;
+    }
+    r.phase = Phase::Resolving;
+    r.nextAddress = 0;
+    r.lookup = StartLookup(r.parts.host);
+    CheckLookup(r);
+}
+
+void Loop::CheckLookup(Request& r) {
+    {
+        std::lock_guard<std::mutex> lock(r.lookup->mutex);
+        if (!r.lookup->done) return;
+    }
+    if (r.lookup->addresses.empty()) {
+        Fail(r, "name lookup failed");
+        return;
+    }
+    ConnectNext(r);
+}
+
+// Tries the host's addresses in resolver order, like the browser will
+void Loop::ConnectNext(Request& r) {
+    CloseConnection(r);
+    const std::vector<std::string>& addresses = r.lookup->addresses;
+    while (r.nextAddress < addresses.size()) {
+        const std::string& address = addresses[r.nextAddress++];
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+        addrinfo* info = nullptr;
+        if (getaddrinfo(address.c_str(), std::to_string(r.parts.port).c_str(), &hints, &info) != 0 || !info) {
+            continue;
+        }
+        SocketHandle s = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (s == kInvalidSocket || !SetNonBlocking(s)) {
+            if (s != kInvalidSocket) CloseSocket(s);
+            freeaddrinfo(info);
+            continue;
+        }
+        int result = connect(s, info->ai_addr, (int)info->ai_addrlen);
+        bool pending = result != 0 && WouldBlock();
+        freeaddrinfo(info);
+        if (result == 0 || pending) {
+            r.socket = s;
+            r.phase = Phase::Connecting;
+            if (result == 0) Connected(r);
+            return;
+        }
+        CloseSocket(s);
+    }
+    Fail(r, "connection failed");
+}
+
+void Loop::Connected(Request& r) {
+    std::string host = r.parts.host.find(':') != std::string::npos ? "[" + r.parts.host + "]" : r.parts.host;
+    if (r.parts.port != (r.parts.https ? 443 : 80)) {
+        host += ":" + std::to_string(r.parts.port);
+    }
+    r.request = "GET " + r.parts.path + " HTTP/1.1\r\n"
+        "Host: " + host + "\r\n"
+        "User-Agent: ww-check/1.0\r\n"
+        "Accept: text/html,*/*\r\n"
+        "Accept-Encoding: identity\r\n"
+        "Connection: close\r\n\r\n";
+    r.out.clear();
+    r.outPos = 0;
+    r.response.clear();
+    if (!r.parts.https) {
+        r.out = r.request;
+        r.phase = Phase::Exchanging;
+        return;
+    }
+
+    // The request is encrypted once the handshake is done
+    r.tls.reset(new TlsClient());
+    if (r.tls->Start(r.parts.host, r.out) == TlsClient::Status::Failed) {
+        Fail(r, "tls " + r.tls->Error());
+        return;
+    }
+    r.phase = Phase::Handshaking;
+}
+
+void Loop::Advance(Request& r, short revents) {
+    if (r.phase == Phase::Connecting) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(r.socket, SOL_SOCKET, SO_ERROR, (char*)&error, &len);
+        if (error != 0 || !(revents & POLLOUT)) {
+            ConnectNext(r);
+        } else {
+            Connected(r);
+        }
+        return;
+    }
+
+    if (r.outPos < r.out.size()) {
+        if (!(revents & (POLLOUT | POLLERR | POLLHUP))) return;
+        int flags = 0;
+#ifdef MSG_NOSIGNAL
+        flags = MSG_NOSIGNAL;
+#endif
+        int sent = (int)send(r.socket, r.out.data() + r.outPos, (int)(r.out.size() - r.outPos), flags);
+        if (sent < 0) {
+            if (!WouldBlock()) Fail(r, "connection reset");
+            return;
+        }
+        r.outPos += sent;
+        return;
+    }
+
+    if (!(revents & (POLLIN | POLLERR | POLLHUP))) return;
+    char buffer[16384];
+    int received = (int)recv(r.socket, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+        if (!WouldBlock()) Fail(r, "connection reset");
+        return;
+    }
+    if (received == 0) {
+        Fail(r, r.phase == Phase::Handshaking ? "tls closed during handshake" : "connection closed");
+        return;
+    }
+    Received(r, buffer, received);
+}
+
+void Loop::Received(Request& r, const char* data, size_t len) {
+    if (r.phase == Phase::Handshaking) {
+        TlsClient::Status status = r.tls->Handshake(data, len, r.out);
+        if (status == TlsClient::Status::Failed) {
+            Fail(r, "tls " + r.tls->Error());
+        } else if (status == TlsClient::Status::Done) {
+            r.phase = Phase::Exchanging;
+            if (!r.tls->Encrypt(r.request, r.out)) {
+                Fail(r, "tls " + r.tls->Error());
+            } else {
+                Received(r, nullptr, 0);  // Records that came with the last handshake message
+            }
+        }
+        return;
+    }
+
+    if (r.tls) {
+        if (!r.tls->Decrypt(data, len, r.response)) {
+            Fail(r, "tls " + r.tls->Error());
+            return;
+        }
+    } else {
+        r.response.append(data, len);
+    }
+
+    size_t end = r.response.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (r.response.size() > kMaxHeaderBytes) {
+            Fail(r, "bad response");
+        } else if (r.tls && r.tls->Closed()) {
+            Fail(r, "connection closed");
+        }
+        return;
+    }
+
+    // "HTTP/1.1 302 Found", then headers
+    int status = 0;
+    if (r.response.compare(0, 5, "HTTP/") == 0) {
+        size_t space = r.response.find(' ');
+        if (space != std::string::npos && space < end) status = atoi(r.response.c_str() + space + 1);
+    }
+    if (status < 100 || status > 999) {
+        Fail(r, "bad response");
+        return;
+    }
+    std::string location;
+    for (size_t line = r.response.find("\r\n") + 2; line < end;) {
+        size_t next = r.response.find("\r\n", line);
+        std::string header = r.response.substr(line, next - line);
+        size_t colon = header.find(':');
+        if (colon != std::string::npos && Lower(Trim(header.substr(0, colon))) == "location") {
+            location = Trim(header.substr(colon + 1));
+        }
+        line = next + 2;
+    }
+    Responded(r, status, location);
+}
+
+void Loop::Responded(Request& r, int status, const std::string& location) {
+    CloseConnection(r);
+    r.chain.back().status = status;
+    bool redirect = status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+    if (!redirect || location.empty()) {
+        r.ok = status < 400;
+        if (!r.ok) r.error = "HTTP " + std::to_string(status);
+        r.phase = Phase::Finished;
+        return;
+    }
+
+    std::string next = TargetChecker::ResolveLocation(r.url, location);
+    for (const CheckHop& hop : r.chain) {
+        if (hop.url == next) {
+            r.chain.push_back(CheckHop());
+            r.chain.back().url = next;
+            Fail(r, "redirect loop");
+            return;
+        }
+    }
+    if ((int)r.chain.size() > m_options.maxRedirects) {
+        Fail(r, "too many redirects");
+        return;
+    }
+    Begin(r, next);
+}
+
+void Loop::Fail(Request& r, const std::string& error) {
+    CloseConnection(r);
+    r.ok = false;
+    r.error = error;
+    r.phase = Phase::Finished;
+}
+
+void Loop::CloseConnection(Request& r) {
+    if (r.socket != kInvalidSocket) {
+        CloseSocket(r.socket);
+        r.socket = kInvalidSocket;
+    }
+    r.tls.reset();
+    r.out.clear();
+    r.outPos = 0;
+}
+
+void Record(CheckReport& report, const Request& r) {
+    report.attempts++;
+    if (r.first) {
+        report.chain = r.chain;
+        report.status = r.chain.empty() ? 0 : r.chain.back().status;
+    }
+    if (r.ok) {
+        report.latency.Record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - r.start).count());
+    } else {
+        report.failures++;
+        if (report.error.empty()) report.error = r.error;
+    }
+}
+
+}
+
+bool TargetChecker::ParseUrl(const std::string& url, Url& parts) {
+    if (!Prewarmer::ParseOrigin(Utf8::ToWide(url), parts.host, parts.port)) {
+        return false;
+    }
+    size_t schemeEnd = url.find("://");
+    parts.https = Lower(url.substr(0, schemeEnd)) == "https";
+    size_t pathStart = url.find_first_of("/?#", schemeEnd + 3);
+    std::string path = pathStart == std::string::npos ? std::string() : url.substr(pathStart);
+    path = path.substr(0, path.find('#'));
+    if (path.empty() || path[0] != '/') path = "/" + path;
+    parts.path = path;
+    return true;
+}
+
+std::string TargetChecker::ResolveLocation(const std::string& base, const std::string& location) {
+    std::string target = Trim(location);
+    target = target.substr(0, target.find('#'));
+    size_t schemeEnd = target.find("://");
+    if (schemeEnd != std::string::npos && schemeEnd > 0 &&
+        target.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+.-") >= schemeEnd) {
+        return target;
+    }
+
+    size_t baseScheme = base.find("://");
+    if (baseScheme == std::string::npos) {
+        return target;
+    }
+    if (target.compare(0, 2, "//") == 0) {
+        return base.substr(0, baseScheme + 1) + target;
+    }
+    size_t pathStart = base.find_first_of("/?#", baseScheme + 3);
+    std::string origin = base.substr(0, pathStart);
+    std::string basePath = pathStart == std::string::npos ? "/" : base.substr(pathStart);
+    basePath = basePath.substr(0, basePath.find_first_of("?#"));
+    if (basePath.empty()) basePath = "/";
+
+    if (target.empty()) {
+        return base.substr(0, base.find('#'));
+    }
+    if (target[0] == '?') {
+        return origin + basePath + target;
+    }
+    std::string query;
+    size_t queryStart = target.find('?');
+    if (queryStart != std::string::npos) {
+        query = target.substr(queryStart);
+        target = target.substr(0, queryStart);
+    }
+    std::string path = target[0] == '/' ? target : basePath.substr(0, basePath.rfind('/') + 1) + target;
+    return origin + RemoveDotSegments(path) + query;
+}
+
+std::vector<CheckReport> TargetChecker::Run(const std::vector<CheckTarget>& targets, const CheckOptions& options) {
+#ifdef _WIN32
+    WSADATA wsa;
+    bool winsock = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+#endif
+    std::vector<CheckReport> reports(targets.size());
+    std::deque<std::unique_ptr<Request>> queue;
+    for (unsigned sample = 0; sample < std::max(1u, options.samples); sample++) {
+        for (size_t i = 0; i < targets.size(); i++) {
+            std::unique_ptr<Request> r(new Request());
+            r->target = i;
+            r->first = sample == 0;
+            queue.push_back(std::move(r));
+        }
+    }
+    for (size_t i = 0; i < targets.size(); i++) {
+        reports[i].name = targets[i].name;
+        reports[i].url = targets[i].url;
+    }
+
+    Loop loop(options);
+    size_t concurrency = std::max(1u, options.concurrency);
+    std::vector<std::unique_ptr<Request>> active;
+    std::vector<pollfd> fds;
+    std::vector<Request*> polled;
+    while (!queue.empty() || !active.empty()) {
+        while (active.size() < concurrency && !queue.empty()) {
+            std::unique_ptr<Request> r = std::move(queue.front());
+            queue.pop_front();
+            r->start = Clock::now();
+            loop.Begin(*r, Utf8::FromWide(targets[r->target].url));
+            active.push_back(std::move(r));
+        }
+
+        // Sleep until a socket is ready, the next deadline passes, or it is
+        // time to look at pending name lookups again
+        Clock::time_point now = Clock::now();
+        long long timeoutMs = -1;
+        fds.clear();
+        polled.clear();
+        for (const std::unique_ptr<Request>& r : active) {
+            if (r->phase == Phase::Finished) {
+                timeoutMs = 0;
+                continue;
+            }
+            long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(r->deadline - now).count() + 1;
+            if (r->phase == Phase::Resolving) {
+                remaining = std::min<long long>(remaining, kLookupPollMs);
+            } else {
+                pollfd fd = {};
+                fd.fd = r->socket;
+                fd.events = (r->phase == Phase::Connecting || r->outPos < r->out.size()) ? POLLOUT : POLLIN;
+                fds.push_back(fd);
+                polled.push_back(r.get());
+            }
+            remaining = std::max<long long>(remaining, 0);
+            if (timeoutMs < 0 || remaining < timeoutMs) timeoutMs = remaining;
+        }
+        if (fds.empty()) {
+            if (timeoutMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        } else {
+            // Note: WSAPoll before Windows 10 2004 doesn't report refused
+            // connections; those run into the deadline instead
+            PollSockets(fds.data(), fds.size(), (int)std::max<long long>(timeoutMs, 0));
+        }
+
+        for (size_t i = 0; i < polled.size(); i++) {
+            if (fds[i].revents) loop.Advance(*polled[i], fds[i].revents);
+        }
+        now = Clock::now();
+        for (std::unique_ptr<Request>& r : active) {
+            if (r->phase == Phase::Resolving) loop.CheckLookup(*r);
+            if (r->phase != Phase::Finished && now >= r->deadline) {
+                loop.Fail(*r, "timed out");
+            }
+            if (r->phase == Phase::Finished) {
+                Record(reports[r->target], *r);
+                r.reset();
+            }
+        }
+        active.erase(std::remove(active.begin(), active.end(), nullptr), active.end());
+    }
+
+    for (CheckReport& report : reports) {
+        report.ok = report.attempts > 0 && report.failures == 0;
+    }
+#ifdef _WIN32
+    if (winsock) WSACleanup();
+#endif
+    return reports;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "LatencyHistogram.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One app target to check
+struct CheckTarget {
+    std::wstring name;
+    std::wstring url;
+};
+
+// One request of a redirect chain
+struct CheckHop {
+    std::string url;
+    int status = 0;                 // 0 when no response arrived
+};
+
+struct CheckReport {
+    std::wstring name;
+    std::wstring url;
+    bool ok = false;                // Every attempt ended below 400 after its redirects
+    int status = 0;                 // Final status of the first attempt (0: none)
+    std::string error;              // First failure ("timed out", "redirect loop", ...)
+    std::vector<CheckHop> chain;    // Requests made by the first attempt
+    unsigned attempts = 0;
+    unsigned failures = 0;
+    LatencyHistogram latency;       // Microseconds to the final response of each successful attempt
+};
+
+// Returns numeric addresses for host ("127.0.0.1", "::1", ...)
+typedef std::function<std::vector<std::string>(const std::string& host)> CheckResolver;
+
+struct CheckOptions {
+    unsigned concurrency = 32;      // Requests in flight at once
+    int timeoutMs = 10000;          // Deadline of each request, from name lookup to response headers
+    int maxRedirects = 10;
+    unsigned samples = 3;           // Attempts per target, for the latency percentiles
+    CheckResolver resolver;         // Empty: getaddrinfo
+};
+
+// Checks that http(s) targets answer, with a single-threaded event loop
+// over non-blocking sockets (poll/WSAPoll), so hundreds of targets are
+// checked with a bounded number of connections and no thread per request.
+//
+// Each attempt sends a GET with "Connection: close", reads the status line
+// and headers, and follows redirects (Location) up to maxRedirects,
+// reporting a URL seen twice as a loop. Only headers are read. Name lookups
+// run on background threads, one per host, and are shared by every request
+// to that host; a lookup that outlives the deadline is abandoned. https
+// needs TlsClient, which is only available on Windows.
+//
+// Attempts are spread out: every target's first attempt is made before any
+// target's second.
+class TargetChecker {
+public:
+    // Results are in the same order as targets
+    static std::vector<CheckReport> Run(const std::vector<CheckTarget>& targets, const CheckOptions& options);
+
+    struct Url {
+        bool https = false;
+        std::string host;           // Lowercase; IPv6 without brackets
+        uint16_t port = 0;
+        std::string path;           // Path and query, at least "/"
+    };
+
+    // Splits an absolute http(s) URL; the fragment is dropped
+    static bool ParseUrl(const std::string& url, Url& parts);
+
+    // Absolute URL a Location header value points to from base
+    static std::string ResolveLocation(const std::string& base, const std::string& location);
+};
@@ -0,0 +1,243 @@
+#include "TlsClient.h"
+
+#ifdef _WIN32
+#define SECURITY_WIN32
+#include "Utf8.h"
+#include <windows.h>
+#include <schannel.h>
+#include <security.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#pragma comment(lib, "secur32.lib")
+
+namespace {
+
+const DWORD kContextFlags = ISC_REQ_SEQUENCE_DETECT | ISC_REQ_REPLAY_DETECT | ISC_REQ_CONFIDENTIALITY |
+    ISC_REQ_ALLOCATE_MEMORY | ISC_REQ_STREAM | ISC_REQ_USE_SUPPLIED_CREDS;
+
+std::string HandshakeError(SECURITY_STATUS status) {
+    switch (status) {
+    case SEC_E_UNTRUSTED_ROOT:
+    case SEC_E_CERT_EXPIRED:
+    case SEC_E_WRONG_PRINCIPAL:
+    case SEC_E_CERT_UNKNOWN:
+    case CRYPT_E_REVOKED:
+        return "certificate";
+    case SEC_I_INCOMPLETE_CREDENTIALS:
+        return "client certificate requested";
+    default:
+        return "handshake";
+    }
+}
+
+}
+
+struct TlsClient::Session {
+    CredHandle credentials = {};
+    CtxtHandle context = {};
+    bool haveCredentials = false;
+    bool haveContext = false;
+    bool established = false;
+    std::wstring host;
+    std::string input;  // Received bytes not consumed yet
+    SecPkgContext_StreamSizes sizes = {};
+
+    ~Session() {
+        if (haveContext) DeleteSecurityContext(&context);
+        if (haveCredentials) FreeCredentialsHandle(&credentials);
+    }
+};
+
+TlsClient::TlsClient() {
+}
+
+TlsClient::~TlsClient() {
+}
+
+bool TlsClient::Available() {
+    return true;
+}
+
+TlsClient::Status TlsClient::Start(const std::string& host, std::string& out) {
+    m_session.reset(new Session());
+    m_session->host = Utf8::ToWide(host);
+    m_closed = false;
+
+    // TLS 1.2 keeps record handling simple (no post-handshake messages)
+    // and is accepted by every server a web app would be on
+    SCHANNEL_CRED cred = {};
+    cred.dwVersion = SCHANNEL_CRED_VERSION;
+    cred.grbitEnabledProtocols = SP_PROT_TLS1_2_CLIENT;
+    cred.dwFlags = SCH_CRED_AUTO_CRED_VALIDATION | SCH_CRED_NO_DEFAULT_CREDS | SCH_USE_STRONG_CRYPTO;
+    if (AcquireCredentialsHandleW(nullptr, (SEC_WCHAR*)UNISP_NAME_W, SECPKG_CRED_OUTBOUND, nullptr, &cred,
+            nullptr, nullptr, &m_session->credentials, nullptr) != SEC_E_OK) {
+        m_error = "credentials";
+        return Status::Failed;
+    }
+    m_session->haveCredentials = true;
+    return Handshake(nullptr, 0, out);
+}
+
+TlsClient::Status TlsClient::Handshake(const char* data, size_t len, std::string& out) {
+    if (!m_session || !m_session->haveCredentials) {
+        m_error = "not started";
+        return Status::Failed;
+    }
+    Session& s = *m_session;
+    if (len) s.input.append(data, len);
+
+    // One call per handshake message; a single read may hold several
+    for (;;) {
+        bool first = !s.haveContext;
+        if (!first && s.input.empty()) {
+            return Status::NeedMore;
+        }
+
+        SecBuffer in[2] = {};
+        in[0].BufferType = SECBUFFER_TOKEN;
+        in[0].cbBuffer = (ULONG)s.input.size();
+        in[0].pvBuffer = s.input.empty() ? nullptr : &s.input[0];
+        in[1].BufferType = SECBUFFER_EMPTY;
+        SecBufferDesc inDesc = { SECBUFFER_VERSION, 2, in };
+        SecBuffer token = {};
+        token.BufferType = SECBUFFER_TOKEN;
+        SecBufferDesc outDesc = { SECBUFFER_VERSION, 1, &token };
+        ULONG flags = 0;
+
+        SECURITY_STATUS status = InitializeSecurityContextW(&s.credentials, first ? nullptr : &s.context,
+            &s.host[0], kContextFlags, 0, 0, first ? nullptr : &inDesc, 0, first ? &s.context : nullptr,
+            &outDesc, &flags, nullptr);
+        if (token.pvBuffer) {
+            out.append((const char*)token.pvBuffer, token.cbBuffer);
+            FreeContextBuffer(token.pvBuffer);
+        }
+        if (status == SEC_E_INCOMPLETE_MESSAGE) {
+            return Status::NeedMore;
+        }
+        if (status != SEC_E_OK && status != SEC_I_CONTINUE_NEEDED) {
+            m_error = HandshakeError(status);
+            return Status::Failed;
+        }
+        s.haveContext = true;
+
+        // Whatever the call didn't consume belongs to the next message
+        if (!first) {
+            if (in[1].BufferType == SECBUFFER_EXTRA && in[1].cbBuffer < s.input.size()) {
+                s.input.erase(0, s.input.size() - in[1].cbBuffer);
+            } else {
+                s.input.clear();
+            }
+        }
+
+        if (status == SEC_E_OK) {
+            if (QueryContextAttributesW(&s.context, SECPKG_ATTR_STREAM_SIZES, &s.sizes) != SEC_E_OK) {
+                m_error = "handshake";
+                return Status::Failed;
+            }
+            s.established = true;
+            return Status::Done;
+        }
+        if (first) {
+            return Status::NeedMore;
+        }
+    }
+}
+
+bool TlsClient::Encrypt(const std::string& plain, std::string& out) {
+    if (!m_session || !m_session->established) {
+        m_error = "not connected";
+        return false;
+    }
+    Session& s = *m_session;
+    const SecPkgContext_StreamSizes& sizes = s.sizes;
+    for (size_t pos = 0; pos < plain.size();) {
+        size_t chunk = std::min<size_t>(plain.size() - pos, sizes.cbMaximumMessage);
+        std::vector<char> record(sizes.cbHeader + chunk + sizes.cbTrailer);
+        memcpy(&record[sizes.cbHeader], plain.data() + pos, chunk);
+
+        SecBuffer buffers[4] = {};
+        buffers[0] = { sizes.cbHeader, SECBUFFER_STREAM_HEADER, &record[0] };
+        buffers[1] = { (ULONG)chunk, SECBUFFER_DATA, &record[sizes.cbHeader] };
+        buffers[2] = { sizes.cbTrailer, SECBUFFER_STREAM_TRAILER, &record[sizes.cbHeader + chunk] };
+        buffers[3].BufferType = SECBUFFER_EMPTY;
+        SecBufferDesc desc = { SECBUFFER_VERSION, 4, buffers };
+        if (EncryptMessage(&s.context, 0, &desc, 0) != SEC_E_OK) {
+            m_error = "encrypt";
+            return false;
+        }
+        out.append(&record[0], buffers[0].cbBuffer + buffers[1].cbBuffer + buffers[2].cbBuffer);
+        pos += chunk;
+    }
+    return true;
+}
+
+bool TlsClient::Decrypt(const char* data, size_t len, std::string& plain) {
+    if (!m_session || !m_session->established) {
+        m_error = "not connected";
+        return false;
+    }
+    Session& s = *m_session;
+    if (len) s.input.append(data, len);
+    while (!s.input.empty() && !m_closed) {
+        SecBuffer buffers[4] = {};
+        buffers[0] = { (ULONG)s.input.size(), SECBUFFER_DATA, &s.input[0] };
+        buffers[1].BufferType = buffers[2].BufferType = buffers[3].BufferType = SECBUFFER_EMPTY;
+        SecBufferDesc desc = { SECBUFFER_VERSION, 4, buffers };
+        SECURITY_STATUS status = DecryptMessage(&s.context, &desc, 0, nullptr);
+        if (status == SEC_E_INCOMPLETE_MESSAGE) {
+            return true;
+        }
+        if (status != SEC_E_OK && status != SEC_I_CONTEXT_EXPIRED) {
+            m_error = status == SEC_I_RENEGOTIATE ? "renegotiation" : "decrypt";
+            return false;
+        }
+
+        // Decrypted in place; copy out before the input buffer changes
+        std::string extra;
+        for (const SecBuffer& b : buffers) {
+            if (b.BufferType == SECBUFFER_DATA && b.cbBuffer) {
+                plain.append((const char*)b.pvBuffer, b.cbBuffer);
+            } else if (b.BufferType == SECBUFFER_EXTRA && b.cbBuffer) {
+                extra.assign((const char*)b.pvBuffer, b.cbBuffer);
+            }
+        }
+        s.input.swap(extra);
+        m_closed = status == SEC_I_CONTEXT_EXPIRED;
+    }
+    return true;
+}
+
+#else
+
+TlsClient::TlsClient() {
+}
+
+TlsClient::~TlsClient() {
+}
+
+bool TlsClient::Available() {
+    return false;
+}
+
+TlsClient::Status TlsClient::Start(const std::string&, std::string&) {
+    m_error = "not supported on this platform";
+    return Status::Failed;
+}
+
+TlsClient::Status TlsClient::Handshake(const char*, size_t, std::string&) {
+    m_error = "not supported on this platform";
+    return Status::Failed;
+}
+
+bool TlsClient::Encrypt(const std::string&, std::string&) {
+    m_error = "not supported on this platform";
+    return false;
+}
+
+bool TlsClient::Decrypt(const char*, size_t, std::string&) {
+    m_error = "not supported on this platform";
+    return false;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Client side of a TLS connection that does no I/O itself: bytes read from
+// the socket go in, bytes to write come out. This lets a single-threaded
+// event loop drive many handshakes at once over non-blocking sockets.
+//
+// Backed by SChannel on Windows (TLS 1.2, certificates checked against
+// the system store with the host name). Other platforms have no
+// implementation; Available() is false there and Start fails.
+class TlsClient {
+public:
+    enum class Status { NeedMore, Done, Failed };
+
+    TlsClient();
+    ~TlsClient();
+
+    TlsClient(const TlsClient&) = delete;
+    TlsClient& operator=(const TlsClient&) = delete;
+
+    static bool Available();
+
+    // Begins the handshake with host (used for SNI and certificate
+    // checks); appends the ClientHello to out
+    Status Start(const std::string& host, std::string& out);
+
+    // Feeds handshake bytes from the server; appends any reply to out.
+    // Bytes after the handshake are kept for Decrypt.
+    Status Handshake(const char* data, size_t len, std::string& out);
+
+    // Appends the records carrying plain to out
+    bool Encrypt(const std::string& plain, std::string& out);
+
+    // Feeds application bytes from the server; appends what could be
+    // decrypted so far to plain. False on a bad record; Closed() once the
+    // server sent close_notify.
+    bool Decrypt(const char* data, size_t len, std::string& plain);
+    bool Closed() const { return m_closed; }
+
+    // Why the last call failed ("certificate", "handshake", ...)
+    const std::string& Error() const { return m_error; }
+
+private:
+#ifdef _WIN32
+    struct Session;  // SChannel credentials, context and buffered input
+    std::unique_ptr<Session> m_session;
+#endif
+    bool m_closed = false;
+    std::string m_error;
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include <string>
+
+// UTF-8 <-> wide string conversion that works with both 16-bit (Windows)
+// and 32-bit (Linux) wchar_t. Invalid sequences become U+FFFD.
+class Utf8 {
+public:
+    static std::wstring ToWide(const std::string& utf8);
+    static std::string FromWide(const std::wstring& wide);
+};
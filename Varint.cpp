@@ -0,0 +1,36 @@
+#include "Varint.h"
+
+void Varint::Put(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+void Varint::PutString(std::string& out, const std::string& value) {
+    Put(out, value.size());
+    out.append(value);
+}
+
+bool Varint::Get(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Varint::GetString(const uint8_t*& p, const uint8_t* end, std::string& value) {
+    uint64_t len = 0;
+    if (!Get(p, end, len) || len > (uint64_t)(end - p)) {
+        return false;
+    }
+    value.assign((const char*)p, (size_t)len);
+    p += len;
+    return true;
+}
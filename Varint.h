@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// LEB128 unsigned varints for compact binary records
+class Varint {
+public:
+    static void Put(std::string& out, uint64_t value);
+    static void PutString(std::string& out, const std::string& value);
+
+    // Advance p past the decoded value; false on truncated or overlong input
+    static bool Get(const uint8_t*& p, const uint8_t* end, uint64_t& value);
+    static bool GetString(const uint8_t*& p, const uint8_t* end, std::string& value);
+};
@@ -1,76 +1,195 @@
 #include "WebViewWindow.h"
 #include "IconHelper.h"
+#include "FileUtil.h"
+#include "AppPaths.h"
+#include "CachePruner.h"
+#include "ImageBlur.h"
+#include "LaunchScheduler.h"
+#include "MemoryStream.h"
+#include "StartupTiming.h"
+#include "MetricsLog.h"
+#include "PngDecoder.h"
+#include "Utf8.h"
 #include <wrl.h>
 #include <wrl/event.h>
 #include <iostream>
 
 #define WM_LOADING_TIMER 1
+#define REDIRECT_SETTLE_TIMER 2
+#define SNAPSHOT_IDLE_TIMER 3
+#define SNAPSHOT_CLOSE_TIMER 4
+
+// Quiet period after the last automatic navigation before the launch
+// redirect chain is considered settled
+static const UINT kRedirectSettleMs = 3000;
+
+// Upper bound on background DNS + TCP prewarming of the target origin
+static const int kPrewarmTimeoutMs = 2000;
+
+// Quiet period after the last navigation before the page is captured for
+// the next launch's snapshot
+static const UINT kSnapshotIdleMs = 5000;
+
+// How long closing the window may wait for the final capture
+static const UINT kSnapshotCloseTimeoutMs = 500;
+
+// How far the snapshot is blended toward the loading background (of 256),
+// so it reads as not ready yet and the loading text stays legible
+static const unsigned kSnapshotTint = 144;
+
+const wchar_t* const WebViewWindow::kAssetOrigin = L"https://app.webwrap/";
+
+// Content-Type for a bundled asset, by extension
+static std::wstring AssetContentType(const std::string& path) {
+    static const struct { const char* ext; const wchar_t* type; } kTypes[] = {
+        { ".html", L"text/html; charset=utf-8" }, { ".htm", L"text/html; charset=utf-8" },
+        { ".js", L"text/javascript; charset=utf-8" }, { ".mjs", L"text/javascript; charset=utf-8" },
+        { ".css", L"text/css; charset=utf-8" }, { ".json", L"application/json" },
+        { ".svg", L"image/svg+xml" }, { ".png", L"image/png" }, { ".jpg", L"image/jpeg" },
+        { ".jpeg", L"image/jpeg" }, { ".gif", L"image/gif" }, { ".webp", L"image/webp" },
+        { ".ico", L"image/x-icon" }, { ".woff2", L"font/woff2" }, { ".woff", L"font/woff" },
+        { ".wasm", L"application/wasm" }, { ".txt", L"text/plain; charset=utf-8" },
+    };
+    size_t dot = path.find_last_of('.');
+    std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    for (const auto& t : kTypes) {
+        if (ext == t.ext) return t.type;
+    }
+    return L"application/octet-stream";
+}
+
+// Copies out what a stream created by CreateStreamOnHGlobal holds
+static bool ReadHGlobalStream(IStream* stream, std::vector<uint8_t>& data) {
+    STATSTG stat = {};
+    HGLOBAL global = nullptr;
+    if (FAILED(stream->Stat(&stat, STATFLAG_NONAME)) || FAILED(GetHGlobalFromStream(stream, &global))) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)GlobalLock(global);
+    if (!bytes) {
+        return false;
+    }
+    data.assign(bytes, bytes + (size_t)stat.cbSize.QuadPart);
+    GlobalUnlock(global);
+    return true;
+}
+
+// Decodes a captured PNG and stores it as key's snapshot
+static void StoreSnapshot(const std::wstring& dir, const std::wstring& key, const std::vector<uint8_t>& png) {
+    PngImage image;
+    size_t bytes = 0;
+    if (!PngDecoder::Decode(png.data(), png.size(), image) ||
+        !SnapshotStore::Save(dir, key, image.bgra.data(), image.width, image.height, (size_t)image.width * 4, &bytes)) {
+        std::wcerr << L"Warning: Failed to store launch snapshot\n";
+        return;
+    }
+    std::wcout << L"Launch snapshot stored (" << image.width << L"x" << image.height << L" capture, "
+               << bytes << L" bytes)\n";
+}
+
+// Bundle name for a request URL under kAssetOrigin ("a%20b/" -> "assets/a b/index.html")
+static std::string AssetName(const std::wstring& uri) {
+    std::string path = Utf8::FromWide(uri.substr(wcslen(WebViewWindow::kAssetOrigin)));
+    path = path.substr(0, path.find_first_of("?#"));
+    std::string decoded;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '%' && i + 2 < path.size() && isxdigit((unsigned char)path[i + 1]) &&
+            isxdigit((unsigned char)path[i + 2])) {
+            decoded.push_back((char)strtol(path.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            decoded.push_back(path[i]);
+        }
+    }
+    if (decoded.empty() || decoded.back() == '/') {
+        decoded += "index.html";
+    }
+    return AppBundle::kAssetPrefix + decoded;
+}
 
 WebViewWindow::WebViewWindow(const std::wstring& title,
     const std::wstring& iconPath,
-    const std::wstring& url)
-    : m_title(title), m_iconPath(iconPath), m_url(url)
+    const std::wstring& url,
+    const std::wstring& userDataFolder,
+    uint64_t cacheBudgetBytes,
+    const AppBundle* bundle,
+    const std::wstring& injectScript)
+    : m_bundle(bundle), m_title(title), m_iconPath(iconPath), m_url(url), m_userDataFolder(userDataFolder),
+      m_cacheBudgetBytes(cacheBudgetBytes), m_injectScript(injectScript), m_redirects(m_redirectStore)
 {
     // Generate unique window class name to avoid conflicts
     static int instanceCounter = 0;
     wchar_t className[256];
     swprintf_s(className, L"WebWrapWindowClass_%d_%p", instanceCounter++, this);
     m_className = className;
+
+    // Skip redirects we've already seen this target go through
+    std::wstring storePath = AppPaths::DataFile(L"redirects.kv");
+    if (!storePath.empty()) {
+        m_redirectStore.Open(storePath);
+    }
+    m_navigateUrl = m_redirects.Lookup(m_url);
+    m_usingMemoizedUrl = !m_navigateUrl.empty();
+    if (m_usingMemoizedUrl) {
+        std::wcout << L"Using memoized redirect target: " << m_navigateUrl << L"\n";
+    } else {
+        m_navigateUrl = m_url;
+    }
+
+    // Warm up DNS and a TCP connection to the origin while the window,
+    // environment and controller are being created
+    if (m_prewarmer.Start(m_navigateUrl, kPrewarmTimeoutMs)) {
+        std::wcout << L"Prewarming connection to target origin\n";
+    }
     
-    // Load icon BEFORE creating window if provided
-    if (!m_iconPath.empty()) {
-        // Convert to absolute path first
-        wchar_t absolutePath[MAX_PATH];
-        DWORD result = GetFullPathNameW(m_iconPath.c_str(), MAX_PATH, absolutePath, nullptr);
-        std::wstring absIconPath = (result > 0) ? std::wstring(absolutePath) : m_iconPath;
-        
+    // A built app carries its icon already converted, so nothing is read or
+    // converted from disk
+    const uint8_t* bundledIcon = nullptr;
+    size_t bundledIconSize = 0;
+    if (m_bundle && m_bundle->Find(AppBundle::kIconName, bundledIcon, bundledIconSize)) {
+        m_hIconLarge = IconHelper::LoadIconFromIcoData(bundledIcon, bundledIconSize, 32);
+        m_hIconSmall = IconHelper::LoadIconFromIcoData(bundledIcon, bundledIconSize, 16);
+        if (m_hIconLarge && m_hIconSmall) {
+            std::wcout << L"✓ Icons loaded from bundle\n";
+            UseBrandColors();
+        } else {
+            std::wcerr << L"✗ Failed to load bundled icon\n";
+        }
+    } else if (!m_iconPath.empty()) {
+        // Load icon BEFORE creating window if provided. It is converted in
+        // memory (or read from a shortcut's cached conversion) and the icons
+        // are created from those bytes; nothing is written or re-read.
+        std::wstring absIconPath = FileUtil::Absolute(m_iconPath);
         std::wcout << L"Loading icon from: " << absIconPath << L"\n";
-        
-        // Validate icon file exists
-        if (GetFileAttributesW(absIconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-            // Get the converted icon path (handles PNG to ICO conversion)
-            std::wstring iconPath = IconHelper::GetConvertedIconPath(absIconPath);
-            
-            std::wcout << L"Converted icon path: " << iconPath << L"\n";
-            
-            if (!iconPath.empty() && GetFileAttributesW(iconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-                // Load large icon (32x32)
-                m_hIconLarge = (HICON)LoadImageW(
-                    nullptr,
-                    iconPath.c_str(),
-                    IMAGE_ICON,
-                    32,
-                    32,
-                    LR_LOADFROMFILE);
-                
-                // Load small icon (16x16 for title bar)
-                m_hIconSmall = (HICON)LoadImageW(
-                    nullptr,
-                    iconPath.c_str(),
-                    IMAGE_ICON,
-                    16,
-                    16,
-                    LR_LOADFROMFILE);
-                
-                if (m_hIconLarge && m_hIconSmall) {
-                    std::wcout << L"✓ Icons loaded successfully (Large: " << m_hIconLarge 
-                               << L", Small: " << m_hIconSmall << L")\n";
-                } else {
-                    std::wcerr << L"✗ Failed to load icons from file: " << absIconPath << L"\n";
-                    DWORD error = GetLastError();
-                    std::wcerr << L"  Error code: " << error << L"\n";
-                    std::wcerr << L"  Icon path: " << iconPath << L"\n";
-                    if (!m_hIconLarge) std::wcerr << L"  Large icon failed\n";
-                    if (!m_hIconSmall) std::wcerr << L"  Small icon failed\n";
-                }
+
+        PreparedIcon icon;
+        if (IconHelper::PrepareIcon(absIconPath, icon)) {
+            // Large icon (32x32) and small icon (16x16 for title bar)
+            m_hIconLarge = IconHelper::LoadIconFromIcoData(icon.ico.data(), icon.ico.size(), 32);
+            m_hIconSmall = IconHelper::LoadIconFromIcoData(icon.ico.data(), icon.ico.size(), 16);
+
+            if (m_hIconLarge && m_hIconSmall) {
+                std::wcout << L"✓ Icons loaded successfully (Large: " << m_hIconLarge
+                           << L", Small: " << m_hIconSmall << L")" << (icon.fromCache ? L" from cache" : L"") << L"\n";
+                UseBrandColors(icon.colors.valid ? &icon.colors : nullptr);
             } else {
-                std::wcerr << L"✗ Failed to get converted icon path or file doesn't exist\n";
+                std::wcerr << L"✗ Failed to create icons from: " << absIconPath << L"\n";
+                DWORD error = GetLastError();
+                std::wcerr << L"  Error code: " << error << L"\n";
+                if (!m_hIconLarge) std::wcerr << L"  Large icon failed\n";
+                if (!m_hIconSmall) std::wcerr << L"  Small icon failed\n";
             }
         } else {
-            std::wcerr << L"✗ Icon file not found: " << absIconPath << L"\n";
+            std::wcerr << L"✗ Failed to load icon: " << absIconPath << L"\n";
         }
     }
 
+    StartupTiming::Mark("icon");
+
+    // Last launch's page, painted until this one has content
+    LoadSnapshot();
+
     // Register window class with icon using WNDCLASSEXW for small icon support
     WNDCLASSEXW wc = {};
     wc.cbSize = sizeof(WNDCLASSEXW);
@@ -101,6 +220,7 @@ WebViewWindow::WebViewWindow(const std::wstring& title,
         std::wcerr << L"Error: Failed to create window.\n";
         return;
     }
+    StartupTiming::Mark("window");
 
     // Set icons on the window instance as well (belt and suspenders approach)
     if (m_hIconLarge && m_hIconSmall) {
@@ -118,6 +238,13 @@ WebViewWindow::WebViewWindow(const std::wstring& title,
 }
 
 WebViewWindow::~WebViewWindow() {
+    // Keep what we learned if the window closes before the settle timer fires
+    FinishLaunchTracking();
+
+    if (m_snapshotWorker.joinable()) {
+        m_snapshotWorker.join();
+    }
+
     // Clean up WebView2 resources in proper order
     if (m_webview) {
         m_webview.Reset();
@@ -149,8 +276,13 @@ WebViewWindow::~WebViewWindow() {
 }
 
 void WebViewWindow::InitWebView() {
+    // A separate user-data folder per app means separate profile locks, so
+    // apps don't serialize their startup on a shared profile
+    if (!m_userDataFolder.empty()) {
+        std::wcout << L"Profile folder: " << m_userDataFolder << L"\n";
+    }
     HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(
-        nullptr, nullptr, nullptr,
+        nullptr, m_userDataFolder.empty() ? nullptr : m_userDataFolder.c_str(), nullptr,
         Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
             [this](HRESULT result, ICoreWebView2Environment* env) -> HRESULT {
                 if (FAILED(result)) {
@@ -166,6 +298,8 @@ void WebViewWindow::InitWebView() {
                     PostQuitMessage(-1);
                     return E_FAIL;
                 }
+                StartupTiming::Mark("environment");
+                m_environment = env;
 
                 HRESULT hr = env->CreateCoreWebView2Controller(
                     m_hWnd,
@@ -184,6 +318,7 @@ void WebViewWindow::InitWebView() {
                                 return E_FAIL;
                             }
 
+                            StartupTiming::Mark("controller");
                             m_controller = controller;
                             HRESULT hr = m_controller->get_CoreWebView2(&m_webview);
                             
@@ -201,26 +336,64 @@ void WebViewWindow::InitWebView() {
                             // Hide the WebView2 initially while loading
                             m_controller->put_IsVisible(FALSE);
 
-                            // Add NavigationCompleted event handler
+                            // Track the launch redirect chain
                             EventRegistrationToken token;
+                            m_webview->add_NavigationStarting(
+                                Microsoft::WRL::Callback<ICoreWebView2NavigationStartingEventHandler>(
+                                    [this](ICoreWebView2* sender, ICoreWebView2NavigationStartingEventArgs* args) -> HRESULT {
+                                        OnNavigationStarting(args);
+                                        return S_OK;
+                                    }).Get(), &token);
+
+                            m_webview->add_SourceChanged(
+                                Microsoft::WRL::Callback<ICoreWebView2SourceChangedEventHandler>(
+                                    [this](ICoreWebView2* sender, ICoreWebView2SourceChangedEventArgs* args) -> HRESULT {
+                                        LPWSTR source = nullptr;
+                                        if (!m_launchSettled && SUCCEEDED(sender->get_Source(&source)) && source) {
+                                            m_settledUrl = source;
+                                            CoTaskMemFree(source);
+                                        }
+                                        return S_OK;
+                                    }).Get(), &token);
+
+                            // Add NavigationCompleted event handler
                             m_webview->add_NavigationCompleted(
                                 Microsoft::WRL::Callback<ICoreWebView2NavigationCompletedEventHandler>(
                                     [this](ICoreWebView2* sender, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT {
+                                        if (TryFallbackFromMemoizedUrl(args)) {
+                                            return S_OK;  // Keep the loading screen up
+                                        }
+
+                                        BOOL success = FALSE;
+                                        args->get_IsSuccess(&success);
+                                        if (success && !m_launchSettled) {
+                                            // Restart the quiet period after every automatic hop
+                                            SetTimer(m_hWnd, REDIRECT_SETTLE_TIMER, kRedirectSettleMs, nullptr);
+                                        }
                                         OnNavigationCompleted();
                                         return S_OK;
                                     }).Get(), &token);
 
-                            // Navigate to the URL
-                            hr = m_webview->Navigate(m_url.c_str());
+                            if (m_bundle) {
+                                ServeBundleAssets();
+                            }
+
+                            // Registered once; WebView2 runs it again on every document
+                            if (!m_injectScript.empty()) {
+                                m_webview->AddScriptToExecuteOnDocumentCreated(m_injectScript.c_str(), nullptr);
+                            }
+
+                            // Navigate to the URL (or its memoized redirect target)
+                            hr = m_webview->Navigate(m_navigateUrl.c_str());
                             if (FAILED(hr)) {
-                                std::wcerr << L"Error: Failed to navigate to URL: " << m_url 
+                                std::wcerr << L"Error: Failed to navigate to URL: " << m_navigateUrl 
                                            << L". HRESULT: 0x" << std::hex << hr << std::dec << L"\n";
                                 // Show error and stop loading
                                 m_isLoading = false;
                                 InvalidateRect(m_hWnd, nullptr, TRUE);
                             } else {
                                 m_webviewInitialized = true;
-                                std::wcout << L"Successfully navigating to: " << m_url << L"\n";
+                                std::wcout << L"Successfully navigating to: " << m_navigateUrl << L"\n";
                             }
 
                             return S_OK;
@@ -243,8 +416,66 @@ void WebViewWindow::InitWebView() {
     }
 }
 
+void WebViewWindow::ServeBundleAssets() {
+    std::wstring filter = std::wstring(kAssetOrigin) + L"*";
+    m_webview->AddWebResourceRequestedFilter(filter.c_str(), COREWEBVIEW2_WEB_RESOURCE_CONTEXT_ALL);
+
+    EventRegistrationToken token;
+    m_webview->add_WebResourceRequested(
+        Microsoft::WRL::Callback<ICoreWebView2WebResourceRequestedEventHandler>(
+            [this](ICoreWebView2* sender, ICoreWebView2WebResourceRequestedEventArgs* args) -> HRESULT {
+                Microsoft::WRL::ComPtr<ICoreWebView2WebResourceRequest> request;
+                LPWSTR uri = nullptr;
+                if (FAILED(args->get_Request(&request)) || FAILED(request->get_Uri(&uri)) || !uri) {
+                    return S_OK;
+                }
+                std::string name = AssetName(uri);
+                CoTaskMemFree(uri);
+
+                // Responses read straight from the mapped executable
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+                Microsoft::WRL::ComPtr<ICoreWebView2WebResourceResponse> response;
+                if (m_bundle->Find(name, data, size)) {
+                    std::wstring headers = L"Content-Type: " + AssetContentType(name);
+                    m_environment->CreateWebResourceResponse(MemoryStream::Create(data, size).Get(),
+                        200, L"OK", headers.c_str(), &response);
+                } else {
+                    m_environment->CreateWebResourceResponse(nullptr, 404, L"Not Found", L"", &response);
+                }
+                args->put_Response(response.Get());
+                return S_OK;
+            }).Get(), &token);
+}
+
 void WebViewWindow::OnNavigationCompleted() {
     std::wcout << L"Navigation completed. Showing content...\n";
+    if (m_isLoading) {
+        StartupTiming::Mark("navigation");
+
+        // Lets --launch-all start the next app
+        LaunchScheduler::SignalReady();
+        RecordPrewarm();
+        StartupTiming::Report();
+
+        // Keep this launch for `ww stats`
+        std::wstring metricsPath = MetricsLog::DefaultPath();
+        if (!metricsPath.empty() &&
+            !MetricsLog::AppendLaunch(metricsPath, Utf8::FromWide(m_title), StartupTiming::Phases())) {
+            std::wcerr << L"Warning: Failed to record startup metrics: " << metricsPath << L"\n";
+        }
+
+        // Trim other apps' caches now that this one is up
+        CachePruner::StartBackground(AppPaths::ProfilesDirectory(), m_cacheBudgetBytes, m_userDataFolder);
+
+        // The real page replaces the snapshot from here on
+        m_snapshot = SnapshotImage();
+    }
+
+    // Capture once things have been quiet for a while
+    if (!m_snapshotDir.empty()) {
+        SetTimer(m_hWnd, SNAPSHOT_IDLE_TIMER, kSnapshotIdleMs, nullptr);
+    }
     
     // Stop loading state
     m_isLoading = false;
@@ -258,18 +489,149 @@ void WebViewWindow::OnNavigationCompleted() {
     InvalidateRect(m_hWnd, nullptr, TRUE);
 }
 
+void WebViewWindow::RecordPrewarm() {
+    // The browser has its own connection by now; stop anything still pending
+    m_prewarmer.Cancel();
+    if (!m_prewarmer.Finished()) {
+        std::wcout << L"Prewarm still resolving at first navigation\n";
+        return;
+    }
+
+    PrewarmResult r = m_prewarmer.Result();
+    StartupTiming::Record("prewarm-dns", r.dnsMs);
+    if (r.resolved) {
+        StartupTiming::Record("prewarm-connect", r.connectMs);
+    }
+    std::wcout << L"Prewarm: " << r.addressCount << L" address(es), "
+               << (r.connected ? L"connected" : r.timedOut ? L"timed out" : r.cancelled ? L"cancelled" : L"not connected")
+               << L"\n";
+}
+
+void WebViewWindow::OnNavigationStarting(ICoreWebView2NavigationStartingEventArgs* args) {
+    if (m_launchSettled) {
+        return;
+    }
+
+    // A navigation the user started ends the automatic redirect chain
+    BOOL userInitiated = FALSE;
+    args->get_IsUserInitiated(&userInitiated);
+    if (userInitiated && m_launchNavigations > 0) {
+        FinishLaunchTracking();
+        return;
+    }
+    m_launchNavigations++;
+}
+
+bool WebViewWindow::TryFallbackFromMemoizedUrl(ICoreWebView2NavigationCompletedEventArgs* args) {
+    if (!m_usingMemoizedUrl || m_launchSettled) {
+        return false;
+    }
+
+    BOOL success = FALSE;
+    args->get_IsSuccess(&success);
+    int status = 0;
+    Microsoft::WRL::ComPtr<ICoreWebView2NavigationCompletedEventArgs2> args2;
+    if (SUCCEEDED(args->QueryInterface(IID_PPV_ARGS(&args2)))) {
+        args2->get_HttpStatusCode(&status);
+    }
+
+    COREWEBVIEW2_WEB_ERROR_STATUS error = COREWEBVIEW2_WEB_ERROR_STATUS_UNKNOWN;
+    args->get_WebErrorStatus(&error);
+    bool superseded = !success && error == COREWEBVIEW2_WEB_ERROR_STATUS_OPERATION_CANCELED;
+    if ((success && status < 400) || superseded) {
+        return false;
+    }
+
+    std::wcerr << L"Memoized URL failed (HTTP " << status << L", error " << error
+               << L"), falling back to: " << m_url << L"\n";
+    m_redirects.Invalidate(m_url);
+    m_usingMemoizedUrl = false;
+    m_settledUrl.clear();
+    m_launchNavigations = 0;
+    m_navigateUrl = m_url;
+    if (FAILED(m_webview->Navigate(m_url.c_str()))) {
+        return false;
+    }
+    return true;
+}
+
+void WebViewWindow::FinishLaunchTracking() {
+    if (m_launchSettled) {
+        return;
+    }
+    m_launchSettled = true;
+    if (m_hWnd) {
+        KillTimer(m_hWnd, REDIRECT_SETTLE_TIMER);
+    }
+
+    if (!m_settledUrl.empty()) {
+        m_redirects.RecordSettled(m_url, m_settledUrl);
+        if (m_settledUrl != m_url) {
+            std::wcout << L"Launch settled on: " << m_settledUrl << L" after "
+                       << m_launchNavigations << L" navigation(s)\n";
+        }
+    }
+}
+
+void WebViewWindow::UseBrandColors(const ImageColors* known) {
+    ImageColors colors;
+    if (known) {
+        colors = *known;
+    } else if (!IconHelper::GetIconColors(m_hIconLarge, colors)) {
+        return;
+    }
+
+    // A very light or very dark dominant color (typically a plain icon
+    // background) says little about the brand; prefer the accent then
+    const ImageColor& d = colors.dominant;
+    int luma = (d.r * 299 + d.g * 587 + d.b * 114) / 1000;
+    const ImageColor& c = (luma > 235 || luma < 20) ? colors.accent : d;
+    m_loadingBackground = RGB(c.r, c.g, c.b);
+
+    // Dark text on light backgrounds, light text on dark ones
+    luma = (c.r * 299 + c.g * 587 + c.b * 114) / 1000;
+    m_loadingText = luma > 150 ? RGB(60, 60, 60) : RGB(240, 240, 240);
+}
+
 void WebViewWindow::DrawLoadingScreen(HDC hdc, const RECT& rect) {
     // Calculate center of window
     int centerX = (rect.right - rect.left) / 2;
     int centerY = (rect.bottom - rect.top) / 2;
-    
-    // Fill background with white
-    HBRUSH whiteBrush = (HBRUSH)GetStockObject(WHITE_BRUSH);
-    FillRect(hdc, &rect, whiteBrush);
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+
+    if (!m_snapshot.bgra.empty() && width > 0 && height > 0) {
+        // Stretch last launch's page over the window. When the aspect ratio
+        // changed, crop the right or bottom: pages are laid out from the top left.
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = (LONG)m_snapshot.width;
+        bmi.bmiHeader.biHeight = -(LONG)m_snapshot.height;  // Top-down
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        int srcWidth = (int)m_snapshot.width;
+        int srcHeight = (int)m_snapshot.height;
+        if ((int64_t)srcWidth * height > (int64_t)srcHeight * width) {
+            srcWidth = (int)((int64_t)srcHeight * width / height);
+        } else {
+            srcHeight = (int)((int64_t)srcWidth * height / width);
+        }
+        SetStretchBltMode(hdc, HALFTONE);
+        SetBrushOrgEx(hdc, 0, 0, nullptr);
+        StretchDIBits(hdc, rect.left, rect.top, width, height, 0, 0, srcWidth, srcHeight,
+            m_snapshot.bgra.data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
+    } else {
+        // Fill background with the brand color (white without an icon)
+        HBRUSH background = CreateSolidBrush(m_loadingBackground);
+        FillRect(hdc, &rect, background);
+        DeleteObject(background);
+    }
     
     // Draw loading text
     SetBkMode(hdc, TRANSPARENT);
-    SetTextColor(hdc, RGB(100, 100, 100));
+    SetTextColor(hdc, m_loadingText);
     
     HFONT hFont = CreateFontW(20, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
         DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
@@ -287,6 +649,84 @@ void WebViewWindow::DrawLoadingScreen(HDC hdc, const RECT& rect) {
     DeleteObject(hFont);
 }
 
+void WebViewWindow::LoadSnapshot() {
+    m_snapshotDir = SnapshotStore::Directory();
+    m_snapshotKey = m_title + L"\n" + m_url;
+    if (m_snapshotDir.empty() || !SnapshotStore::Load(m_snapshotDir, m_snapshotKey, m_snapshot)) {
+        return;
+    }
+
+    // Blurred when stored; dimmed here, toward this launch's brand color
+    ImageBlur::Tint(m_snapshot.bgra.data(), m_snapshot.width, m_snapshot.height, (size_t)m_snapshot.width * 4,
+        GetRValue(m_loadingBackground), GetGValue(m_loadingBackground), GetBValue(m_loadingBackground),
+        kSnapshotTint);
+    std::wcout << L"✓ Launch snapshot loaded (" << m_snapshot.width << L"x" << m_snapshot.height << L")\n";
+    StartupTiming::Mark("snapshot");
+}
+
+bool WebViewWindow::CaptureSnapshot() {
+    if (!m_webview || m_isLoading || m_capturing || m_snapshotDir.empty()) {
+        return false;
+    }
+
+    Microsoft::WRL::ComPtr<IStream> stream;
+    if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &stream))) {
+        return false;
+    }
+    HRESULT hr = m_webview->CapturePreview(COREWEBVIEW2_CAPTURE_PREVIEW_IMAGE_FORMAT_PNG, stream.Get(),
+        Microsoft::WRL::Callback<ICoreWebView2CapturePreviewCompletedHandler>(
+            [this, stream](HRESULT result) -> HRESULT {
+                m_capturing = false;
+                std::vector<uint8_t> png;
+                if (FAILED(result) || !ReadHGlobalStream(stream.Get(), png)) {
+                    png.clear();
+                }
+                OnSnapshotCaptured(std::move(png));
+                return S_OK;
+            }).Get());
+    m_capturing = SUCCEEDED(hr);
+    return m_capturing;
+}
+
+void WebViewWindow::OnSnapshotCaptured(std::vector<uint8_t> png) {
+    // One store at a time; they write the same file
+    if (m_snapshotWorker.joinable()) {
+        m_snapshotWorker.join();
+    }
+
+    if (m_closing) {
+        // Decoding and storing take a few tens of ms; the window is going anyway
+        if (!png.empty()) {
+            StoreSnapshot(m_snapshotDir, m_snapshotKey, png);
+        }
+        FinishClose();
+        return;
+    }
+    if (!png.empty()) {
+        std::wstring dir = m_snapshotDir;
+        std::wstring key = m_snapshotKey;
+        m_snapshotWorker = std::thread([dir, key, png = std::move(png)]() {
+            StoreSnapshot(dir, key, png);
+        });
+    }
+}
+
+bool WebViewWindow::CaptureOnClose() {
+    // A second close (or one with nothing to capture) goes straight through
+    if (m_closing || (!m_capturing && !CaptureSnapshot())) {
+        return false;
+    }
+    m_closing = true;
+    KillTimer(m_hWnd, SNAPSHOT_IDLE_TIMER);
+    SetTimer(m_hWnd, SNAPSHOT_CLOSE_TIMER, kSnapshotCloseTimeoutMs, nullptr);
+    return true;
+}
+
+void WebViewWindow::FinishClose() {
+    KillTimer(m_hWnd, SNAPSHOT_CLOSE_TIMER);
+    DestroyWindow(m_hWnd);
+}
+
 void WebViewWindow::RunMessageLoop() {
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0)) {
@@ -337,8 +777,36 @@ LRESULT CALLBACK WebViewWindow::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPAR
                 GetClientRect(hWnd, &bounds);
                 self->m_controller->put_Bounds(bounds);
             }
+            // The loading screen is stretched and centered, so all of it moves
+            if (self->m_isLoading) {
+                InvalidateRect(hWnd, nullptr, FALSE);
+            }
             break;
         }
+        case WM_TIMER:
+            if (wParam == REDIRECT_SETTLE_TIMER) {
+                self->FinishLaunchTracking();
+                return 0;
+            }
+            if (wParam == SNAPSHOT_IDLE_TIMER) {
+                KillTimer(hWnd, SNAPSHOT_IDLE_TIMER);
+                self->CaptureSnapshot();
+                return 0;
+            }
+            if (wParam == SNAPSHOT_CLOSE_TIMER) {
+                // The capture took too long; close without it
+                self->FinishClose();
+                return 0;
+            }
+            break;
+
+        case WM_CLOSE:
+            // Keep the window up until the page is captured for next launch
+            if (self->CaptureOnClose()) {
+                return 0;
+            }
+            break;
+
         case WM_DESTROY:
             PostQuitMessage(0);
             return 0;
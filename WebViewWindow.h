@@ -1,34 +1,95 @@
 #pragma once
 #include <windows.h>
 #include <string>
+#include <thread>
+#include <vector>
 #include <wrl.h>
 #include <WebView2.h>
+#include "AppBundle.h"
+#include "ImageAnalysis.h"
+#include "KvStore.h"
+#include "Prewarmer.h"
+#include "RedirectCache.h"
+#include "SnapshotStore.h"
 
 class WebViewWindow {
 public:
+    // userDataFolder: WebView2 profile folder (empty for the runtime default);
+    // cacheBudgetBytes: cache size other apps' profiles are pruned to (0 = off);
+    // bundle: payload of a built app, whose icon replaces iconPath and whose
+    // assets are served under kAssetOrigin (must outlive the window);
+    // injectScript: runs in every page before its own scripts (see InjectBundle)
     WebViewWindow(const std::wstring& title,
         const std::wstring& iconPath,
-        const std::wstring& url);
+        const std::wstring& url,
+        const std::wstring& userDataFolder,
+        uint64_t cacheBudgetBytes,
+        const AppBundle* bundle = nullptr,
+        const std::wstring& injectScript = std::wstring());
     
     ~WebViewWindow();
 
     void RunMessageLoop();
 
+    // Origin bundled web assets are served from, e.g. kAssetOrigin + "index.html"
+    static const wchar_t* const kAssetOrigin;
+
 private:
     HWND m_hWnd = nullptr;
     Microsoft::WRL::ComPtr<ICoreWebView2Controller> m_controller;
     Microsoft::WRL::ComPtr<ICoreWebView2> m_webview;
+    Microsoft::WRL::ComPtr<ICoreWebView2Environment> m_environment;
+    const AppBundle* m_bundle;
     std::wstring m_title;
     std::wstring m_iconPath;
     std::wstring m_url;
+    std::wstring m_userDataFolder;
+    uint64_t m_cacheBudgetBytes;
+    std::wstring m_injectScript;
     std::wstring m_className;
     bool m_webviewInitialized = false;
     bool m_isLoading = true;
     HICON m_hIconLarge = nullptr;
     HICON m_hIconSmall = nullptr;
 
+    // Loading screen colors, taken from the icon when there is one
+    COLORREF m_loadingBackground = RGB(255, 255, 255);
+    COLORREF m_loadingText = RGB(100, 100, 100);
+
+    // Redirect memoization: m_navigateUrl is m_url or where it settled last time
+    KvStore m_redirectStore;
+    RedirectCache m_redirects;
+    std::wstring m_navigateUrl;
+    std::wstring m_settledUrl;
+    bool m_usingMemoizedUrl = false;
+    bool m_launchSettled = false;
+    int m_launchNavigations = 0;
+
+    Prewarmer m_prewarmer;
+
+    // Last-frame snapshot: painted (dimmed) while loading, captured again
+    // once the page has been idle for a while and when the window closes
+    std::wstring m_snapshotDir;
+    std::wstring m_snapshotKey;
+    SnapshotImage m_snapshot;
+    bool m_capturing = false;
+    bool m_closing = false;           // WM_CLOSE waits for the capture, up to a timeout
+    std::thread m_snapshotWorker;     // Stores idle captures off the UI thread
+
     static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
     void InitWebView();
+    void ServeBundleAssets();
+    // Loading screen colors from the icon; known: colors found while converting it
+    void UseBrandColors(const ImageColors* known = nullptr);
     void DrawLoadingScreen(HDC hdc, const RECT& rect);
+    void LoadSnapshot();
+    bool CaptureSnapshot();
+    void OnSnapshotCaptured(std::vector<uint8_t> png);
+    bool CaptureOnClose();
+    void FinishClose();
     void OnNavigationCompleted();
+    void RecordPrewarm();
+    void OnNavigationStarting(ICoreWebView2NavigationStartingEventArgs* args);
+    bool TryFallbackFromMemoizedUrl(ICoreWebView2NavigationCompletedEventArgs* args);
+    void FinishLaunchTracking();
 };
@@ -0,0 +1,65 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned threads, std::function<void()> threadInit, std::function<void()> threadExit) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&WorkerPool::Run, this, threadInit, threadExit);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work.notify_all();
+    for (std::thread& t : m_threads) {
+        t.join();
+    }
+}
+
+void WorkerPool::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_work.notify_one();
+}
+
+void WorkerPool::WaitIdle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_jobs.empty() && m_running == 0; });
+}
+
+void WorkerPool::Run(std::function<void()> threadInit, std::function<void()> threadExit) {
+    if (threadInit) {
+        threadInit();
+    }
+
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                break;  // Stopping and drained
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_running++;
+        }
+
+        job();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0 && m_jobs.empty()) {
+            m_idle.notify_all();
+        }
+    }
+
+    if (threadExit) {
+        threadExit();
+    }
+}
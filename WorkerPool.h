@@ -0,0 +1,40 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool for independent jobs (icon conversions, shortcut
+// writes). threadInit/threadExit run on each worker, e.g. to set up COM.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads,
+        std::function<void()> threadInit = nullptr,
+        std::function<void()> threadExit = nullptr);
+
+    // Finishes queued jobs, then joins the workers
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Submit(std::function<void()> job);
+
+    // Blocks until every submitted job has finished
+    void WaitIdle();
+
+    size_t Size() const { return m_threads.size(); }
+
+private:
+    void Run(std::function<void()> threadInit, std::function<void()> threadExit);
+
+    std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::condition_variable m_idle;
+    std::deque<std::function<void()>> m_jobs;
+    size_t m_running = 0;
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
@@ -0,0 +1,191 @@
+// Allocation tracker benchmark: checks per-phase counts for every form of
+// new/delete, from one and several threads, that nothing is counted while
+// disabled, and that phases past kMaxPhases fold into the last one. Then it
+// times new/delete disabled and enabled against plain malloc/free, and
+// checks an allocation budget for parsing a manifest, the way a CI job
+// would guard a launch path.
+//
+// See README.md ("Allocation Stats") for build and usage.
+
+#include "../AllocTracker.h"
+#include "../Manifest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double NanosecondsSince(Clock::time_point start, int ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+// Keeps the compiler from pairing up and removing new/delete calls
+void* volatile g_sink;
+
+const AllocPhaseStats* FindPhase(const std::vector<AllocPhaseStats>& phases, const std::string& name) {
+    for (const AllocPhaseStats& p : phases) {
+        if (p.name == name) return &p;
+    }
+    return nullptr;
+}
+
+double TimeNewDelete(int ops) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < ops; i++) {
+        char* p = new char[32 + (i & 255)];
+        g_sink = p;
+        delete[] p;
+    }
+    return NanosecondsSince(start, ops);
+}
+
+double TimeMallocFree(int ops) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < ops; i++) {
+        void* p = std::malloc(32 + (i & 255));
+        g_sink = p;
+        std::free(p);
+    }
+    return NanosecondsSince(start, ops);
+}
+
+std::string SampleManifest(int apps) {
+    std::string text = "# apps\n";
+    for (int i = 0; i < apps; i++) {
+        text += "[App " + std::to_string(i) + "]\n";
+        text += "target = https://app" + std::to_string(i) + ".example.com/start\n";
+        text += "icon = C:\\Icons\\app" + std::to_string(i) + ".png\n";
+        text += "profile = work\n\n";
+    }
+    return text;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int ops = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) {
+            ops = std::atoi(argv[++i]);
+        } else {
+            std::printf("Usage: allocbench [--ops N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // Every form of new/delete is counted against the phase it ran in
+    AllocTracker::Enable();
+    std::vector<char*> blocks;
+    blocks.reserve(10);
+    AllocTracker::EndPhase("setup");
+    for (int i = 0; i < 10; i++) blocks.push_back(new char[100]);
+    int* single = new int(7);
+    int* nothrow = new (std::nothrow) int[4];
+    delete single;
+    delete[] nothrow;
+    for (int i = 0; i < 4; i++) delete[] blocks[i];
+    AllocTracker::EndPhase("mixed");
+    for (int i = 4; i < 10; i++) delete[] blocks[i];
+    AllocTracker::EndPhase("cleanup");
+
+    std::vector<AllocPhaseStats> phases = AllocTracker::Phases();
+    const AllocPhaseStats* setup = FindPhase(phases, "setup");
+    const AllocPhaseStats* mixed = FindPhase(phases, "mixed");
+    const AllocPhaseStats* cleanup = FindPhase(phases, "cleanup");
+    Check(setup && setup->allocations == 1 && setup->frees == 0, "setup phase counts its one allocation");
+    Check(mixed && mixed->allocations == 12 && mixed->frees == 6, "array, single and nothrow forms counted");
+    Check(mixed && mixed->bytes >= 1000 + sizeof(int) * 5 && mixed->peakLiveBytes >= setup->peakLiveBytes + 1000,
+        "bytes and peak live bytes counted");
+    Check(cleanup && cleanup->allocations == 0 && cleanup->frees == 6 &&
+        cleanup->peakLiveBytes == mixed->peakLiveBytes - (int64_t)(mixed->freedBytes), "frees land in the phase they ran in");
+    Check(phases.size() == 3, "empty current phase omitted");
+
+    // Allocations from other threads go to the current phase
+    const int threads = 4, perThread = 10000;
+    AllocTracker::Enable();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([] {
+            for (int i = 0; i < perThread; i++) {
+                std::string* s = new std::string(64, 'x');
+                delete s;
+            }
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    workers.clear();
+    workers.shrink_to_fit();
+    AllocTracker::EndPhase("threads");
+    phases = AllocTracker::Phases();
+    Check(phases.size() == 1 && phases[0].name == "threads", "one phase recorded");
+    Check(phases[0].allocations >= (uint64_t)threads * perThread * 2 && phases[0].allocations == phases[0].frees,
+        "every thread's allocations counted and freed");
+
+    // Nothing is counted while disabled; surplus phases fold into the last
+    AllocTracker::Disable();
+    uint64_t before = AllocTracker::Phases().back().allocations;
+    for (int i = 0; i < 100; i++) delete new int(i);
+    Check(AllocTracker::Phases().back().allocations == before, "disabled counts nothing");
+    AllocTracker::Enable();
+    for (int i = 0; i < AllocTracker::kMaxPhases + 5; i++) {
+        delete new int(i);
+        AllocTracker::EndPhase(i < AllocTracker::kMaxPhases - 1 ? "early" : "late");
+    }
+    phases = AllocTracker::Phases();
+    Check(phases.size() == (size_t)AllocTracker::kMaxPhases && phases.back().name == "late" &&
+        phases.back().allocations == 6, "phases past the limit fold into the last");
+    AllocTracker::Disable();
+
+    // Overhead per new/delete pair
+    TimeMallocFree(ops / 10);
+    double mallocNs = TimeMallocFree(ops);
+    double disabledNs = TimeNewDelete(ops);
+    AllocTracker::Enable();
+    double enabledNs = TimeNewDelete(ops);
+    AllocTracker::Disable();
+    std::printf("%-26s %8s\n", "per allocate+free", "ns");
+    std::printf("%-26s %8.1f\n", "malloc/free", mallocNs);
+    std::printf("%-26s %8.1f\n", "new/delete, disabled", disabledNs);
+    std::printf("%-26s %8.1f\n", "new/delete, enabled", enabledNs);
+    Check(disabledNs < mallocNs * 1.5 + 2.0, "disabled tracker adds next to nothing");
+
+    // Budget check, as CI would run it for a launch path
+    const int apps = 20;
+    std::string text = SampleManifest(apps);
+    AllocTracker::Enable();
+    std::vector<ManifestEntry> entries;
+    std::wstring error;
+    bool parsed = Manifest::Parse(text, entries, error);
+    AllocTracker::EndPhase("manifest");
+    AllocTracker::Disable();
+    phases = AllocTracker::Phases();
+    const AllocPhaseStats* manifest = FindPhase(phases, "manifest");
+    double perApp = manifest ? (double)manifest->allocations / apps : 0;
+    std::printf("manifest parse: %.1f allocations, %.0f bytes per app\n", perApp,
+        manifest ? (double)manifest->bytes / apps : 0);
+    Check(parsed && entries.size() == (size_t)apps, "manifest parses");
+    Check(manifest && perApp <= 40, "manifest parse within 40 allocations per app");
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Image analysis benchmark: times ImageAnalysis::AlphaBounds and Colors on
+// 512-4096 px sources, checks the bounds against a plain per-pixel scan on
+// random shapes, checks that a synthetic logo's brand color is found, and
+// measures how much larger the glyph is at 16/32 px once margins are
+// trimmed.
+//
+// Portable; see README.md ("Icon Trimming and Brand Colors") for build and
+// usage.
+
+#include "../ImageAnalysis.h"
+#include "../IconPipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+ImageRect ReferenceBounds(const uint8_t* bgra, uint32_t width, uint32_t height, uint8_t threshold) {
+    uint32_t x0 = width, y0 = height, x1 = 0, y1 = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            if (bgra[((size_t)y * width + x) * 4 + 3] > threshold) {
+                x0 = std::min(x0, x);
+                y0 = std::min(y0, y);
+                x1 = std::max(x1, x);
+                y1 = std::max(y1, y);
+            }
+        }
+    }
+    ImageRect r;
+    if (x0 < width) {
+        r.x = x0;
+        r.y = y0;
+        r.width = x1 - x0 + 1;
+        r.height = y1 - y0 + 1;
+    }
+    return r;
+}
+
+bool SameRect(const ImageRect& a, const ImageRect& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+// Logo-like source: a brand-colored disc with a white mark and a soft
+// edge, covering `coverage` of the canvas side, on transparency
+std::vector<uint8_t> Logo(uint32_t size, float coverage, const uint8_t brand[3]) {
+    std::vector<uint8_t> bgra((size_t)size * size * 4, 0);
+    float c = size / 2.0f, r = size * coverage / 2.0f;
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            float dx = x + 0.5f - c, dy = y + 0.5f - c;
+            float d = std::sqrt(dx * dx + dy * dy);
+            float a = std::min(1.0f, std::max(0.0f, r - d));
+            if (a <= 0) continue;
+            uint8_t* p = &bgra[((size_t)y * size + x) * 4];
+            bool mark = std::fabs(dx) < r * 0.15f && std::fabs(dy) < r * 0.5f;
+            p[0] = mark ? 255 : brand[2];
+            p[1] = mark ? 255 : brand[1];
+            p[2] = mark ? 255 : brand[0];
+            p[3] = (uint8_t)(a * 255 + 0.5f);
+        }
+    }
+    return bgra;
+}
+
+// Fraction of the icon's pixels that are mostly opaque
+double Coverage(const std::vector<uint8_t>& bgra) {
+    size_t visible = 0;
+    for (size_t i = 3; i < bgra.size(); i += 4) visible += bgra[i] >= 128;
+    return (double)visible / (bgra.size() / 4);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::printf("Usage: analysisbench [--iterations N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // Bounds agree with the reference scan on random rectangles and specks,
+    // including odd widths that leave a scalar tail
+    std::mt19937 rng(7);
+    for (int t = 0; t < 300; t++) {
+        uint32_t w = 1 + rng() % 97, h = 1 + rng() % 97;
+        std::vector<uint8_t> img((size_t)w * h * 4, 0);
+        int specks = (int)(rng() % 4);
+        for (int s = 0; s < specks; s++) {
+            uint32_t x = rng() % w, y = rng() % h;
+            img[((size_t)y * w + x) * 4 + 3] = (uint8_t)(1 + rng() % 255);
+        }
+        uint8_t threshold = (uint8_t)(t % 3 == 0 ? 0 : rng() % 200);
+        Check(SameRect(ImageAnalysis::AlphaBounds(img.data(), w, h, (size_t)w * 4, threshold),
+            ReferenceBounds(img.data(), w, h, threshold)), "bounds match the reference scan");
+    }
+
+    // Trim keeps the padding inside the image and the content inside the rect
+    ImageRect content;
+    content.x = 100;
+    content.y = 300;
+    content.width = 200;
+    content.height = 100;
+    ImageRect trimmed = ImageAnalysis::TrimRect(content, 512, 512, 0.1f);
+    Check(trimmed.x == 80 && trimmed.y == 280 && trimmed.width == 240 && trimmed.height == 140,
+        "trim adds padding on every side");
+    trimmed = ImageAnalysis::TrimRect(content, 320, 410, 0.1f);
+    Check(trimmed.x + trimmed.width == 320 && trimmed.y + trimmed.height == 410, "trim clamps to the image");
+
+    const uint8_t brand[3] = { 0xd9, 0x30, 0x25 };
+    std::printf("%-6s %10s %12s %10s %10s %12s\n", "size", "bounds ms", "per-pixel ms", "colors ms",
+        "ico ms", "ico+trim ms");
+    const uint32_t sizes[] = { 512, 1024, 2048, 4096 };
+    for (uint32_t size : sizes) {
+        std::vector<uint8_t> logo = Logo(size, 0.45f, brand);
+        size_t stride = (size_t)size * 4;
+
+        double boundsMs = 1e9, referenceMs = 1e9, colorsMs = 1e9, icoMs = 1e9, trimMs = 1e9;
+        ImageRect bounds;
+        ImageColors colors;
+        std::vector<uint8_t> ico;
+        IcoImage plain, trim;
+        IconPipelineOptions options;
+        options.trim = true;
+        for (int i = 0; i < iterations; i++) {
+            Clock::time_point start = Clock::now();
+            bounds = ImageAnalysis::AlphaBounds(logo.data(), size, size, stride);
+            boundsMs = std::min(boundsMs, MillisecondsSince(start));
+
+            start = Clock::now();
+            ImageRect reference = ReferenceBounds(logo.data(), size, size, 0);
+            referenceMs = std::min(referenceMs, MillisecondsSince(start));
+            Check(SameRect(bounds, reference), "logo bounds match");
+
+            start = Clock::now();
+            colors = ImageAnalysis::Colors(logo.data(), size, size, stride);
+            colorsMs = std::min(colorsMs, MillisecondsSince(start));
+
+            start = Clock::now();
+            IconPipeline::PixelsToIco(logo.data(), size, size, stride, 32, ico, &plain);
+            icoMs = std::min(icoMs, MillisecondsSince(start));
+
+            start = Clock::now();
+            IconPipeline::PixelsToIco(logo.data(), size, size, stride, 32, ico, &trim, nullptr, options);
+            trimMs = std::min(trimMs, MillisecondsSince(start));
+        }
+        std::printf("%-6u %10.3f %12.3f %10.3f %10.2f %12.2f\n", size, boundsMs, referenceMs, colorsMs,
+            icoMs, trimMs);
+
+        Check(colors.valid && std::abs(colors.dominant.r - brand[0]) <= 8 &&
+            std::abs(colors.dominant.g - brand[1]) <= 8 && std::abs(colors.dominant.b - brand[2]) <= 8,
+            "dominant color is the brand color");
+        Check(colors.accent.r == colors.dominant.r && colors.accent.g == colors.dominant.g,
+            "saturated dominant color is also the accent");
+
+        if (size == 512) {
+            // Glyph size at small icon sizes with and without trimming
+            const uint32_t iconSizes[] = { 16, 32 };
+            for (uint32_t iconSize : iconSizes) {
+                IconPipeline::PixelsToIco(logo.data(), size, size, stride, iconSize, ico, &plain);
+                IconPipeline::PixelsToIco(logo.data(), size, size, stride, iconSize, ico, &trim, nullptr, options);
+                double before = Coverage(plain.bgra), after = Coverage(trim.bgra);
+                std::printf("coverage at %u px: %.0f%% -> %.0f%% of the icon\n", iconSize, before * 100, after * 100);
+                Check(after > before * 3, "trimming enlarges the glyph");
+            }
+        }
+    }
+
+    // Fully transparent and fully opaque edge cases
+    std::vector<uint8_t> empty(64 * 64 * 4, 0);
+    Check(ImageAnalysis::AlphaBounds(empty.data(), 64, 64, 256).Empty(), "transparent image has no bounds");
+    Check(!ImageAnalysis::Colors(empty.data(), 64, 64, 256).valid, "transparent image has no colors");
+    ImageRect whole = ImageAnalysis::TrimRect(ImageRect(), 64, 64, 0.1f);
+    Check(whole.width == 64 && whole.height == 64, "empty bounds keep the whole image");
+    std::vector<uint8_t> opaque(64 * 64 * 4, 255);
+    ImageRect full = ImageAnalysis::AlphaBounds(opaque.data(), 64, 64, 256);
+    Check(full.x == 0 && full.y == 0 && full.width == 64 && full.height == 64, "opaque image is all content");
+    ImageColors gray = ImageAnalysis::Colors(opaque.data(), 64, 64, 256);
+    Check(gray.accent.r == gray.dominant.r, "unsaturated image falls back to the dominant color");
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
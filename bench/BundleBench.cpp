@@ -0,0 +1,216 @@
+// Single-file app benchmark: appends payloads to a copy of this executable
+// and checks that every file round-trips, that rebuilding replaces the
+// payload, that damaged indexes and footers are rejected, and that the
+// bundled copy still runs and finds its own payload. Then it compares
+// opening a bundle by mapping it against reading the whole file, for
+// payloads from 1 to 256 MB.
+//
+// POSIX only (runs the bundled copy with fork/exec); see README.md
+// ("Single-File Apps") for build and usage.
+
+#include "../AppBundle.h"
+#include "../FileUtil.h"
+#include "../Utf8.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string RandomBytes(std::mt19937& rng, size_t size) {
+    std::string data(size, '\0');
+    for (char& c : data) c = (char)(rng() & 0xFF);
+    return data;
+}
+
+// A config, an icon and count assets of roughly total bytes
+std::vector<BundleFile> SampleFiles(std::mt19937& rng, int count, size_t total) {
+    std::vector<BundleFile> files(2);
+    files[0].name = AppBundle::kConfigName;
+    files[0].data = "[Bench]\ntarget = index.html\n";
+    files[1].name = AppBundle::kIconName;
+    files[1].data = RandomBytes(rng, 40000);
+    for (int i = 0; i < count; i++) {
+        BundleFile f;
+        f.name = std::string(AppBundle::kAssetPrefix) + (i == 0 ? "index.html" : "lib/file" + std::to_string(i) + ".js");
+        f.data = RandomBytes(rng, i == 0 ? 2000 : total / count);
+        files.push_back(std::move(f));
+    }
+    return files;
+}
+
+bool SameFiles(const AppBundle& bundle, const std::vector<BundleFile>& files) {
+    if (bundle.Count() != files.size()) return false;
+    for (const BundleFile& f : files) {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        if (!bundle.Find(f.name, data, size) || size != f.data.size() ||
+            memcmp(data, f.data.data(), size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rewrites path with the byte at offset from the end flipped
+bool Damage(const std::wstring& from, const std::wstring& to, size_t fromEnd) {
+    std::string data;
+    if (!FileUtil::Read(from, data) || fromEnd > data.size()) return false;
+    data[data.size() - fromEnd] ^= 0x40;
+    return FileUtil::Write(to, data.data(), data.size());
+}
+
+// Runs the bundled copy in child mode; it exits 0 when it finds its config
+int RunBundled(const std::string& path) {
+    chmod(path.c_str(), 0755);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl(path.c_str(), path.c_str(), "--child", (char*)nullptr);
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int RunChild() {
+    AppBundle self;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    if (!self.OpenSelf() || !self.Find(AppBundle::kConfigName, data, size)) return 3;
+    return std::string((const char*)data, size).find("[Bench]") == 0 ? 0 : 4;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--child") {
+        return RunChild();
+    }
+    int maxMb = 256;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-mb" && i + 1 < argc) {
+            maxMb = std::atoi(argv[++i]);
+        } else {
+            std::printf("Usage: bundlebench [--max-mb N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    char path[4096];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0) {
+        std::fprintf(stderr, "cannot locate own executable\n");
+        return 1;
+    }
+    path[len] = 0;
+    std::wstring self = Utf8::ToWide(path);
+    char dirTemplate[] = "/tmp/bundlebench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::fprintf(stderr, "cannot create temp directory\n");
+        return 1;
+    }
+    std::string dir = dirTemplate;
+    std::wstring wdir = Utf8::ToWide(dir);
+    std::wstring app = FileUtil::Join(wdir, L"app");
+    std::wstring damaged = FileUtil::Join(wdir, L"damaged");
+    std::mt19937 rng(38);
+
+    // Round trip, and the copy still runs and finds its own payload
+    std::string image;
+    FileUtil::Read(self, image);
+    Check(AppBundle::ImageSize((const uint8_t*)image.data(), image.size()) == image.size(),
+        "plain executable has no payload");
+    AppBundle bundle;
+    Check(!bundle.Open(self), "plain executable does not open as a bundle");
+    std::vector<BundleFile> files = SampleFiles(rng, 50, 1 << 20);
+    Check(AppBundle::Build(self, app, files), "build");
+    Check(bundle.Open(app) && SameFiles(bundle, files) && bundle.Verify(), "files round-trip");
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    Check(!bundle.Find("assets/missing.js", data, size), "missing file not found");
+    Check(RunBundled(Utf8::FromWide(app)) == 0, "bundled executable runs and reads its payload");
+
+    // Rebuilding from a bundled app keeps the original image
+    std::vector<BundleFile> smaller = SampleFiles(rng, 3, 10000);
+    Check(AppBundle::Build(app, app, smaller), "rebuild");
+    std::string rebuilt;
+    FileUtil::Read(app, rebuilt);
+    Check(AppBundle::ImageSize((const uint8_t*)rebuilt.data(), rebuilt.size()) == image.size() &&
+        memcmp(rebuilt.data(), image.data(), image.size()) == 0, "rebuild replaces the payload");
+    Check(bundle.Open(app) && SameFiles(bundle, smaller), "rebuilt files round-trip");
+
+    // Damage: footer magic, index, file data, truncation
+    Check(Damage(app, damaged, 32) && !bundle.Open(damaged), "bad footer magic rejected");
+    Check(Damage(app, damaged, 40) && !bundle.Open(damaged), "bad index rejected");
+    Check(Damage(app, damaged, 200) && bundle.Open(damaged) && !bundle.Verify(), "bad file data fails Verify");
+    Check(FileUtil::Write(damaged, rebuilt.data(), rebuilt.size() - 1) && !bundle.Open(damaged), "truncated file rejected");
+    AppBundle empty;
+    Check(!empty.Parse(nullptr, 0) && !empty.Parse((const uint8_t*)"WWBUNDLE", 8), "short data rejected");
+
+    // Open and read one asset: mapping versus reading the whole file
+    std::printf("%-10s %14s %14s %14s\n", "payload", "map+find ms", "read+parse ms", "verify ms");
+    for (int mb = 1; mb <= maxMb; mb *= 4) {
+        Check(AppBundle::Build(self, app, SampleFiles(rng, 200, (size_t)mb << 20)), "build large");
+        const int runs = 20;
+        double mapped = 0, read = 0, verify = 0;
+        bool found = true;
+        for (int r = 0; r < runs; r++) {
+            Clock::time_point start = Clock::now();
+            AppBundle b;
+            found = found && b.Open(app) && b.Find("assets/index.html", data, size) && size == 2000;
+            mapped += MillisecondsSince(start) / runs;
+
+            start = Clock::now();
+            std::string whole;
+            AppBundle parsed;
+            found = found && FileUtil::Read(app, whole) &&
+                parsed.Parse((const uint8_t*)whole.data(), whole.size()) &&
+                parsed.Find("assets/index.html", data, size);
+            read += MillisecondsSince(start) / runs;
+
+            if (r == 0) {
+                start = Clock::now();
+                found = found && b.Verify();
+                verify = MillisecondsSince(start);
+            }
+        }
+        std::printf("%4d MB    %14.3f %14.3f %14.1f\n", mb, mapped, read, verify);
+        Check(found, "large bundle opens");
+        if (mb >= 16) Check(mapped < read, "mapping beats reading for large payloads");
+    }
+
+    FileUtil::Remove(app);
+    FileUtil::Remove(damaged);
+    rmdir(dir.c_str());
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,406 @@
+// Target check benchmark: runs TargetChecker against a local stand-in HTTP
+// server whose paths answer, redirect (relative, absolute, in a loop),
+// return errors, answer late, hang or drop the connection, plus a closed
+// port and a resolver with unknown and slow host names. Checks statuses,
+// redirect chains, errors, deadlines, shared name lookups and that no more
+// than the requested number of connections are ever open at once, then
+// measures throughput against fast and slow responses at several
+// concurrency levels.
+//
+// POSIX only (poll-based stand-in server); see README.md ("Target Checks")
+// for build and usage.
+
+#include "../TargetChecker.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Listens on 127.0.0.1 with an ephemeral port
+int Listen(uint16_t& port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (s < 0 || bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 1024) != 0
+        || getsockname(s, (sockaddr*)&addr, &len) != 0) {
+        if (s >= 0) close(s);
+        return -1;
+    }
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    port = ntohs(addr.sin_port);
+    return s;
+}
+
+// Single-threaded HTTP stand-in. Paths:
+//   /ok                 200
+//   /slow/<ms>          200 after ms
+//   /hops/<n>           302 to hops/<n-1> (relative), /hops/0 is 200
+//   /abs                301 to http://127.0.0.1:<port>/ok
+//   /loop/a, /loop/b    302 to each other
+//   /missing            404
+//   /hang               never answers
+//   /drop               closes without answering
+class StandInServer {
+public:
+    bool Start() {
+        m_listener = Listen(m_port);
+        if (m_listener < 0) return false;
+        m_thread = std::thread([this] { Run(); });
+        return true;
+    }
+
+    void Stop() {
+        m_stop = true;
+        if (m_thread.joinable()) m_thread.join();
+        for (const Connection& c : m_connections) close(c.socket);
+        m_connections.clear();
+        if (m_listener >= 0) close(m_listener);
+    }
+
+    uint16_t Port() const { return m_port; }
+    std::string Url(const std::string& path) const { return "http://127.0.0.1:" + std::to_string(m_port) + path; }
+
+    // Most connections open at once since the last reset
+    size_t PeakConnections() const { return m_peak; }
+    size_t Requests() const { return m_requests; }
+    void ResetCounters() { m_peak = 0; m_requests = 0; }
+
+private:
+    struct Connection {
+        int socket;
+        std::string request;
+        bool answered = false;
+        Clock::time_point respondAt;
+        std::string response;
+    };
+
+    void Route(Connection& c) {
+        size_t start = c.request.find(' ') + 1;
+        std::string path = c.request.substr(start, c.request.find(' ', start) - start);
+        c.answered = true;
+        c.respondAt = Clock::now();
+        m_requests++;
+        std::string status = "200 OK", location;
+        if (path.compare(0, 6, "/slow/") == 0) {
+            c.respondAt += std::chrono::milliseconds(atoi(path.c_str() + 6));
+        } else if (path.compare(0, 6, "/hops/") == 0) {
+            int n = atoi(path.c_str() + 6);
+            if (n > 0) {
+                status = "302 Found";
+                location = std::to_string(n - 1);
+            }
+        } else if (path == "/abs") {
+            status = "301 Moved Permanently";
+            location = Url("/ok");
+        } else if (path == "/loop/a" || path == "/loop/b") {
+            status = "302 Found";
+            location = path == "/loop/a" ? "/loop/b" : "./a";
+        } else if (path == "/missing") {
+            status = "404 Not Found";
+        } else if (path == "/hang") {
+            c.respondAt = Clock::time_point::max();
+        } else if (path == "/drop") {
+            c.response.clear();
+            return;
+        } else if (path != "/ok") {
+            status = "404 Not Found";
+        }
+        c.response = "HTTP/1.1 " + status + "\r\nContent-Length: 2\r\nConnection: close\r\n" +
+            (location.empty() ? "" : "Location: " + location + "\r\n") + "\r\nok";
+    }
+
+    void Run() {
+        std::vector<pollfd> fds;
+        while (!m_stop) {
+            fds.clear();
+            pollfd listener = { m_listener, POLLIN, 0 };
+            fds.push_back(listener);
+            int timeoutMs = 5;
+            Clock::time_point now = Clock::now();
+            for (const Connection& c : m_connections) {
+                pollfd fd = { c.socket, POLLIN, 0 };
+                fds.push_back(fd);
+                if (c.answered && c.respondAt != Clock::time_point::max()) {
+                    long long wait = std::chrono::duration_cast<std::chrono::milliseconds>(c.respondAt - now).count();
+                    timeoutMs = (int)std::max<long long>(0, std::min<long long>(timeoutMs, wait));
+                }
+            }
+            poll(fds.data(), fds.size(), timeoutMs);
+
+            for (size_t i = 1; i < fds.size(); i++) {
+                Connection& c = m_connections[i - 1];
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                char buffer[4096];
+                ssize_t n = recv(c.socket, buffer, sizeof(buffer), 0);
+                if (n > 0 && !c.answered) {
+                    c.request.append(buffer, n);
+                    if (c.request.find("\r\n\r\n") != std::string::npos) Route(c);
+                } else if (n == 0) {
+                    // The client gave up (or sent nothing); drop the connection
+                    c.answered = true;
+                    c.respondAt = Clock::now();
+                    c.response.clear();
+                }
+            }
+            now = Clock::now();
+            for (size_t i = 0; i < m_connections.size();) {
+                Connection& c = m_connections[i];
+                if (c.answered && c.respondAt <= now) {
+                    if (!c.response.empty()) send(c.socket, c.response.data(), c.response.size(), MSG_NOSIGNAL);
+                    close(c.socket);
+                    m_connections.erase(m_connections.begin() + i);
+                } else {
+                    i++;
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                for (;;) {
+                    int s = accept(m_listener, nullptr, nullptr);
+                    if (s < 0) break;
+                    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+                    Connection c;
+                    c.socket = s;
+                    m_connections.push_back(c);
+                }
+                m_peak = std::max<size_t>(m_peak, m_connections.size());
+            }
+        }
+    }
+
+    int m_listener = -1;
+    uint16_t m_port = 0;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{ false };
+    std::atomic<size_t> m_peak{ 0 };
+    std::atomic<size_t> m_requests{ 0 };
+    std::vector<Connection> m_connections;
+};
+
+// Host names for the checker: app.test and slow.test are the stand-in
+// (slow.test after 150 ms), anything else doesn't exist
+struct TestResolver {
+    std::mutex mutex;
+    std::map<std::string, int> lookups;
+
+    std::vector<std::string> Resolve(const std::string& host) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lookups[host]++;
+        }
+        if (host == "slow.test") std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        if (host == "app.test" || host == "slow.test" || host == "127.0.0.1") return { "127.0.0.1" };
+        return {};
+    }
+};
+
+const CheckReport& Find(const std::vector<CheckReport>& reports, const std::wstring& name) {
+    for (const CheckReport& r : reports) {
+        if (r.name == name) return r;
+    }
+    static CheckReport none;
+    return none;
+}
+
+std::vector<CheckTarget> Targets(const std::vector<std::pair<std::wstring, std::string>>& list) {
+    std::vector<CheckTarget> targets;
+    for (const auto& item : list) {
+        CheckTarget t;
+        t.name = item.first;
+        t.url = Utf8::ToWide(item.second);
+        targets.push_back(t);
+    }
+    return targets;
+}
+
+// Requests per second for count targets at path, and the peak connection count
+double Throughput(StandInServer& server, const std::string& path, size_t count, unsigned concurrency,
+    double& p99Ms, size_t& peak) {
+    std::vector<CheckTarget> targets;
+    for (size_t i = 0; i < count; i++) {
+        CheckTarget t;
+        t.name = L"app" + std::to_wstring(i);
+        t.url = Utf8::ToWide(server.Url(path));
+        targets.push_back(t);
+    }
+    CheckOptions options;
+    options.concurrency = concurrency;
+    options.samples = 1;
+    server.ResetCounters();
+    Clock::time_point start = Clock::now();
+    std::vector<CheckReport> reports = TargetChecker::Run(targets, options);
+    double seconds = MillisecondsSince(start) / 1000;
+    LatencyHistogram all;
+    bool ok = true;
+    for (const CheckReport& r : reports) {
+        all.Merge(r.latency);
+        ok = ok && r.ok;
+    }
+    Check(ok, "every throughput request succeeds");
+    p99Ms = all.Percentile(99) / 1000.0;
+    peak = server.PeakConnections();
+    return count / seconds;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t targets = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--targets" && i + 1 < argc) {
+            targets = (size_t)std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::printf("Usage: checkbench [--targets N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // URL handling
+    TargetChecker::Url url;
+    Check(TargetChecker::ParseUrl("HTTPS://Example.COM:8443/a/b?x=1#frag", url) && url.https &&
+        url.host == "example.com" && url.port == 8443 && url.path == "/a/b?x=1", "parse url");
+    Check(TargetChecker::ParseUrl("http://[::1]?q", url) && !url.https && url.host == "::1" && url.port == 80 &&
+        url.path == "/?q", "parse ipv6 url without path");
+    Check(!TargetChecker::ParseUrl("file:///C:/app/index.html", url), "file urls rejected");
+    Check(TargetChecker::ResolveLocation("http://h/a/b/c?q", "d") == "http://h/a/b/d", "relative location");
+    Check(TargetChecker::ResolveLocation("http://h/a/b/c", "../x/./y?z#f") == "http://h/a/x/y?z", "dot segments");
+    Check(TargetChecker::ResolveLocation("https://h/a", "//cdn.h/p") == "https://cdn.h/p", "scheme-relative location");
+    Check(TargetChecker::ResolveLocation("https://h/a/b", "/root") == "https://h/root", "absolute path location");
+    Check(TargetChecker::ResolveLocation("https://h/a?x", "?y") == "https://h/a?y", "query-only location");
+    Check(TargetChecker::ResolveLocation("https://h/a", "HTTP://other/") == "HTTP://other/", "absolute location");
+
+    StandInServer server;
+    if (!server.Start()) {
+        std::fprintf(stderr, "cannot start stand-in server\n");
+        return 1;
+    }
+    uint16_t closedPort = 0;
+    close(Listen(closedPort));
+    std::string base = "http://app.test:" + std::to_string(server.Port());
+
+    // Every kind of target at once
+    TestResolver resolver;
+    CheckOptions options;
+    options.concurrency = 4;
+    options.timeoutMs = 400;
+    options.maxRedirects = 5;
+    options.samples = 3;
+    options.resolver = [&resolver](const std::string& host) { return resolver.Resolve(host); };
+    std::vector<CheckTarget> mixed = Targets({
+        { L"ok", base + "/ok" },
+        { L"slow", base + "/slow/30" },
+        { L"hops", base + "/hops/3" },
+        { L"abs", base + "/abs" },
+        { L"loop", base + "/loop/a" },
+        { L"far", base + "/hops/9" },
+        { L"missing", base + "/missing" },
+        { L"hang", base + "/hang" },
+        { L"drop", base + "/drop" },
+        { L"closed", "http://127.0.0.1:" + std::to_string(closedPort) + "/" },
+        { L"nx", "http://nx.test/" },
+        { L"slowdns", "http://slow.test:" + std::to_string(server.Port()) + "/ok" },
+        { L"file", "file:///C:/app/index.html" },
+    });
+    server.ResetCounters();
+    Clock::time_point start = Clock::now();
+    std::vector<CheckReport> reports = TargetChecker::Run(mixed, options);
+    double mixedMs = MillisecondsSince(start);
+
+    std::printf("%-8s %6s %8s %8s  %s\n", "target", "status", "p50 ms", "p99 ms", "chain / error");
+    for (const CheckReport& r : reports) {
+        std::string chain;
+        for (const CheckHop& hop : r.chain) chain += (chain.empty() ? "" : " -> ") + std::to_string(hop.status);
+        std::printf("%-8s %6d %8.1f %8.1f  %s%s%s\n", Utf8::FromWide(r.name).c_str(), r.status,
+            r.latency.Percentile(50) / 1000.0, r.latency.Percentile(99) / 1000.0, chain.c_str(),
+            r.error.empty() ? "" : "  ", r.error.c_str());
+    }
+    std::printf("mixed run: %.0f ms, peak %zu connections (limit %u)\n", mixedMs, server.PeakConnections(), options.concurrency);
+
+    Check(Find(reports, L"ok").ok && Find(reports, L"ok").status == 200 && Find(reports, L"ok").attempts == 3 &&
+        Find(reports, L"ok").latency.Count() == 3, "ok target");
+    Check(Find(reports, L"slow").ok && Find(reports, L"slow").latency.Percentile(50) >= 30000, "slow target latency");
+    const CheckReport& hops = Find(reports, L"hops");
+    Check(hops.ok && hops.chain.size() == 4 && hops.chain[0].status == 302 && hops.chain[3].status == 200 &&
+        hops.chain[3].url == base + "/hops/0", "relative redirect chain");
+    Check(Find(reports, L"abs").ok && Find(reports, L"abs").chain.size() == 2 &&
+        Find(reports, L"abs").chain[1].url == server.Url("/ok"), "absolute redirect to another host name");
+    Check(!Find(reports, L"loop").ok && Find(reports, L"loop").error == "redirect loop", "redirect loop");
+    Check(!Find(reports, L"far").ok && Find(reports, L"far").error == "too many redirects" &&
+        Find(reports, L"far").chain.size() == 6, "redirect limit");
+    Check(!Find(reports, L"missing").ok && Find(reports, L"missing").status == 404 &&
+        Find(reports, L"missing").error == "HTTP 404", "http error status");
+    Check(!Find(reports, L"hang").ok && Find(reports, L"hang").error == "timed out" &&
+        Find(reports, L"hang").failures == 3, "deadline");
+    Check(!Find(reports, L"drop").ok && Find(reports, L"drop").error == "connection closed", "dropped connection");
+    Check(!Find(reports, L"closed").ok && Find(reports, L"closed").error == "connection failed", "closed port");
+    Check(!Find(reports, L"nx").ok && Find(reports, L"nx").error == "name lookup failed", "unknown host");
+    Check(Find(reports, L"slowdns").ok, "slow name lookup");
+    Check(!Find(reports, L"file").ok && Find(reports, L"file").error == "not an http(s) URL", "non-http target");
+    Check(resolver.lookups["app.test"] == 1 && resolver.lookups["slow.test"] == 1, "one lookup per host");
+    Check(server.PeakConnections() <= options.concurrency, "connections within the limit");
+    // Three rounds of the hanging target run into the deadline one after another at most
+    Check(mixedMs < 3 * options.timeoutMs + 1000, "run bounded by deadlines");
+
+    // Throughput: fast answers, then 50 ms answers where concurrency pays off
+    std::printf("\n%-14s %6s %12s %10s %6s\n", "responses", "limit", "requests/s", "p99 ms", "peak");
+    double slowRate[3] = {};
+    const unsigned limits[] = { 8, 32, 128 };
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < 3; i++) {
+            double p99 = 0;
+            size_t peak = 0;
+            bool slow = pass == 1;
+            size_t count = slow ? std::min<size_t>(targets, 512) : targets;
+            double rate = Throughput(server, slow ? "/slow/50" : "/ok", count, limits[i], p99, peak);
+            std::printf("%-14s %6u %12.0f %10.1f %6zu\n", slow ? "50 ms" : "immediate", limits[i], rate, p99, peak);
+            Check(peak <= limits[i], "throughput connections within the limit");
+            if (slow) slowRate[i] = rate;
+        }
+    }
+    Check(slowRate[1] > 2.5 * slowRate[0] && slowRate[2] > 2.5 * slowRate[1], "slow responses overlap");
+
+    server.Stop();
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
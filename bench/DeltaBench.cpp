@@ -0,0 +1,485 @@
+// Delta update benchmark: measures chunking and hashing throughput
+// (Chunker, Checksums::Xxh64) and the size of ww diff patches for typical
+// updates of a synthetic web app build, against downloading the whole
+// tree or only the changed files, both deflated. Checks XXH64 against
+// reference vectors, that chunk boundaries survive an insertion, that
+// chunk sizes stay within bounds, that applied patches reproduce the new
+// tree byte for byte, that damaged or mismatched patches and unsafe paths
+// are rejected without touching the tree, and that an interrupted swap is
+// completed.
+//
+// Linux only (temp folders); see README.md ("Delta Updates") for build
+// and usage.
+
+#include "../Checksums.h"
+#include "../ChunkIndex.h"
+#include "../Chunker.h"
+#include "../Deflate.h"
+#include "../DeltaPatch.h"
+#include "../FileUtil.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef std::map<std::string, std::string> Tree;  // Relative path -> contents
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+uint64_t g_seed = 0x9E3779B97F4A7C15ULL;
+
+uint64_t Random() {
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 7;
+    g_seed ^= g_seed << 17;
+    return g_seed;
+}
+
+std::string RandomBytes(size_t len) {
+    std::string out(len, '\0');
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t v = Random();
+        memcpy(&out[i], &v, std::min<size_t>(8, len - i));
+    }
+    return out;
+}
+
+// Minified-looking JavaScript: compresses about like real bundles do
+std::string SampleScript(size_t len) {
+    static const char* const words[] = { "function", "return", "var", "const", "this", "props", "state",
+        "useEffect", "createElement", "undefined", "null", "length", "push", "map", "filter", "then",
+        "Promise", "document", "window", "addEventListener", "value", "children", "className" };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    static const char* const glue[] = { "(", ")", "{", "}", ".", ",", ";", "=", "=>", "&&", "||", "?", ":" };
+    std::string out;
+    out.reserve(len + 64);
+    while (out.size() < len) {
+        uint64_t r = Random();
+        if (r % 5 == 0) {
+            char name[16];
+            std::snprintf(name, sizeof(name), "%c%c%u", 'a' + (int)(r >> 8) % 26, 'a' + (int)(r >> 16) % 26,
+                (unsigned)(r >> 24) % 1000);
+            out += name;
+        } else {
+            out += words[(r >> 8) % wordCount];
+        }
+        out += glue[(r >> 32) % 13];
+        if ((r >> 40) % 97 == 0) out += "\"" + std::to_string(r >> 44) + "\"";
+    }
+    out.resize(len);
+    return out;
+}
+
+std::string SampleStyle(size_t len) {
+    std::string out;
+    while (out.size() < len) {
+        uint64_t r = Random();
+        out += ".c" + std::to_string(r % 5000) + "{margin:" + std::to_string((r >> 16) % 32) + "px;color:#" +
+            std::to_string((r >> 24) % 999999) + ";display:" + ((r >> 48) % 2 ? "flex" : "block") + "}";
+    }
+    out.resize(len);
+    return out;
+}
+
+std::string ContentHash(const std::string& data) {
+    char hex[9];
+    std::snprintf(hex, sizeof(hex), "%08x", (unsigned)Checksums::Xxh64(data.data(), data.size()));
+    return hex;
+}
+
+// A webpack-style build: hashed script and style names, an index.html
+// pointing at them, images and fonts
+struct Build {
+    std::string main, vendor, style;
+    Tree media;
+};
+
+Tree Render(const Build& b) {
+    Tree tree;
+    std::string mainName = "assets/main." + ContentHash(b.main) + ".js";
+    std::string vendorName = "assets/vendor." + ContentHash(b.vendor) + ".js";
+    std::string styleName = "assets/style." + ContentHash(b.style) + ".css";
+    tree[mainName] = b.main;
+    tree[vendorName] = b.vendor;
+    tree[styleName] = b.style;
+    tree["index.html"] = "<!doctype html><html><head><link rel=stylesheet href=\"" + styleName +
+        "\"></head><body><div id=root></div><script src=\"" + vendorName + "\"></script><script src=\"" +
+        mainName + "\"></script></body></html>\n";
+    for (const auto& m : b.media) tree[m.first] = m.second;
+    return tree;
+}
+
+// Insert or replace a few hundred bytes at a few places, like a code change
+void Edit(std::string& text, int edits) {
+    for (int i = 0; i < edits; i++) {
+        size_t at = (size_t)(Random() % text.size());
+        std::string change = SampleScript(200 + Random() % 400);
+        if (i % 2) text.replace(at, std::min<size_t>(change.size(), text.size() - at), change);
+        else text.insert(at, change);
+    }
+}
+
+bool WriteTree(const std::wstring& root, const Tree& tree) {
+    for (const auto& f : tree) {
+        std::wstring path = FileUtil::Join(root, Utf8::ToWide(f.first));
+        size_t slash = path.rfind(L'/');
+        if (!FileUtil::MakeDirectories(path.substr(0, slash)) || !FileUtil::Write(path, f.second.data(), f.second.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ReadTree(const std::wstring& dir, const std::string& prefix, Tree& tree) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) return false;
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        std::string name = prefix + Utf8::FromWide(e.name);
+        if (e.isDirectory) {
+            if (!ReadTree(path, name + "/", tree)) return false;
+        } else if (!FileUtil::Read(path, tree[name])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SameTree(const std::wstring& dir, const Tree& expected) {
+    Tree actual;
+    return ReadTree(dir, "", actual) && actual == expected;
+}
+
+size_t DeflatedSize(const std::string& data) {
+    std::vector<uint8_t> out;
+    Deflate::CompressZlib((const uint8_t*)data.data(), data.size(), 6, out);
+    return out.size();
+}
+
+// Full download: every file deflated; changed files only: those whose
+// path or contents differ from the old tree
+void Baselines(const Tree& from, const Tree& to, size_t& full, size_t& changed) {
+    full = changed = 0;
+    for (const auto& f : to) {
+        size_t size = DeflatedSize(f.second);
+        full += size;
+        auto old = from.find(f.first);
+        if (old == from.end() || old->second != f.second) changed += size;
+    }
+}
+
+void TestXxh64() {
+    struct Vector { const char* text; uint64_t seed; uint64_t hash; };
+    const Vector vectors[] = {
+        { "", 0, 0xEF46DB3751D8E999ULL },
+        { "a", 0, 0xD24EC4F1A98C6E5BULL },
+        { "abc", 0, 0x44BC2CF5AD770999ULL },
+        { "Nobody inspects the spammish repetition", 0, 0xFBCEA83C8A378BF1ULL },
+    };
+    for (const Vector& v : vectors) {
+        Check(Checksums::Xxh64(v.text, strlen(v.text), v.seed) == v.hash, v.text[0] ? v.text : "xxh64 of empty input");
+    }
+
+    // Unaligned input and every length around the 32-byte stripe
+    std::string data = RandomBytes(200);
+    std::string copy = " " + data;
+    bool same = true;
+    for (size_t len = 0; len <= 100; len++) {
+        same = same && Checksums::Xxh64(data.data(), len) == Checksums::Xxh64(copy.data() + 1, len);
+    }
+    Check(same, "xxh64 independent of alignment");
+}
+
+void TestChunker() {
+    std::string data = RandomBytes(4 << 20);
+    std::vector<Chunk> chunks;
+    Chunker::Split((const uint8_t*)data.data(), data.size(), chunks);
+
+    bool bounded = true, contiguous = true;
+    size_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunks[i].offset != offset) contiguous = false;
+        if (chunks[i].length > Chunker::kMaxSize || (i + 1 < chunks.size() && chunks[i].length < Chunker::kMinSize)) {
+            bounded = false;
+        }
+        offset += chunks[i].length;
+    }
+    Check(contiguous && offset == data.size(), "chunks cover the input");
+    Check(bounded, "chunk sizes within bounds");
+    double average = (double)data.size() / chunks.size();
+    Check(average > Chunker::kAvgSize * 0.7 && average < Chunker::kAvgSize * 1.5, "average chunk size near target");
+
+    // Only the chunks around an insertion change
+    std::string edited = data;
+    edited.insert(data.size() / 2, RandomBytes(100));
+    std::vector<Chunk> after;
+    Chunker::Split((const uint8_t*)edited.data(), edited.size(), after);
+    std::unordered_set<uint64_t> before;
+    for (const Chunk& c : chunks) before.insert(c.hash);
+    size_t kept = 0;
+    for (const Chunk& c : after) kept += before.count(c.hash);
+    Check(after.size() - kept <= 3, "insertion changes at most a few chunks");
+
+    // Runs of one byte never match the mask: cut at kMaxSize
+    std::string zeros(300000, '\0');
+    chunks.clear();
+    Chunker::Split((const uint8_t*)zeros.data(), zeros.size(), chunks);
+    Check(chunks.size() == 5 && chunks[0].length == Chunker::kMaxSize, "uniform input cut at the maximum size");
+    chunks.clear();
+    Chunker::Split((const uint8_t*)zeros.data(), 0, chunks);
+    Check(chunks.empty(), "empty input has no chunks");
+
+    std::printf("  chunks: %zu average %.0f bytes, %zu of %zu kept after a 100-byte insertion\n",
+        before.size(), average, kept, after.size());
+}
+
+void BenchThroughput() {
+    const size_t size = 64 << 20;
+    std::string data = RandomBytes(size);
+    const uint8_t* p = (const uint8_t*)data.data();
+    std::vector<double> cutMs, hashMs, splitMs;
+    size_t sink = 0;
+    for (int run = 0; run < 5; run++) {
+        Clock::time_point start = Clock::now();
+        for (size_t pos = 0; pos < size;) {
+            size_t n = Chunker::Cut(p + pos, size - pos);
+            pos += n;
+            sink++;
+        }
+        cutMs.push_back(MillisecondsSince(start));
+
+        start = Clock::now();
+        sink += (size_t)Checksums::Xxh64(p, size);
+        hashMs.push_back(MillisecondsSince(start));
+
+        std::vector<Chunk> chunks;
+        start = Clock::now();
+        Chunker::Split(p, size, chunks);
+        splitMs.push_back(MillisecondsSince(start));
+        sink += chunks.size();
+    }
+    double gb = size / 1e9;
+    std::printf("  cut points      %6.2f GB/s\n", gb / (Median(cutMs) / 1000));
+    std::printf("  xxh64           %6.2f GB/s\n", gb / (Median(hashMs) / 1000));
+    std::printf("  split and hash  %6.2f GB/s  (64 MB, median of 5)\n", gb / (Median(splitMs) / 1000));
+    if (sink == 1) std::printf(" ");
+}
+
+// Applies patch to a fresh copy of from and checks the result is to
+bool ApplyCopy(const std::wstring& dir, const Tree& from, const std::string& patch, DeltaStats& stats) {
+    FileUtil::RemoveTree(dir);
+    std::string error;
+    return WriteTree(dir, from) &&
+        DeltaPatch::Apply(dir, (const uint8_t*)patch.data(), patch.size(), error, &stats);
+}
+
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::printf("Usage: deltabench\n");
+        return arg == "--help" ? 0 : 2;
+    }
+
+    TestXxh64();
+    std::printf("Chunking\n");
+    TestChunker();
+    BenchThroughput();
+
+    char dirTemplate[] = "/tmp/deltabench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::fprintf(stderr, "cannot create temp directory\n");
+        return 1;
+    }
+    std::wstring root = Utf8::ToWide(dirTemplate);
+
+    // Version 1: about 4 MB, like a mid-sized single-page app
+    Build v1;
+    v1.main = SampleScript(700 << 10);
+    v1.vendor = SampleScript(1600 << 10);
+    v1.style = SampleStyle(160 << 10);
+    for (int i = 0; i < 16; i++) {
+        v1.media["images/photo" + std::to_string(i) + ".jpg"] = RandomBytes(20000 + Random() % 80000);
+    }
+    v1.media["fonts/inter.woff2"] = RandomBytes(110000);
+    v1.media["fonts/mono.woff2"] = RandomBytes(90000);
+    Tree oldTree = Render(v1);
+
+    struct Scenario {
+        const char* name;
+        Tree tree;
+    };
+    std::vector<Scenario> scenarios;
+    Build edit = v1;
+    Edit(edit.main, 2);
+    scenarios.push_back({ "app code edit", Render(edit) });
+    Build bump = edit;
+    Edit(bump.main, 6);
+    Edit(bump.vendor, 12);
+    Edit(bump.style, 3);
+    scenarios.push_back({ "dependency bump", Render(bump) });
+    Build media = v1;
+    media.media["images/banner.png"] = RandomBytes(150000);
+    media.media.erase("fonts/mono.woff2");
+    scenarios.push_back({ "new image, font removed", Render(media) });
+    scenarios.push_back({ "no change", oldTree });
+
+    std::wstring oldDir = FileUtil::Join(root, L"v1");
+    Check(WriteTree(oldDir, oldTree), "write version 1");
+    TreeIndex base;
+    Check(ChunkIndex::Build(oldDir, base), "index version 1");
+    std::string savedIndex;
+    ChunkIndex::Serialize(base, savedIndex);
+    TreeIndex parsed;
+    Check(ChunkIndex::Parse((const uint8_t*)savedIndex.data(), savedIndex.size(), parsed) &&
+        parsed.Hash() == base.Hash() && parsed.files.size() == base.files.size(), "index round trip");
+    savedIndex[savedIndex.size() / 2] ^= 1;
+    Check(!ChunkIndex::Parse((const uint8_t*)savedIndex.data(), savedIndex.size(), parsed), "damaged index rejected");
+
+    std::printf("Patch size (version 1: %zu files, %.0f KB, index %.1f KB)\n", oldTree.size(),
+        base.TotalBytes() / 1024.0, savedIndex.size() / 1024.0);
+    std::printf("  %-26s %10s %10s %10s %8s %8s\n", "update", "full KB", "files KB", "patch KB", "reused", "applied");
+    std::wstring newDir = FileUtil::Join(root, L"new");
+    std::wstring localDir = FileUtil::Join(root, L"local");
+    std::string editPatch;
+    std::vector<double> createMs, applyMs;
+    for (const Scenario& s : scenarios) {
+        FileUtil::RemoveTree(newDir);
+        Check(WriteTree(newDir, s.tree), "write new version");
+        std::string patch;
+        DeltaStats stats;
+        Check(DeltaPatch::Create(base, newDir, patch, &stats), "create patch");
+
+        DeltaStats applied;
+        bool ok = ApplyCopy(localDir, oldTree, patch, applied) && SameTree(localDir, s.tree);
+        Check(ok, s.name);
+        size_t full = 0, changed = 0;
+        Baselines(oldTree, s.tree, full, changed);
+        uint64_t total = stats.reusedBytes + stats.literalBytes;
+        std::printf("  %-26s %10.1f %10.1f %10.1f %7.1f%% %8s\n", s.name, full / 1024.0, changed / 1024.0,
+            patch.size() / 1024.0, total ? 100.0 * stats.reusedBytes / total : 0.0, ok ? "ok" : "FAILED");
+        if (editPatch.empty()) editPatch = patch;
+    }
+
+    // Timings for the common case
+    FileUtil::RemoveTree(newDir);
+    WriteTree(newDir, scenarios[0].tree);
+    for (int run = 0; run < 5; run++) {
+        std::string patch;
+        Clock::time_point start = Clock::now();
+        DeltaPatch::Create(base, newDir, patch);
+        createMs.push_back(MillisecondsSince(start));
+
+        FileUtil::RemoveTree(localDir);
+        WriteTree(localDir, oldTree);
+        std::string error;
+        start = Clock::now();
+        DeltaPatch::Apply(localDir, (const uint8_t*)editPatch.data(), editPatch.size(), error);
+        applyMs.push_back(MillisecondsSince(start));
+    }
+    std::printf("  diff %.1f ms, patch %.1f ms (app code edit, median of 5)\n", Median(createMs), Median(applyMs));
+
+    // Applying again is a no-op
+    DeltaStats stats;
+    std::string error;
+    Check(DeltaPatch::Apply(localDir, (const uint8_t*)editPatch.data(), editPatch.size(), error, &stats) &&
+        stats.upToDate && SameTree(localDir, scenarios[0].tree), "already patched tree is up to date");
+
+    // A damaged patch or a modified local copy leaves the tree alone
+    std::string damaged = editPatch;
+    damaged[damaged.size() / 3] ^= 0x40;
+    FileUtil::RemoveTree(localDir);
+    WriteTree(localDir, oldTree);
+    Check(!DeltaPatch::Apply(localDir, (const uint8_t*)damaged.data(), damaged.size(), error) &&
+        SameTree(localDir, oldTree), "damaged patch rejected");
+    Tree modified = oldTree;
+    modified["index.html"] += "<!-- local -->";
+    FileUtil::RemoveTree(localDir);
+    WriteTree(localDir, modified);
+    Check(!DeltaPatch::Apply(localDir, (const uint8_t*)editPatch.data(), editPatch.size(), error) &&
+        SameTree(localDir, modified), "patch for another version rejected");
+
+    // Interrupted after the new tree was complete: before and during the swap
+    std::wstring pending = localDir + L".patch-new";
+    std::wstring old = localDir + L".patch-old";
+    FileUtil::RemoveTree(localDir);
+    WriteTree(localDir, oldTree);
+    WriteTree(pending, scenarios[0].tree);
+    WriteTree(localDir + L".patch-tmp", scenarios[0].tree);
+    Check(DeltaPatch::Recover(localDir) && SameTree(localDir, scenarios[0].tree) && !FileUtil::Exists(pending) &&
+        !FileUtil::Exists(old) && !FileUtil::Exists(localDir + L".patch-tmp"), "swap completed before it started");
+    FileUtil::RemoveTree(localDir);
+    WriteTree(old, oldTree);
+    WriteTree(pending, scenarios[0].tree);
+    Check(DeltaPatch::Apply(localDir, (const uint8_t*)editPatch.data(), editPatch.size(), error, &stats) &&
+        stats.upToDate && SameTree(localDir, scenarios[0].tree) && !FileUtil::Exists(old), "swap completed halfway");
+
+    // A folder given with a trailing separator is swapped as a whole
+    FileUtil::RemoveTree(localDir);
+    WriteTree(localDir, oldTree);
+    Check(DeltaPatch::Apply(localDir + L"/", (const uint8_t*)editPatch.data(), editPatch.size(), error, &stats) &&
+        !stats.upToDate && SameTree(localDir, scenarios[0].tree) && !FileUtil::Exists(pending) &&
+        !FileUtil::Exists(old) && !FileUtil::Exists(localDir + L".patch-tmp"), "trailing separator patched in place");
+    WriteTree(pending, oldTree);
+    Check(DeltaPatch::Recover(localDir + L"//") && SameTree(localDir, oldTree) && !FileUtil::Exists(pending),
+        "trailing separator recovered");
+
+    // A path that climbs out of the folder, with a valid checksum
+    Tree evil;
+    evil["ab/evil"] = "x";
+    std::wstring evilDir = FileUtil::Join(root, L"crafted");
+    WriteTree(evilDir, evil);
+    std::string patch;
+    DeltaPatch::Create(TreeIndex(), evilDir, patch);
+    size_t at = patch.find("ab/evil");
+    patch.replace(at, 3, "../");
+    patch.resize(patch.size() - 4);
+    uint32_t crc = Checksums::Crc32(0, (const uint8_t*)patch.data(), patch.size());
+    for (int i = 0; i < 4; i++) patch.push_back((char)(crc >> (8 * i)));
+    std::wstring target = FileUtil::Join(root, L"target");
+    Check(!DeltaPatch::Apply(target, (const uint8_t*)patch.data(), patch.size(), error) &&
+        error.find("unsafe path") != std::string::npos && !FileUtil::Exists(FileUtil::Join(root, L"evil")) &&
+        !FileUtil::Exists(target), "unsafe path rejected");
+
+    // A missing folder is an empty tree: a patch from nothing installs
+    DeltaPatch::Create(TreeIndex(), newDir, patch);
+    Check(DeltaPatch::Apply(target, (const uint8_t*)patch.data(), patch.size(), error) &&
+        SameTree(target, scenarios[0].tree), "patch from an empty tree installs");
+
+    FileUtil::RemoveTree(root);
+    Check(!FileUtil::Exists(root), "temp folder removed");
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
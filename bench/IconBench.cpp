@@ -0,0 +1,309 @@
+// Icon pipeline benchmark: runs the PNG -> .ico conversion used by
+// IconHelper::ConvertPngToIco over a corpus at every icon size, times the
+// decode / resample / encode stages, compares each render against a
+// reference image and writes a JSON report with pass/fail thresholds.
+//
+// Portable; see README.md ("Icon Benchmark") for build and usage.
+
+#include "../FileUtil.h"
+#include "../IconPipeline.h"
+#include "../ImageMetrics.h"
+#include "../PngDecoder.h"
+#include "../PngEncoder.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+const uint32_t kSizes[] = { 16, 32, 48, 64, 128, 256 };
+
+struct Options {
+    std::wstring corpusDir = L"bench/corpus";
+    std::wstring referenceDir = L"bench/reference";
+    std::string reportPath = "iconbench.json";
+    int iterations = 5;
+    bool updateReferences = false;
+
+    // Regression thresholds
+    double minSsim = 0.995;
+    double minPsnr = 40.0;
+    int maxAlphaError = 4;
+    double maxCaseMs = 0.0;  // 0 = no time limit
+};
+
+struct CaseResult {
+    std::string image;
+    uint32_t size = 0;
+    uint32_t sourceWidth = 0;
+    uint32_t sourceHeight = 0;
+    double decodeMs = 0.0;    // Medians over the iterations
+    double resampleMs = 0.0;
+    double encodeMs = 0.0;
+    double totalMs = 0.0;
+    size_t icoBytes = 0;
+    uint64_t peakMemoryKb = 0;
+    bool hasReference = false;
+    ImageQuality quality;
+    bool pass = false;
+    std::string failure;
+};
+
+// Process high-water mark of resident memory
+uint64_t PeakMemoryKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return pmc.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return (uint64_t)usage.ru_maxrss / 1024;
+#else
+        return (uint64_t)usage.ru_maxrss;
+#endif
+    }
+    return 0;
+#endif
+}
+
+double Median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+std::string JsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::wstring ReferencePath(const Options& opts, const std::wstring& stem, uint32_t size) {
+    return FileUtil::Join(opts.referenceDir, stem + L"_" + std::to_wstring(size) + L".png");
+}
+
+void RunCase(const Options& opts, const std::string& png, const std::wstring& stem, uint32_t size, CaseResult& r) {
+    r.size = size;
+
+    std::vector<double> decode, resample, encode, total;
+    std::vector<uint8_t> ico;
+    IcoImage rendered;
+    for (int i = 0; i < opts.iterations; i++) {
+        IconPipelineStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (!IconPipeline::PngToIco((const uint8_t*)png.data(), png.size(), size, ico, &rendered, &stats)) {
+            r.failure = "conversion failed";
+            return;
+        }
+        total.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        decode.push_back(stats.decodeMs);
+        resample.push_back(stats.resampleMs);
+        encode.push_back(stats.encodeMs);
+        r.sourceWidth = stats.sourceWidth;
+        r.sourceHeight = stats.sourceHeight;
+    }
+    r.decodeMs = Median(decode);
+    r.resampleMs = Median(resample);
+    r.encodeMs = Median(encode);
+    r.totalMs = Median(total);
+    r.icoBytes = ico.size();
+    r.peakMemoryKb = PeakMemoryKb();
+
+    std::wstring refPath = ReferencePath(opts, stem, size);
+    if (opts.updateReferences) {
+        std::vector<uint8_t> out;
+        PngEncoder::Encode(rendered.bgra.data(), size, size, (size_t)size * 4,
+            PngEncoder::Layout::BGRA, 9, out);
+        if (!FileUtil::Write(refPath, out.data(), out.size())) {
+            r.failure = "cannot write reference";
+            return;
+        }
+    }
+
+    std::string refData;
+    PngImage ref;
+    if (!FileUtil::Read(refPath, refData) ||
+        !PngDecoder::Decode((const uint8_t*)refData.data(), refData.size(), ref) ||
+        ref.width != size || ref.height != size) {
+        r.failure = "missing reference";
+        return;
+    }
+    r.hasReference = true;
+    r.quality = ImageMetrics::Compare(rendered.bgra.data(), ref.bgra.data(), size, size);
+
+    if (r.quality.ssim < opts.minSsim) {
+        r.failure = "ssim below threshold";
+    } else if (r.quality.psnr < opts.minPsnr) {
+        r.failure = "psnr below threshold";
+    } else if (r.quality.maxAlphaError > opts.maxAlphaError) {
+        r.failure = "alpha error above threshold";
+    } else if (opts.maxCaseMs > 0.0 && r.totalMs > opts.maxCaseMs) {
+        r.failure = "slower than time limit";
+    } else {
+        r.pass = true;
+    }
+}
+
+bool WriteReport(const Options& opts, const std::vector<CaseResult>& results, double elapsedMs) {
+    size_t failed = 0;
+    for (const auto& r : results) failed += r.pass ? 0 : 1;
+
+    std::string json;
+    char buf[512];
+    json += "{\n  \"version\": 1,\n";
+    snprintf(buf, sizeof(buf), "  \"iterations\": %d,\n", opts.iterations);
+    json += buf;
+    snprintf(buf, sizeof(buf),
+        "  \"thresholds\": { \"minSsim\": %.4f, \"minPsnr\": %.2f, \"maxAlphaError\": %d, \"maxCaseMs\": %.3f },\n",
+        opts.minSsim, opts.minPsnr, opts.maxAlphaError, opts.maxCaseMs);
+    json += buf;
+    json += "  \"cases\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const CaseResult& r = results[i];
+        json += "    { \"image\": \"" + JsonEscape(r.image) + "\"";
+        snprintf(buf, sizeof(buf),
+            ", \"size\": %u, \"sourceWidth\": %u, \"sourceHeight\": %u"
+            ", \"decodeMs\": %.4f, \"resampleMs\": %.4f, \"encodeMs\": %.4f, \"totalMs\": %.4f"
+            ", \"icoBytes\": %zu, \"peakMemoryKb\": %llu",
+            r.size, r.sourceWidth, r.sourceHeight, r.decodeMs, r.resampleMs, r.encodeMs, r.totalMs,
+            r.icoBytes, (unsigned long long)r.peakMemoryKb);
+        json += buf;
+        if (r.hasReference) {
+            snprintf(buf, sizeof(buf), ", \"ssim\": %.6f, \"psnr\": %.3f, \"maxAlphaError\": %d",
+                r.quality.ssim, r.quality.psnr, r.quality.maxAlphaError);
+            json += buf;
+        }
+        json += std::string(", \"pass\": ") + (r.pass ? "true" : "false");
+        if (!r.pass) json += ", \"failure\": \"" + JsonEscape(r.failure) + "\"";
+        json += i + 1 < results.size() ? " },\n" : " }\n";
+    }
+    json += "  ],\n";
+    snprintf(buf, sizeof(buf), "  \"summary\": { \"cases\": %zu, \"failed\": %zu, \"elapsedMs\": %.1f }\n}\n",
+        results.size(), failed, elapsedMs);
+    json += buf;
+
+    return FileUtil::Write(Utf8::ToWide(opts.reportPath), json.data(), json.size());
+}
+
+void PrintUsage() {
+    printf("Usage: iconbench [options]\n\n"
+        "  --corpus <dir>        Source PNGs (default: bench/corpus)\n"
+        "  --reference <dir>     Reference renders (default: bench/reference)\n"
+        "  --report <file>       JSON report path (default: iconbench.json)\n"
+        "  --iterations <n>      Timed runs per case (default: 5)\n"
+        "  --min-ssim <value>    Fail below this SSIM (default: 0.995)\n"
+        "  --min-psnr <dB>       Fail below this PSNR (default: 40)\n"
+        "  --max-alpha <n>       Fail above this alpha error (default: 4)\n"
+        "  --max-ms <ms>         Fail cases slower than this (default: off)\n"
+        "  --update              Rewrite the references from the current output\n");
+}
+
+bool ParseArgs(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--corpus" && hasValue) opts.corpusDir = Utf8::ToWide(argv[++i]);
+        else if (arg == "--reference" && hasValue) opts.referenceDir = Utf8::ToWide(argv[++i]);
+        else if (arg == "--report" && hasValue) opts.reportPath = argv[++i];
+        else if (arg == "--iterations" && hasValue) opts.iterations = std::max(1, atoi(argv[++i]));
+        else if (arg == "--min-ssim" && hasValue) opts.minSsim = atof(argv[++i]);
+        else if (arg == "--min-psnr" && hasValue) opts.minPsnr = atof(argv[++i]);
+        else if (arg == "--max-alpha" && hasValue) opts.maxAlphaError = atoi(argv[++i]);
+        else if (arg == "--max-ms" && hasValue) opts.maxCaseMs = atof(argv[++i]);
+        else if (arg == "--update") opts.updateReferences = true;
+        else {
+            PrintUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!ParseArgs(argc, argv, opts)) {
+        return 2;
+    }
+
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(opts.corpusDir, entries)) {
+        fprintf(stderr, "Error: cannot read corpus directory %s\n", Utf8::FromWide(opts.corpusDir).c_str());
+        return 2;
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const FileUtil::Entry& a, const FileUtil::Entry& b) { return a.name < b.name; });
+    if (opts.updateReferences) {
+        FileUtil::MakeDirectories(opts.referenceDir);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CaseResult> results;
+    printf("%-28s %5s %9s %9s %9s %8s %9s %7s  %s\n",
+        "image", "size", "decode", "resample", "encode", "ssim", "psnr", "alpha", "result");
+    for (const auto& entry : entries) {
+        size_t dot = entry.name.rfind(L'.');
+        if (entry.isDirectory || dot == std::wstring::npos || entry.name.substr(dot) != L".png") {
+            continue;
+        }
+
+        std::string png;
+        if (!FileUtil::Read(FileUtil::Join(opts.corpusDir, entry.name), png)) {
+            fprintf(stderr, "Error: cannot read %s\n", Utf8::FromWide(entry.name).c_str());
+            return 2;
+        }
+
+        std::wstring stem = entry.name.substr(0, dot);
+        for (uint32_t size : kSizes) {
+            CaseResult r;
+            r.image = Utf8::FromWide(entry.name);
+            RunCase(opts, png, stem, size, r);
+            printf("%-28s %5u %7.3fms %7.3fms %7.3fms %8.5f %7.2fdB %7d  %s\n",
+                r.image.c_str(), r.size, r.decodeMs, r.resampleMs, r.encodeMs,
+                r.quality.ssim, r.quality.psnr, r.quality.maxAlphaError,
+                r.pass ? "ok" : r.failure.c_str());
+            results.push_back(r);
+        }
+    }
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!WriteReport(opts, results, elapsedMs)) {
+        fprintf(stderr, "Error: cannot write report %s\n", opts.reportPath.c_str());
+        return 2;
+    }
+
+    size_t failed = 0;
+    for (const auto& r : results) failed += r.pass ? 0 : 1;
+    printf("\n%zu cases, %zu failed, peak memory %llu KB, report: %s\n",
+        results.size(), failed, (unsigned long long)PeakMemoryKb(), opts.reportPath.c_str());
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+// Icon preparation benchmark: times getting a window's icons from a PNG or
+// SVG source end to end, the old way (convert, write a temporary .ico,
+// check it exists, read it back once per icon size) against the in-memory
+// path (IconSource::Load, entries found in the buffer) and against reusing
+// a shortcut's cached conversion. Checks that both paths produce the same
+// bytes, that entries are picked like LoadImage would, that .ico sources
+// pass through untouched, and that missing or damaged files are handled.
+//
+// Linux only (temp folders); see README.md ("In-Memory Icons") for build
+// and usage.
+
+#include "../FileUtil.h"
+#include "../IconCache.h"
+#include "../IconSource.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+const char kSvg[] =
+    "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 64 64\">"
+    "<rect x=\"4\" y=\"4\" width=\"56\" height=\"56\" rx=\"12\" fill=\"#1a73e8\"/>"
+    "<circle cx=\"32\" cy=\"32\" r=\"14\" fill=\"#ffffff\"/>"
+    "<path d=\"M20 44 L44 20\" stroke=\"#fbbc04\" stroke-width=\"6\"/>"
+    "</svg>";
+
+// What a launch used to do: resolve the cache name, convert, write the
+// .ico to the temp folder, check it is there, then let LoadImage read the
+// file again for the 32 px and the 16 px icon
+bool PrepareViaTempFile(const std::wstring& absPath, const std::wstring& tempDir, size_t& bytes32, size_t& bytes16) {
+    std::wstring icoPath = IconCache::VersionedPath(tempDir, absPath);
+    PreparedIcon converted;
+    if (icoPath.empty() || !IconSource::Load(absPath, L"", converted) ||
+        !FileUtil::Write(icoPath, converted.ico.data(), converted.ico.size()) || !FileUtil::Exists(icoPath)) {
+        return false;
+    }
+    size_t offset = 0;
+    for (int size : { 32, 16 }) {
+        std::string file;
+        if (!FileUtil::Read(icoPath, file) ||
+            !IconSource::FindEntry((const uint8_t*)file.data(), file.size(), size, offset, size == 32 ? bytes32 : bytes16)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PrepareInMemory(const std::wstring& absPath, const std::wstring& cacheDir, PreparedIcon& icon,
+    size_t& bytes32, size_t& bytes16) {
+    size_t offset = 0;
+    return IconSource::Load(absPath, cacheDir, icon) &&
+        IconSource::FindEntry(icon.ico.data(), icon.ico.size(), 32, offset, bytes32) &&
+        IconSource::FindEntry(icon.ico.data(), icon.ico.size(), 16, offset, bytes16);
+}
+
+// Size of the entry FindEntry picks, or 0
+uint32_t PickedSize(const std::vector<uint8_t>& ico, uint32_t size) {
+    size_t offset = 0, bytes = 0;
+    if (!IconSource::FindEntry(ico.data(), ico.size(), size, offset, bytes)) {
+        return 0;
+    }
+    for (size_t i = 0; i < (size_t)(ico[4] | ico[5] << 8); i++) {
+        const uint8_t* e = ico.data() + 6 + i * 16;
+        if ((size_t)(e[12] | e[13] << 8 | e[14] << 16 | (uint32_t)e[15] << 24) == offset) {
+            return e[0] ? e[0] : 256;
+        }
+    }
+    return 0;
+}
+
+// Minimal .ico directory with entries of the given sizes and no image data
+// beyond a byte each
+std::vector<uint8_t> FakeIco(const std::vector<uint32_t>& sizes) {
+    size_t count = sizes.size();
+    std::vector<uint8_t> ico(6 + count * 16 + count, 0);
+    ico[2] = 1;
+    ico[4] = (uint8_t)count;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* e = ico.data() + 6 + i * 16;
+        e[0] = e[1] = (uint8_t)(sizes[i] & 0xFF);
+        e[8] = 1;
+        e[12] = (uint8_t)(6 + count * 16 + i);
+    }
+    return ico;
+}
+
+void RemoveTree(const std::wstring& dir) {
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(dir, entries);
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        if (e.isDirectory) RemoveTree(path);
+        else FileUtil::Remove(path);
+    }
+    rmdir(Utf8::FromWide(dir).c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::wstring corpusDir = L"bench/corpus";
+    int iterations = 9;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--corpus" && i + 1 < argc) {
+            corpusDir = Utf8::ToWide(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::printf("Usage: iconprepbench [--corpus <dir>] [--iterations N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // Entry selection: smallest entry at least as large, else the largest
+    std::vector<uint8_t> fake = FakeIco({ 16, 48, 256, 32 });
+    Check(PickedSize(fake, 32) == 32 && PickedSize(fake, 20) == 32 && PickedSize(fake, 16) == 16 &&
+        PickedSize(fake, 64) == 256, "entry selection");
+    Check(PickedSize(FakeIco({ 16, 24 }), 32) == 24, "largest entry when none is big enough");
+    std::vector<uint8_t> truncated = fake;
+    truncated.resize(20);
+    size_t offset = 0, bytes = 0;
+    Check(!IconSource::FindEntry(truncated.data(), truncated.size(), 32, offset, bytes), "truncated directory rejected");
+
+    char dirTemplate[] = "/tmp/iconprepbench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::fprintf(stderr, "cannot create temp directory\n");
+        return 1;
+    }
+    std::wstring root = Utf8::ToWide(dirTemplate);
+    std::wstring tempDir = FileUtil::Join(root, L"temp");
+    std::wstring cacheDir = FileUtil::Join(root, L"cache");
+    FileUtil::MakeDirectories(tempDir);
+    FileUtil::MakeDirectories(cacheDir);
+
+    std::vector<std::wstring> sources;
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(corpusDir, entries)) {
+        std::fprintf(stderr, "Error: cannot read corpus directory %s\n", Utf8::FromWide(corpusDir).c_str());
+        RemoveTree(root);
+        return 1;
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const FileUtil::Entry& a, const FileUtil::Entry& b) { return a.name < b.name; });
+    for (const FileUtil::Entry& e : entries) {
+        if (IconSource::IsPng(e.name)) sources.push_back(FileUtil::Absolute(FileUtil::Join(corpusDir, e.name)));
+    }
+    std::wstring svgPath = FileUtil::Join(root, L"logo.svg");
+    FileUtil::Write(svgPath, kSvg, sizeof(kSvg) - 1);
+    sources.push_back(svgPath);
+
+    std::printf("%-24s %12s %12s %12s\n", "source", "temp file", "in memory", "cached");
+    double totalOld = 0, totalNew = 0, totalCached = 0;
+    for (const std::wstring& path : sources) {
+        std::vector<double> oldMs, newMs, cachedMs;
+        PreparedIcon icon, cached;
+        size_t old32 = 0, old16 = 0, new32 = 0, new16 = 0, cached32 = 0, cached16 = 0;
+        bool oldOk = true, newOk = true, cachedOk = true;
+        for (int r = 0; r < iterations; r++) {
+            Clock::time_point start = Clock::now();
+            oldOk = PrepareViaTempFile(path, tempDir, old32, old16) && oldOk;
+            oldMs.push_back(MillisecondsSince(start));
+
+            start = Clock::now();
+            newOk = PrepareInMemory(path, L"", icon, new32, new16) && newOk;
+            newMs.push_back(MillisecondsSince(start));
+
+            // The temp folder now holds the conversion a shortcut would have left
+            start = Clock::now();
+            cachedOk = PrepareInMemory(path, tempDir, cached, cached32, cached16) && cachedOk;
+            cachedMs.push_back(MillisecondsSince(start));
+        }
+        std::string name = Utf8::FromWide(path.substr(path.find_last_of(L'/') + 1));
+        std::printf("%-24s %9.2f ms %9.2f ms %9.2f ms\n", name.c_str(), Median(oldMs), Median(newMs), Median(cachedMs));
+        totalOld += Median(oldMs);
+        totalNew += Median(newMs);
+        totalCached += Median(cachedMs);
+
+        Check(oldOk && newOk && cachedOk, ("prepared " + name).c_str());
+        Check(old32 == new32 && old16 == new16 && new32 == cached32 && new16 == cached16,
+            ("same entries both ways for " + name).c_str());
+        Check(!icon.fromCache && icon.colors.valid, ("colors found while converting " + name).c_str());
+        Check(cached.fromCache && cached.ico == icon.ico, ("cached conversion reused for " + name).c_str());
+        if (IconSource::IsSvg(path)) {
+            // Vector sources are rasterized at every size; raster ones hold one image that Windows scales
+            Check(PickedSize(icon.ico, 32) == 32 && PickedSize(icon.ico, 16) == 16, "exact sizes rendered from svg");
+        }
+    }
+    std::printf("%-24s %9.2f ms %9.2f ms %9.2f ms\n", "total", totalOld, totalNew, totalCached);
+    Check(totalCached < totalNew, "cached conversion faster than converting");
+
+    // .ico sources are handed over as they are
+    PreparedIcon converted, passthrough;
+    IconSource::Load(sources[0], L"", converted);
+    std::wstring icoPath = FileUtil::Join(root, L"app.ico");
+    FileUtil::Write(icoPath, converted.ico.data(), converted.ico.size());
+    Check(IconSource::Load(icoPath, cacheDir, passthrough) && passthrough.ico == converted.ico &&
+        !passthrough.fromCache && !passthrough.colors.valid, ".ico passed through");
+
+    // Missing sources fail; a damaged cache file is converted again
+    PreparedIcon missing;
+    Check(!IconSource::Load(FileUtil::Join(root, L"missing.png"), cacheDir, missing) && missing.ico.empty(),
+        "missing source fails");
+    std::wstring damaged = IconCache::VersionedPath(cacheDir, sources[0]);
+    FileUtil::Write(damaged, "not an icon", 11);
+    PreparedIcon repaired;
+    Check(IconSource::Load(sources[0], cacheDir, repaired) && !repaired.fromCache && repaired.ico == converted.ico,
+        "damaged cache file converted again");
+
+    // Nothing is written by the in-memory path
+    std::vector<FileUtil::Entry> cacheEntries;
+    FileUtil::List(cacheDir, cacheEntries);
+    Check(cacheEntries.size() == 1, "loading writes no files");
+
+    RemoveTree(root);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Inject bundle benchmark: checks the JavaScript and CSS minifiers on
+// literals, comments and line breaks that automatic semicolon insertion
+// depends on, then times building a bundle from a folder of scripts and
+// styles (cold) against loading it from the cache (warm). Checks that
+// edited sources and damaged cache files cause a rebuild and that old
+// versions are removed.
+//
+// Linux only (temp folders and file times); see README.md ("Page
+// Injection") for build and usage.
+
+#include "../FileUtil.h"
+#include "../InjectBundle.h"
+#include "../Minifier.h"
+#include "../Utf8.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void CheckMinified(const std::string& actual, const std::string& expected, const char* what) {
+    if (actual != expected) {
+        std::fprintf(stderr, "  got:      %s\n  expected: %s\n", actual.c_str(), expected.c_str());
+    }
+    Check(actual == expected, what);
+}
+
+// A typical page fix: a few hundred lines of commented, indented code
+std::string SampleScript(int id, int lines) {
+    std::string text = "// Fix " + std::to_string(id) + ": keyboard shortcuts and banner removal\n"
+        "/* Runs on every page of the app. */\n";
+    for (int i = 0; i < lines; i++) {
+        text += "function handler" + std::to_string(i) + "(event) {\n"
+            "    // Ignore typing in inputs\n"
+            "    if (event.target && /^(INPUT|TEXTAREA)$/i.test(event.target.tagName)) return;\n"
+            "    const label = `shortcut ${event.key} #" + std::to_string(i) + "`;\n"
+            "    document.querySelectorAll(\".promo-banner, [data-ad]\").forEach(el => el.remove());\n"
+            "    console.debug(label, 'handled');\n"
+            "}\n"
+            "document.addEventListener('keydown', handler" + std::to_string(i) + ");\n\n";
+    }
+    return text;
+}
+
+std::string SampleStyle(int id, int rules) {
+    std::string text = "/* Dark mode " + std::to_string(id) + " */\n";
+    for (int i = 0; i < rules; i++) {
+        text += ".panel-" + std::to_string(i) + " > .item:hover,\n.panel-" + std::to_string(i) + " a {\n"
+            "    background: #1e1e1e;   /* surface */\n"
+            "    color: rgb(230, 230, 230);\n"
+            "    width: calc(100% - 2px);\n"
+            "}\n\n";
+    }
+    return text;
+}
+
+bool WriteFile(const std::wstring& path, const std::string& text) {
+    return FileUtil::Write(path, text.data(), text.size());
+}
+
+size_t CountCacheFiles(const std::wstring& cacheDir) {
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(cacheDir, entries);
+    return entries.size();
+}
+
+void RemoveTree(const std::wstring& dir) {
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(dir, entries);
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        if (e.isDirectory) RemoveTree(path);
+        else FileUtil::Remove(path);
+    }
+    rmdir(Utf8::FromWide(dir).c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int files = 12, lines = 40;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--files" && i + 1 < argc) {
+            files = std::atoi(argv[++i]);
+        } else if (arg == "--lines" && i + 1 < argc) {
+            lines = std::atoi(argv[++i]);
+        } else {
+            std::printf("Usage: injectbench [--files N] [--lines <functions per script>]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // JavaScript: literals stay intact, comments go, line breaks stay where ASI needs them
+    CheckMinified(Minifier::Js("var a = 1 ;  // note\nvar b = 'x  // y' ;"), "var a=1;var b='x  // y';", "js comments and strings");
+    CheckMinified(Minifier::Js("let s = `a ${ f(\"}\") + `b ${c}` } d`;"), "let s=`a ${ f(\"}\") + `b ${c}` } d`;", "js templates");
+    CheckMinified(Minifier::Js("x = a / b / c;\ny = /[/]+ x/g.test(z);"), "x=a/b/c;y=/[/]+ x/g.test(z);", "js division and regex");
+    CheckMinified(Minifier::Js("return /a b/ .test(s)"), "return/a b/.test(s)", "js regex after keyword");
+    CheckMinified(Minifier::Js("a = b\n++c\nreturn\nx"), "a=b\n++c\nreturn\nx", "js line breaks kept for ASI");
+    CheckMinified(Minifier::Js("a + +b - -c; 1 .toString()"), "a+ +b- -c;1 .toString()", "js unary operators");
+    CheckMinified(Minifier::Js("f(a,\n  b) {\n  c;\n}\n"), "f(a,b){c;}", "js joinable line breaks dropped");
+    CheckMinified(Minifier::Js("/*! MIT */\nvar /* x */ y"), "/*! MIT */\nvar y", "js license comment kept");
+
+    // CSS: spaces that matter (descendants, calc) stay
+    CheckMinified(Minifier::Css("a  b > c:hover , d {\n  color : red ;\n  width: calc(1px + 2px);\n}\n"),
+        "a b>c:hover,d{color :red;width:calc(1px + 2px)}", "css whitespace");
+    CheckMinified(Minifier::Css("/* x */ a::after { content: \"  /* no */  \"; }"), "a::after{content:\"  /* no */  \"}", "css strings and comments");
+    CheckMinified(Minifier::Css("@media screen and (max-width: 600px) { a :is(b) { x: y } }"),
+        "@media screen and (max-width:600px){a :is(b){x:y}}", "css media queries and descendant pseudo-classes");
+
+    char dirTemplate[] = "/tmp/injectbench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::fprintf(stderr, "cannot create temp directory\n");
+        return 1;
+    }
+    std::wstring root = Utf8::ToWide(dirTemplate);
+    std::wstring sources = FileUtil::Join(root, L"inject");
+    std::wstring cacheDir = FileUtil::Join(root, L"cache");
+    FileUtil::MakeDirectories(sources);
+    size_t sourceBytes = 0;
+    for (int i = 0; i < files; i++) {
+        std::string text = i % 3 == 2 ? SampleStyle(i, lines) : SampleScript(i, lines);
+        std::wstring name = (i < 10 ? L"0" : L"") + std::to_wstring(i) + (i % 3 == 2 ? L"-dark.css" : L"-keys.js");
+        WriteFile(FileUtil::Join(sources, name), text);
+        sourceBytes += text.size();
+    }
+    WriteFile(FileUtil::Join(sources, L"notes.txt"), "not injected");
+
+    // Cold: read, minify, write the cache; warm: one cached file
+    std::string cold, warm;
+    InjectStats coldStats, warmStats;
+    Clock::time_point start = Clock::now();
+    bool built = InjectBundle::Load(sources, cacheDir, cold, &coldStats);
+    double coldMs = MillisecondsSince(start);
+    const int runs = 50;
+    double warmMs = 0;
+    bool hits = true;
+    for (int r = 0; r < runs; r++) {
+        start = Clock::now();
+        hits = InjectBundle::Load(sources, cacheDir, warm, &warmStats) && warmStats.cacheHit && hits;
+        warmMs += MillisecondsSince(start) / runs;
+    }
+    std::printf("%d files, %zu source bytes -> %zu bundle bytes (%.0f%%)\n", files, sourceBytes,
+        cold.size(), 100.0 * cold.size() / sourceBytes);
+    std::printf("cold build %.3f ms, warm load %.3f ms\n", coldMs, warmMs);
+    Check(built && !coldStats.cacheHit && coldStats.files == (size_t)files, "cold build reads every source");
+    Check(hits && warm == cold, "warm load comes from the cache and matches");
+    Check(cold.find("[ww inject] 00-keys.js") != std::string::npos && cold.find("createElement(\"style\")") != std::string::npos,
+        "scripts wrapped and styles added");
+    Check(cold.find("not injected") == std::string::npos, "other files ignored");
+    Check(warmMs < coldMs, "warm load faster than cold build");
+
+    // An edited source is rebuilt, and the stale version removed
+    std::wstring first = FileUtil::Join(sources, L"00-keys.js");
+    WriteFile(first, SampleScript(0, lines) + "console.log('edited');\n");
+    std::string edited;
+    InjectStats editedStats;
+    Check(InjectBundle::Load(sources, cacheDir, edited, &editedStats) && !editedStats.cacheHit &&
+        edited.find("edited") != std::string::npos, "edited source rebuilt");
+    Check(CountCacheFiles(cacheDir) == 1, "stale bundle removed");
+
+    // A damaged cache file is rebuilt rather than injected
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(cacheDir, entries);
+    std::wstring cachePath = FileUtil::Join(cacheDir, entries[0].name);
+    std::string cached;
+    FileUtil::Read(cachePath, cached);
+    cached[cached.size() / 2] ^= 0x20;
+    WriteFile(cachePath, cached);
+    std::string repaired;
+    InjectStats repairedStats;
+    Check(InjectBundle::Load(sources, cacheDir, repaired, &repairedStats) && !repairedStats.cacheHit &&
+        repaired == edited, "damaged cache rebuilt");
+
+    // Without a cache folder every load builds
+    std::string uncached;
+    InjectStats uncachedStats;
+    Check(InjectBundle::Load(sources, L"", uncached, &uncachedStats) && !uncachedStats.cacheHit &&
+        uncached == edited, "no cache folder builds");
+    Check(!InjectBundle::Load(FileUtil::Join(root, L"missing"), cacheDir, uncached), "missing folder reported");
+
+    RemoveTree(root);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
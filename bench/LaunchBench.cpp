@@ -0,0 +1,207 @@
+// Launch scheduler benchmark: starts a fleet of CPU-bound stand-in apps
+// (this executable in child mode) with different concurrency limits and
+// reports total and per-app time to ready. Checks priority order, the
+// concurrency limit, and that timeouts and early exits are reported.
+//
+// POSIX only (children are started with posix_spawn); see README.md
+// ("Fleet Launch") for build and usage.
+
+#include "../LaunchScheduler.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Fixed amount of CPU work, standing in for a browser starting up
+volatile uint64_t g_sink;
+
+void Spin(uint64_t iterations) {
+    uint64_t x = 88172645463325252ULL;
+    for (uint64_t i = 0; i < iterations; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    }
+    g_sink = x;
+}
+
+uint64_t IterationsPerMs() {
+    Clock::time_point start = Clock::now();
+    uint64_t n = 1000000;
+    Spin(n);
+    return (uint64_t)(n / std::max(0.01, MillisecondsSince(start)));
+}
+
+// Child mode: works, signals ready (unless silent), lingers, exits
+int RunChild(uint64_t iterations, const std::string& mode, int lingerMs) {
+    if (mode == "crash") return 3;
+    Spin(iterations);
+    if (mode == "ready" && !LaunchScheduler::SignalReady()) return 4;
+    std::this_thread::sleep_for(std::chrono::milliseconds(lingerMs));
+    return 0;
+}
+
+std::vector<LaunchItem> Fleet(const std::wstring& self, int apps, uint64_t iterations) {
+    std::vector<LaunchItem> items;
+    for (int i = 0; i < apps; i++) {
+        LaunchItem item;
+        item.name = L"app" + std::to_wstring(i);
+        item.executable = self;
+        item.args = { L"--child", std::to_wstring(iterations), L"ready", L"200" };
+        item.priority = apps - i;  // Reverse of list order
+        items.push_back(item);
+    }
+    return items;
+}
+
+// Largest number of items that were starting at the same moment
+int MaxOverlap(const std::vector<LaunchResult>& results) {
+    std::vector<std::pair<double, int>> edges;
+    for (const LaunchResult& r : results) {
+        edges.push_back(std::make_pair(r.startMs, 1));
+        edges.push_back(std::make_pair(r.startMs + r.readyMs, -1));
+    }
+    std::sort(edges.begin(), edges.end());  // Ends sort before starts at the same time
+    int current = 0, most = 0;
+    for (const auto& e : edges) {
+        current += e.second;
+        most = std::max(most, current);
+    }
+    return most;
+}
+
+void ReapChildren() {
+    while (waitpid(-1, nullptr, 0) > 0) {
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 5 && std::string(argv[1]) == "--child") {
+        return RunChild(std::strtoull(argv[2], nullptr, 10), argv[3], std::atoi(argv[4]));
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    int apps = (int)std::max(8u, cores * 2);
+    int workMs = 150;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--apps" && i + 1 < argc) {
+            apps = std::atoi(argv[++i]);
+        } else if (arg == "--work" && i + 1 < argc) {
+            workMs = std::atoi(argv[++i]);
+        } else {
+            std::printf("Usage: launchbench [--apps N] [--work <ms of CPU per app>]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    char path[4096];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0) {
+        std::fprintf(stderr, "cannot locate own executable\n");
+        return 1;
+    }
+    path[len] = 0;
+    std::wstring self = Utf8::ToWide(path);
+    uint64_t iterations = IterationsPerMs() * (uint64_t)workMs;
+    std::vector<LaunchItem> fleet = Fleet(self, apps, iterations);
+
+    unsigned autoLimit = LaunchScheduler::AutoConcurrency();
+    std::printf("%d apps, %d ms CPU each, %u core(s), auto concurrency %u\n", apps, workMs, cores, autoLimit);
+    std::printf("%-12s %10s %10s %10s %10s\n", "concurrency", "total ms", "mean ms", "first ms", "max ms");
+
+    std::vector<unsigned> limits;
+    const unsigned candidates[] = { 1, autoLimit, cores, (unsigned)apps };
+    for (unsigned limit : candidates) {
+        if (std::find(limits.begin(), limits.end(), limit) == limits.end()) limits.push_back(limit);
+    }
+    double limitedMean = 0, unlimitedMean = 0;
+    for (unsigned limit : limits) {
+        LaunchOptions options;
+        options.concurrency = limit;
+        Clock::time_point start = Clock::now();
+        std::vector<LaunchResult> results = LaunchScheduler::Run(fleet, options);
+        double total = MillisecondsSince(start);
+
+        std::vector<double> readyAt;
+        bool allReady = true;
+        for (const LaunchResult& r : results) {
+            allReady = allReady && r.started && r.ready;
+            readyAt.push_back(r.startMs + r.readyMs);
+        }
+        std::sort(readyAt.begin(), readyAt.end());
+        double mean = 0;
+        for (double t : readyAt) mean += t / readyAt.size();
+        std::printf("%-12u %10.0f %10.0f %10.0f %10.0f\n", limit, total, mean, readyAt.front(), readyAt.back());
+
+        Check(allReady, "every app becomes ready");
+        Check(MaxOverlap(results) <= (int)limit, "concurrency limit respected");
+        if (limit == 1) {
+            // Priorities are the reverse of list order
+            bool ordered = true;
+            for (size_t i = 1; i < results.size(); i++) ordered = ordered && results[i].startMs <= results[i - 1].startMs;
+            Check(ordered, "higher priority starts first");
+        }
+        if (limit == cores) limitedMean = mean;
+        if (limit == (unsigned)apps) unlimitedMean = mean;
+        ReapChildren();
+    }
+    if ((unsigned)apps > cores) {
+        Check(limitedMean < unlimitedMean, "limiting to the core count lowers mean time to ready");
+    }
+
+    // A child that never signals is timed out; one that exits is reported
+    std::vector<LaunchItem> odd(3);
+    odd[0].name = L"silent";
+    odd[0].args = { L"--child", L"0", L"silent", L"2000" };
+    odd[1].name = L"crash";
+    odd[1].args = { L"--child", L"0", L"crash", L"0" };
+    odd[2].name = L"missing";
+    odd[2].executable = L"/nonexistent/ww";
+    odd[0].executable = odd[1].executable = self;
+    LaunchOptions options;
+    options.concurrency = 3;
+    options.readyTimeoutMs = 300;
+    std::vector<LaunchResult> results = LaunchScheduler::Run(odd, options);
+    Check(results[0].timedOut && !results[0].ready && results[0].readyMs >= 300 && results[0].readyMs < 1000,
+        "silent child times out");
+    Check(results[1].exited && !results[1].ready && results[1].readyMs < 300, "exiting child is reported");
+    Check(!results[2].started, "missing executable is reported");
+    std::printf("odd:      silent timed out after %.0f ms, crash exited after %.0f ms\n",
+        results[0].readyMs, results[1].readyMs);
+    if (results[0].processId) kill((pid_t)results[0].processId, SIGTERM);
+    ReapChildren();
+
+    Check(!LaunchScheduler::SignalReady(), "no signal outside a scheduler");
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Startup metrics benchmark: measures LatencyHistogram record / percentile /
+// merge costs and MetricsLog append / load / compact costs, and checks the
+// properties `ww stats` relies on: percentile error within one sub-bucket,
+// lossless merge and serialization, no lost records under concurrent
+// appends, and recovery from a torn record.
+//
+// Portable; see README.md ("Startup Metrics") for build and usage.
+
+#include "../FileUtil.h"
+#include "../LatencyHistogram.h"
+#include "../MetricsLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double ElapsedNs(Clock::time_point start) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Launch-like latencies in microseconds: log-normal around ~40 ms with a long tail
+std::vector<uint64_t> Samples(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::lognormal_distribution<double> dist(std::log(40000.0), 0.8);
+    std::vector<uint64_t> values(n);
+    for (uint64_t& v : values) v = (uint64_t)dist(rng);
+    return values;
+}
+
+void CheckBucketLayout() {
+    bool ok = true;
+    for (size_t i = 0; i + 1 < LatencyHistogram::kBucketCount; ++i) {
+        uint64_t lo = LatencyHistogram::BucketLowest(i);
+        ok = ok && LatencyHistogram::BucketIndex(lo) == i
+            && LatencyHistogram::BucketIndex(LatencyHistogram::BucketHighest(i)) == i
+            && LatencyHistogram::BucketLowest(i + 1) == LatencyHistogram::BucketHighest(i) + 1;
+    }
+    ok = ok && LatencyHistogram::BucketIndex(UINT64_MAX) == LatencyHistogram::kBucketCount - 1;
+    Check(ok, "bucket layout is contiguous");
+}
+
+void BenchHistogram() {
+    const size_t n = 1000000;
+    std::vector<uint64_t> values = Samples(n, 1);
+
+    LatencyHistogram h;
+    Clock::time_point start = Clock::now();
+    for (uint64_t v : values) h.Record(v);
+    std::printf("record:      %.1f ns/op\n", ElapsedNs(start) / n);
+
+    std::vector<uint64_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    const double percentiles[] = { 50, 90, 99, 99.9 };
+    double worst = 0;
+    start = Clock::now();
+    for (double p : percentiles) {
+        uint64_t exact = sorted[(size_t)std::ceil(p / 100.0 * n) - 1];
+        uint64_t got = h.Percentile(p);
+        worst = std::max(worst, std::fabs((double)got - (double)exact) / (double)exact);
+    }
+    std::printf("percentile:  %.1f us/op, worst relative error %.4f\n",
+        ElapsedNs(start) / 1000.0 / 4, worst);
+    Check(worst <= 1.0 / 64, "percentile within one sub-bucket");
+    Check(h.Percentile(100) == sorted.back() && h.Percentile(0) == sorted.front(), "extremes exact");
+
+    // Merging per-launch pieces gives the same histogram as recording everything once
+    LatencyHistogram parts[4];
+    for (size_t i = 0; i < n; ++i) parts[i % 4].Record(values[i]);
+    LatencyHistogram merged;
+    start = Clock::now();
+    for (const LatencyHistogram& part : parts) merged.Merge(part);
+    std::printf("merge:       %.1f us/op\n", ElapsedNs(start) / 1000.0 / 4);
+    bool same = merged.Count() == h.Count() && merged.Min() == h.Min() && merged.Max() == h.Max();
+    for (double p = 0; p <= 100; p += 0.5) same = same && merged.Percentile(p) == h.Percentile(p);
+    Check(same, "merge equals single histogram");
+
+    std::string bytes;
+    h.Serialize(bytes);
+    LatencyHistogram loaded;
+    const uint8_t* p = (const uint8_t*)bytes.data();
+    Check(loaded.Deserialize(p, p + bytes.size()) && p == (const uint8_t*)bytes.data() + bytes.size(), "deserialize");
+    same = loaded.Count() == h.Count() && loaded.Max() == h.Max();
+    for (double q = 0; q <= 100; q += 0.5) same = same && loaded.Percentile(q) == h.Percentile(q);
+    Check(same, "serialization round trip");
+    std::printf("serialized:  %zu bytes for %zu samples\n", bytes.size(), n);
+}
+
+void BenchLog(const std::wstring& path) {
+    FileUtil::Remove(path);
+    FileUtil::Remove(path + L".compacting");
+
+    // Concurrent "launches" appending to the same log
+    const int writers = 8;
+    const int launchesPerWriter = 50;
+    const char* apps[] = { "Gmail", "GitHub", "Calendar" };
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            std::vector<uint64_t> values = Samples(launchesPerWriter * 6, w + 10);
+            for (int i = 0; i < launchesPerWriter; ++i) {
+                std::vector<StartupTiming::Phase> phases;
+                const char* names[] = { "args", "icon", "window", "environment", "controller", "navigation" };
+                for (int k = 0; k < 6; ++k) {
+                    phases.push_back(StartupTiming::Phase{ names[k], values[i * 6 + k] / 1000.0 });
+                }
+                MetricsLog::AppendLaunch(path, apps[(w + i) % 3], phases);
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    const int total = writers * launchesPerWriter;
+    std::printf("append:      %.1f us/launch (%d writers, fsync per append)\n",
+        ElapsedNs(start) / 1000.0 / launchesPerWriter, writers);
+
+    std::vector<AppLatency> before;
+    start = Clock::now();
+    Check(MetricsLog::Load(path, before), "load");
+    std::printf("load:        %.1f us (%d launch records)\n", ElapsedNs(start) / 1000.0, total);
+    uint64_t launches = 0;
+    for (const AppLatency& a : before) launches += a.launches;
+    Check(launches == (uint64_t)total && before.size() == 3, "no records lost under concurrent appends");
+
+    std::string raw;
+    FileUtil::Read(path, raw);
+    start = Clock::now();
+    Check(MetricsLog::Compact(path), "compact");
+    std::printf("compact:     %.1f us\n", ElapsedNs(start) / 1000.0);
+    std::string compacted;
+    FileUtil::Read(path, compacted);
+    std::printf("log size:    %zu -> %zu bytes\n", raw.size(), compacted.size());
+
+    std::vector<AppLatency> after;
+    Check(MetricsLog::Load(path, after) && after.size() == before.size(), "load compacted");
+    bool same = true;
+    for (size_t i = 0; i < after.size() && i < before.size(); ++i) {
+        same = same && after[i].app == before[i].app && after[i].launches == before[i].launches
+            && after[i].phases.size() == before[i].phases.size();
+        for (size_t k = 0; same && k < after[i].phases.size(); ++k) {
+            same = after[i].phases[k].histogram.Percentile(99) == before[i].phases[k].histogram.Percentile(99);
+        }
+    }
+    Check(same, "compaction preserves percentiles");
+
+    // A launch that died mid-write, followed by a healthy one
+    std::vector<StartupTiming::Phase> phases = { StartupTiming::Phase{ "navigation", 120.0 } };
+    std::string torn = "\x57\x57\x4D\x4C\x40\x00\x00\x00garbage";
+    FileUtil::Append(path, torn.data(), torn.size());
+    MetricsLog::AppendLaunch(path, "Gmail", phases);
+    std::vector<AppLatency> recovered;
+    Check(MetricsLog::Load(path, recovered), "load after torn record");
+    launches = 0;
+    for (const AppLatency& a : recovered) launches += a.launches;
+    Check(launches == (uint64_t)total + 1, "record after torn one is kept");
+
+    FileUtil::Remove(path);
+}
+
+}
+
+int main() {
+    CheckBucketLayout();
+    BenchHistogram();
+    BenchLog(L"metricsbench.log");
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,213 @@
+// PNG encoder benchmark: encodes the icon entries IcoBuilder stores as PNG
+// (each corpus image fitted to 64 and 256 px) at every Deflate level and
+// reports encode time against output size. Checks that every output
+// decodes back to the same pixels through PngDecoder, that raw Deflate and
+// zlib streams round trip through Inflate at every level, and that higher
+// levels don't produce larger files overall. Inputs that end inside a
+// repeated run check the matcher's bounds.
+//
+// Portable; see README.md ("PNG Encoding") for build and usage.
+
+#include "../Deflate.h"
+#include "../FileUtil.h"
+#include "../ImageResample.h"
+#include "../Inflate.h"
+#include "../PngDecoder.h"
+#include "../PngEncoder.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const uint32_t kSizes[] = { 64, 256 };
+const int kLevels = 10;
+
+int g_failures = 0;
+
+void Check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+struct Entry {
+    std::string name;
+    uint32_t size = 0;
+    std::vector<uint8_t> bgra;
+};
+
+// Same alpha handling as the encoder: fully transparent pixels may come
+// back with any color, so only their alpha is compared
+bool SamePixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        if (a[i + 3] != b[i + 3]) return false;
+        if (a[i + 3] && memcmp(&a[i], &b[i], 3) != 0) return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::wstring corpusDir = L"bench/corpus";
+    int iterations = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--corpus" && i + 1 < argc) {
+            corpusDir = Utf8::ToWide(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::printf("Usage: pngbench [--corpus <dir>] [--iterations N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::vector<FileUtil::Entry> files;
+    if (!FileUtil::List(corpusDir, files)) {
+        std::fprintf(stderr, "cannot list %s\n", Utf8::FromWide(corpusDir).c_str());
+        return 1;
+    }
+    std::sort(files.begin(), files.end(),
+        [](const FileUtil::Entry& a, const FileUtil::Entry& b) { return a.name < b.name; });
+
+    // Icon entries as IcoBuilder would receive them
+    std::vector<Entry> entries;
+    for (const FileUtil::Entry& f : files) {
+        if (f.isDirectory || f.name.size() < 4 || f.name.compare(f.name.size() - 4, 4, L".png") != 0) continue;
+        std::string data;
+        PngImage source;
+        if (!FileUtil::Read(FileUtil::Join(corpusDir, f.name), data) ||
+            !PngDecoder::Decode((const uint8_t*)data.data(), data.size(), source)) {
+            Check(false, "decode " + Utf8::FromWide(f.name));
+            continue;
+        }
+        for (uint32_t size : kSizes) {
+            Entry e;
+            e.name = Utf8::FromWide(f.name.substr(0, f.name.size() - 4));
+            e.size = size;
+            ImageResample::FitSquare(source.bgra.data(), source.width, source.height, (size_t)source.width * 4,
+                size, e.bgra);
+            entries.push_back(std::move(e));
+        }
+    }
+    if (entries.empty()) {
+        std::fprintf(stderr, "no PNG files in %s\n", Utf8::FromWide(corpusDir).c_str());
+        return 1;
+    }
+
+    // Encode time and size per level; the raw size is what a 32-bit DIB entry would take
+    std::printf("%-22s %5s %9s", "image", "size", "raw");
+    for (int level = 0; level < kLevels; level++) std::printf("   level %d", level);
+    std::printf("\n");
+    std::vector<double> totalMs(kLevels, 0.0);
+    std::vector<size_t> totalBytes(kLevels, 0);
+    size_t totalRaw = 0;
+    for (const Entry& e : entries) {
+        size_t raw = e.bgra.size();
+        totalRaw += raw;
+        std::vector<double> ms(kLevels);
+        std::vector<size_t> bytes(kLevels);
+        for (int level = 0; level < kLevels; level++) {
+            std::vector<uint8_t> png;
+            std::vector<double> runs;
+            for (int i = 0; i < iterations; i++) {
+                png.clear();
+                Clock::time_point start = Clock::now();
+                bool ok = PngEncoder::Encode(e.bgra.data(), e.size, e.size, (size_t)e.size * 4,
+                    PngEncoder::Layout::BGRA, level, png);
+                runs.push_back(MillisecondsSince(start));
+                if (!ok) break;
+            }
+            ms[level] = Median(runs);
+            bytes[level] = png.size();
+            totalMs[level] += ms[level];
+            totalBytes[level] += png.size();
+
+            PngImage decoded;
+            std::string label = e.name + " " + std::to_string(e.size) + " level " + std::to_string(level);
+            Check(PngDecoder::Decode(png.data(), png.size(), decoded) && decoded.width == e.size &&
+                decoded.height == e.size && SamePixels(decoded.bgra, e.bgra), "png round trip " + label);
+
+            std::vector<uint8_t> packed, unpacked;
+            Deflate::Compress(e.bgra.data(), e.bgra.size(), level, packed);
+            Check(Inflate::Decompress(packed.data(), packed.size(), e.bgra.size(), unpacked) && unpacked == e.bgra,
+                "deflate round trip " + label);
+            packed.clear();
+            unpacked.clear();
+            Deflate::CompressZlib(e.bgra.data(), e.bgra.size(), level, packed);
+            Check(Inflate::DecompressZlib(packed.data(), packed.size(), e.bgra.size(), unpacked) &&
+                unpacked == e.bgra, "zlib round trip " + label);
+        }
+
+        std::printf("%-22s %5u %9zu", e.name.c_str(), e.size, raw);
+        for (int level = 0; level < kLevels; level++) std::printf(" %9zu", bytes[level]);
+        std::printf("\n%-22s %5s %9s", "", "", "ms");
+        for (int level = 0; level < kLevels; level++) std::printf(" %9.2f", ms[level]);
+        std::printf("\n");
+    }
+
+    std::printf("%-22s %5s %9zu", "total", "", totalRaw);
+    for (int level = 0; level < kLevels; level++) std::printf(" %9zu", totalBytes[level]);
+    std::printf("\n%-22s %5s %9s", "", "", "ms");
+    for (int level = 0; level < kLevels; level++) std::printf(" %9.2f", totalMs[level]);
+    std::printf("\n");
+
+    Check(totalBytes[0] > totalBytes[1], "compression beats stored blocks");
+    for (int level = 2; level < kLevels; level++) {
+        Check(totalBytes[level] <= totalBytes[1], "level " + std::to_string(level) + " no larger than level 1");
+    }
+
+    // Small inputs and edge cases of the stream formats
+    for (int level = 0; level < kLevels; level++) {
+        const char* samples[] = { "", "a", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "abcabcabcabcabcabd" };
+        for (const char* s : samples) {
+            std::vector<uint8_t> packed, unpacked;
+            Deflate::CompressZlib((const uint8_t*)s, strlen(s), level, packed);
+            Check(Inflate::DecompressZlib(packed.data(), packed.size(), strlen(s) + 1, unpacked) &&
+                std::string(unpacked.begin(), unpacked.end()) == s, "short zlib round trip");
+        }
+    }
+
+    // Buffers ending inside a repeated run: the lazy matcher looks one byte
+    // ahead with a match that already reaches the end of the input (run
+    // under -fsanitize=address to catch reads past it)
+    for (int level = 1; level < kLevels; level++) {
+        for (size_t tail = 0; tail < 300; tail += 7) {
+            std::string text = "prefix: the quick brown fox, ";
+            text += text.substr(0, 9);
+            text.append(tail, 'z');
+            text += text.substr(0, 20 + tail % 40);
+            std::vector<uint8_t> exact(text.begin(), text.end()), packed, unpacked;
+            Deflate::Compress(exact.data(), exact.size(), level, packed);
+            Check(Inflate::Decompress(packed.data(), packed.size(), exact.size(), unpacked) && unpacked == exact,
+                "run at end of input round trip, level " + std::to_string(level));
+        }
+    }
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
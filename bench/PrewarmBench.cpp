@@ -0,0 +1,191 @@
+// Connection prewarm check: runs Prewarmer against local stand-in servers
+// with simulated DNS latency (a slow resolver) and TCP latency (a listener
+// whose accept queue is full, so SYNs go unanswered), and verifies that
+// results are reported and that the deadline and Cancel() are honoured.
+//
+// POSIX only (relies on Linux dropping SYNs to a full accept queue); see
+// README.md ("Connection Prewarming") for build and usage.
+
+#include "../Prewarmer.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Listens on 127.0.0.1 with an ephemeral port; never accepts
+int Listen(int backlog, uint16_t& port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (s < 0 || bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, backlog) != 0
+        || getsockname(s, (sockaddr*)&addr, &len) != 0) {
+        if (s >= 0) close(s);
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return s;
+}
+
+// Fills the accept queue of a backlog-0 listener until new connections
+// stall. Returns false if the platform completes them anyway.
+bool SaturateBacklog(uint16_t port, std::vector<int>& fillers) {
+    for (int i = 0; i < 8; ++i) {
+        int s = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(s, F_SETFL, O_NONBLOCK);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        connect(s, (sockaddr*)&addr, sizeof(addr));
+        fillers.push_back(s);
+
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(s, &writable);
+        timeval tv = { 0, 200 * 1000 };
+        if (select(s + 1, nullptr, &writable, nullptr, &tv) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Prewarmer::Resolver SlowResolver(int delayMs) {
+    return [delayMs](const std::string& host) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        return host == "app.test" ? std::vector<std::string>{ "127.0.0.1" } : std::vector<std::string>();
+    };
+}
+
+std::wstring LocalUrl(uint16_t port) {
+    return L"https://app.test:" + std::to_wstring(port) + L"/inbox?x=1";
+}
+
+void CheckParseOrigin() {
+    struct Case {
+        const wchar_t* url;
+        bool ok;
+        const char* host;
+        uint16_t port;
+    };
+    const Case cases[] = {
+        { L"https://Mail.Example.com/u/0/", true, "mail.example.com", 443 },
+        { L"http://localhost:3000", true, "localhost", 3000 },
+        { L"https://user:pw@example.com:8443?q=1", true, "example.com", 8443 },
+        { L"http://[::1]:8080/", true, "::1", 8080 },
+        { L"https://example.com#frag", true, "example.com", 443 },
+        { L"file:///C:/app/index.html", false, "", 0 },
+        { L"https://example.com:99999/", false, "", 0 },
+        { L"https://:443/", false, "", 0 },
+    };
+    for (const Case& c : cases) {
+        std::string host;
+        uint16_t port = 0;
+        bool ok = Prewarmer::ParseOrigin(c.url, host, port);
+        if (ok != c.ok || (ok && (host != c.host || port != c.port))) {
+            std::fprintf(stderr, "FAIL: ParseOrigin case %s -> %d %s:%u\n", c.host, ok, host.c_str(), port);
+            g_failures++;
+        }
+    }
+}
+
+}
+
+int main() {
+    CheckParseOrigin();
+
+    // Healthy origin behind an 80 ms resolver
+    uint16_t port = 0;
+    int server = Listen(16, port);
+    Check(server >= 0, "listen");
+    {
+        Prewarmer prewarmer;
+        prewarmer.SetResolver(SlowResolver(80));
+        Clock::time_point start = Clock::now();
+        Check(prewarmer.Start(LocalUrl(port), 1000), "start");
+        Check(!prewarmer.Start(LocalUrl(port), 1000), "second start rejected");
+        Check(prewarmer.Wait(2000), "healthy prewarm finishes");
+        PrewarmResult r = prewarmer.Result();
+        std::printf("healthy:   dns %.1f ms, connect %.2f ms, total %.1f ms\n", r.dnsMs, r.connectMs, MillisecondsSince(start));
+        Check(r.resolved && r.connected && !r.timedOut && !r.cancelled, "healthy prewarm connects");
+        Check(r.dnsMs >= 79, "resolver latency measured");
+    }
+    close(server);
+
+    // Resolver slower than the deadline: Wait gives up, the thread is abandoned
+    {
+        Prewarmer prewarmer;
+        prewarmer.SetResolver(SlowResolver(400));
+        prewarmer.Start(L"https://app.test/", 100);
+        Clock::time_point start = Clock::now();
+        Check(!prewarmer.Wait(150), "slow resolver not finished");
+        std::printf("slow dns:  abandoned after %.1f ms\n", MillisecondsSince(start));
+    }
+
+    // Unanswered SYNs: the connect must stop at the deadline, or on Cancel()
+    server = Listen(0, port);
+    std::vector<int> fillers;
+    if (server >= 0 && SaturateBacklog(port, fillers)) {
+        Prewarmer timed;
+        timed.SetResolver(SlowResolver(0));
+        Clock::time_point start = Clock::now();
+        timed.Start(LocalUrl(port), 300);
+        Check(timed.Wait(1000), "stalled connect finishes");
+        double elapsed = MillisecondsSince(start);
+        PrewarmResult r = timed.Result();
+        std::printf("stalled:   timed out after %.1f ms (deadline 300 ms)\n", elapsed);
+        Check(r.resolved && !r.connected && r.timedOut, "stalled connect times out");
+        Check(elapsed < 300 + 60, "deadline honoured");
+
+        Prewarmer cancelled;
+        cancelled.SetResolver(SlowResolver(0));
+        cancelled.Start(LocalUrl(port), 5000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        start = Clock::now();
+        cancelled.Cancel();
+        Check(cancelled.Wait(1000), "cancelled connect finishes");
+        elapsed = MillisecondsSince(start);
+        std::printf("cancelled: stopped %.1f ms after Cancel()\n", elapsed);
+        Check(cancelled.Result().cancelled, "cancel reported");
+        Check(elapsed < 60, "cancel honoured promptly");
+    } else {
+        std::printf("stalled:   skipped (accept queue could not be saturated)\n");
+    }
+    for (int s : fillers) close(s);
+    if (server >= 0) close(server);
+
+    // Let the abandoned resolver thread finish before exit
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
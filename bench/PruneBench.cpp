@@ -0,0 +1,186 @@
+// Cache pruner benchmark: builds a large synthetic WebView2-style profile
+// (cache directories plus site data), times CachePruner::Measure with
+// different thread counts, prunes to a budget and checks that only cache
+// files were removed, oldest first, and that the budget is met. Service
+// worker storage counts as site data and must be left alone.
+//
+// POSIX only (sets access times with utimensat); see README.md
+// ("Per-App Profiles") for build and usage.
+
+#include "../CachePruner.h"
+#include "../FileUtil.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct SyntheticFile {
+    std::wstring path;
+    uint64_t size;
+    int64_t lastUsed;
+    bool cache;
+};
+
+void SetTimes(const std::wstring& path, int64_t t) {
+    timespec times[2] = { { (time_t)t, 0 }, { (time_t)t, 0 } };
+    utimensat(AT_FDCWD, Utf8::FromWide(path).c_str(), times, 0);
+}
+
+// Spreads files over cache and site-data directories, many levels deep
+std::vector<SyntheticFile> BuildTree(const std::wstring& root, int dirs, int filesPerDir) {
+    // The first four are caches, the rest site data
+    const wchar_t* const parents[] = {
+        L"EBWebView/Default/Cache/Cache_Data", L"EBWebView/Default/Code Cache/js",
+        L"EBWebView/Default/GPUCache", L"EBWebView/GrShaderCache",
+        L"EBWebView/Default/IndexedDB", L"EBWebView/Default/Local Storage/leveldb",
+        L"EBWebView/Default/Service Worker/CacheStorage", L"EBWebView/Default/Service Worker/ScriptCache",
+    };
+    const int kParents = sizeof(parents) / sizeof(parents[0]);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> sizeDist(256, 16384);
+    std::uniform_int_distribution<int> ageDist(0, 90 * 24 * 3600);
+    int64_t now = (int64_t)time(nullptr);
+    std::string payload(16384, 'x');
+
+    std::vector<SyntheticFile> files;
+    for (int d = 0; d < dirs; ++d) {
+        const wchar_t* parent = parents[d % kParents];
+        bool cache = d % kParents < 4;
+        std::wstring dir = FileUtil::Join(root, parent);
+        dir = FileUtil::Join(dir, L"d" + std::to_wstring(d / kParents % 16));
+        dir = FileUtil::Join(dir, L"e" + std::to_wstring(d));
+        FileUtil::MakeDirectories(dir);
+        for (int f = 0; f < filesPerDir; ++f) {
+            SyntheticFile file;
+            file.path = FileUtil::Join(dir, (f == 0 && cache) ? L"index" : L"f_" + std::to_wstring(f));
+            file.size = (uint64_t)sizeDist(rng);
+            file.lastUsed = now - ageDist(rng);
+            file.cache = cache;
+            // Plain stdio: FileUtil::Write's fsync would dominate the build
+            FILE* out = std::fopen(Utf8::FromWide(file.path).c_str(), "wb");
+            if (out) {
+                std::fwrite(payload.data(), 1, (size_t)file.size, out);
+                std::fclose(out);
+            }
+            SetTimes(file.path, file.lastUsed);
+            files.push_back(file);
+        }
+    }
+    return files;
+}
+
+void RemoveTree(const std::wstring& root) {
+    std::string command = "rm -rf '" + Utf8::FromWide(root) + "'";
+    if (std::system(command.c_str()) != 0) {
+        std::fprintf(stderr, "warning: failed to remove %s\n", Utf8::FromWide(root).c_str());
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int dirs = 600;
+    int filesPerDir = 50;
+    std::wstring root = L"prunebench.tmp";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dirs" && i + 1 < argc) {
+            dirs = std::atoi(argv[++i]);
+        } else if (arg == "--files" && i + 1 < argc) {
+            filesPerDir = std::atoi(argv[++i]);
+        } else if (arg == "--root" && i + 1 < argc) {
+            root = Utf8::ToWide(argv[++i]);
+        } else {
+            std::printf("Usage: prunebench [--dirs N] [--files N] [--root <dir>]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    RemoveTree(root);
+    Clock::time_point start = Clock::now();
+    std::vector<SyntheticFile> files = BuildTree(root, dirs, filesPerDir);
+    std::printf("build:    %zu files in %.0f ms\n", files.size(), MillisecondsSince(start));
+
+    uint64_t expectedTotal = 0, expectedCache = 0;
+    for (const SyntheticFile& f : files) {
+        expectedTotal += f.size;
+        if (f.cache) expectedCache += f.size;
+    }
+
+    // Warm the directory cache once so thread counts are compared fairly
+    CachePruner::Measure(root, 1);
+    const unsigned threadCounts[] = { 1, 2, 4, 8 };
+    for (unsigned threads : threadCounts) {
+        start = Clock::now();
+        DiskUsage usage = CachePruner::Measure(root, threads);
+        std::printf("measure:  %u thread(s) %.1f ms (%zu dirs, %zu files)\n",
+            threads, MillisecondsSince(start), usage.directories, usage.files);
+        Check(usage.files == files.size() && usage.totalBytes == expectedTotal
+            && usage.cacheBytes == expectedCache, "measured sizes match");
+    }
+
+    uint64_t budget = expectedCache / 4;
+    PruneResult r = CachePruner::Prune(root, budget);
+    std::printf("prune:    removed %zu files (%llu KB) in %.1f ms, budget %llu KB\n",
+        r.removedFiles, (unsigned long long)(r.removedBytes / 1024), r.elapsedMs,
+        (unsigned long long)(budget / 1024));
+
+    // Only cache files are gone, the budget is met, and nothing kept is older
+    // than anything removed
+    int64_t newestRemoved = INT64_MIN, oldestKept = INT64_MAX;
+    bool siteDataKept = true, serviceWorkerKept = true, indexKept = true;
+    for (const SyntheticFile& f : files) {
+        bool exists = FileUtil::Exists(f.path);
+        bool isIndex = f.path.size() >= 6 && f.path.compare(f.path.size() - 6, 6, L"/index") == 0;
+        if (!f.cache) {
+            siteDataKept = siteDataKept && exists;
+            if (f.path.find(L"/Service Worker/") != std::wstring::npos) {
+                serviceWorkerKept = serviceWorkerKept && exists;
+            }
+        } else if (isIndex) {
+            indexKept = indexKept && exists;
+        } else if (exists) {
+            oldestKept = std::min(oldestKept, f.lastUsed);
+        } else {
+            newestRemoved = std::max(newestRemoved, f.lastUsed);
+        }
+    }
+    Check(siteDataKept, "site data untouched");
+    Check(serviceWorkerKept, "service worker CacheStorage and ScriptCache untouched");
+    Check(indexKept, "cache index files kept");
+    Check(newestRemoved <= oldestKept, "least recently used removed first");
+    DiskUsage after = CachePruner::Measure(root);
+    Check(after.cacheBytes <= budget, "cache within budget");
+    Check(after.cacheBytes + r.removedBytes == expectedCache, "removed bytes accounted");
+
+    RemoveTree(root);
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
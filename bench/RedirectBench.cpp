@@ -0,0 +1,251 @@
+// Redirect cache benchmark: measures launch-time costs of the redirect
+// memo (loading the store, KvStore::Get, RedirectCache::Lookup) and
+// checks the behaviour those numbers depend on: expiry, the replay policy,
+// recovery from a torn log tail, and several processes (stood in for by
+// separate stores and threads) sharing one log.
+//
+// Portable; see README.md ("Redirect Cache Benchmark") for build and usage.
+
+#include "../FileUtil.h"
+#include "../KvStore.h"
+#include "../RedirectCache.h"
+#include "../Utf8.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock SteadyClock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double ElapsedNs(SteadyClock::time_point start) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - start).count();
+}
+
+std::wstring TargetUrl(int i) {
+    return L"https://app" + std::to_wstring(i) + L".example.com/";
+}
+
+std::wstring FinalUrl(int i) {
+    return L"https://login" + std::to_wstring(i % 7) + L".example.com/app/" + std::to_wstring(i) + L"/home";
+}
+
+void CheckPolicy() {
+    struct Case {
+        const wchar_t* target;
+        const wchar_t* finalUrl;
+        bool replayable;
+    };
+    const Case cases[] = {
+        { L"https://mail.example.com", L"https://mail.example.com/u/0/#inbox", true },
+        { L"http://example.com", L"https://www.example.com/", true },
+        { L"https://example.com", L"http://example.com/", false },
+        { L"https://example.com", L"https://example.com/cb?code=abc&state=xyz", false },
+        { L"https://example.com", L"https://example.com/cb#access_token=abc", false },
+        { L"https://example.com", L"https://example.com/video?codec=h264", true },
+        { L"https://example.com", L"file:///C:/index.html", false },
+    };
+    for (const Case& c : cases) {
+        bool got = RedirectCache::IsReplayable(c.target, c.finalUrl);
+        if (got != c.replayable) {
+            std::fprintf(stderr, "FAIL: IsReplayable(%s) = %d\n", Utf8::FromWide(c.finalUrl).c_str(), got);
+            g_failures++;
+        }
+    }
+}
+
+void CheckExpiry() {
+    int64_t now = 1000;
+    KvStore store;
+    store.SetClock([&now]() { return now; });
+    RedirectCache cache(store, 60);
+    cache.RecordSettled(TargetUrl(1), FinalUrl(1));
+    Check(cache.Lookup(TargetUrl(1)) == FinalUrl(1), "lookup before expiry");
+    now += 61;
+    Check(cache.Lookup(TargetUrl(1)).empty(), "lookup after expiry");
+}
+
+void CheckTornTail(const std::wstring& path) {
+    FileUtil::Remove(path);
+    {
+        KvStore store;
+        store.Open(path);
+        store.Put("a", "1", 0);
+        store.Put("b", "2", 0);
+    }
+
+    // Simulate a crash halfway through the last record
+    std::string data;
+    FileUtil::Read(path, data);
+    data.resize(data.size() - 3);
+    FileUtil::Write(path, data.data(), data.size());
+
+    KvStore store;
+    Check(store.Open(path), "open torn log");
+    std::string value;
+    Check(store.Get("a", value) && value == "1", "record before torn tail survives");
+    Check(!store.Get("b", value), "torn record dropped");
+
+    // Records appended after the torn one are still found
+    store.Put("c", "3", 0);
+    KvStore reloaded;
+    reloaded.Open(path);
+    Check(reloaded.Get("a", value) && reloaded.Get("c", value) && value == "3", "record after torn tail read");
+    Check(reloaded.Compact(), "compact torn log");
+    std::string compacted;
+    FileUtil::Read(path, compacted);
+    KvStore clean;
+    clean.Open(path);
+    Check(clean.Size() == 2 && compacted.size() < data.size() + 30, "torn bytes compacted away");
+    FileUtil::Remove(path);
+}
+
+// Two launches share the log: compaction in one keeps what the other
+// appended after it was opened, and a half-written record from the other
+// doesn't hide later ones
+void CheckSharedLog(const std::wstring& path) {
+    FileUtil::Remove(path);
+    KvStore first, second;
+    first.Open(path);
+    second.Open(path);
+    Check(first.Put("first", "1", 0), "put from first store");
+
+    // Another launch still writing its record
+    const char partial[] = "KVWV\x01\x02";
+    FileUtil::Append(path, partial, sizeof(partial) - 1);
+
+    // Enough overwrites to make the second store compact
+    bool ok = true;
+    for (int i = 0; i < 200; ++i) ok = second.Put("second", std::to_string(i), 0) && ok;
+    Check(ok, "puts from second store");
+    std::string data, value;
+    FileUtil::Read(path, data);
+    Check(data.size() < 200 * 24, "second store compacted");
+
+    KvStore reloaded;
+    reloaded.Open(path);
+    Check(reloaded.Get("first", value) && value == "1", "other store's record survives compaction");
+    Check(reloaded.Get("second", value) && value == "199", "compacting store's record kept");
+    Check(second.Get("first", value), "compaction picks up other store's records");
+
+    // Concurrent compactions write separate temporary files
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&path, &failures, t]() {
+            KvStore store;
+            store.Open(path);
+            for (int i = 0; i < 100; ++i) {
+                if (!store.Put("t" + std::to_string(t), std::to_string(i), 0)) failures++;
+                if (i % 10 == 9 && !store.Compact()) failures++;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    Check(failures == 0, "concurrent compactions succeed");
+    reloaded.Open(path);
+    Check(reloaded.Get("first", value) && reloaded.Get("second", value), "records survive concurrent compactions");
+    FileUtil::Remove(path);
+}
+
+void PrintUsage() {
+    std::printf("Usage: redirectbench [--entries N] [--lookups N] [--store <path>]\n");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int entries = 1000;
+    int lookups = 1000000;
+    std::wstring path = L"redirectbench.kv";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--entries" && i + 1 < argc) {
+            entries = std::atoi(argv[++i]);
+        } else if (arg == "--lookups" && i + 1 < argc) {
+            lookups = std::atoi(argv[++i]);
+        } else if (arg == "--store" && i + 1 < argc) {
+            path = Utf8::ToWide(argv[++i]);
+        } else {
+            PrintUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+    if (entries < 1 || lookups < 1) {
+        PrintUsage();
+        return 2;
+    }
+
+    CheckPolicy();
+    CheckExpiry();
+    CheckTornTail(path);
+    CheckSharedLog(path);
+
+    // Populate a store the size of a heavy user's
+    FileUtil::Remove(path);
+    {
+        KvStore store;
+        store.Open(path);
+        RedirectCache cache(store);
+        SteadyClock::time_point start = SteadyClock::now();
+        for (int i = 0; i < entries; ++i) {
+            cache.RecordSettled(TargetUrl(i), FinalUrl(i));
+        }
+        std::printf("record:  %.0f ns/op (%d entries, fsync per write)\n", ElapsedNs(start) / entries, entries);
+    }
+
+    // Launch-time load
+    KvStore store;
+    SteadyClock::time_point start = SteadyClock::now();
+    Check(store.Open(path), "open populated store");
+    std::printf("open:    %.1f us (%zu entries)\n", ElapsedNs(start) / 1000.0, store.Size());
+    Check(store.Size() == (size_t)entries, "entry count after reload");
+
+    std::vector<std::string> keys;
+    std::vector<std::wstring> targets;
+    for (int i = 0; i < entries; ++i) {
+        targets.push_back(TargetUrl(i));
+        keys.push_back("redirect:" + Utf8::FromWide(targets.back()));
+    }
+
+    size_t found = 0;
+    std::string value;
+    start = SteadyClock::now();
+    for (int i = 0; i < lookups; ++i) {
+        found += store.Get(keys[i % entries], value);
+    }
+    std::printf("get:     %.1f ns/op\n", ElapsedNs(start) / lookups);
+    Check(found == (size_t)lookups, "every key found");
+
+    RedirectCache cache(store);
+    found = 0;
+    start = SteadyClock::now();
+    for (int i = 0; i < lookups; ++i) {
+        found += !cache.Lookup(targets[i % entries]).empty();
+    }
+    std::printf("lookup:  %.1f ns/op (includes UTF-8 conversion)\n", ElapsedNs(start) / lookups);
+    Check(found == (size_t)lookups, "every target memoized");
+    Check(cache.Lookup(TargetUrl(3)) == FinalUrl(3), "lookup returns recorded URL");
+
+    FileUtil::Remove(path);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,367 @@
+// Shortcut sync benchmark: parses the .lnk fixtures in bench/lnk with
+// ShellLink and checks every field (LinkInfo local paths, relative paths,
+// arguments, icon locations, environment blocks, Unicode paths). Every
+// truncation and a set of corrupt headers, sizes and offsets must be
+// rejected or parsed without reading out of bounds. Then checks the
+// create/update/delete/keep decisions of ShortcutSync::Plan, including
+// links whose icon the shell stored as %USERPROFILE%\..., and times parsing
+// and planning for a large shortcut folder.
+//
+// Portable; see README.md ("Shortcut Sync") for build and usage.
+
+#include "../FileUtil.h"
+#include "../ShellLink.h"
+#include "../ShortcutSync.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const wchar_t kExe[] = L"C:\\Program Files\\WebWrap\\WebWrap.exe";
+const wchar_t kArgs[] = L"--target \"https://example.com/\" --name \"Example\" --icon \"C:\\Icons\\example.png\"";
+const wchar_t kIcon[] = L"C:\\Users\\me\\AppData\\Local\\Temp\\WebWrap\\example.ico";
+const wchar_t kHash[] = L"0123456789abcdef";
+
+int g_failures = 0;
+
+void Check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Environment of the machine the fixtures were "written" on; names are
+// case-insensitive as on Windows
+bool FakeEnvironment(const std::wstring& name, std::wstring& value) {
+    static const std::map<std::wstring, std::wstring> vars = {
+        { L"userprofile", L"C:\\Users\\me" },
+        { L"localappdata", L"C:\\Users\\me\\AppData\\Local" },
+        { L"programfiles", L"C:\\Program Files" },
+    };
+    std::wstring key(name);
+    for (auto& c : key) c = (wchar_t)std::towlower(c);
+    auto found = vars.find(key);
+    if (found == vars.end()) return false;
+    value = found->second;
+    return true;
+}
+
+bool EmptyEnvironment(const std::wstring&, std::wstring&) {
+    return false;
+}
+
+bool Parse(const std::string& data, ShellLinkInfo& info) {
+    return ShellLink::Parse((const uint8_t*)data.data(), data.size(), info);
+}
+
+uint32_t GetU32(const std::string& data, size_t pos) {
+    uint32_t v = 0;
+    memcpy(&v, data.data() + pos, 4);
+    return v;
+}
+
+void PutU32(std::string& data, size_t pos, uint32_t v) {
+    for (int i = 0; i < 4; i++) data[pos + i] = (char)(v >> (8 * i));
+}
+
+struct Expected {
+    const char* file;
+    std::wstring targetPath;
+    std::wstring description;
+    std::wstring relativePath;
+    std::wstring workingDir;
+    std::wstring arguments;
+    std::wstring iconLocation;
+    std::wstring iconEnvironment;
+    int iconIndex;
+};
+
+void CheckFixtures(const std::wstring& dir, std::map<std::string, std::string>& files) {
+    const std::wstring envIcon = L"%USERPROFILE%\\AppData\\Local\\Temp\\WebWrap\\example.ico";
+    const Expected expected[] = {
+        { "local_path.lnk", kExe, L"WebWrap 0123456789abcdef", L"", L"C:\\Program Files\\WebWrap", kArgs, kIcon, L"", 0 },
+        { "relative_path.lnk", L"", L"Notes", L"..\\Tools\\notes.exe", L"C:\\Tools", L"--new", L"notes.exe", L"", 2 },
+        { "env_icon.lnk", L"%ProgramFiles%\\WebWrap\\WebWrap.exe", L"WebWrap 0123456789abcdef", L"", L"", kArgs,
+            envIcon, envIcon, 0 },
+        { "env_icon_only.lnk", L"", L"WebWrap fedcba9876543210", L"", L"", L"--target \"https://mail.example.com/\"",
+            L"%LOCALAPPDATA%\\WebWrap\\mail.ico", L"%LOCALAPPDATA%\\WebWrap\\mail.ico", 0 },
+        { "unicode_path.lnk", Utf8::ToWide("C:\\Apps\\Caf\xC3\xA9 \xF0\x9F\x98\x80.exe"),
+            Utf8::ToWide("Caf\xC3\xA9 \xF0\x9F\x98\x80"), L"", L"", L"", L"", L"", 0 },
+    };
+
+    for (const Expected& e : expected) {
+        std::string name = e.file;
+        std::string& data = files[name];
+        ShellLinkInfo info;
+        if (!FileUtil::Read(FileUtil::Join(dir, Utf8::ToWide(e.file)), data) || !Parse(data, info)) {
+            Check(false, "parse " + name);
+            continue;
+        }
+        Check(info.targetPath == e.targetPath, name + " target path");
+        Check(info.description == e.description, name + " description");
+        Check(info.relativePath == e.relativePath, name + " relative path");
+        Check(info.workingDir == e.workingDir, name + " working dir");
+        Check(info.arguments == e.arguments, name + " arguments");
+        Check(info.iconLocation == e.iconLocation, name + " icon location");
+        Check(info.iconEnvironment == e.iconEnvironment, name + " icon environment");
+        Check(info.iconIndex == e.iconIndex, name + " icon index");
+    }
+}
+
+// Every prefix must parse without overreading; one that parses can only be
+// missing ExtraData, never carry a partial string
+void CheckTruncation(const std::map<std::string, std::string>& files) {
+    for (const auto& file : files) {
+        ShellLinkInfo full;
+        if (!Parse(file.second, full)) continue;
+        for (size_t len = 0; len < file.second.size(); len++) {
+            std::string prefix = file.second.substr(0, len);
+            ShellLinkInfo info;
+            if (!Parse(prefix, info)) continue;
+            bool whole = len >= 0x4C && info.description == full.description &&
+                info.relativePath == full.relativePath && info.workingDir == full.workingDir &&
+                info.arguments == full.arguments && info.targetPath.size() <= full.targetPath.size();
+            Check(whole, file.first + " truncated to " + std::to_string(len));
+        }
+    }
+}
+
+// Offset of the first ExtraData block with the given signature
+size_t FindBlock(const std::string& data, uint32_t signature) {
+    for (size_t i = 0x4C; i + 8 <= data.size(); i++) {
+        if (GetU32(data, i + 4) == signature && GetU32(data, i) == 0x314) return i;
+    }
+    return std::string::npos;
+}
+
+void CheckCorruption(const std::map<std::string, std::string>& files) {
+    const std::string& local = files.at("local_path.lnk");
+    const std::string& env = files.at("env_icon.lnk");
+    ShellLinkInfo info;
+    std::string bad;
+
+    bad = local;
+    bad[4] ^= 0x01;
+    Check(!Parse(bad, info), "bad CLSID rejected");
+
+    bad = local;
+    PutU32(bad, 0, 0x4D);
+    Check(!Parse(bad, info), "bad header size rejected");
+
+    // LinkInfo follows the IDList, whose size is the first field after the header
+    size_t linkInfo = 0x4C + 2 + (uint8_t)local[0x4C] + ((uint8_t)local[0x4D] << 8);
+    bad = local;
+    PutU32(bad, linkInfo, 0xFFFFFFFF);
+    Check(!Parse(bad, info), "huge LinkInfo size rejected");
+    bad = local;
+    PutU32(bad, linkInfo, 4);
+    Check(!Parse(bad, info), "LinkInfo size below its header rejected");
+
+    bad = local;
+    PutU32(bad, linkInfo + 16, 0xFFFF);  // LocalBasePathOffset
+    Check(Parse(bad, info) && info.targetPath.empty() && info.arguments == kArgs,
+        "out-of-range local path offset ignored");
+
+    bad = local;
+    bad[0x4C] = (char)0xFF;
+    bad[0x4D] = (char)0xFF;
+    Check(!Parse(bad, info), "IDList past the end rejected");
+
+    // First StringData count: description, right after LinkInfo
+    size_t strings = linkInfo + GetU32(local, linkInfo);
+    bad = local;
+    bad[strings] = (char)0xFF;
+    bad[strings + 1] = (char)0xFF;
+    Check(!Parse(bad, info), "string count past the end rejected");
+
+    size_t block = FindBlock(env, 0xA0000001);
+    Check(block != std::string::npos, "env_icon.lnk has an environment block");
+    if (block != std::string::npos) {
+        bad = env;
+        PutU32(bad, block, 0x7FFFFFFF);
+        Check(Parse(bad, info) && info.targetPath.empty() && info.iconEnvironment.empty() &&
+            info.arguments == kArgs, "oversized extra block ignored");
+        bad = env;
+        PutU32(bad, block, 0x20);
+        Check(Parse(bad, info) && info.targetPath.empty() && info.arguments == kArgs,
+            "short environment block not read");
+    }
+
+    // Random damage: anything goes as long as nothing is read out of bounds
+    uint32_t seed = 12345;
+    for (const auto& file : files) {
+        for (int i = 0; i < 2000; i++) {
+            bad = file.second;
+            for (int flips = 0; flips < 4; flips++) {
+                seed = seed * 1664525 + 1013904223;
+                bad[(seed >> 8) % bad.size()] = (char)(seed >> 24);
+            }
+            Parse(bad, info);
+        }
+    }
+}
+
+void CheckExpansion() {
+    ShortcutSync::EnvLookup env = FakeEnvironment;
+    Check(ShortcutSync::ExpandEnvironment(L"%USERPROFILE%\\x", env) == L"C:\\Users\\me\\x", "expand variable");
+    Check(ShortcutSync::ExpandEnvironment(L"%userprofile%%ProgramFiles%", env) == L"C:\\Users\\meC:\\Program Files",
+        "expand adjacent variables");
+    Check(ShortcutSync::ExpandEnvironment(L"%NOPE%\\x", env) == L"%NOPE%\\x", "unknown variable kept");
+    Check(ShortcutSync::ExpandEnvironment(L"50%%USERPROFILE%", env) == L"50%C:\\Users\\me", "stray percent kept");
+    Check(ShortcutSync::ExpandEnvironment(L"100%", env) == L"100%", "unterminated name kept");
+    Check(ShortcutSync::ExpandEnvironment(L"", env).empty(), "empty text");
+}
+
+ShortcutSpec MakeSpec(const std::wstring& name) {
+    ShortcutSpec spec;
+    spec.name = name;
+    spec.arguments = kArgs;
+    spec.iconLocation = kIcon;
+    spec.iconHash = kHash;
+    return spec;
+}
+
+// Action planned for a single existing link against a single spec
+SyncAction PlanOne(const ShortcutSpec& spec, const ShellLinkInfo& link,
+    const ShortcutSync::EnvLookup& env = FakeEnvironment) {
+    std::vector<ExistingShortcut> existing(1);
+    existing[0].name = L"Example";
+    existing[0].link = link;
+    std::vector<SyncStep> steps = ShortcutSync::Plan({ spec }, existing, kExe, env);
+    return steps.size() == 1 ? steps[0].action : SyncAction::Create;
+}
+
+void CheckPlan(const std::map<std::string, std::string>& files) {
+    ShellLinkInfo local, envIcon, envIconOnly, relative;
+    Parse(files.at("local_path.lnk"), local);
+    Parse(files.at("env_icon.lnk"), envIcon);
+    Parse(files.at("env_icon_only.lnk"), envIconOnly);
+    Parse(files.at("relative_path.lnk"), relative);
+
+    ShortcutSpec spec = MakeSpec(L"Example");
+    Check(PlanOne(spec, local) == SyncAction::Keep, "unchanged link kept");
+    Check(PlanOne(spec, envIcon) == SyncAction::Keep, "link with %USERPROFILE% icon kept");
+    Check(PlanOne(spec, envIcon, EmptyEnvironment) == SyncAction::Update,
+        "link with unresolvable icon variable updated");
+
+    ShellLinkInfo blockOnly = envIcon;
+    blockOnly.iconLocation = L"C:\\Stale\\other.ico";
+    Check(PlanOne(spec, blockOnly) == SyncAction::Keep, "icon block preferred over icon location");
+
+    ShellLinkInfo upper = local;
+    upper.iconLocation = L"C:\\USERS\\ME\\APPDATA\\LOCAL\\TEMP\\WEBWRAP\\EXAMPLE.ICO";
+    upper.targetPath = L"c:\\program files\\webwrap\\webwrap.exe";
+    Check(PlanOne(spec, upper) == SyncAction::Keep, "paths compared case-insensitively");
+
+    ShortcutSpec changed = spec;
+    changed.arguments += L" --profile \"work\"";
+    Check(PlanOne(changed, local) == SyncAction::Update, "changed arguments updated");
+    changed = spec;
+    changed.iconLocation = L"C:\\Users\\me\\AppData\\Local\\Temp\\WebWrap\\example-2.ico";
+    Check(PlanOne(changed, envIcon) == SyncAction::Update, "changed icon updated");
+    changed = spec;
+    changed.iconHash = L"fedcba9876543210";
+    Check(PlanOne(changed, local) == SyncAction::Update, "changed icon contents updated");
+    ShellLinkInfo moved = local;
+    moved.targetPath = L"D:\\Old\\WebWrap.exe";
+    Check(PlanOne(spec, moved) == SyncAction::Update, "link to another executable updated");
+
+    // A whole folder: new, renamed-case, removed (ours and not ours)
+    std::vector<ExistingShortcut> existing(5);
+    existing[0].name = L"EXAMPLE";
+    existing[0].link = envIcon;
+    existing[1].name = L"Mail";            // Stamped, no longer in the manifest
+    existing[1].link = envIconOnly;
+    existing[2].name = L"Notes";           // Someone else's shortcut
+    existing[2].link = relative;
+    existing[3].name = L"Unstamped";       // Ours by target (%ProgramFiles%), not by stamp
+    existing[3].link = envIcon;
+    existing[3].link.description = L"Old shortcut";
+    existing[4].name = L"Foreign";
+    existing[4].link = local;
+    existing[4].link.description.clear();
+    existing[4].link.targetPath = L"C:\\Windows\\notepad.exe";
+
+    std::vector<ShortcutSpec> desired = { spec, MakeSpec(L"Docs") };
+    std::vector<SyncStep> steps = ShortcutSync::Plan(desired, existing, kExe, FakeEnvironment);
+    std::map<std::wstring, SyncAction> actions;
+    for (const SyncStep& step : steps) actions[step.name] = step.action;
+    Check(steps.size() == 4, "folder plan step count");
+    Check(actions.count(L"Example") && actions[L"Example"] == SyncAction::Keep, "folder: existing link kept");
+    Check(actions.count(L"Docs") && actions[L"Docs"] == SyncAction::Create, "folder: new app created");
+    Check(actions.count(L"Mail") && actions[L"Mail"] == SyncAction::Delete, "folder: removed app deleted");
+    Check(actions.count(L"Unstamped") && actions[L"Unstamped"] == SyncAction::Delete,
+        "folder: link to our executable deleted");
+    Check(!actions.count(L"Notes") && !actions.count(L"Foreign"), "folder: other shortcuts left alone");
+}
+
+// Parse and plan times for a folder of n shortcuts, all unchanged
+void Measure(const std::map<std::string, std::string>& files, int n) {
+    const std::string& data = files.at("env_icon.lnk");
+    std::vector<ExistingShortcut> existing(n);
+    std::vector<ShortcutSpec> desired;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; i++) {
+        existing[i].name = L"App " + std::to_wstring(i);
+        Parse(data, existing[i].link);
+    }
+    double parseMs = MillisecondsSince(start);
+    for (int i = 0; i < n; i++) desired.push_back(MakeSpec(L"App " + std::to_wstring(i)));
+
+    start = Clock::now();
+    std::vector<SyncStep> steps = ShortcutSync::Plan(desired, existing, kExe, FakeEnvironment);
+    double planMs = MillisecondsSince(start);
+    size_t kept = std::count_if(steps.begin(), steps.end(),
+        [](const SyncStep& s) { return s.action == SyncAction::Keep; });
+    Check(kept == (size_t)n, "all " + std::to_string(n) + " unchanged shortcuts kept");
+    std::printf("%6d shortcuts  parse %8.3f ms  plan %8.3f ms  kept %zu\n", n, parseMs, planMs, kept);
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::wstring dir = L"bench/lnk";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lnk" && i + 1 < argc) {
+            dir = Utf8::ToWide(argv[++i]);
+        } else {
+            std::printf("Usage: shortcutbench [--lnk <dir>]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::map<std::string, std::string> files;
+    CheckFixtures(dir, files);
+    if (g_failures) {
+        std::fprintf(stderr, "Error: cannot use the fixtures in %s\n", Utf8::FromWide(dir).c_str());
+        return 1;
+    }
+    CheckTruncation(files);
+    CheckCorruption(files);
+    CheckExpansion();
+    CheckPlan(files);
+    for (int n : { 100, 1000, 10000 }) Measure(files, n);
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,457 @@
+// Launch snapshot benchmark: times the snapshot codec against PNG
+// (PngEncoder/PngDecoder) on synthetic page captures, the separable box
+// blur against a direct 2D box filter, preparing a capture for storage
+// and the launch-side load (read, inflate, decode, tint). Checks that the
+// codec round trips exactly and rejects damaged input, that the blur
+// matches a float reference, that stored snapshots stay small and that
+// the folder is trimmed to its budget, newest first.
+//
+// Linux only (temp folders); see README.md ("Launch Snapshots") for build
+// and usage.
+
+#include "../FileUtil.h"
+#include "../ImageBlur.h"
+#include "../PngDecoder.h"
+#include "../PngEncoder.h"
+#include "../SnapshotCodec.h"
+#include "../SnapshotStore.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <utime.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> bgra;
+};
+
+uint32_t g_seed = 12345;
+
+uint32_t Random() {
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return g_seed >> 8;
+}
+
+void FillRect(Image& img, uint32_t x0, uint32_t y0, uint32_t w, uint32_t h, uint8_t r, uint8_t g, uint8_t b) {
+    for (uint32_t y = y0; y < std::min(img.height, y0 + h); y++) {
+        for (uint32_t x = x0; x < std::min(img.width, x0 + w); x++) {
+            uint8_t* p = &img.bgra[((size_t)y * img.width + x) * 4];
+            p[0] = b;
+            p[1] = g;
+            p[2] = r;
+            p[3] = 255;
+        }
+    }
+}
+
+// A web app at scale (1.0 = 1920x1080): header bar, sidebar, lines of
+// text made of glyph-sized marks, buttons and a photo with noise
+Image MakePage(uint32_t width, uint32_t height) {
+    Image img;
+    img.width = width;
+    img.height = height;
+    img.bgra.assign((size_t)width * height * 4, 255);
+    const double s = width / 1920.0;
+    auto px = [s](double v) { return (uint32_t)(v * s + 0.5); };
+
+    FillRect(img, 0, 0, width, px(64), 26, 115, 232);
+    FillRect(img, 0, px(64), px(280), height, 241, 243, 244);
+    for (int i = 0; i < 12; i++) {
+        FillRect(img, px(24), px(96 + i * 40), px(160 + (Random() % 80)), px(12), 95, 99, 104);
+    }
+
+    // Paragraphs of "words"
+    uint32_t glyph = std::max<uint32_t>(1, px(9));
+    for (uint32_t y = px(110); y + px(20) < px(700); y += px(26)) {
+        uint32_t x = px(320);
+        while (x < px(1200)) {
+            uint32_t letters = 2 + Random() % 8;
+            for (uint32_t k = 0; k < letters; k++) {
+                for (uint32_t gy = 0; gy < px(14); gy++) {
+                    for (uint32_t gx = 0; gx < glyph; gx++) {
+                        if (Random() % 3 == 0) FillRect(img, x + gx, y + gy, 1, 1, 32, 33, 36);
+                    }
+                }
+                x += glyph + 1;
+            }
+            x += glyph;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        FillRect(img, px(320 + i * 150), px(740), px(130), px(40), 232, 240, 254);
+    }
+
+    // Photo: smooth gradient plus sensor noise
+    for (uint32_t y = px(110); y < std::min(height, px(1040)); y++) {
+        for (uint32_t x = px(1280); x < std::min(width, px(1880)); x++) {
+            uint8_t* p = &img.bgra[((size_t)y * width + x) * 4];
+            int n = (int)(Random() % 9) - 4;
+            p[0] = (uint8_t)std::min(255, std::max(0, (int)(x * 255 / width) + n));
+            p[1] = (uint8_t)std::min(255, std::max(0, (int)(y * 200 / height) + n));
+            p[2] = (uint8_t)std::min(255, std::max(0, 120 + n));
+        }
+    }
+    return img;
+}
+
+Image MakeNoise(uint32_t width, uint32_t height) {
+    Image img;
+    img.width = width;
+    img.height = height;
+    img.bgra.resize((size_t)width * height * 4);
+    for (size_t i = 0; i < img.bgra.size(); i++) {
+        img.bgra[i] = (i % 4 == 3) ? 255 : (uint8_t)Random();
+    }
+    return img;
+}
+
+bool RoundTrips(const Image& img) {
+    std::vector<uint8_t> encoded;
+    SnapshotCodec::Encode(img.bgra.data(), img.width, img.height, (size_t)img.width * 4, encoded);
+    SnapshotImage decoded;
+    return SnapshotCodec::Decode(encoded.data(), encoded.size(), decoded) && decoded.width == img.width &&
+        decoded.height == img.height && decoded.bgra == img.bgra;
+}
+
+// Three box passes computed directly: every output pixel sums its whole
+// (2r+1) x (2r+1) window, in floating point, edges clamped
+void ReferenceBlur(Image& img, uint32_t radius, int passes) {
+    const int w = (int)img.width, h = (int)img.height, r = (int)radius;
+    std::vector<float> cur(img.bgra.begin(), img.bgra.end()), next(cur.size());
+    const float norm = 1.0f / ((2 * r + 1) * (2 * r + 1));
+    for (int pass = 0; pass < passes; pass++) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                for (int c = 0; c < 4; c++) {
+                    float sum = 0;
+                    for (int dy = -r; dy <= r; dy++) {
+                        int yy = std::min(h - 1, std::max(0, y + dy));
+                        for (int dx = -r; dx <= r; dx++) {
+                            int xx = std::min(w - 1, std::max(0, x + dx));
+                            sum += cur[((size_t)yy * w + xx) * 4 + c];
+                        }
+                    }
+                    next[((size_t)y * w + x) * 4 + c] = sum * norm;
+                }
+            }
+        }
+        cur.swap(next);
+    }
+    for (size_t i = 0; i < cur.size(); i++) {
+        img.bgra[i] = (uint8_t)std::min(255.0f, std::max(0.0f, std::floor(cur[i] + 0.5f)));
+    }
+}
+
+int MaxDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    int worst = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        worst = std::max(worst, std::abs((int)a[i] - (int)b[i]));
+    }
+    return worst;
+}
+
+void RemoveTree(const std::wstring& dir) {
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(dir, entries);
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        if (e.isDirectory) RemoveTree(path);
+        else FileUtil::Remove(path);
+    }
+    rmdir(Utf8::FromWide(dir).c_str());
+}
+
+uint64_t FolderBytes(const std::wstring& dir, size_t& files) {
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(dir, entries);
+    uint64_t total = 0;
+    files = entries.size();
+    for (const FileUtil::Entry& e : entries) total += e.size;
+    return total;
+}
+
+void SetModified(const std::wstring& path, time_t when) {
+    struct utimbuf times = { when, when };
+    utime(Utf8::FromWide(path).c_str(), &times);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 9;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::printf("Usage: snapshotbench [--iterations N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // Codec: exact round trips, including noise (all literals), single
+    // pixels, long runs and a row stride wider than the pixels
+    Image page = MakePage(1920, 1080);
+    Check(RoundTrips(page), "full page round trips");
+    Check(RoundTrips(MakeNoise(97, 61)), "noise round trips");
+    Check(RoundTrips(MakeNoise(1, 1)), "single pixel round trips");
+    Image flat;
+    flat.width = 1000;
+    flat.height = 3;
+    flat.bgra.assign(flat.width * flat.height * 4, 0);
+    for (size_t i = 3; i < flat.bgra.size(); i += 4) flat.bgra[i] = 255;
+    Check(RoundTrips(flat), "long black runs round trip");
+    {
+        std::vector<uint8_t> padded(64 * 20 + 4 * 3 + 16);
+        for (size_t i = 0; i < padded.size(); i++) padded[i] = (uint8_t)(i % 4 == 3 ? 255 : i * 7);
+        std::vector<uint8_t> encoded;
+        SnapshotCodec::Encode(padded.data(), 3, 20, 64, encoded);
+        SnapshotImage decoded;
+        bool same = SnapshotCodec::Decode(encoded.data(), encoded.size(), decoded);
+        for (uint32_t y = 0; same && y < 20; y++) {
+            same = std::equal(&padded[y * 64], &padded[y * 64 + 12], &decoded.bgra[y * 12]);
+        }
+        Check(same, "strided rows round trip");
+    }
+
+    // Damaged input is rejected, never read past
+    {
+        Image small = MakePage(160, 90);
+        std::vector<uint8_t> encoded;
+        SnapshotCodec::Encode(small.bgra.data(), small.width, small.height, (size_t)small.width * 4, encoded);
+        bool allRejected = true;
+        for (size_t len = 0; len < encoded.size(); len++) {
+            std::vector<uint8_t> cut(encoded.begin(), encoded.begin() + len);
+            SnapshotImage decoded;
+            allRejected = allRejected && !SnapshotCodec::Decode(cut.data(), cut.size(), decoded);
+        }
+        Check(allRejected, "every truncation rejected");
+        std::vector<uint8_t> bad = encoded;
+        bad[0] = 'X';
+        SnapshotImage decoded;
+        Check(!SnapshotCodec::Decode(bad.data(), bad.size(), decoded), "bad magic rejected");
+        bad = encoded;
+        bad[7] = 0x7F;  // width in the hundreds of millions
+        Check(!SnapshotCodec::Decode(bad.data(), bad.size(), decoded), "oversized image rejected");
+        bad = encoded;
+        bad[SnapshotCodec::kHeaderBytes] = 0xFF;
+        Check(!SnapshotCodec::Decode(bad.data(), bad.size(), decoded), "reserved op rejected");
+    }
+
+    // Blur: matches the direct filter, keeps flat images flat, survives a
+    // radius larger than the image
+    {
+        Image a = MakePage(120, 70);
+        Image b = a;
+        ImageBlur::Box(a.bgra.data(), a.width, a.height, (size_t)a.width * 4, 3);
+        ReferenceBlur(b, 3, 3);
+        Check(MaxDifference(a.bgra, b.bgra) <= 2, "blur matches reference");
+
+        Image c = MakeNoise(7, 5);
+        Image d = c;
+        ImageBlur::Box(c.bgra.data(), c.width, c.height, (size_t)c.width * 4, 9, 1);
+        ReferenceBlur(d, 9, 1);
+        Check(MaxDifference(c.bgra, d.bgra) <= 1, "radius larger than image");
+
+        Image e = flat;
+        FillRect(e, 0, 0, e.width, e.height, 200, 100, 50);
+        std::vector<uint8_t> before = e.bgra;
+        ImageBlur::Box(e.bgra.data(), e.width, e.height, (size_t)e.width * 4, 5);
+        Check(e.bgra == before, "flat image unchanged");
+
+        ImageBlur::Tint(e.bgra.data(), e.width, e.height, (size_t)e.width * 4, 0, 0, 0, 0);
+        Check(e.bgra == before, "tint by 0 unchanged");
+        ImageBlur::Tint(e.bgra.data(), e.width, e.height, (size_t)e.width * 4, 10, 20, 30, 256);
+        Check(e.bgra[0] == 30 && e.bgra[1] == 20 && e.bgra[2] == 10 && e.bgra[3] == 255, "full tint gives the color");
+    }
+
+    // Timings on two capture sizes (1x and 1.33x DPI), and on the
+    // prepared snapshot that is actually stored and decoded at launch
+    std::printf("%-22s %10s %10s %10s %10s %10s\n", "image", "bytes", "encode", "decode", "png bytes", "png dec");
+    struct Case {
+        const char* name;
+        Image img;
+    };
+    std::vector<Case> cases;
+    cases.push_back({ "page 1920x1080", page });
+    cases.push_back({ "page 2560x1440", MakePage(2560, 1440) });
+    SnapshotImage prepared;
+    SnapshotStore::Prepare(page.bgra.data(), page.width, page.height, (size_t)page.width * 4, prepared);
+    Image preparedImg;
+    preparedImg.width = prepared.width;
+    preparedImg.height = prepared.height;
+    preparedImg.bgra = prepared.bgra;
+    char preparedName[32];
+    std::snprintf(preparedName, sizeof(preparedName), "snapshot %ux%u", prepared.width, prepared.height);
+    cases.push_back({ preparedName, preparedImg });
+    Check(std::max(prepared.width, prepared.height) == SnapshotStore::kMaxSide, "prepared to fit kMaxSide");
+    Check(RoundTrips(preparedImg), "prepared snapshot round trips");
+
+    size_t snapshotBytes = 0;
+    for (Case& c : cases) {
+        std::vector<double> encMs, decMs, pngDecMs;
+        std::vector<uint8_t> encoded, png;
+        SnapshotImage decoded;
+        for (int r = 0; r < iterations; r++) {
+            Clock::time_point start = Clock::now();
+            SnapshotCodec::Encode(c.img.bgra.data(), c.img.width, c.img.height, (size_t)c.img.width * 4, encoded);
+            encMs.push_back(MillisecondsSince(start));
+            start = Clock::now();
+            SnapshotCodec::Decode(encoded.data(), encoded.size(), decoded);
+            decMs.push_back(MillisecondsSince(start));
+        }
+        PngEncoder::Encode(c.img.bgra.data(), c.img.width, c.img.height, (size_t)c.img.width * 4,
+            PngEncoder::Layout::BGRA, 6, png);
+        PngImage pngDecoded;
+        for (int r = 0; r < iterations; r++) {
+            Clock::time_point start = Clock::now();
+            PngDecoder::Decode(png.data(), png.size(), pngDecoded);
+            pngDecMs.push_back(MillisecondsSince(start));
+        }
+        std::printf("%-22s %10zu %7.2f ms %7.2f ms %10zu %7.2f ms\n", c.name, encoded.size(), Median(encMs),
+            Median(decMs), png.size(), Median(pngDecMs));
+        Check(Median(decMs) < Median(pngDecMs), (std::string("decodes faster than png: ") + c.name).c_str());
+        snapshotBytes = encoded.size();
+    }
+    Check(snapshotBytes < 64 * 1024, "stored snapshot under 64 KB");
+
+    // Blur cost: separable running sums against the direct window, at the
+    // stored size (direct filter only once, it is slow)
+    {
+        std::vector<double> boxMs;
+        for (int r = 0; r < iterations; r++) {
+            Image work = preparedImg;
+            Clock::time_point start = Clock::now();
+            ImageBlur::Box(work.bgra.data(), work.width, work.height, (size_t)work.width * 4,
+                SnapshotStore::kBlurRadius);
+            boxMs.push_back(MillisecondsSince(start));
+        }
+        Image work = preparedImg;
+        Clock::time_point start = Clock::now();
+        ReferenceBlur(work, SnapshotStore::kBlurRadius, 3);
+        double directMs = MillisecondsSince(start);
+        std::printf("blur r=%u x3 at %ux%u: separable %.2f ms, direct %.2f ms\n", SnapshotStore::kBlurRadius,
+            work.width, work.height, Median(boxMs), directMs);
+        Check(Median(boxMs) < directMs, "separable blur faster than direct");
+
+        std::vector<double> bigMs;
+        for (int r = 0; r < iterations; r++) {
+            Image big = page;
+            start = Clock::now();
+            ImageBlur::Box(big.bgra.data(), big.width, big.height, (size_t)big.width * 4, 16);
+            bigMs.push_back(MillisecondsSince(start));
+        }
+        std::printf("blur r=16 x3 at 1920x1080: %.2f ms\n", Median(bigMs));
+    }
+
+    // Preparing captures (box reduce, resample, blur)
+    for (size_t i = 0; i < 2; i++) {
+        std::vector<double> ms;
+        for (int r = 0; r < iterations; r++) {
+            SnapshotImage out;
+            Clock::time_point start = Clock::now();
+            SnapshotStore::Prepare(cases[i].img.bgra.data(), cases[i].img.width, cases[i].img.height,
+                (size_t)cases[i].img.width * 4, out);
+            ms.push_back(MillisecondsSince(start));
+        }
+        std::printf("prepare %s: %.2f ms\n", cases[i].name, Median(ms));
+    }
+
+    char dirTemplate[] = "/tmp/snapshotbench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        std::fprintf(stderr, "cannot create temp directory\n");
+        return 1;
+    }
+    std::wstring root = Utf8::ToWide(dirTemplate);
+
+    // Store: save and load, per key; what the window does at launch
+    size_t bytes = 0;
+    Check(SnapshotStore::Save(root, L"Mail\nhttps://mail.example.com/", page.bgra.data(), page.width, page.height,
+        (size_t)page.width * 4, &bytes), "snapshot saved");
+    std::printf("stored snapshot: %zu bytes (codec %zu, zlib level 1)\n", bytes, snapshotBytes);
+    Check(bytes < snapshotBytes && bytes < 32 * 1024, "stored snapshot under 32 KB");
+    SnapshotImage loaded;
+    std::vector<double> loadMs;
+    for (int r = 0; r < iterations; r++) {
+        Clock::time_point start = Clock::now();
+        bool ok = SnapshotStore::Load(root, L"Mail\nhttps://mail.example.com/", loaded);
+        if (ok) {
+            ImageBlur::Tint(loaded.bgra.data(), loaded.width, loaded.height, (size_t)loaded.width * 4,
+                26, 115, 232, 96);
+        }
+        loadMs.push_back(MillisecondsSince(start));
+        Check(ok, "snapshot loaded");
+    }
+    std::printf("launch: read + inflate + decode + tint %.2f ms\n", Median(loadMs));
+    Check(loaded.width == prepared.width && loaded.height == prepared.height, "loaded snapshot size");
+    Check(!SnapshotStore::Load(root, L"Other\nhttps://other.example.com/", loaded), "no snapshot for another app");
+    std::wstring damaged = SnapshotStore::PathFor(root, L"Broken\nhttps://broken.example.com/");
+    FileUtil::Write(damaged, "WWSN\x10\0\0\0\x10\0\0\0", 12);
+    Check(!SnapshotStore::Load(root, L"Broken\nhttps://broken.example.com/", loaded), "damaged snapshot rejected");
+    std::string stored;
+    FileUtil::Read(SnapshotStore::PathFor(root, L"Mail\nhttps://mail.example.com/"), stored);
+    stored[stored.size() / 2] ^= 0x10;
+    FileUtil::Write(damaged, stored.data(), stored.size());
+    Check(!SnapshotStore::Load(root, L"Broken\nhttps://broken.example.com/", loaded), "flipped bit rejected");
+    FileUtil::Remove(damaged);
+
+    // Budget: many apps, oldest evicted first
+    Image small = MakePage(640, 360);
+    std::vector<std::wstring> paths;
+    const time_t base = 1700000000;
+    for (int i = 0; i < 200; i++) {
+        std::wstring key = L"App " + std::to_wstring(i) + L"\nhttps://app" + std::to_wstring(i) + L".example.com/";
+        small.bgra[0] = (uint8_t)i;
+        std::wstring path = SnapshotStore::PathFor(root, key);
+        // Save trims; the earlier files get older times so the order is defined
+        for (size_t k = 0; k < paths.size(); k++) SetModified(paths[k], base + (time_t)k);
+        SnapshotStore::Save(root, key, small.bgra.data(), small.width, small.height, (size_t)small.width * 4);
+        paths.push_back(path);
+    }
+    size_t files = 0;
+    uint64_t total = FolderBytes(root, files);
+    std::printf("folder after 200 apps: %zu snapshots, %llu bytes (budget %llu)\n", files,
+        (unsigned long long)total, (unsigned long long)SnapshotStore::kBudgetBytes);
+    Check(total <= SnapshotStore::kBudgetBytes, "folder within budget");
+    Check(FileUtil::Exists(paths.back()) && FileUtil::Exists(paths[paths.size() - 2]), "newest kept");
+    Check(!FileUtil::Exists(paths.front()), "oldest evicted");
+    Check(files > 10, "budget holds many apps");
+
+    RemoveTree(root);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
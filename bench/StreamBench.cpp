@@ -0,0 +1,381 @@
+// Streaming downscale benchmark: checks PngRowReader against the full
+// decoder (corpus images, split IDAT chunks, byte-sized reads, corrupt
+// data) and BoxReducer against a plain box average, and that both paths
+// size trimmed icons from the content. Then it converts
+// 2048-8192 px PNGs with the full decode and with the streaming path in
+// child processes, reporting time and peak resident memory for each and
+// comparing the rendered icons.
+//
+// Linux only (measures children with fork/exec and wait4); see README.md
+// ("Large Source Images") for build and usage.
+
+#include "../Checksums.h"
+#include "../FileUtil.h"
+#include "../IconPipeline.h"
+#include "../ImageMetrics.h"
+#include "../ImageResample.h"
+#include "../PngDecoder.h"
+#include "../PngEncoder.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Serves a byte buffer in reads of at most chunk bytes
+PngRowReader::Source MemorySource(const std::vector<uint8_t>& data, size_t chunk) {
+    size_t pos = 0;
+    return [&data, chunk, pos](uint8_t* buffer, size_t capacity) mutable {
+        size_t n = std::min(std::min(capacity, chunk), data.size() - pos);
+        memcpy(buffer, data.data() + pos, n);
+        pos += n;
+        return n;
+    };
+}
+
+bool StreamDecode(const std::vector<uint8_t>& png, size_t chunk, PngImage& image) {
+    PngRowReader reader(MemorySource(png, chunk));
+    if (!reader.Open()) return false;
+    image.width = reader.Info().width;
+    image.height = reader.Info().height;
+    image.bgra.assign((size_t)image.width * image.height * 4, 0);
+    for (uint32_t y = 0; y < image.height; y++) {
+        if (!reader.ReadRow(&image.bgra[(size_t)y * image.width * 4])) return false;
+    }
+    return reader.Finish();
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+// Rewrites png with its image data spread over IDAT chunks of at most
+// piece bytes, as some encoders do
+std::vector<uint8_t> SplitIdat(const std::vector<uint8_t>& png, size_t piece) {
+    std::vector<uint8_t> out(png.begin(), png.begin() + 8), data;
+    size_t pos = 8;
+    bool written = false;
+    while (pos + 12 <= png.size()) {
+        uint32_t len = ((uint32_t)png[pos] << 24) | ((uint32_t)png[pos + 1] << 16) |
+            ((uint32_t)png[pos + 2] << 8) | png[pos + 3];
+        const uint8_t* type = &png[pos + 4];
+        if (memcmp(type, "IDAT", 4) == 0) {
+            data.insert(data.end(), type + 4, type + 4 + len);
+        } else {
+            if (!data.empty() && !written) {
+                for (size_t i = 0; i < data.size(); i += piece) {
+                    size_t n = std::min(piece, data.size() - i);
+                    uint8_t head[8];
+                    PutU32(head, (uint32_t)n);
+                    memcpy(head + 4, "IDAT", 4);
+                    out.insert(out.end(), head, head + 8);
+                    out.insert(out.end(), data.begin() + i, data.begin() + i + n);
+                    uint32_t crc = Checksums::Crc32(Checksums::Crc32(0, head + 4, 4), &data[i], n);
+                    PutU32(head, crc);
+                    out.insert(out.end(), head, head + 4);
+                }
+                written = true;
+            }
+            out.insert(out.end(), png.begin() + pos, png.begin() + pos + 12 + len);
+        }
+        pos += 12 + len;
+    }
+    return out;
+}
+
+// A logo on a transparent canvas: soft-edged disc with a gradient and a
+// checker a few icon pixels wide, so both the alpha edge and detail near
+// the icon's resolution are exercised
+std::vector<uint8_t> MakeLogo(uint32_t width, uint32_t height) {
+    std::vector<uint8_t> rgba((size_t)width * height * 4);
+    uint32_t cell = std::max(width, height) / 96 + 1;
+    float cx = width * 0.5f, cy = height * 0.5f, r = std::min(width, height) * 0.3f;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t* p = &rgba[(size_t)y * width * 4];
+        for (uint32_t x = 0; x < width; x++, p += 4) {
+            float d = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+            float a = std::max(0.0f, std::min(1.0f, (r - d) / (r * 0.02f)));
+            p[0] = (uint8_t)(40 + 200 * x / width);
+            p[1] = (uint8_t)(((x / cell + y / cell) & 1) ? 90 : 140);
+            p[2] = (uint8_t)(220 - 180 * y / height);
+            p[3] = (uint8_t)(a * 255.0f + 0.5f);
+        }
+    }
+    return rgba;
+}
+
+void CheckRowReader() {
+    int checked = 0;
+    std::vector<FileUtil::Entry> entries;
+    FileUtil::List(L"bench/corpus", entries);
+    for (const FileUtil::Entry& e : entries) {
+        std::string data;
+        if (!FileUtil::Read(FileUtil::Join(L"bench/corpus", e.name), data)) continue;
+        std::vector<uint8_t> png(data.begin(), data.end());
+        PngInfo info;
+        PngImage full, streamed, split;
+        if (!PngDecoder::Probe(png.data(), png.size(), info) || !PngDecoder::Decode(png.data(), png.size(), full)) {
+            continue;
+        }
+        if (info.interlaced) {
+            Check(!StreamDecode(png, 65536, streamed), "interlaced images are rejected");
+            continue;
+        }
+        Check(StreamDecode(png, 65536, streamed) && streamed.bgra == full.bgra, "rows match the full decode");
+        Check(StreamDecode(png, 7, streamed) && streamed.bgra == full.bgra, "byte-sized reads match");
+        Check(StreamDecode(SplitIdat(png, 1000), 4096, split) && split.bgra == full.bgra,
+            "split IDAT chunks match");
+        checked++;
+    }
+
+    // Encoder output for both layouts, and corruption is reported
+    std::vector<uint8_t> logo = MakeLogo(301, 187), png;
+    PngEncoder::Encode(logo.data(), 301, 187, 301 * 4, PngEncoder::Layout::RGBA, 6, png);
+    PngImage full, streamed;
+    PngDecoder::Decode(png.data(), png.size(), full);
+    Check(StreamDecode(png, 333, streamed) && streamed.bgra == full.bgra, "encoder output matches");
+    std::vector<uint8_t> corrupt = png;
+    corrupt[corrupt.size() / 2] ^= 0x40;
+    Check(!StreamDecode(corrupt, 4096, streamed), "corrupt data is rejected");
+    Check(!StreamDecode(std::vector<uint8_t>(png.begin(), png.end() - 20), 4096, streamed),
+        "truncated data is rejected");
+    std::printf("rows:     %d corpus images match the full decode\n", checked);
+}
+
+void CheckBoxReducer() {
+    std::mt19937 rng(7);
+    const uint32_t w = 103, h = 58, f = 4;
+    std::vector<uint8_t> bgra((size_t)w * h * 4);
+    for (uint8_t& v : bgra) v = (uint8_t)rng();
+    for (size_t i = 3; i < bgra.size(); i += 16) bgra[i] = 0;  // Some fully transparent pixels
+
+    BoxReducer reducer(w, h, f, f);
+    for (uint32_t y = 0; y < h; y++) reducer.PushRow(&bgra[(size_t)y * w * 4]);
+    Check(reducer.Width() == 26 && reducer.Height() == 15, "reduced size rounds up");
+
+    int worst = 0;
+    for (uint32_t oy = 0; oy < reducer.Height(); oy++) {
+        for (uint32_t ox = 0; ox < reducer.Width(); ox++) {
+            double sum[4] = { 0, 0, 0, 0 };
+            int area = 0;
+            for (uint32_t y = oy * f; y < std::min(h, oy * f + f); y++) {
+                for (uint32_t x = ox * f; x < std::min(w, ox * f + f); x++, area++) {
+                    const uint8_t* p = &bgra[((size_t)y * w + x) * 4];
+                    for (int c = 0; c < 3; c++) sum[c] += p[c] * p[3];
+                    sum[3] += p[3];
+                }
+            }
+            const uint8_t* got = &reducer.Pixels()[((size_t)oy * reducer.Width() + ox) * 4];
+            worst = std::max(worst, std::abs(got[3] - (int)std::lround(sum[3] / area)));
+            for (int c = 0; c < 3 && sum[3] > 0; c++) {
+                worst = std::max(worst, std::abs(got[c] - (int)std::lround(sum[c] / sum[3])));
+            }
+        }
+    }
+    Check(worst <= 1, "box averages match the reference");
+    Check(BoxReducer::Factor(8192, 4096, 1024) == 8 && BoxReducer::Factor(900, 900, 1024) == 1,
+        "box factor keeps the longer side above the minimum");
+}
+
+// A small logo on a large transparent canvas: with trimming, both paths
+// size the icon from the content, not from the canvas
+void CheckTrimmedSize() {
+    const uint32_t canvas = 2048;
+    const uint32_t logos[][2] = { { 100, 60 }, { 40, 40 }, { 900, 12 } };
+    for (const auto& logo : logos) {
+        std::vector<uint8_t> rgba((size_t)canvas * canvas * 4, 0), png;
+        for (uint32_t y = 0; y < logo[1]; y++) {
+            for (uint32_t x = 0; x < logo[0]; x++) {
+                uint8_t* p = &rgba[((size_t)(y + 700) * canvas + x + 900) * 4];
+                p[0] = 200;
+                p[3] = 255;
+            }
+        }
+        PngEncoder::Encode(rgba.data(), canvas, canvas, (size_t)canvas * 4, PngEncoder::Layout::RGBA, 1, png);
+
+        IconPipelineOptions options;
+        options.trim = true;
+        std::vector<uint8_t> ico;
+        IcoImage full, streamed;
+        Check(IconPipeline::PngToIco(png.data(), png.size(), 0, ico, &full, nullptr, options) &&
+            IconPipeline::StreamPngToIco(MemorySource(png, 65536), 0, ico, &streamed, nullptr, options),
+            "trimmed conversions succeed");
+        Check(full.size == streamed.size && full.size < 256, "trimmed icon sized from the content");
+    }
+}
+
+// Child mode: converts one file and prints the elapsed time; the rendered
+// icon goes to out as raw BGRA
+int Convert(bool stream, bool trim, const char* path, const char* out) {
+    Clock::time_point start = Clock::now();
+    IconPipelineOptions options;
+    options.trim = trim;
+    std::vector<uint8_t> ico;
+    IcoImage rendered;
+    bool ok;
+    if (stream) {
+        FILE* file = FileUtil::OpenRead(Utf8::ToWide(path));
+        ok = file && IconPipeline::StreamPngToIco([file](uint8_t* buffer, size_t capacity) {
+            return std::fread(buffer, 1, capacity, file);
+        }, 0, ico, &rendered, nullptr, options);
+        if (file) std::fclose(file);
+    } else {
+        std::string png;
+        ok = FileUtil::Read(Utf8::ToWide(path), png) &&
+            IconPipeline::PngToIco((const uint8_t*)png.data(), png.size(), 0, ico, &rendered, nullptr, options);
+    }
+    if (!ok) return 1;
+    double ms = MillisecondsSince(start);
+    FILE* f = std::fopen(out, "wb");
+    if (!f) return 1;
+    std::fwrite(rendered.bgra.data(), 1, rendered.bgra.size(), f);
+    std::fclose(f);
+    std::printf("%.3f %u\n", ms, rendered.size);
+    return 0;
+}
+
+struct Run {
+    bool ok = false;
+    double ms = 0;
+    long peakKb = 0;
+    uint32_t size = 0;
+};
+
+Run RunChild(const char* self, bool stream, bool trim, const std::string& png, const std::string& out) {
+    Run run;
+    int fds[2];
+    if (pipe(fds) != 0) return run;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl(self, self, "--child", stream ? "stream" : "full", trim ? "trim" : "fit",
+            png.c_str(), out.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    close(fds[1]);
+    char text[128] = {};
+    size_t got = 0;
+    ssize_t n;
+    while (got < sizeof(text) - 1 && (n = read(fds[0], text + got, sizeof(text) - 1 - got)) > 0) got += (size_t)n;
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage = {};
+    if (pid > 0 && wait4(pid, &status, 0, &usage) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        run.ok = std::sscanf(text, "%lf %u", &run.ms, &run.size) == 2;
+        run.peakKb = usage.ru_maxrss;
+    }
+    return run;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 6 && std::string(argv[1]) == "--child") {
+        return Convert(std::string(argv[2]) == "stream", std::string(argv[3]) == "trim", argv[4], argv[5]);
+    }
+
+    uint32_t maxSize = 8192;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max" && i + 1 < argc) {
+            maxSize = (uint32_t)std::atoi(argv[++i]);
+        } else {
+            std::printf("Usage: streambench [--max <pixels>]   (run from the repository root)\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    CheckRowReader();
+    CheckBoxReducer();
+    CheckTrimmedSize();
+
+    char self[4096];
+    ssize_t selfLen = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (selfLen <= 0) {
+        std::fprintf(stderr, "cannot locate own executable\n");
+        return 1;
+    }
+    self[selfLen] = 0;
+
+    std::printf("%-7s %10s %9s %10s %9s %8s %8s\n", "source", "full ms", "full MB",
+        "stream ms", "stream MB", "SSIM", "trimmed");
+    long firstStreamKb = 0, lastStreamKb = 0;
+    for (uint32_t size = 2048; size <= maxSize; size *= 2) {
+        // Encoded at a low level and freed before the children run
+        std::string png = "streambench_" + std::to_string(size) + ".png";
+        {
+            std::vector<uint8_t> logo = MakeLogo(size, size), data;
+            PngEncoder::Encode(logo.data(), size, size, (size_t)size * 4, PngEncoder::Layout::RGBA, 1, data);
+            FileUtil::Write(Utf8::ToWide(png), data.data(), data.size());
+        }
+
+        // Untrimmed, the box pre-pass should be invisible. Trimmed, the
+        // margins are found on the reduced image, so the crop can differ by
+        // up to one box (a quarter of an icon pixel) and SSIM drops a little.
+        double ssim[2] = { 0, 0 };
+        Run full, stream;
+        for (int trim = 0; trim < 2; trim++) {
+            full = RunChild(self, false, trim != 0, png, png + ".full");
+            stream = RunChild(self, true, trim != 0, png, png + ".stream");
+            Check(full.ok && stream.ok, "both conversions succeed");
+            Check(full.size == stream.size, "same icon size");
+
+            std::string a, b;
+            if (FileUtil::Read(Utf8::ToWide(png + ".full"), a) && FileUtil::Read(Utf8::ToWide(png + ".stream"), b) &&
+                a.size() == b.size() && a.size() == (size_t)full.size * full.size * 4) {
+                ssim[trim] = ImageMetrics::Compare((const uint8_t*)a.data(), (const uint8_t*)b.data(),
+                    full.size, full.size).ssim;
+            }
+        }
+        Check(ssim[0] >= 0.995, "streamed icon matches the full decode");
+        Check(ssim[1] >= 0.9, "streamed trimmed icon is close to the full decode");
+        Check(stream.peakKb < full.peakKb, "streaming uses less memory");
+
+        if (!firstStreamKb) firstStreamKb = stream.peakKb;
+        lastStreamKb = stream.peakKb;
+        std::printf("%-7u %10.1f %9.1f %10.1f %9.1f %8.4f %8.4f\n", size, full.ms, full.peakKb / 1024.0,
+            stream.ms, stream.peakKb / 1024.0, ssim[0], ssim[1]);
+
+        std::remove(png.c_str());
+        std::remove((png + ".full").c_str());
+        std::remove((png + ".stream").c_str());
+    }
+
+    // Rows grow linearly with the source while the intermediate stays fixed
+    Check(lastStreamKb < firstStreamKb * 2, "streaming peak memory stays flat as sources grow");
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
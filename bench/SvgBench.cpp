@@ -0,0 +1,227 @@
+// SVG icon benchmark: parses every SVG in bench/svg and renders it with
+// SvgImage at each size IconSource::FromSvg produces (kSvgSizes), timing
+// parse and raster per size. Each render is compared with the matching
+// PNG in bench/reference/svg using SSIM, PSNR and the largest alpha
+// error. Also checks that hostile geometry (huge, overflowing or
+// non-finite coordinates and stroke widths) renders without crashing.
+//
+// Portable; see README.md ("SVG Benchmark") for build and usage.
+
+#include "../FileUtil.h"
+#include "../IconSource.h"
+#include "../ImageMetrics.h"
+#include "../PngDecoder.h"
+#include "../PngEncoder.h"
+#include "../SvgImage.h"
+#include "../Utf8.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::wstring svgDir = L"bench/svg";
+    std::wstring referenceDir = L"bench/reference/svg";
+    int iterations = 5;
+    bool updateReferences = false;
+
+    // Regression thresholds, as in IconBench
+    double minSsim = 0.995;
+    double minPsnr = 40.0;
+    int maxAlphaError = 4;
+};
+
+int g_failures = 0;
+
+void Check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+std::wstring ReferencePath(const Options& opts, const std::wstring& stem, uint32_t size) {
+    return FileUtil::Join(opts.referenceDir, stem + L"_" + std::to_wstring(size) + L".png");
+}
+
+// Compares one render with its reference (writing it first with --update)
+bool CheckReference(const Options& opts, const std::wstring& stem, uint32_t size, const std::vector<uint8_t>& bgra,
+    ImageQuality& quality, std::string& failure) {
+    std::wstring path = ReferencePath(opts, stem, size);
+    if (opts.updateReferences) {
+        std::vector<uint8_t> png;
+        if (!PngEncoder::Encode(bgra.data(), size, size, (size_t)size * 4, PngEncoder::Layout::BGRA, 9, png) ||
+            !FileUtil::Write(path, png.data(), png.size())) {
+            failure = "cannot write reference";
+            return false;
+        }
+    }
+
+    std::string data;
+    PngImage ref;
+    if (!FileUtil::Read(path, data) || !PngDecoder::Decode((const uint8_t*)data.data(), data.size(), ref) ||
+        ref.width != size || ref.height != size) {
+        failure = "missing reference";
+        return false;
+    }
+    quality = ImageMetrics::Compare(bgra.data(), ref.bgra.data(), size, size);
+    if (quality.ssim < opts.minSsim) {
+        failure = "ssim below threshold";
+    } else if (quality.psnr < opts.minPsnr) {
+        failure = "psnr below threshold";
+    } else if (quality.maxAlphaError > opts.maxAlphaError) {
+        failure = "alpha error above threshold";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+// Geometry that used to overflow the rasterizer; each must render to a
+// full-size buffer at the smallest and largest icon size
+void CheckHostileInput() {
+    const char* const documents[] = {
+        "<svg width='100' height='100'><path d='M1e38 138 L-1e38 -1e38 L 5 5 Z' stroke='black' stroke-width='1e38'/></svg>",
+        "<svg width='100' height='100'><path d='M-3e38 -3e38 L3e38 3e38 L3e38 -3e38 Z' fill='red'/></svg>",
+        "<svg width='100' height='100'><path d='M0 0 C1e38 1e38 -1e38 1e38 100 100' stroke='blue' stroke-width='4' "
+            "stroke-linecap='round' stroke-linejoin='round'/></svg>",
+        "<svg width='100' height='100'><circle cx='50' cy='50' r='1e38' stroke='green' stroke-width='3e38'/></svg>",
+        "<svg width='100' height='100'><g transform='scale(1e30)'><rect x='-1e10' y='1' width='1e20' height='2'/></g></svg>",
+        "<svg width='100' height='100'><polyline points='0,0 1e-30,1e38 50,50' fill='none' stroke='black' "
+            "stroke-width='2' stroke-linecap='square'/></svg>",
+    };
+    const uint32_t sizes[] = { 16, 256 };
+    int index = 0;
+    for (const char* text : documents) {
+        std::unique_ptr<SvgImage> svg = SvgImage::Parse(text);
+        std::string label = "hostile document " + std::to_string(index++);
+        if (!svg) {
+            continue;  // Rejecting it at parse time is fine too
+        }
+        for (uint32_t size : sizes) {
+            std::vector<uint8_t> bgra = svg->Render(size);
+            Check(bgra.size() == (size_t)size * size * 4, label + " at " + std::to_string(size));
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--svg" && hasValue) opts.svgDir = Utf8::ToWide(argv[++i]);
+        else if (arg == "--reference" && hasValue) opts.referenceDir = Utf8::ToWide(argv[++i]);
+        else if (arg == "--iterations" && hasValue) opts.iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-ssim" && hasValue) opts.minSsim = std::atof(argv[++i]);
+        else if (arg == "--min-psnr" && hasValue) opts.minPsnr = std::atof(argv[++i]);
+        else if (arg == "--max-alpha" && hasValue) opts.maxAlphaError = std::atoi(argv[++i]);
+        else if (arg == "--update") opts.updateReferences = true;
+        else {
+            std::printf("Usage: svgbench [--svg <dir>] [--reference <dir>] [--iterations N] [--update]\n"
+                        "                [--min-ssim X] [--min-psnr DB] [--max-alpha N]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(opts.svgDir, entries)) {
+        std::fprintf(stderr, "Error: cannot read %s\n", Utf8::FromWide(opts.svgDir).c_str());
+        return 1;
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const FileUtil::Entry& a, const FileUtil::Entry& b) { return a.name < b.name; });
+    if (opts.updateReferences) {
+        FileUtil::MakeDirectories(opts.referenceDir);
+    }
+
+    std::printf("%-14s %8s", "svg (ms)", "parse");
+    for (uint32_t size : IconSource::kSvgSizes) std::printf(" %7u", size);
+    std::printf("  %7s %7s\n", "min ssim", "min psnr");
+
+    size_t cases = 0;
+    std::vector<double> sizeTotals(sizeof(IconSource::kSvgSizes) / sizeof(IconSource::kSvgSizes[0]), 0.0);
+    for (const FileUtil::Entry& e : entries) {
+        if (e.isDirectory || e.name.size() < 4 || e.name.compare(e.name.size() - 4, 4, L".svg") != 0) continue;
+        std::wstring stem = e.name.substr(0, e.name.size() - 4);
+        std::string name = Utf8::FromWide(stem);
+        std::string text;
+        if (!FileUtil::Read(FileUtil::Join(opts.svgDir, e.name), text)) {
+            Check(false, "read " + name);
+            continue;
+        }
+
+        std::vector<double> parseRuns;
+        std::unique_ptr<SvgImage> svg;
+        for (int i = 0; i < opts.iterations; i++) {
+            Clock::time_point start = Clock::now();
+            svg = SvgImage::Parse(text);
+            parseRuns.push_back(MillisecondsSince(start));
+        }
+        if (!svg) {
+            Check(false, "parse " + name);
+            continue;
+        }
+        std::printf("%-14s %8.3f", name.c_str(), Median(parseRuns));
+
+        double minSsim = 1.0, minPsnr = ImageMetrics::kMaxPsnr;
+        std::vector<std::string> failures;
+        size_t column = 0;
+        for (uint32_t size : IconSource::kSvgSizes) {
+            std::vector<double> runs;
+            std::vector<uint8_t> bgra;
+            for (int i = 0; i < opts.iterations; i++) {
+                Clock::time_point start = Clock::now();
+                bgra = svg->Render(size);
+                runs.push_back(MillisecondsSince(start));
+            }
+            double ms = Median(runs);
+            sizeTotals[column++] += ms;
+            std::printf(" %7.3f", ms);
+
+            ImageQuality quality;
+            std::string failure;
+            if (!CheckReference(opts, stem, size, bgra, quality, failure)) {
+                failures.push_back(name + " at " + std::to_string(size) + ": " + failure);
+            }
+            minSsim = std::min(minSsim, quality.ssim);
+            minPsnr = std::min(minPsnr, quality.psnr);
+            cases++;
+        }
+        std::printf("  %8.5f %8.2f\n", minSsim, minPsnr);
+        for (const std::string& f : failures) Check(false, f);
+    }
+    if (!cases) {
+        std::fprintf(stderr, "Error: no .svg files in %s\n", Utf8::FromWide(opts.svgDir).c_str());
+        return 1;
+    }
+    std::printf("%-14s %8s", "total", "");
+    for (double ms : sizeTotals) std::printf(" %7.3f", ms);
+    std::printf("\n");
+
+    CheckHostileInput();
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed (%zu renders)\n", cases);
+    return 0;
+}
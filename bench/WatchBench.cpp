@@ -0,0 +1,311 @@
+// Watch mode benchmark: runs ManifestWatcher over a temporary manifest and
+// a set of PNG icons (converted with the real icon pipeline into versioned
+// cache entries), edits them the way users and editors do, and checks that
+// every batch regenerates exactly the affected apps. Reports the latency
+// from a file write to the regenerated output.
+//
+// Linux only (inotify); see README.md ("Watch Mode") for build and usage.
+
+#include "../FileUtil.h"
+#include "../IconCache.h"
+#include "../IconPipeline.h"
+#include "../ManifestWatcher.h"
+#include "../PngEncoder.h"
+#include "../Utf8.h"
+#include "../WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void RemoveTree(const std::wstring& root) {
+    std::string command = "rm -rf '" + Utf8::FromWide(root) + "'";
+    if (std::system(command.c_str()) != 0) {
+        std::fprintf(stderr, "warning: failed to remove %s\n", Utf8::FromWide(root).c_str());
+    }
+}
+
+// Solid-ish 64x64 icon whose pixels depend on seed
+void WriteIcon(const std::wstring& path, uint32_t seed) {
+    const uint32_t size = 64;
+    std::vector<uint8_t> rgba(size * size * 4);
+    for (uint32_t i = 0; i < size * size; ++i) {
+        rgba[i * 4 + 0] = (uint8_t)(seed * 37 + i % size);
+        rgba[i * 4 + 1] = (uint8_t)(seed * 91 + i / size);
+        rgba[i * 4 + 2] = (uint8_t)(seed * 13);
+        rgba[i * 4 + 3] = 255;
+    }
+    std::vector<uint8_t> png;
+    PngEncoder::Encode(rgba.data(), size, size, size * 4, PngEncoder::Layout::RGBA, 6, png);
+    FileUtil::Write(path, png.data(), png.size());
+}
+
+struct App {
+    std::wstring name;
+    std::wstring target;
+    std::wstring icon;
+};
+
+void WriteManifest(const std::wstring& path, const std::vector<App>& apps) {
+    std::string text = "# watch bench\n";
+    for (const App& a : apps) {
+        text += "[" + Utf8::FromWide(a.name) + "]\n";
+        text += "target = " + Utf8::FromWide(a.target) + "\n";
+        text += "icon = " + Utf8::FromWide(a.icon) + "\n\n";
+    }
+    FileUtil::Write(path, text.data(), text.size());
+}
+
+// Stand-in for ShortcutHelper: converts the icon into the versioned cache
+// and writes a "shortcut" file naming the target and icon location
+class Generator {
+public:
+    Generator(const std::wstring& cacheDir, const std::wstring& outDir)
+        : m_cacheDir(cacheDir), m_outDir(outDir) {
+    }
+
+    bool Update(const ManifestEntry& entry, bool iconChanged) {
+        std::wstring icoPath = IconCache::VersionedPath(m_cacheDir, entry.icon);
+        if (icoPath.empty()) {
+            return false;
+        }
+        if (iconChanged || !FileUtil::Exists(icoPath)) {
+            std::string png;
+            std::vector<uint8_t> ico;
+            if (!FileUtil::Read(entry.icon, png) ||
+                !IconPipeline::PngToIco((const uint8_t*)png.data(), png.size(), 0, ico) ||
+                !FileUtil::Write(icoPath, ico.data(), ico.size())) {
+                return false;
+            }
+            IconCache::RemoveOtherVersions(m_cacheDir, entry.icon, icoPath);
+        }
+        std::string link = Utf8::FromWide(entry.target) + "\n" + Utf8::FromWide(icoPath) + "\n";
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_updates[entry.name]++;
+        return FileUtil::Write(ShortcutPath(entry.name), link.data(), link.size());
+    }
+
+    bool Remove(const std::wstring& name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_removals[name]++;
+        return FileUtil::Remove(ShortcutPath(name));
+    }
+
+    std::wstring ShortcutPath(const std::wstring& name) const {
+        return FileUtil::Join(m_outDir, name + L".lnk");
+    }
+
+    // Apps touched since the last call
+    std::map<std::wstring, int> TakeUpdates() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<std::wstring, int> out;
+        out.swap(m_updates);
+        return out;
+    }
+
+    std::map<std::wstring, int> TakeRemovals() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<std::wstring, int> out;
+        out.swap(m_removals);
+        return out;
+    }
+
+private:
+    std::wstring m_cacheDir;
+    std::wstring m_outDir;
+    std::mutex m_mutex;
+    std::map<std::wstring, int> m_updates;
+    std::map<std::wstring, int> m_removals;
+};
+
+bool Contains(const std::wstring& path, const std::wstring& needle) {
+    std::string data;
+    return FileUtil::Read(path, data) && data.find(Utf8::FromWide(needle)) != std::string::npos;
+}
+
+double Percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p / 100.0 * (v.size() - 1) + 0.5))];
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    // The watcher reports through std::wcout; unsynced, it can't lock stdout
+    // into wide mode and swallow the printf output below
+    std::ios::sync_with_stdio(false);
+
+    int appCount = 8;
+    int edits = 20;
+    std::wstring root = FileUtil::Absolute(L"watchbench.tmp");
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--apps" && i + 1 < argc) {
+            appCount = std::max(6, std::atoi(argv[++i]));  // The scenarios below use App0-App5
+        } else if (arg == "--edits" && i + 1 < argc) {
+            edits = std::atoi(argv[++i]);
+        } else if (arg == "--root" && i + 1 < argc) {
+            root = FileUtil::Absolute(Utf8::ToWide(argv[++i]));
+        } else {
+            std::printf("Usage: watchbench [--apps N] [--edits N] [--root <dir>]\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    RemoveTree(root);
+    std::wstring iconDir = FileUtil::Join(root, L"icons");
+    std::wstring cacheDir = FileUtil::Join(root, L"cache");
+    std::wstring outDir = FileUtil::Join(root, L"shortcuts");
+    FileUtil::MakeDirectories(iconDir);
+    FileUtil::MakeDirectories(cacheDir);
+    FileUtil::MakeDirectories(outDir);
+
+    // App 0 and 1 share an icon; every other app has its own
+    std::vector<App> apps;
+    for (int i = 0; i < appCount; ++i) {
+        App a;
+        a.name = L"App" + std::to_wstring(i);
+        a.target = L"https://app" + std::to_wstring(i) + L".example.com";
+        a.icon = FileUtil::Join(iconDir, L"icon" + std::to_wstring(i == 1 ? 0 : i) + L".png");
+        apps.push_back(a);
+    }
+    for (int i = 0; i < appCount; ++i) {
+        if (i != 1) WriteIcon(apps[i].icon, (uint32_t)i);
+    }
+    std::wstring manifest = FileUtil::Join(root, L"apps.ini");
+    WriteManifest(manifest, apps);
+
+    Generator generator(cacheDir, outDir);
+    WatchActions actions;
+    actions.updateApp = [&generator](const ManifestEntry& e, bool iconChanged) {
+        return generator.Update(e, iconChanged);
+    };
+    actions.removeApp = [&generator](const std::wstring& name) {
+        return generator.Remove(name);
+    };
+
+    WorkerPool pool(4);
+    ManifestWatcher watcher(manifest, actions, pool);
+    Check(watcher.Start(), "watcher starts");
+    for (const ManifestEntry& e : watcher.Entries()) {
+        generator.Update(e, false);
+    }
+    generator.TakeUpdates();
+
+    WatchBatch batch;
+
+    // 1. Editing one icon regenerates only the app using it
+    WriteIcon(apps[3].icon, 100);
+    Check(watcher.Poll(2000, &batch), "icon edit produces a batch");
+    std::map<std::wstring, int> updates = generator.TakeUpdates();
+    Check(updates.size() == 1 && updates.count(L"App3"), "only the affected app regenerated");
+    Check(Contains(generator.ShortcutPath(L"App3"), IconCache::VersionedPath(cacheDir, apps[3].icon)),
+        "shortcut points at the new icon version");
+
+    // 2. A shared icon regenerates every app using it
+    WriteIcon(apps[0].icon, 101);
+    Check(watcher.Poll(2000, &batch), "shared icon edit produces a batch");
+    updates = generator.TakeUpdates();
+    Check(updates.size() == 2 && updates.count(L"App0") && updates.count(L"App1"),
+        "both apps sharing the icon regenerated");
+
+    // 3. A burst of saves is coalesced into one regeneration
+    std::thread burst([&apps]() {
+        for (int i = 0; i < 6; ++i) {
+            WriteIcon(apps[2].icon, 200 + i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        }
+    });
+    Check(watcher.Poll(2000, &batch), "burst produces a batch");
+    burst.join();
+    updates = generator.TakeUpdates();
+    std::printf("burst:    %zu events coalesced into %d update(s), %.0f ms\n",
+        batch.events, updates[L"App2"], batch.latencyMs);
+    Check(batch.events >= 6 && updates.size() == 1 && updates[L"App2"] == 1, "burst coalesced");
+    Check(!watcher.Poll(400, &batch), "no trailing batch after a burst");
+
+    // 4. Manifest edit: one target changed, one app added, one removed
+    std::vector<App> edited = apps;
+    edited[4].target = L"https://changed.example.com";
+    App added;
+    added.name = L"Added";
+    added.target = L"https://added.example.com";
+    added.icon = FileUtil::Join(iconDir, L"added.png");
+    WriteIcon(added.icon, 300);
+    edited.push_back(added);
+    edited.erase(edited.begin() + 5);
+    WriteManifest(manifest, edited);
+    Check(watcher.Poll(2000, &batch), "manifest edit produces a batch");
+    updates = generator.TakeUpdates();
+    std::map<std::wstring, int> removals = generator.TakeRemovals();
+    Check(updates.size() == 2 && updates.count(L"App4") && updates.count(L"Added"),
+        "changed and added apps regenerated");
+    Check(removals.size() == 1 && removals.count(L"App5"), "removed app cleaned up");
+    Check(!FileUtil::Exists(generator.ShortcutPath(L"App5")), "removed shortcut deleted");
+    Check(Contains(generator.ShortcutPath(L"App4"), L"changed.example.com"), "new target written");
+
+    // 5. Icons added by the manifest are watched; removed apps' icons are not
+    WriteIcon(added.icon, 301);
+    WriteIcon(apps[5].icon, 302);
+    Check(watcher.Poll(2000, &batch), "new icon is watched");
+    updates = generator.TakeUpdates();
+    Check(updates.size() == 1 && updates.count(L"Added"), "only the new app regenerated");
+
+    // 6. Event-to-update latency for single icon saves
+    std::vector<double> latencies;
+    for (int i = 0; i < edits; ++i) {
+        const App& app = edited[(size_t)(i % (int)edited.size())];
+        if (app.name == L"App1") continue;  // Shares App0's icon
+        Clock::time_point written = Clock::now();
+        WriteIcon(app.icon, 400 + (uint32_t)i);
+        if (!watcher.Poll(2000, &batch)) {
+            Check(false, "latency edit produces a batch");
+            continue;
+        }
+        latencies.push_back(MillisecondsSince(written));
+        generator.TakeUpdates();
+    }
+    std::printf("latency:  p50 %.0f ms, p90 %.0f ms, max %.0f ms over %zu saves (debounce %d ms)\n",
+        Percentile(latencies, 50), Percentile(latencies, 90), Percentile(latencies, 100),
+        latencies.size(), ManifestWatcher::kQuietMs);
+    Check(Percentile(latencies, 100) < ManifestWatcher::kMaxDelayMs + 500,
+        "updates land within the maximum debounce delay");
+
+    // One cache entry per icon still in use
+    std::vector<FileUtil::Entry> cached;
+    FileUtil::List(cacheDir, cached);
+    std::printf("cache:    %zu converted icons\n", cached.size());
+    Check(cached.size() <= edited.size(), "stale icon versions removed");
+
+    RemoveTree(root);
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -2,15 +2,52 @@
 #include <string>
 #include "WebViewWindow.h"
 #include "ShortcutHelper.h"
+#include "LaunchScheduler.h"
+#include "AllocTracker.h"
+#include "AppBundle.h"
+#include "DeltaPatch.h"
+#include "FileUtil.h"
+#include "IconHelper.h"
+#include "InjectBundle.h"
+#include "Manifest.h"
+#include "StartupTiming.h"
+#include "TargetChecker.h"
+#include "MetricsLog.h"
+#include "Utf8.h"
+#include "AppPaths.h"
 #include <algorithm>
+#include <iomanip>
 
 // Simple struct to hold CLI options
 struct Options {
     std::wstring target;
     std::wstring name;
     std::wstring icon;
+    std::wstring syncManifest;
+    std::wstring watchManifest;
+    std::wstring launchManifest;
+    std::wstring checkManifest;
+    std::wstring outPath;
+    std::wstring diffOld;
+    std::wstring diffNew;
+    std::wstring indexOut;
+    std::wstring patchDir;
+    std::wstring patchFile;
+    std::wstring assetsDir;
+    std::wstring injectDir;
+    std::wstring shortcutDir;
+    std::wstring profile;
+    uint64_t cacheBudgetMb = 256;
+    bool cacheBudgetSet = false;
+    unsigned concurrency = 0;
+    int timeoutMs = 10000;
+    int maxRedirects = 10;
+    unsigned samples = 3;
     bool createShortcut = false;
+    bool showStats = false;
+    bool build = false;
     bool debugMode = false;
+    bool allocStats = false;
 };
 
 // Convert std::string to std::wstring
@@ -25,21 +62,361 @@ std::wstring stringToWString(const std::string& str) {
 // Print usage information
 void printUsage() {
     std::wcout << L"WebWrapCLI - Wrap web applications as native Windows apps\n\n";
-    std::wcout << L"Usage: ww.exe --target <url> [options]\n\n";
+    std::wcout << L"Usage: ww.exe --target <url> [options]\n";
+    std::wcout << L"       ww.exe --sync <manifest> [--shortcut-dir <dir>]\n";
+    std::wcout << L"       ww.exe --watch <manifest> [--shortcut-dir <dir>]\n";
+    std::wcout << L"       ww.exe --launch-all <manifest> [--concurrency <n>]\n";
+    std::wcout << L"       ww.exe build --out <file.exe> --target <url> [options] [--assets <dir>]\n";
+    std::wcout << L"       ww.exe check <manifest> [--concurrency <n>] [--timeout <ms>] [--samples <n>]\n";
+    std::wcout << L"       ww.exe diff <old dir|index> <new dir> --out <patch> [--index <file>]\n";
+    std::wcout << L"       ww.exe patch <dir> <patch>\n";
+    std::wcout << L"       ww.exe stats [--name <name>]\n\n";
     std::wcout << L"Required Arguments:\n";
     std::wcout << L"  --target <url>    URL or local HTML file to display\n";
     std::wcout << L"                    - Web URLs: http:// or https://\n";
     std::wcout << L"                    - Local files: file:///C:/path/to/file.html\n\n";
     std::wcout << L"Optional Arguments:\n";
     std::wcout << L"  --name <name>     Window title and shortcut name (default: \"Web App\")\n";
-    std::wcout << L"  --icon <path>     Path to icon file (.ico or .png)\n";
+    std::wcout << L"  --icon <path>     Path to icon file (.ico, .png or .svg)\n";
     std::wcout << L"  -s                Create desktop shortcut only (don't launch window)\n";
+    std::wcout << L"  --profile <name>  Browser profile to use (default: one per --name);\n";
+    std::wcout << L"                    apps with the same profile share logins and cache\n";
+    std::wcout << L"  --cache-budget <MB>  Cache size other profiles are pruned to (default: 256,\n";
+    std::wcout << L"                    0 disables pruning)\n";
+    std::wcout << L"  --inject <dir>    Run the .js and .css files in dir in every page\n";
+    std::wcout << L"  --sync <manifest> Update shortcuts for every app in a manifest file,\n";
+    std::wcout << L"                    rewriting only the ones that changed\n";
+    std::wcout << L"  --watch <manifest>  Sync, then keep shortcuts up to date as the manifest\n";
+    std::wcout << L"                    or its icons change (Ctrl+C to stop)\n";
+    std::wcout << L"  --shortcut-dir <dir>  Folder used by --sync and --watch (default: Desktop)\n";
+    std::wcout << L"  --launch-all <manifest>  Open every app in a manifest, a few at a time,\n";
+    std::wcout << L"                    starting the next as each one finishes loading\n";
+    std::wcout << L"  --concurrency <n> Apps --launch-all starts at once (default: from CPU and disk),\n";
+    std::wcout << L"                    or requests check makes at once (default: 32)\n";
+    std::wcout << L"  --timeout <ms>    Deadline of each check request (default: 10000)\n";
+    std::wcout << L"  --samples <n>     Requests check makes per target (default: 3)\n";
+    std::wcout << L"  --max-redirects <n>  Redirects check follows per request (default: 10)\n";
+    std::wcout << L"  --index <file>    Save the new version's chunk index when running diff\n";
     std::wcout << L"  --debug           Show console window for debugging\n";
+    std::wcout << L"  --alloc-stats     Print heap allocations per startup phase on exit\n\n";
+    std::wcout << L"Commands:\n";
+    std::wcout << L"  build             Write a single-file app: a copy of ww.exe carrying the\n";
+    std::wcout << L"                    options, the converted icon and optionally --assets\n";
+    std::wcout << L"                    (--target is then a page inside that folder)\n";
+    std::wcout << L"  check <manifest>  Request every target in a manifest and report status,\n";
+    std::wcout << L"                    redirects and p50/p99 latency; exits with -1 if any failed\n";
+    std::wcout << L"  diff <old> <new>  Write a patch (--out) that updates a copy of the old folder to\n";
+    std::wcout << L"                    the new one, reusing unchanged chunks; <old> may be an index\n";
+    std::wcout << L"                    saved with --index instead of the folder itself\n";
+    std::wcout << L"  patch <dir> <patch>  Update a folder with a patch from diff, all at once\n";
+    std::wcout << L"  stats             Print p50/p90/p99 startup time per phase for every app\n";
+    std::wcout << L"                    (or only --name) across recorded launches\n";
     std::wcout << L"  --help            Show this help message\n\n";
     std::wcout << L"Example:\n";
     std::wcout << L"  ww.exe --target https://example.com --name \"My App\" --icon app.ico -s\n";
     std::wcout << L"  ww.exe --target file:///C:/dev/myapp/index.html --name \"Local App\"\n";
     std::wcout << L"  ww.exe --target https://github.com --icon github.png\n";
+    std::wcout << L"  ww.exe --sync apps.ini\n";
+    std::wcout << L"  ww.exe --watch apps.ini --shortcut-dir C:\\Users\\me\\Apps\n";
+    std::wcout << L"  ww.exe --launch-all apps.ini --concurrency 2\n";
+    std::wcout << L"  ww.exe build --out Gmail.exe --target https://mail.google.com --name Gmail --icon gmail.png\n";
+    std::wcout << L"  ww.exe check apps.ini --concurrency 64 --timeout 5000\n";
+    std::wcout << L"  ww.exe diff app-1.0.idx dist --out app-1.1.patch --index app-1.1.idx\n";
+    std::wcout << L"  ww.exe patch C:\\Apps\\MyApp\\assets app-1.1.patch\n";
+    std::wcout << L"  ww.exe stats --name Gmail\n";
+}
+
+// Print one row of latency percentiles (recorded in microseconds)
+void printStatsRow(const std::string& label, const LatencyHistogram& h) {
+    std::wcout << L"  " << std::left << std::setw(18) << Utf8::ToWide(label) << std::right;
+    const double percentiles[] = { 50, 90, 99 };
+    for (double p : percentiles) {
+        std::wcout << std::setw(10) << h.Percentile(p) / 1000.0;
+    }
+    std::wcout << std::setw(10) << h.Max() / 1000.0 << L"\n";
+}
+
+void printStatsTable(const AppLatency& app) {
+    std::wcout << Utf8::ToWide(app.app) << L" (" << app.launches << L" launches)\n";
+    std::wcout << L"  " << std::left << std::setw(18) << L"phase (ms)" << std::right
+               << std::setw(10) << L"p50" << std::setw(10) << L"p90"
+               << std::setw(10) << L"p99" << std::setw(10) << L"max" << L"\n";
+    for (const PhaseHistogram& p : app.phases) {
+        printStatsRow(p.phase, p.histogram);
+    }
+    std::wcout << L"\n";
+}
+
+// Print startup latency percentiles from the metrics log
+bool printStats(const std::wstring& appFilter) {
+    std::wstring path = MetricsLog::DefaultPath();
+    if (path.empty()) {
+        std::wcerr << L"Error: No data folder for metrics\n";
+        return false;
+    }
+
+    // Fold launches recorded since the last report into histograms first
+    if (!MetricsLog::Compact(path)) {
+        std::wcerr << L"Warning: Failed to compact metrics log: " << path << L"\n";
+    }
+
+    std::vector<AppLatency> apps;
+    if (!MetricsLog::Load(path, apps)) {
+        std::wcerr << L"Error: Failed to read metrics log: " << path << L"\n";
+        return false;
+    }
+
+    std::string filter = Utf8::FromWide(appFilter);
+    AppLatency all;
+    all.app = "All apps";
+    std::wcout << std::fixed << std::setprecision(1);
+    for (const AppLatency& app : apps) {
+        if (!filter.empty() && app.app != filter) continue;
+        printStatsTable(app);
+        all.Merge(app);
+    }
+
+    if (all.launches == 0) {
+        std::wcout << L"No launches recorded" << (filter.empty() ? L"" : L" for " + appFilter) << L".\n";
+    } else if (filter.empty() && apps.size() > 1) {
+        printStatsTable(all);
+    }
+    return true;
+}
+
+// Start every app in a manifest through the launch scheduler and report
+// how long each took to become usable
+bool launchAll(const std::wstring& manifestPath, unsigned concurrency) {
+    std::vector<ManifestEntry> entries;
+    std::wstring error;
+    if (!Manifest::Load(manifestPath, entries, error)) {
+        std::wcerr << L"Error: " << error << L"\n";
+        return false;
+    }
+
+    wchar_t exePath[MAX_PATH];
+    if (GetModuleFileNameW(nullptr, exePath, MAX_PATH) == 0) {
+        std::wcerr << L"Error: Failed to get executable path\n";
+        return false;
+    }
+
+    // Each app is a separate ww process; "priority = <n>" starts lower numbers first
+    std::vector<LaunchItem> items;
+    for (const ManifestEntry& entry : entries) {
+        LaunchItem item;
+        item.name = entry.name;
+        item.executable = exePath;
+        item.args = { L"--target", entry.target, L"--name", entry.name };
+        if (!entry.icon.empty()) {
+            item.args.push_back(L"--icon");
+            item.args.push_back(entry.icon);
+        }
+        auto profile = entry.extra.find(L"profile");
+        if (profile != entry.extra.end()) {
+            item.args.push_back(L"--profile");
+            item.args.push_back(profile->second);
+        }
+        auto priority = entry.extra.find(L"priority");
+        if (priority != entry.extra.end()) {
+            item.priority = _wtoi(priority->second.c_str());
+        }
+        items.push_back(item);
+    }
+
+    LaunchOptions options;
+    options.concurrency = concurrency ? concurrency : LaunchScheduler::AutoConcurrency();
+    std::wcout << L"Launching " << items.size() << L" app(s), " << options.concurrency << L" at a time\n";
+    std::vector<LaunchResult> results = LaunchScheduler::Run(items, options);
+
+    std::wcout << std::fixed << std::setprecision(0);
+    std::wcout << L"  " << std::left << std::setw(24) << L"app" << std::right
+               << std::setw(10) << L"start ms" << std::setw(10) << L"ready ms" << L"\n";
+    double allReadyMs = 0;
+    bool ok = true;
+    for (const LaunchResult& r : results) {
+        std::wcout << L"  " << std::left << std::setw(24) << r.name << std::right;
+        if (!r.started) {
+            std::wcout << std::setw(10) << L"-" << std::setw(10) << L"-" << L"  failed to start\n";
+            ok = false;
+            continue;
+        }
+        std::wcout << std::setw(10) << r.startMs << std::setw(10) << r.readyMs
+                   << (r.ready ? L"" : r.timedOut ? L"  timed out" : L"  exited") << L"\n";
+        if (r.startMs + r.readyMs > allReadyMs) allReadyMs = r.startMs + r.readyMs;
+    }
+    std::wcout << L"All apps settled after " << allReadyMs << L" ms\n";
+    return ok;
+}
+
+// Local path of a file:// URL (file:///C:/path/to/file.html -> C:/path/to/file.html);
+// false if the URL isn't a file URL
+bool fileUrlToPath(const std::wstring& url, std::wstring& path) {
+    if (url.find(L"file://") != 0) {
+        return false;
+    }
+    path = url.substr(7); // Skip "file://"
+
+    // Remove leading slash if it's a Windows path (file:///C:/...)
+    if (path.length() > 2 && path[0] == L'/' && path[2] == L':') {
+        path = path.substr(1);
+    }
+    return true;
+}
+
+// Request every target in a manifest a few times and report which ones are
+// dead, slow or stuck in redirects
+bool checkTargets(const Options& opts) {
+    std::vector<ManifestEntry> entries;
+    std::wstring error;
+    if (!Manifest::Load(opts.checkManifest, entries, error)) {
+        std::wcerr << L"Error: " << error << L"\n";
+        return false;
+    }
+
+    // Local pages only need to exist; everything else goes to the checker
+    std::vector<CheckTarget> targets;
+    size_t failed = 0;
+    for (const ManifestEntry& entry : entries) {
+        std::wstring path;
+        if (fileUrlToPath(entry.target, path)) {
+            if (!FileUtil::Exists(path)) {
+                std::wcout << L"  " << entry.name << L": local file not found: " << path << L"\n";
+                failed++;
+            }
+            continue;
+        }
+        CheckTarget target;
+        target.name = entry.name;
+        target.url = entry.target;
+        targets.push_back(target);
+    }
+
+    CheckOptions options;
+    options.concurrency = opts.concurrency ? opts.concurrency : options.concurrency;
+    options.timeoutMs = opts.timeoutMs;
+    options.maxRedirects = opts.maxRedirects;
+    options.samples = opts.samples;
+    std::wcout << L"Checking " << targets.size() << L" target(s), " << options.concurrency
+               << L" requests at a time, " << options.samples << L" per target\n";
+    std::vector<CheckReport> reports = TargetChecker::Run(targets, options);
+
+    // A target is slow when half its requests take longer than this
+    const double kSlowMs = 2000;
+    size_t slow = 0;
+    std::wcout << std::fixed << std::setprecision(0);
+    std::wcout << L"  " << std::left << std::setw(24) << L"app" << std::right
+               << std::setw(8) << L"status" << std::setw(10) << L"p50 ms" << std::setw(10) << L"p99 ms" << L"\n";
+    for (const CheckReport& r : reports) {
+        std::wcout << L"  " << std::left << std::setw(24) << r.name << std::right << std::setw(8);
+        if (r.status) std::wcout << r.status;
+        else std::wcout << L"-";
+        if (r.latency.Count()) {
+            double p50 = r.latency.Percentile(50) / 1000.0;
+            std::wcout << std::setw(10) << p50 << std::setw(10) << r.latency.Percentile(99) / 1000.0;
+            if (p50 > kSlowMs) {
+                std::wcout << L"  slow";
+                slow++;
+            }
+        } else {
+            std::wcout << std::setw(10) << L"-" << std::setw(10) << L"-";
+        }
+        if (!r.ok) {
+            std::wcout << L"  " << Utf8::ToWide(r.error);
+            if (r.failures < r.attempts) std::wcout << L" (" << r.failures << L" of " << r.attempts << L")";
+            failed++;
+        }
+        std::wcout << L"\n";
+        if (r.chain.size() > 1) {
+            for (const CheckHop& hop : r.chain) {
+                std::wcout << L"      " << (hop.status ? std::to_wstring(hop.status) : L"-") << L" "
+                           << Utf8::ToWide(hop.url) << L"\n";
+            }
+        }
+    }
+    std::wcout << (entries.size() - failed) << L" ok, " << failed << L" failed, " << slow << L" slow\n";
+    return failed == 0;
+}
+
+// Print how a delta update splits into reused and new bytes
+void printDeltaStats(const DeltaStats& stats) {
+    uint64_t total = stats.reusedBytes + stats.literalBytes;
+    std::wcout << L"  " << stats.files << L" file(s), " << stats.chunks << L" chunk(s), "
+               << (total + 1023) / 1024 << L" KB\n";
+    std::wcout << L"  reused " << stats.reusedChunks << L" chunk(s), " << (stats.reusedBytes + 1023) / 1024
+               << L" KB; new " << (stats.literalBytes + 1023) / 1024 << L" KB\n";
+}
+
+// Write a patch from an old version (its folder or saved index) to a new folder
+bool diffTrees(const Options& opts) {
+    if (opts.outPath.empty()) {
+        std::wcerr << L"Error: diff needs --out <patch>\n";
+        return false;
+    }
+
+    // An index saved by an earlier diff stands in for the old folder
+    TreeIndex base;
+    FileUtil::Entry info;
+    if (FileUtil::Stat(opts.diffOld, info) && !info.isDirectory) {
+        std::string data;
+        if (!FileUtil::Read(opts.diffOld, data) ||
+            !ChunkIndex::Parse((const uint8_t*)data.data(), data.size(), base)) {
+            std::wcerr << L"Error: Not a chunk index: " << opts.diffOld << L"\n";
+            return false;
+        }
+    } else if (!ChunkIndex::Build(opts.diffOld, base)) {
+        std::wcerr << L"Error: Failed to read folder: " << opts.diffOld << L"\n";
+        return false;
+    }
+    if (base.chunkerVersion != Chunker::kVersion) {
+        std::wcerr << L"Error: Index was made by a different version of ww: " << opts.diffOld << L"\n";
+        return false;
+    }
+
+    std::string patch;
+    DeltaStats stats;
+    TreeIndex target;
+    if (!DeltaPatch::Create(base, opts.diffNew, patch, &stats, &target)) {
+        std::wcerr << L"Error: Failed to read folder: " << opts.diffNew << L"\n";
+        return false;
+    }
+    if (!FileUtil::Write(opts.outPath, patch.data(), patch.size())) {
+        std::wcerr << L"Error: Failed to write patch: " << opts.outPath << L"\n";
+        return false;
+    }
+    if (!opts.indexOut.empty()) {
+        std::string index;
+        ChunkIndex::Serialize(target, index);
+        if (!FileUtil::Write(opts.indexOut, index.data(), index.size())) {
+            std::wcerr << L"Error: Failed to write index: " << opts.indexOut << L"\n";
+            return false;
+        }
+    }
+
+    std::wcout << L"Wrote " << opts.outPath << L": " << (stats.patchBytes + 1023) / 1024 << L" KB\n";
+    printDeltaStats(stats);
+    return true;
+}
+
+// Update a folder in place with a patch from diffTrees
+bool patchTree(const Options& opts) {
+    std::string patch;
+    if (!FileUtil::Read(opts.patchFile, patch)) {
+        std::wcerr << L"Error: Failed to read patch: " << opts.patchFile << L"\n";
+        return false;
+    }
+    std::string error;
+    DeltaStats stats;
+    if (!DeltaPatch::Apply(opts.patchDir, (const uint8_t*)patch.data(), patch.size(), error, &stats)) {
+        std::wcerr << L"Error: " << Utf8::ToWide(error) << L": " << opts.patchDir << L"\n";
+        return false;
+    }
+    if (stats.upToDate) {
+        std::wcout << opts.patchDir << L" is already up to date\n";
+        return true;
+    }
+    std::wcout << L"Updated " << opts.patchDir << L"\n";
+    printDeltaStats(stats);
+    return true;
 }
 
 // Parse CLI arguments
@@ -61,12 +438,75 @@ Options parseArgs(int argc, char* argv[]) {
         else if (arg == "--icon" && i + 1 < argc) {
             opts.icon = stringToWString(argv[++i]);
         }
+        else if (arg == "--sync" && i + 1 < argc) {
+            opts.syncManifest = stringToWString(argv[++i]);
+        }
+        else if (arg == "--watch" && i + 1 < argc) {
+            opts.watchManifest = stringToWString(argv[++i]);
+        }
+        else if (arg == "--launch-all" && i + 1 < argc) {
+            opts.launchManifest = stringToWString(argv[++i]);
+        }
+        else if (arg == "--concurrency" && i + 1 < argc) {
+            opts.concurrency = (unsigned)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--shortcut-dir" && i + 1 < argc) {
+            opts.shortcutDir = stringToWString(argv[++i]);
+        }
+        else if (arg == "--profile" && i + 1 < argc) {
+            opts.profile = stringToWString(argv[++i]);
+        }
+        else if (arg == "--cache-budget" && i + 1 < argc) {
+            opts.cacheBudgetMb = strtoull(argv[++i], nullptr, 10);
+            opts.cacheBudgetSet = true;
+        }
+        else if (arg == "stats" && i == 1) {
+            opts.showStats = true;
+        }
+        else if (arg == "check" && i == 1 && i + 1 < argc) {
+            opts.checkManifest = stringToWString(argv[++i]);
+        }
+        else if (arg == "diff" && i == 1 && i + 2 < argc) {
+            opts.diffOld = stringToWString(argv[++i]);
+            opts.diffNew = stringToWString(argv[++i]);
+        }
+        else if (arg == "patch" && i == 1 && i + 2 < argc) {
+            opts.patchDir = stringToWString(argv[++i]);
+            opts.patchFile = stringToWString(argv[++i]);
+        }
+        else if (arg == "--index" && i + 1 < argc) {
+            opts.indexOut = stringToWString(argv[++i]);
+        }
+        else if (arg == "--timeout" && i + 1 < argc) {
+            opts.timeoutMs = atoi(argv[++i]);
+        }
+        else if (arg == "--samples" && i + 1 < argc) {
+            opts.samples = (unsigned)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--max-redirects" && i + 1 < argc) {
+            opts.maxRedirects = atoi(argv[++i]);
+        }
+        else if (arg == "build" && i == 1) {
+            opts.build = true;
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            opts.outPath = stringToWString(argv[++i]);
+        }
+        else if (arg == "--assets" && i + 1 < argc) {
+            opts.assetsDir = stringToWString(argv[++i]);
+        }
+        else if (arg == "--inject" && i + 1 < argc) {
+            opts.injectDir = stringToWString(argv[++i]);
+        }
         else if (arg == "-s") {
             opts.createShortcut = true;
         }
         else if (arg == "--debug") {
             opts.debugMode = true;
         }
+        else if (arg == "--alloc-stats") {
+            opts.allocStats = true;
+        }
         else {
             std::wcerr << L"Warning: Unknown argument or missing value: " 
                        << stringToWString(arg) << L"\n";
@@ -94,18 +534,11 @@ bool isValidUrl(const std::wstring& url) {
 
 // Validate and normalize file path for file:// URLs
 bool validateFilePath(const std::wstring& url) {
-    if (url.find(L"file://") != 0) {
+    std::wstring filePath;
+    if (!fileUrlToPath(url, filePath)) {
         return true; // Not a file URL, other validation applies
     }
     
-    // Extract the file path from file:// URL
-    std::wstring filePath = url.substr(7); // Skip "file://"
-    
-    // Remove leading slash if it's a Windows path (file:///C:/...)
-    if (filePath.length() > 2 && filePath[0] == L'/' && filePath[2] == L':') {
-        filePath = filePath.substr(1);
-    }
-    
     // Check if file exists
     if (GetFileAttributesW(filePath.c_str()) == INVALID_FILE_ATTRIBUTES) {
         std::wcerr << L"Error: Local file not found: " << filePath << L"\n";
@@ -129,8 +562,8 @@ bool isValidIconFile(const std::wstring& iconPath) {
     std::wstring ext = iconPath.substr(dotPos);
     std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
     
-    if (ext != L".ico" && ext != L".png") {
-        std::wcerr << L"Error: Icon must be .ico or .png format\n";
+    if (ext != L".ico" && ext != L".png" && ext != L".svg") {
+        std::wcerr << L"Error: Icon must be .ico, .png or .svg format\n";
         std::wcerr << L"Provided: " << iconPath << L"\n";
         return false;
     }
@@ -138,10 +571,147 @@ bool isValidIconFile(const std::wstring& iconPath) {
     return true;
 }
 
+// Adds every file under dir to files as "assets/<relative path>"
+bool addAssets(const std::wstring& dir, const std::string& prefix, std::vector<BundleFile>& files) {
+    std::vector<FileUtil::Entry> entries;
+    if (!FileUtil::List(dir, entries)) {
+        std::wcerr << L"Error: Failed to list assets folder: " << dir << L"\n";
+        return false;
+    }
+    for (const FileUtil::Entry& e : entries) {
+        std::wstring path = FileUtil::Join(dir, e.name);
+        std::string name = prefix + Utf8::FromWide(e.name);
+        if (e.isDirectory) {
+            if (!addAssets(path, name + "/", files)) return false;
+            continue;
+        }
+        BundleFile file;
+        file.name = AppBundle::kAssetPrefix + name;
+        if (!FileUtil::Read(path, file.data)) {
+            std::wcerr << L"Error: Failed to read asset: " << path << L"\n";
+            return false;
+        }
+        files.push_back(std::move(file));
+    }
+    return true;
+}
+
+// Write a copy of this executable with the app's options, its icon
+// (converted now rather than on every first launch) and any web assets
+bool buildApp(const Options& opts) {
+    if (opts.outPath.empty() || (opts.target.empty() && opts.assetsDir.empty())) {
+        std::wcerr << L"Error: build needs --out and --target (or --assets)\n";
+        return false;
+    }
+
+    // Bundled settings use the manifest format, one app section
+    std::wstring config = L"[" + (opts.name.empty() ? std::wstring(L"Web App") : opts.name) + L"]\n";
+    config += L"target = " + (opts.target.empty() ? std::wstring(L"index.html") : opts.target) + L"\n";
+    if (!opts.profile.empty()) {
+        config += L"profile = " + opts.profile + L"\n";
+    }
+    config += L"cache-budget = " + std::to_wstring(opts.cacheBudgetMb) + L"\n";
+
+    std::vector<BundleFile> files(1);
+    files[0].name = AppBundle::kConfigName;
+    files[0].data = Utf8::FromWide(config);
+
+    if (!opts.icon.empty()) {
+        BundleFile icon;
+        icon.name = AppBundle::kIconName;
+        PreparedIcon prepared;
+        if (!isValidIconFile(opts.icon) || !IconHelper::PrepareIcon(FileUtil::Absolute(opts.icon), prepared)) {
+            std::wcerr << L"Error: Failed to convert icon: " << opts.icon << L"\n";
+            return false;
+        }
+        icon.data.assign(prepared.ico.begin(), prepared.ico.end());
+        files.push_back(std::move(icon));
+    }
+    if (!opts.assetsDir.empty() && !addAssets(opts.assetsDir, "", files)) {
+        return false;
+    }
+
+    wchar_t exePath[MAX_PATH];
+    if (GetModuleFileNameW(nullptr, exePath, MAX_PATH) == 0) {
+        std::wcerr << L"Error: Failed to get executable path\n";
+        return false;
+    }
+    AppBundle check;
+    if (!AppBundle::Build(exePath, opts.outPath, files) || !check.Open(opts.outPath) || !check.Verify()) {
+        std::wcerr << L"Error: Failed to write app: " << opts.outPath << L"\n";
+        return false;
+    }
+
+    uint64_t payloadBytes = 0;
+    for (const BundleFile& f : files) payloadBytes += f.data.size();
+    std::wcout << L"Built " << opts.outPath << L": " << files.size() << L" file(s), "
+               << (payloadBytes + 1023) / 1024 << L" KB payload\n";
+    return true;
+}
+
+// Take the options a built app carries; anything on the command line still wins
+bool applyBundle(const AppBundle& bundle, Options& opts) {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::vector<ManifestEntry> entries;
+    std::wstring error;
+    if (!bundle.Find(AppBundle::kConfigName, data, size) ||
+        !Manifest::Parse(std::string((const char*)data, size), entries, error) || entries.size() != 1) {
+        std::wcerr << L"Error: Bundled configuration is invalid: " << error << L"\n";
+        return false;
+    }
+
+    const ManifestEntry& app = entries[0];
+    if (opts.name.empty()) opts.name = app.name;
+    if (opts.target.empty()) {
+        // Relative targets are pages inside the bundled assets
+        opts.target = app.target.find(L"://") == std::wstring::npos
+            ? WebViewWindow::kAssetOrigin + app.target : app.target;
+    }
+    auto profile = app.extra.find(L"profile");
+    if (opts.profile.empty() && profile != app.extra.end()) opts.profile = profile->second;
+    auto budget = app.extra.find(L"cache-budget");
+    if (!opts.cacheBudgetSet && budget != app.extra.end()) opts.cacheBudgetMb = _wtoi64(budget->second.c_str());
+    return true;
+}
+
+// Sends output to the console ww was started from, if any; debug mode
+// already has a console of its own
+void attachParentConsole(const Options& opts) {
+    if (!opts.debugMode && AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* pFile;
+        freopen_s(&pFile, "CONOUT$", "w", stdout);
+        freopen_s(&pFile, "CONOUT$", "w", stderr);
+        std::wcout.clear();
+        std::wcerr.clear();
+    }
+}
+
+// Releases COM and the converted arguments; returns the process exit code
+int finish(bool ok, int argc, char** argvA, LPWSTR* argv) {
+    CoUninitialize();
+    for (int i = 0; i < argc; i++) delete[] argvA[i];
+    delete[] argvA;
+    LocalFree(argv);
+    return ok ? 0 : -1;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    StartupTiming::Start();
+
     // Get command line arguments
     int argc;
     LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+    // Checked before parsing, so the argument handling is counted as well.
+    // Only a whole argument counts, not the text inside a URL or title
+    // (CommandLineToArgvW allocates with LocalAlloc, which isn't tracked)
+    for (int i = 1; i < argc; i++) {
+        if (wcscmp(argv[i], L"--alloc-stats") == 0) {
+            AllocTracker::Enable();
+            break;
+        }
+    }
     
     // Convert wide char arguments to char for parseArgs
     char** argvA = new char*[argc];
@@ -169,27 +739,74 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Initialize COM for shell operations
     CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
 
+    // A built app (see buildApp) carries its options in its own image;
+    // the mapping stays open for the life of the window
+    AppBundle bundle;
+    bool bundled = !opts.build && bundle.OpenSelf();
+    if (bundled && !applyBundle(bundle, opts)) {
+        bundled = false;
+    }
+
     // Show help if no arguments provided
-    if (argc < 2) {
+    if (argc < 2 && !bundled) {
         printUsage();
-        
-        // Clean up
-        for (int i = 0; i < argc; i++) delete[] argvA[i];
-        delete[] argvA;
-        LocalFree(argv);
-        return -1;
+        return finish(false, argc, argvA, argv);
+    }
+
+    // Stats reporting doesn't use --target either
+    if (opts.showStats) {
+        attachParentConsole(opts);
+        bool ok = printStats(opts.name);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Watch mode runs until Ctrl+C and reports each change as it happens
+    if (!opts.watchManifest.empty()) {
+        attachParentConsole(opts);
+        bool ok = ShortcutHelper::WatchManifest(opts.watchManifest, opts.shortcutDir);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Building an app reports what went into it
+    if (opts.build) {
+        attachParentConsole(opts);
+        bool ok = buildApp(opts);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Fleet launch reports each app's time to ready in the console
+    if (!opts.launchManifest.empty()) {
+        attachParentConsole(opts);
+        bool ok = launchAll(opts.launchManifest, opts.concurrency);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Target checks print a report to the console
+    if (!opts.checkManifest.empty()) {
+        attachParentConsole(opts);
+        bool ok = checkTargets(opts);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Delta updates report what was reused
+    if (!opts.diffOld.empty() || !opts.patchDir.empty()) {
+        attachParentConsole(opts);
+        bool ok = opts.diffOld.empty() ? patchTree(opts) : diffTrees(opts);
+        return finish(ok, argc, argvA, argv);
+    }
+
+    // Manifest sync doesn't use --target; handle it before validation
+    if (!opts.syncManifest.empty()) {
+        attachParentConsole(opts);
+        bool ok = ShortcutHelper::SyncShortcuts(opts.syncManifest, opts.shortcutDir);
+        return finish(ok, argc, argvA, argv);
     }
 
     // Validate required arguments
     if (opts.target.empty()) {
         std::wcerr << L"Error: --target [url] is required.\n\n";
         printUsage();
-        
-        // Clean up
-        for (int i = 0; i < argc; i++) delete[] argvA[i];
-        delete[] argvA;
-        LocalFree(argv);
-        return -1;
+        return finish(false, argc, argvA, argv);
     }
 
     // Validate URL format
@@ -200,21 +817,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         std::wcerr << L"  https://example.com\n";
         std::wcerr << L"  http://localhost:3000\n";
         std::wcerr << L"  file:///C:/path/to/file.html\n";
-        
-        // Clean up
-        for (int i = 0; i < argc; i++) delete[] argvA[i];
-        delete[] argvA;
-        LocalFree(argv);
-        return -1;
+        return finish(false, argc, argvA, argv);
     }
     
     // Validate file path if it's a file:// URL
     if (!validateFilePath(opts.target)) {
-        // Clean up
-        for (int i = 0; i < argc; i++) delete[] argvA[i];
-        delete[] argvA;
-        LocalFree(argv);
-        return -1;
+        return finish(false, argc, argvA, argv);
     }
 
     // Set default name if not provided
@@ -246,11 +854,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             std::wcout << L"Icon: " << opts.icon << L"\n";
         }
         
-        ShortcutHelper::CreateShortcut(opts.name, opts.icon, opts.target);
+        ShortcutHelper::CreateShortcut(opts.name, opts.icon, opts.target, opts.profile);
         
         std::wcout << L"Shortcut created. Exiting without launching window.\n";
     }
     else {
+        StartupTiming::Mark("args");
+
         // Launch the window
         std::wcout << L"Initializing WebView2 window...\n";
         std::wcout << L"Title: " << opts.name << L"\n";
@@ -259,20 +869,35 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
             std::wcout << L"Icon: " << opts.icon << L"\n";
         }
 
+        // Each app (or --profile group) gets its own browser profile
+        std::wstring userDataFolder = AppPaths::ProfileDirectory(opts.profile.empty() ? opts.name : opts.profile);
+
+        // Page fixes, from the bundle cache unless the sources changed
+        std::string injectScript;
+        if (!opts.injectDir.empty()) {
+            InjectStats stats;
+            if (InjectBundle::Load(opts.injectDir, InjectBundle::CacheDirectory(), injectScript, &stats)) {
+                std::wcout << L"Inject: " << stats.files << L" file(s), " << stats.bundleBytes << L" bytes"
+                           << (stats.cacheHit ? L" (cached)" : L"") << L"\n";
+            } else {
+                std::wcerr << L"Warning: Failed to read inject folder: " << opts.injectDir << L"\n";
+            }
+            StartupTiming::Mark("inject");
+        }
+
         // Pass the URL into the WebViewWindow constructor
-        WebViewWindow window(opts.name, opts.icon, opts.target);
+        WebViewWindow window(opts.name, opts.icon, opts.target, userDataFolder,
+            opts.cacheBudgetMb * 1024 * 1024, bundled ? &bundle : nullptr, Utf8::ToWide(injectScript));
 
         // Run the message loop (navigation happens inside async callback in WebViewWindow)
         window.RunMessageLoop();
+
+        if (opts.allocStats) {
+            AllocTracker::Disable();
+            attachParentConsole(opts);
+            AllocTracker::Report();
+        }
     }
-    
-    // Cleanup COM
-    CoUninitialize();
-    
-    // Clean up command line arguments
-    for (int i = 0; i < argc; i++) delete[] argvA[i];
-    delete[] argvA;
-    LocalFree(argv);
-    
-    return 0;
+
+    return finish(true, argc, argvA, argv);
 }
\ No newline at end of file